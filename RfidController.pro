@@ -1,4 +1,5 @@
-SUBDIRS += src/RfidController.pro
+SUBDIRS += src/RfidController.pro \
+    tests/tests.pro
 
 TEMPLATE = subdirs
 CONFIG += ordered warn_on qt debug_and_release 
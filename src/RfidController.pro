@@ -20,14 +20,23 @@ DEFINES  += GUI
 #Comment this to disable logging support
 DEFINES += LOG
 
+#Comment this to disable collecting and exporting metrics
+DEFINES += METRICS
+
+#Comment this to disable recording latency spans of taps
+DEFINES += TRACING
+
 #Comment this to enable support of systemtray
 \DEFINES  += QT_NO_SYSTEMTRAYICON
 
 CONFIG(release, debug|release) : DEFINES += QT_NO_DEBUG_OUTPUT
 
 TARGET   = rfid-controller
-CONFIG   += c++17
-QT       += core
+CONFIG   += c++20
+QT       += core concurrent network
+
+#GCC 10 enables coroutines (used by PipelineCommand) only with explicit flag
+*-g++*: QMAKE_CXXFLAGS += -fcoroutines
 
 DESTDIR            = ../bin
 MOC_DIR            = ../build/moc
@@ -40,30 +49,91 @@ win32:OBJECTS_DIR  = ../build/o/win32
 #
 
 HEADERS += \
+    appconfig/CardFormatSettings.h \
     appconfig/CommandLineParser.h \
+    appconfig/CommandSchedulerSettings.h \
+    appconfig/DecoderSettings.h \
+    appconfig/DeviceMultiplexerSettings.h \
+    appconfig/KeyMatchingSettings.h \
+    appconfig/ReconnectSettings.h \
     appconfig/RfidControllerSettings.h \
     appconfig/Settings.h \
     appconfig/SettingsCore.h \
     core/CommandListManager.h \
+    core/KeyEvent.h \
+    core/KeyId.h \
     core/NotificationType.h \
     core/RfidController.h \
+    core/RingBuffer.h \
     core/ServiceTypes.h \
+    core/StartupProfiler.h \
+    core/cards/CardNormalizer.h \
+    core/TimerWheel.h \
+    core/commands/BatchCommand.h \
+    core/commands/ChildExit.h \
+    core/commands/ChildSupervisor.h \
     core/commands/Command.h \
     core/commands/CommandList.h \
-    core/commands/ShellCommand.h
+    core/commands/CommandScheduler.h \
+    core/commands/CommandTask.h \
+    core/commands/CommandTemplate.h \
+    core/commands/ExecutionPolicy.h \
+    core/commands/FuzzyKeyIndex.h \
+    core/commands/KeyDigest.h \
+    core/commands/KeyPatternMatcher.h \
+    core/commands/KeySet.h \
+    core/commands/MembershipCommand.h \
+    core/commands/PipelineCommand.h \
+    core/commands/ShellCommand.h \
+    core/commands/SocketCommand.h \
+    core/devices/DeviceMultiplexer.h \
+    core/devices/EpollBackend.h \
+    core/devices/IoUringBackend.h \
+    core/devices/KeyDecoder.h \
+    core/devices/MultiplexerBackend.h \
+    core/devices/ReconnectSupervisor.h
 
 SOURCES += \
+    appconfig/CardFormatSettings.cpp \
     appconfig/CommandLineParser.cpp \
+    appconfig/CommandSchedulerSettings.cpp \
+    appconfig/DecoderSettings.cpp \
+    appconfig/DeviceMultiplexerSettings.cpp \
+    appconfig/KeyMatchingSettings.cpp \
+    appconfig/ReconnectSettings.cpp \
     appconfig/RfidControllerSettings.cpp \
     appconfig/Settings.cpp \
     appconfig/SettingsCore.cpp \
     core/CommandListManager.cpp \
+    core/KeyEvent.cpp \
+    core/KeyId.cpp \
     core/NotificationType.cpp \
     core/RfidController.cpp \
     core/ServiceTypes.cpp \
+    core/StartupProfiler.cpp \
+    core/cards/CardNormalizer.cpp \
+    core/TimerWheel.cpp \
+    core/commands/BatchCommand.cpp \
+    core/commands/ChildSupervisor.cpp \
     core/commands/Command.cpp \
     core/commands/CommandList.cpp \
+    core/commands/CommandScheduler.cpp \
+    core/commands/CommandTask.cpp \
+    core/commands/CommandTemplate.cpp \
+    core/commands/ExecutionPolicy.cpp \
+    core/commands/FuzzyKeyIndex.cpp \
+    core/commands/KeyDigest.cpp \
+    core/commands/KeyPatternMatcher.cpp \
+    core/commands/KeySet.cpp \
+    core/commands/MembershipCommand.cpp \
+    core/commands/PipelineCommand.cpp \
     core/commands/ShellCommand.cpp \
+    core/commands/SocketCommand.cpp \
+    core/devices/DeviceMultiplexer.cpp \
+    core/devices/EpollBackend.cpp \
+    core/devices/IoUringBackend.cpp \
+    core/devices/KeyDecoder.cpp \
+    core/devices/ReconnectSupervisor.cpp \
     main.cpp
 
 DISTFILES += \
@@ -107,6 +177,7 @@ contains(DEFINES, SERIAL) {
     HEADERS += \
         appconfig/SerialDeviceManagerSettings.h \
         core/devices/SerialDevice.h \
+        core/serial/SerialBaudDetector.h \
         core/serial/SerialPortConfig.h \
         core/serial/SerialPortFilter.h \
         core/serial/SerialDeviceManager.h \
@@ -115,6 +186,7 @@ contains(DEFINES, SERIAL) {
     SOURCES += \
         appconfig/SerialDeviceManagerSettings.cpp \
         core/devices/SerialDevice.cpp \
+        core/serial/SerialBaudDetector.cpp \
         core/serial/SerialPortConfig.cpp \
         core/serial/SerialPortFilter.cpp \
         core/serial/SerialDeviceManager.cpp \
@@ -150,6 +222,40 @@ contains(DEFINES, LOG) {
         core/Logger.cpp
 }
 
+#
+# If we have metrics support enabled - we need these files
+#
+
+contains(DEFINES, METRICS) {
+
+    HEADERS += \
+        appconfig/MetricsSettings.h \
+        core/metrics/Metrics.h \
+        core/metrics/MetricsExporter.h \
+        core/metrics/MetricsRegistry.h
+
+    SOURCES += \
+        appconfig/MetricsSettings.cpp \
+        core/metrics/Metrics.cpp \
+        core/metrics/MetricsExporter.cpp \
+        core/metrics/MetricsRegistry.cpp
+}
+
+#
+# If we have tracing support enabled - we need these files
+#
+
+contains(DEFINES, TRACING) {
+
+    HEADERS += \
+        appconfig/TracingSettings.h \
+        core/tracing/Tracer.h
+
+    SOURCES += \
+        appconfig/TracingSettings.cpp \
+        core/tracing/Tracer.cpp
+}
+
 #
 # If we have GUI support enabled - we need these files
 #
@@ -160,21 +266,23 @@ contains(DEFINES, GUI) {
     HEADERS += \
         appconfig/MainWindowSettings.h \
         menus/NotificationTypeMenu.h \
+        models/CommandListFilterModel.h \
+        models/CommandListModel.h \
+        widgets/CommandItemDelegate.h \
+        widgets/CommandListWidget.h \
         widgets/Hex16BitSpinBox.h \
         widgets/MonitorWidget.h \
-        widgets/CommandEditWidget.h \
-        widgets/CommandListWidget.h \
-        widgets/ShellCommandEditWidget.h \
         windows/MainWindow.h
 
     SOURCES += \
         appconfig/MainWindowSettings.cpp \
         menus/NotificationTypeMenu.cpp \
+        models/CommandListFilterModel.cpp \
+        models/CommandListModel.cpp \
+        widgets/CommandItemDelegate.cpp \
+        widgets/CommandListWidget.cpp \
         widgets/Hex16BitSpinBox.cpp \
         widgets/MonitorWidget.cpp \
-        widgets/CommandEditWidget.cpp \
-        widgets/CommandListWidget.cpp \
-        widgets/ShellCommandEditWidget.cpp \
         windows/MainWindow.cpp
 
     # Some HID-related GUI files
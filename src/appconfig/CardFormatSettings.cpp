@@ -0,0 +1,63 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CardFormatSettings.h"
+
+#include "core/cards/CardNormalizer.h"
+
+CardFormatSettings* CardFormatSettings::theOne = nullptr;
+
+static const QLatin1String CARD_NORMALIZATION( "cards/normalize"   );
+static const QLatin1String PROX_BITS(          "cards/proxBits"    );
+static const QLatin1String REVERSE_UID(        "cards/reverseUid"  );
+
+void CardFormatSettings::_loadValues()
+{
+    m_cardNormalization = _value(CARD_NORMALIZATION,true).toBool();
+    m_proxBits = qBound(24,_value(PROX_BITS,32).toInt(),32);
+    m_reverseUid = _value(REVERSE_UID,false).toBool();
+}
+
+void CardFormatSettings::setCardNormalization(bool state)
+{
+    m_cardNormalization = state;
+    _setValue(CARD_NORMALIZATION,state);
+}
+
+void CardFormatSettings::setProxBits(int bits)
+{
+    m_proxBits = bits;
+    _setValue(PROX_BITS,bits);
+}
+
+void CardFormatSettings::setReverseUid(bool state)
+{
+    m_reverseUid = state;
+    _setValue(REVERSE_UID,state);
+}
+
+void CardFormatSettings::configureCardNormalizer(CardNormalizer* normalizer) const
+{
+    normalizer->setEnabled(m_cardNormalization);
+    normalizer->setProxBits(m_proxBits);
+    normalizer->setReverseUid(m_reverseUid);
+}
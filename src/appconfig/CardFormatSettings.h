@@ -0,0 +1,70 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CARDFORMATSETTINGS_H
+#define CARDFORMATSETTINGS_H
+
+#include "SettingsCore.h"
+
+class CardNormalizer;
+
+class CardFormatSettings : public virtual SettingsCore
+{
+public:
+    static CardFormatSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief If true - keys are converted to canonical card IDs before matching with commands */
+    bool      cardNormalization() const            { return m_cardNormalization; }
+    void      setCardNormalization(bool state);
+
+    /*! @brief Number of lower bits of proximity card numbers used for matching (24...32) */
+    int       proxBits() const                     { return m_proxBits; }
+    void      setProxBits(int bits);
+
+    /*! @brief If true - byte order of MIFARE UIDs is reversed */
+    bool      reverseUid() const                   { return m_reverseUid; }
+    void      setReverseUid(bool state);
+
+    /*! @brief Applies these settings to the CardNormalizer */
+    void      configureCardNormalizer(CardNormalizer* normalizer) const;
+
+protected:
+    CardFormatSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static CardFormatSettings* theOne;
+
+    bool      m_cardNormalization;
+    int       m_proxBits;
+    bool      m_reverseUid;
+};
+#define cardFormatSettings CardFormatSettings::get()
+
+#endif // CARDFORMATSETTINGS_H
@@ -25,7 +25,10 @@
 CommandLineParser::CommandLineParser() :
     m_configFile(       QStringList{ "c", "config"}           ),
     m_preserveConfig(   QStringList{ "p", "preserve-config" } ),
-    m_commandsFile(     QStringList{ "r", "commands" }        )
+    m_commandsFile(     QStringList{ "r", "commands" }        ),
+    m_startupProfile(   "startup-profile"                     ),
+    m_ioBackend(        "io-backend"                          ),
+    m_buildKeySet(      "build-key-set"                       )
 #ifdef GUI
     ,m_noGui(      "no-gui"       ),
     m_startHidden( "start-hidden" )
@@ -35,6 +38,14 @@ CommandLineParser::CommandLineParser() :
     ,m_logFile(         QStringList{ "l", "log"}              )
 #endif
 
+#ifdef METRICS
+    ,m_metricsFile(     "metrics"                             )
+#endif //METRICS
+
+#ifdef TRACING
+    ,m_traceFile(       "trace"                               )
+#endif //TRACING
+
 #ifdef HID
     ,m_inputVendorIds(       "hid-vendors"  ),
     m_inputProductIds(       "hid-products" )
@@ -76,6 +87,20 @@ CommandLineParser::CommandLineParser() :
     m_commandsFile.setDescription(tr("Commands <file> to open."));
     addOption(m_commandsFile);
 
+    // --startup-profile
+    m_startupProfile.setDescription(tr("Print timeline of startup phases when all devices are opened."));
+    addOption(m_startupProfile);
+
+    // --io-backend
+    m_ioBackend.setValueName("backend");
+    m_ioBackend.setDescription(tr("Read devices using <backend>: epoll (default) or io_uring."));
+    addOption(m_ioBackend);
+
+    // --build-key-set
+    m_buildKeySet.setValueName("file");
+    m_buildKeySet.setDescription(tr("Convert list of keys in <file> to image <file>.kset, which is loaded without parsing, and exit."));
+    addOption(m_buildKeySet);
+
     //
     // This part is needed only if we have GUI support enabled
     //
@@ -95,6 +120,20 @@ CommandLineParser::CommandLineParser() :
     addOption(m_logFile);
 #endif
 
+#ifdef METRICS
+    // / --metrics
+    m_metricsFile.setValueName("file");
+    m_metricsFile.setDescription(tr("Periodically write metrics in Prometheus text format to <file>."));
+    addOption(m_metricsFile);
+#endif //METRICS
+
+#ifdef TRACING
+    // / --trace
+    m_traceFile.setValueName("file");
+    m_traceFile.setDescription(tr("Write latency spans of the last taps to <file> on exit (Chrome trace format for *.json)."));
+    addOption(m_traceFile);
+#endif //TRACING
+
 #ifdef HID
     //
     // This part is needed only if we have GUI support enabled
@@ -53,12 +53,22 @@ public:
 
     QString             commandsFile() const     { return value(m_commandsFile); }
 
+    bool                startupProfile() const   { return isSet(m_startupProfile); }
+
+    QString             ioBackend() const        { return value(m_ioBackend); }
+
+    QString             buildKeySet() const      { return value(m_buildKeySet); }
+
 private:
     QCommandLineOption m_configFile;
     QCommandLineOption m_preserveConfig;
 
     QCommandLineOption m_commandsFile;
 
+    QCommandLineOption m_startupProfile;
+    QCommandLineOption m_ioBackend;
+    QCommandLineOption m_buildKeySet;
+
 #ifdef GUI
 //
 // This part is needed only if we have GUI support enabled
@@ -85,6 +95,30 @@ private:
     QCommandLineOption m_logFile;
 #endif
 
+#ifdef METRICS
+//
+// This part is needed only if we have metrics support enabled
+//
+
+public:
+    QString metricsFile() const                  { return value(m_metricsFile); }
+
+private:
+    QCommandLineOption m_metricsFile;
+#endif //METRICS
+
+#ifdef TRACING
+//
+// This part is needed only if we have tracing support enabled
+//
+
+public:
+    QString traceFile() const                    { return value(m_traceFile); }
+
+private:
+    QCommandLineOption m_traceFile;
+#endif //TRACING
+
 #ifdef HID
 //
 // This part is needed only if we have HID support enabled
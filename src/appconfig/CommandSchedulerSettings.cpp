@@ -0,0 +1,57 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandSchedulerSettings.h"
+
+#include "core/commands/CommandScheduler.h"
+
+CommandSchedulerSettings* CommandSchedulerSettings::theOne = nullptr;
+
+static const QLatin1String MAX_IN_FLIGHT(   "commands/maxInFlight"   );
+static const QLatin1String QUEUE_CAPACITY(  "commands/queueCapacity" );
+
+static const int DEFAULT_MAX_IN_FLIGHT = 0;
+static const int DEFAULT_QUEUE_CAPACITY = 1024;
+
+void CommandSchedulerSettings::_loadValues()
+{
+    m_commandsMaxInFlight = qMax(0,_value(MAX_IN_FLIGHT,DEFAULT_MAX_IN_FLIGHT).toInt());
+    m_commandsQueueCapacity = qMax(0,_value(QUEUE_CAPACITY,DEFAULT_QUEUE_CAPACITY).toInt());
+}
+
+void CommandSchedulerSettings::setCommandsMaxInFlight(int count)
+{
+    m_commandsMaxInFlight = count;
+    _setValue(MAX_IN_FLIGHT,count);
+}
+
+void CommandSchedulerSettings::setCommandsQueueCapacity(int count)
+{
+    m_commandsQueueCapacity = count;
+    _setValue(QUEUE_CAPACITY,count);
+}
+
+void CommandSchedulerSettings::configureCommandScheduler(CommandScheduler* scheduler) const
+{
+    scheduler->setMaxInFlight(m_commandsMaxInFlight);
+    scheduler->setQueueCapacity(m_commandsQueueCapacity);
+}
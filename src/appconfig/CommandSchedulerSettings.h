@@ -0,0 +1,66 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDSCHEDULERSETTINGS_H
+#define COMMANDSCHEDULERSETTINGS_H
+
+#include "SettingsCore.h"
+
+class CommandScheduler;
+
+class CommandSchedulerSettings : public virtual SettingsCore
+{
+public:
+    static CommandSchedulerSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief Maximal number of commands running at once, 0 - unlimited. Limits of single commands are set in the
+     *         command file, see ExecutionPolicy */
+    int       commandsMaxInFlight() const          { return m_commandsMaxInFlight; }
+    void      setCommandsMaxInFlight(int count);
+
+    /*! @brief Maximal number of invocations of all commands waiting to be started */
+    int       commandsQueueCapacity() const        { return m_commandsQueueCapacity; }
+    void      setCommandsQueueCapacity(int count);
+
+    /*! @brief Applies these settings to the CommandScheduler */
+    void      configureCommandScheduler(CommandScheduler* scheduler) const;
+
+protected:
+    CommandSchedulerSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static CommandSchedulerSettings* theOne;
+
+    int       m_commandsMaxInFlight;
+    int       m_commandsQueueCapacity;
+};
+#define commandSchedulerSettings CommandSchedulerSettings::get()
+
+#endif // COMMANDSCHEDULERSETTINGS_H
@@ -0,0 +1,57 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DecoderSettings.h"
+
+#include "core/devices/KeyDecoder.h"
+
+DecoderSettings* DecoderSettings::theOne = nullptr;
+
+static const QLatin1String KEY_TIMEOUT(          "decoder/keyTimeout"     );
+static const QLatin1String MAX_KEY_LENGTH(       "decoder/maxKeyLength"   );
+
+static const int DEFAULT_KEY_TIMEOUT    = 100;
+static const int DEFAULT_MAX_KEY_LENGTH = 64;
+
+void DecoderSettings::_loadValues()
+{
+    m_keyTimeout = qMax(1,_value(KEY_TIMEOUT,DEFAULT_KEY_TIMEOUT).toInt());
+    m_maxKeyLength = qBound(1,_value(MAX_KEY_LENGTH,DEFAULT_MAX_KEY_LENGTH).toInt(),KeyDecoder::CAPACITY);
+}
+
+void DecoderSettings::setKeyTimeout(int timeoutMs)
+{
+    m_keyTimeout = timeoutMs;
+    _setValue(KEY_TIMEOUT,timeoutMs);
+}
+
+void DecoderSettings::setMaxKeyLength(int length)
+{
+    m_maxKeyLength = length;
+    _setValue(MAX_KEY_LENGTH,length);
+}
+
+void DecoderSettings::configureKeyDecoder(KeyDecoder* decoder) const
+{
+    decoder->setTimeout(quint64(m_keyTimeout) * 1000 * 1000);
+    decoder->setMaximumLength(m_maxKeyLength);
+}
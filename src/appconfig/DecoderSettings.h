@@ -0,0 +1,65 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DECODERSETTINGS_H
+#define DECODERSETTINGS_H
+
+#include "SettingsCore.h"
+
+class KeyDecoder;
+
+class DecoderSettings : public virtual SettingsCore
+{
+public:
+    static DecoderSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief Maximal gap between two characters of one key in milliseconds */
+    int       keyTimeout() const            { return m_keyTimeout; }
+    void      setKeyTimeout(int timeoutMs);
+
+    /*! @brief Maximal length of the key. Longer keys are discarded */
+    int       maxKeyLength() const          { return m_maxKeyLength; }
+    void      setMaxKeyLength(int length);
+
+    /*! @brief Applies these settings to the KeyDecoder of some device */
+    void      configureKeyDecoder(KeyDecoder* decoder) const;
+
+protected:
+    DecoderSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static DecoderSettings* theOne;
+
+    int       m_keyTimeout;
+    int       m_maxKeyLength;
+};
+#define decoderSettings DecoderSettings::get()
+
+#endif // DECODERSETTINGS_H
@@ -20,29 +20,21 @@
  *
  */
 
-#include "CommandEditWidget.h"
+#include "DeviceMultiplexerSettings.h"
 
-#include "ShellCommandEditWidget.h"
+DeviceMultiplexerSettings* DeviceMultiplexerSettings::theOne = nullptr;
 
-CommandEditWidget::CommandEditWidget(QWidget *parent)
-    : QWidget{parent}
-{}
+static const QLatin1String IO_BACKEND(           "devices/ioBackend"      );
 
-void CommandEditWidget::setCurrentCommand(Command* command)
+void DeviceMultiplexerSettings::_loadValues()
 {
-    p_currentCommand = command;
-
-    _displayCommand(command);
+    const QString backendName = _value(IO_BACKEND,DeviceMultiplexer::backendName(DeviceMultiplexer::Epoll)).toString();
+    if (!DeviceMultiplexer::backendFromName(backendName,&m_ioBackend))
+        m_ioBackend = DeviceMultiplexer::Epoll;
 }
 
-CommandEditWidget* CommandEditWidget::create(Command::Type cmdType)
+void DeviceMultiplexerSettings::setIoBackend(DeviceMultiplexer::Backend backend)
 {
-    switch (cmdType) {
-    case Command::Shell:
-        return new ShellCommandEditWidget;
-    case Command::Unknown:
-        return nullptr;
-    }
-    Q_ASSERT(false);
-    return nullptr;
+    m_ioBackend = backend;
+    _setValue(IO_BACKEND,DeviceMultiplexer::backendName(backend));
 }
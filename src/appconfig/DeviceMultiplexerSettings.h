@@ -0,0 +1,57 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEVICEMULTIPLEXERSETTINGS_H
+#define DEVICEMULTIPLEXERSETTINGS_H
+
+#include "SettingsCore.h"
+
+#include "./core/devices/DeviceMultiplexer.h"
+
+class DeviceMultiplexerSettings : public virtual SettingsCore
+{
+public:
+    static DeviceMultiplexerSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief Backend used to read devices. If it is not available - epoll is used */
+    DeviceMultiplexer::Backend  ioBackend() const           { return m_ioBackend; }
+    void                        setIoBackend(DeviceMultiplexer::Backend backend);
+
+protected:
+    DeviceMultiplexerSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static DeviceMultiplexerSettings* theOne;
+
+    DeviceMultiplexer::Backend  m_ioBackend;
+};
+#define deviceMultiplexerSettings DeviceMultiplexerSettings::get()
+
+#endif // DEVICEMULTIPLEXERSETTINGS_H
@@ -0,0 +1,57 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyMatchingSettings.h"
+
+#include "core/commands/FuzzyKeyIndex.h"
+#include "core/commands/KeyDigest.h"
+
+KeyMatchingSettings* KeyMatchingSettings::theOne = nullptr;
+
+static const QLatin1String FUZZY_MATCHING( "matching/fuzzy"          );
+static const QLatin1String FUZZY_DISTANCE( "matching/fuzzyDistance"  );
+static const QLatin1String DIGEST_SECRET(  "matching/keyDigestSecret");
+
+void KeyMatchingSettings::_loadValues()
+{
+    m_fuzzyMatching = _value(FUZZY_MATCHING,false).toBool();
+    m_fuzzyDistance = qBound(1,_value(FUZZY_DISTANCE,1).toInt(),FuzzyKeyIndex::MAX_DISTANCE);
+
+    //With preserved config secret lives only until exit, so hashed files saved meanwhile can not be opened later
+    m_keyDigestSecret = QByteArray::fromHex(_value(DIGEST_SECRET).toString().toLatin1());
+    if (m_keyDigestSecret.isEmpty()) {
+        m_keyDigestSecret = KeyDigest::generateSecret();
+        _setValue(DIGEST_SECRET,QString::fromLatin1(m_keyDigestSecret.toHex()));
+    }
+}
+
+void KeyMatchingSettings::setFuzzyMatching(bool state)
+{
+    m_fuzzyMatching = state;
+    _setValue(FUZZY_MATCHING,state);
+}
+
+void KeyMatchingSettings::setFuzzyDistance(int distance)
+{
+    m_fuzzyDistance = qBound(1,distance,FuzzyKeyIndex::MAX_DISTANCE);
+    _setValue(FUZZY_DISTANCE,m_fuzzyDistance);
+}
@@ -0,0 +1,68 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYMATCHINGSETTINGS_H
+#define KEYMATCHINGSETTINGS_H
+
+#include "SettingsCore.h"
+
+class KeyMatchingSettings : public virtual SettingsCore
+{
+public:
+    static KeyMatchingSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief If true - keys, which match no command, are compared with keys of commands allowing few flipped bits */
+    bool      fuzzyMatching() const                { return m_fuzzyMatching; }
+    void      setFuzzyMatching(bool state);
+
+    /*! @brief Maximal number of flipped bits (1...FuzzyKeyIndex::MAX_DISTANCE) */
+    int       fuzzyDistance() const                { return m_fuzzyDistance; }
+    void      setFuzzyDistance(int distance);
+
+    /*! @brief Returns maximal number of flipped bits, or 0 if fuzzy matching is disabled */
+    int       fuzzyMatchingDistance() const        { return m_fuzzyMatching ? m_fuzzyDistance : 0; }
+
+    /*! @brief Secret of key digests in hashed command files (see KeyDigest). Generated and stored on the first start.
+     *         It is kept here and not in command files, so settings file should be readable only by its owner */
+    QByteArray keyDigestSecret() const             { return m_keyDigestSecret; }
+
+protected:
+    KeyMatchingSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static KeyMatchingSettings* theOne;
+
+    bool      m_fuzzyMatching;
+    int       m_fuzzyDistance;
+    QByteArray m_keyDigestSecret;
+};
+#define keyMatchingSettings KeyMatchingSettings::get()
+
+#endif // KEYMATCHINGSETTINGS_H
@@ -36,6 +36,8 @@ static const QLatin1String LOG_DETACHED(         "log/detachedDevices"    );
 static const QLatin1String LOG_OPENED(           "log/openedDevices"      );
 static const QLatin1String LOG_CLOSED(           "log/closedDevices"      );
 
+static const QLatin1String LOG_COMMANDS(         "log/commands"           );
+
 void LoggerSettings::_loadValues()
 {
     m_logFile = _value(LOG_FILE).toString();
@@ -50,6 +52,8 @@ void LoggerSettings::_loadValues()
 
     m_logAttachedDevices = _value(LOG_ATTACHED).toBool();
     m_logDetachedDevices = _value(LOG_DETACHED).toBool();
+
+    m_logCommands = _value(LOG_COMMANDS).toBool();
 }
 
 void LoggerSettings::setLogFile(const QString& logFile)
@@ -99,3 +103,9 @@ void LoggerSettings::setClosedDeviceLogging(bool state)
    m_logClosedDevices = state;
    _setValue(LOG_CLOSED,state);
 }
+
+void LoggerSettings::setCommandsLogging(bool state)
+{
+    m_logCommands = state;
+    _setValue(LOG_COMMANDS,state);
+}
@@ -57,6 +57,9 @@ public:
     bool      logClosedDevices() const      { return m_logClosedDevices; }
     void      setClosedDeviceLogging(bool state);
 
+    bool      logCommands() const           { return m_logCommands; }
+    void      setCommandsLogging(bool state);
+
 protected:
     LoggerSettings() {
         //Save this, so some other code parts can access only this specific part of settings
@@ -80,6 +83,8 @@ private:
 
     bool m_logOpenedDevices;
     bool m_logClosedDevices;
+
+    bool m_logCommands;
 };
 #define loggerSettings LoggerSettings::get()
 
@@ -25,10 +25,12 @@
 LoggerWidgetSettings* LoggerWidgetSettings::theOne = nullptr;
 
 static const QLatin1String LOG_TO_WIDGET(   "logWidget/logToWidget"  );
+static const QLatin1String MAX_LINE_COUNT(  "logWidget/maxLineCount" );
 
 void LoggerWidgetSettings::_loadValues()
 {
     m_logToWidget = _value(LOG_TO_WIDGET).toBool();
+    m_maxLineCount = qBound(MINIMAL_LINE_COUNT,_value(MAX_LINE_COUNT,5000).toInt(),MAXIMAL_LINE_COUNT);
 }
 
 void LoggerWidgetSettings::setLogToWidget(bool state)
@@ -36,3 +38,9 @@ void LoggerWidgetSettings::setLogToWidget(bool state)
     m_logToWidget = state;
     _setValue(LOG_TO_WIDGET,state);
 }
+
+void LoggerWidgetSettings::setMaxLineCount(int count)
+{
+    m_maxLineCount = qBound(MINIMAL_LINE_COUNT,count,MAXIMAL_LINE_COUNT);
+    _setValue(MAX_LINE_COUNT,m_maxLineCount);
+}
@@ -36,6 +36,15 @@ public:
     bool logToWidget() const { return m_logToWidget; }
     void setLogToWidget(bool state);
 
+    /*! @brief Bounds of maxLineCount, also used by the editor of LogWidget */
+    static const int MINIMAL_LINE_COUNT = 100;
+    static const int MAXIMAL_LINE_COUNT = 1000000;
+
+    /*! @brief Maximum number of lines, which are kept and displayed by LogWidget. Limited to
+     *         MINIMAL_LINE_COUNT...MAXIMAL_LINE_COUNT */
+    int  maxLineCount() const { return m_maxLineCount; }
+    void setMaxLineCount(int count);
+
 protected:
     LoggerWidgetSettings() {
         //Save this, so some other code parts can access only this specific part of settings
@@ -48,6 +57,7 @@ private:
     static LoggerWidgetSettings* theOne;
 
     bool m_logToWidget;
+    int  m_maxLineCount;
 };
 #define loggerWidgetSettings LoggerWidgetSettings::get()
 
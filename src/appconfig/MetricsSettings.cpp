@@ -0,0 +1,48 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MetricsSettings.h"
+
+MetricsSettings* MetricsSettings::theOne = nullptr;
+
+static const QLatin1String METRICS_FILE(         "metrics/file"           );
+static const QLatin1String METRICS_INTERVAL(     "metrics/exportInterval" );
+
+static const int DEFAULT_EXPORT_INTERVAL = 15;
+
+void MetricsSettings::_loadValues()
+{
+    m_metricsFile = _value(METRICS_FILE).toString();
+    m_metricsExportInterval = qMax(1,_value(METRICS_INTERVAL,DEFAULT_EXPORT_INTERVAL).toInt());
+}
+
+void MetricsSettings::setMetricsFile(const QString& fileName)
+{
+    m_metricsFile = fileName;
+    _setValue(METRICS_FILE,fileName);
+}
+
+void MetricsSettings::setMetricsExportInterval(int seconds)
+{
+    m_metricsExportInterval = seconds;
+    _setValue(METRICS_INTERVAL,seconds);
+}
@@ -0,0 +1,60 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICSSETTINGS_H
+#define METRICSSETTINGS_H
+
+#include "SettingsCore.h"
+
+class MetricsSettings : public virtual SettingsCore
+{
+public:
+    static MetricsSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief File, where metrics are exported in Prometheus text format. Empty - metrics are not exported */
+    QString   metricsFile() const           { return m_metricsFile; }
+    void      setMetricsFile(const QString& fileName);
+
+    /*! @brief Interval between metrics exports in seconds */
+    int       metricsExportInterval() const { return m_metricsExportInterval; }
+    void      setMetricsExportInterval(int seconds);
+
+protected:
+    MetricsSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static MetricsSettings* theOne;
+
+    QString   m_metricsFile;
+    int       m_metricsExportInterval;
+};
+#define metricsSettings MetricsSettings::get()
+
+#endif // METRICSSETTINGS_H
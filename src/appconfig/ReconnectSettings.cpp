@@ -0,0 +1,66 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ReconnectSettings.h"
+
+#include "core/devices/ReconnectSupervisor.h"
+
+ReconnectSettings* ReconnectSettings::theOne = nullptr;
+
+static const QLatin1String RECONNECT(               "devices/reconnect"             );
+static const QLatin1String RECONNECT_INITIAL_DELAY( "devices/reconnectInitialDelay" );
+static const QLatin1String RECONNECT_MAXIMUM_DELAY( "devices/reconnectMaximumDelay" );
+
+static const int DEFAULT_INITIAL_DELAY = 50;
+static const int DEFAULT_MAXIMUM_DELAY = 30000;
+
+void ReconnectSettings::_loadValues()
+{
+    m_deviceReconnection = _value(RECONNECT,true).toBool();
+    m_reconnectInitialDelay = qMax(1,_value(RECONNECT_INITIAL_DELAY,DEFAULT_INITIAL_DELAY).toInt());
+    m_reconnectMaximumDelay = qMax(m_reconnectInitialDelay,_value(RECONNECT_MAXIMUM_DELAY,DEFAULT_MAXIMUM_DELAY).toInt());
+}
+
+void ReconnectSettings::setDeviceReconnection(bool state)
+{
+    m_deviceReconnection = state;
+    _setValue(RECONNECT,state);
+}
+
+void ReconnectSettings::setReconnectInitialDelay(int delayMs)
+{
+    m_reconnectInitialDelay = delayMs;
+    _setValue(RECONNECT_INITIAL_DELAY,delayMs);
+}
+
+void ReconnectSettings::setReconnectMaximumDelay(int delayMs)
+{
+    m_reconnectMaximumDelay = delayMs;
+    _setValue(RECONNECT_MAXIMUM_DELAY,delayMs);
+}
+
+void ReconnectSettings::configureReconnectSupervisor(ReconnectSupervisor* supervisor) const
+{
+    supervisor->setEnabled(m_deviceReconnection);
+    supervisor->setInitialDelay(quint64(m_reconnectInitialDelay) * 1000 * 1000);
+    supervisor->setMaximumDelay(quint64(m_reconnectMaximumDelay) * 1000 * 1000);
+}
@@ -0,0 +1,70 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RECONNECTSETTINGS_H
+#define RECONNECTSETTINGS_H
+
+#include "SettingsCore.h"
+
+class ReconnectSupervisor;
+
+class ReconnectSettings : public virtual SettingsCore
+{
+public:
+    static ReconnectSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief If true - devices closed because of errors are reopened automatically */
+    bool      deviceReconnection() const           { return m_deviceReconnection; }
+    void      setDeviceReconnection(bool state);
+
+    /*! @brief Delay before the first reconnection attempt in milliseconds */
+    int       reconnectInitialDelay() const        { return m_reconnectInitialDelay; }
+    void      setReconnectInitialDelay(int delayMs);
+
+    /*! @brief Upper limit of the delay between reconnection attempts in milliseconds */
+    int       reconnectMaximumDelay() const        { return m_reconnectMaximumDelay; }
+    void      setReconnectMaximumDelay(int delayMs);
+
+    /*! @brief Applies these settings to the ReconnectSupervisor of some device manager */
+    void      configureReconnectSupervisor(ReconnectSupervisor* supervisor) const;
+
+protected:
+    ReconnectSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static ReconnectSettings* theOne;
+
+    bool      m_deviceReconnection;
+    int       m_reconnectInitialDelay;
+    int       m_reconnectMaximumDelay;
+};
+#define reconnectSettings ReconnectSettings::get()
+
+#endif // RECONNECTSETTINGS_H
@@ -30,10 +30,25 @@ void RfidControllerSettings::_loadValues()
 {
     m_openedCommandsFileName = _value(OPENED_FILE).toString();
 
+    CardFormatSettings::_loadValues();
+    CommandSchedulerSettings::_loadValues();
+    DecoderSettings::_loadValues();
+    DeviceMultiplexerSettings::_loadValues();
+    KeyMatchingSettings::_loadValues();
+    ReconnectSettings::_loadValues();
+
 #ifdef LOG
     LoggerSettings::_loadValues();
 #endif //LOG
 
+#ifdef METRICS
+    MetricsSettings::_loadValues();
+#endif //METRICS
+
+#ifdef TRACING
+    TracingSettings::_loadValues();
+#endif //TRACING
+
 #ifdef HID
     InputDeviceManagerSettings::_loadValues();
 #endif //HID
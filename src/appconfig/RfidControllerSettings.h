@@ -24,6 +24,12 @@
 #define RFIDCONTROLLERSETTINGS_H
 
 #include "./SettingsCore.h"
+#include "./CardFormatSettings.h"
+#include "./CommandSchedulerSettings.h"
+#include "./DecoderSettings.h"
+#include "./DeviceMultiplexerSettings.h"
+#include "./KeyMatchingSettings.h"
+#include "./ReconnectSettings.h"
 
 #ifdef HID
     #include "./InputDeviceManagerSettings.h"
@@ -37,7 +43,21 @@
     #include "./LoggerSettings.h"
 #endif
 
+#ifdef METRICS
+    #include "./MetricsSettings.h"
+#endif //METRICS
+
+#ifdef TRACING
+    #include "./TracingSettings.h"
+#endif //TRACING
+
 class RfidControllerSettings : public virtual SettingsCore
+    ,public virtual CardFormatSettings
+    ,public virtual CommandSchedulerSettings
+    ,public virtual DecoderSettings
+    ,public virtual DeviceMultiplexerSettings
+    ,public virtual KeyMatchingSettings
+    ,public virtual ReconnectSettings
 #ifdef HID
     ,public virtual InputDeviceManagerSettings
 #endif //HID
@@ -47,6 +67,12 @@ class RfidControllerSettings : public virtual SettingsCore
 #ifdef LOG
     ,public virtual LoggerSettings
 #endif //LOG
+#ifdef METRICS
+    ,public virtual MetricsSettings
+#endif //METRICS
+#ifdef TRACING
+    ,public virtual TracingSettings
+#endif //TRACING
 {
 public:
     static RfidControllerSettings* get() {
@@ -22,11 +22,23 @@
 
 #include "SerialDeviceManagerSettings.h"
 
+#include <QDebug>
+
 static const QLatin1String DEFAULT_BAUD_RATE(    "serial/defaultBaudRate"      );
 static const QLatin1String DEFAULT_DATA_BITS(    "serial/defaultDataBits"      );
 static const QLatin1String DEFAULT_FLOW_CONTROL( "serial/defaultFlowControl"   );
 static const QLatin1String DEFAULT_PARITY(       "serial/defaultParity"        );
 static const QLatin1String DEFAULT_STOP_BITS(    "serial/defaultStopBits"      );
+static const QLatin1String DEFAULT_BACKEND(      "serial/defaultBackend"       );
+static const QLatin1String DEFAULT_READ_MINIMUM( "serial/defaultReadMinimum"   );
+static const QLatin1String DEFAULT_READ_TIMEOUT( "serial/defaultReadTimeout"   );
+static const QLatin1String DEFAULT_LOW_LATENCY(  "serial/defaultLowLatency"    );
+static const QLatin1String DEFAULT_BUFFER_SIZE(  "serial/defaultReadBufferSize");
+
+static const QLatin1String AUTODETECT_BAUD_RATE( "serial/autodetectBaudRate" );
+static const QLatin1String BAUD_RATE_CANDIDATES( "serial/baudRateCandidates");
+static const QLatin1String PORT_NAME_PROFILES(   "serial/profiles/port/"     );
+static const QLatin1String USB_PROFILES(         "serial/profiles/usb/"      );
 
 static const QLatin1String SERIAL_AUTOCONNECT(   "serial/autoconnect");
 static const QLatin1String SERIAL_PORT_NAMES(    "serial/portNames");
@@ -37,11 +49,36 @@ SerialDeviceManagerSettings* SerialDeviceManagerSettings::theOne = nullptr;
 
 void SerialDeviceManagerSettings::_loadValues()
 {
-    m_serialPortConfig.setBaudRate(_value(DEFAULT_BAUD_RATE,QSerialPort::Baud9600).value<QSerialPort::BaudRate>());
+    const QSerialPort::BaudRate baudRate = _value(DEFAULT_BAUD_RATE,QSerialPort::Baud9600).value<QSerialPort::BaudRate>();
+    if (SerialPortConfig::isSupportedBaudRate(baudRate)) {
+        m_serialPortConfig.setBaudRate(baudRate);
+    } else {
+        qWarning() << "Unsupported default baud rate"<<baudRate<<"; 9600 is used";
+        m_serialPortConfig.setBaudRate(QSerialPort::Baud9600);
+    }
     m_serialPortConfig.setDataBits(_value(DEFAULT_DATA_BITS,QSerialPort::Data5).value<QSerialPort::DataBits>());
     m_serialPortConfig.setFlowControl(_value(DEFAULT_FLOW_CONTROL,QSerialPort::SoftwareControl).value<QSerialPort::FlowControl>());
     m_serialPortConfig.setParity(_value(DEFAULT_PARITY,QSerialPort::NoParity).value<QSerialPort::Parity>());
     m_serialPortConfig.setStopBits(_value(DEFAULT_STOP_BITS,QSerialPort::OneStop).value<QSerialPort::StopBits>());
+    m_serialPortConfig.setBackend(static_cast<SerialPortConfig::Backend>(
+                                      _value(DEFAULT_BACKEND,SerialPortConfig::QtSerialPortBackend).toInt()));
+    m_serialPortConfig.setReadMinimum(_value(DEFAULT_READ_MINIMUM,1).toInt());
+    m_serialPortConfig.setReadTimeout(_value(DEFAULT_READ_TIMEOUT,0).toInt());
+    m_serialPortConfig.setLowLatency(_value(DEFAULT_LOW_LATENCY,true).toBool());
+    m_serialPortConfig.setReadBufferSize(_value(DEFAULT_BUFFER_SIZE,256).toInt());
+
+    m_baudRateAutodetection = _value(AUTODETECT_BAUD_RATE,true).toBool();
+    m_baudRateCandidates.clear();
+    const QStringList candidates = _value(BAUD_RATE_CANDIDATES,"115200,57600,38400,19200,9600,4800,2400,1200")
+            .toString().split(',');
+    for (const QString& candidate : candidates) {
+        const int rate = candidate.trimmed().toInt();
+        if (SerialPortConfig::isSupportedBaudRate(rate)) {
+            m_baudRateCandidates.append(static_cast<QSerialPort::BaudRate>(rate));
+        } else if (!candidate.trimmed().isEmpty()) {
+            qWarning() << "Unsupported baud rate candidate"<<candidate<<"is ignored";
+        }
+    }
 
     m_serialDeviceAutoconnection = _value(SERIAL_AUTOCONNECT).toBool();
 
@@ -58,6 +95,78 @@ void SerialDeviceManagerSettings::setDefaultSerialPortCongiguration(const Serial
     _setValue(DEFAULT_FLOW_CONTROL,params.flowControl());
     _setValue(DEFAULT_PARITY,params.parity());
     _setValue(DEFAULT_STOP_BITS,params.stopBits());
+    _setValue(DEFAULT_BACKEND,params.backend());
+    _setValue(DEFAULT_READ_MINIMUM,params.readMinimum());
+    _setValue(DEFAULT_READ_TIMEOUT,params.readTimeout());
+    _setValue(DEFAULT_LOW_LATENCY,params.lowLatency());
+    _setValue(DEFAULT_BUFFER_SIZE,params.readBufferSize());
+}
+
+SerialPortConfig SerialDeviceManagerSettings::serialPortConfiguration(const QSerialPortInfo& portInfo) const
+{
+    SerialPortConfig result = m_serialPortConfig;
+
+    const QString profile = _serialPortProfile(portInfo);
+    if (profile.isEmpty()) {
+        result.setAutodetectBaudRate(m_baudRateAutodetection);
+        return result;
+    }
+
+    if (!result.applyProfileString(profile)) {
+        qWarning() << "Malformed serial profile"<<profile<<"for port"<<portInfo.portName()<<"; default configuration used";
+        result.setAutodetectBaudRate(m_baudRateAutodetection);
+    }
+
+    return result;
+}
+
+bool SerialDeviceManagerSettings::hasSerialPortProfile(const QSerialPortInfo& portInfo) const
+{
+    return !_serialPortProfile(portInfo).isEmpty();
+}
+
+void SerialDeviceManagerSettings::setPortNameProfile(const QString& portName, const SerialPortConfig& config)
+{
+    _setValue(QString(PORT_NAME_PROFILES) + portName,config.toProfileString());
+}
+
+void SerialDeviceManagerSettings::setUsbProfile(quint16 vendorId, quint16 productId, const SerialPortConfig& config)
+{
+    _setValue(QString("%1%2_%3").arg(USB_PROFILES)
+              .arg(vendorId,4,16,QLatin1Char('0')).arg(productId,4,16,QLatin1Char('0')),
+              config.toProfileString());
+}
+
+void SerialDeviceManagerSettings::setBaudRateAutodetection(bool state)
+{
+    m_baudRateAutodetection = state;
+    _setValue(AUTODETECT_BAUD_RATE,state);
+}
+
+QList<QSerialPort::BaudRate> SerialDeviceManagerSettings::baudRateCandidates() const
+{
+    //Most of the ports keep using default settings, so it is tried first
+    QList<QSerialPort::BaudRate> result{ m_serialPortConfig.baudRate() };
+    for (QSerialPort::BaudRate rate : m_baudRateCandidates) {
+        if (!result.contains(rate))
+            result.append(rate);
+    }
+
+    return result;
+}
+
+QString SerialDeviceManagerSettings::_serialPortProfile(const QSerialPortInfo& portInfo) const
+{
+    const QString portProfile = _value(QString(PORT_NAME_PROFILES) + portInfo.portName()).toString();
+    if (!portProfile.isEmpty())
+        return portProfile;
+
+    if (!portInfo.hasVendorIdentifier() || !portInfo.hasProductIdentifier())
+        return QString();
+
+    return _value(QString("%1%2_%3").arg(USB_PROFILES)
+                  .arg(portInfo.vendorIdentifier(),4,16,QLatin1Char('0'))
+                  .arg(portInfo.productIdentifier(),4,16,QLatin1Char('0'))).toString();
 }
 
 void SerialDeviceManagerSettings::setSerialDeviceAutoconnection(bool state)
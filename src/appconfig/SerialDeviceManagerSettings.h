@@ -26,6 +26,7 @@
 #include "./SettingsCore.h"
 
 #include <QSerialPort>
+#include <QSerialPortInfo>
 
 #include "./core/serial/SerialPortConfig.h"
 #include "./core/serial/SerialPortFilter.h"
@@ -41,6 +42,20 @@ public:
     SerialPortConfig    defaultSerialPortConfiguration() const { return m_serialPortConfig; }
     void                setDefaultSerialPortCongiguration(const SerialPortConfig& params);
 
+    /*! @brief Returns configuration for the port. Profile of the port name has priority over profile of the VID:PID,
+     *         if port has no profile - default configuration is used (with baud rate detection, if it is enabled) */
+    SerialPortConfig    serialPortConfiguration(const QSerialPortInfo& portInfo) const;
+    bool                hasSerialPortProfile(const QSerialPortInfo& portInfo) const;
+    void                setPortNameProfile(const QString& portName, const SerialPortConfig& config);
+    void                setUsbProfile(quint16 vendorId, quint16 productId, const SerialPortConfig& config);
+
+    /*! @brief If true - baud rate of ports without profile is detected from the received frames */
+    bool                baudRateAutodetection() const      { return m_baudRateAutodetection; }
+    void                setBaudRateAutodetection(bool state);
+
+    /*! @brief Baud rates tried by the detection. Default baud rate is always the first one */
+    QList<QSerialPort::BaudRate> baudRateCandidates() const;
+
     bool                serialDeviceAutoconnection() const { return m_serialDeviceAutoconnection; }
     void                setSerialDeviceAutoconnection(bool state);
 
@@ -58,7 +73,11 @@ protected:
 private:
     static SerialDeviceManagerSettings* theOne;
 
+    QString             _serialPortProfile(const QSerialPortInfo& portInfo) const;
+
     SerialPortConfig    m_serialPortConfig;
+    bool                m_baudRateAutodetection;
+    QList<QSerialPort::BaudRate> m_baudRateCandidates;
     bool                m_serialDeviceAutoconnection;
     SerialPortFilter    m_serialPortFilter;
 };
@@ -22,6 +22,8 @@
 
 #include "Settings.h"
 
+#include <QDebug>
+
 void Settings::applyCommandLineParameters(const CommandLineParser& parser)
 {
     if (parser.preserveConfig())
@@ -30,11 +32,30 @@ void Settings::applyCommandLineParameters(const CommandLineParser& parser)
     if (!parser.commandsFile().isEmpty())
         setOpenedCommandsFileName(parser.commandsFile());
 
+    if (!parser.ioBackend().isEmpty()) {
+        DeviceMultiplexer::Backend ioBackend;
+        if (DeviceMultiplexer::backendFromName(parser.ioBackend(),&ioBackend)) {
+            setIoBackend(ioBackend);
+        } else {
+            qWarning() << "Unknown I/O backend:" << parser.ioBackend();
+        }
+    }
+
 #ifdef LOG
     if (!parser.logFile().isEmpty())
         setLogFile(parser.logFile());
 #endif //LOG
 
+#ifdef METRICS
+    if (!parser.metricsFile().isEmpty())
+        setMetricsFile(parser.metricsFile());
+#endif //METRICS
+
+#ifdef TRACING
+    if (!parser.traceFile().isEmpty())
+        setTraceFile(parser.traceFile());
+#endif //TRACING
+
 #ifdef HID
     if (parser.inputDeviceFilterConfigured())
         appendInputDeviceFilter(parser.inputDeviceFilter());
@@ -0,0 +1,48 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TracingSettings.h"
+
+TracingSettings* TracingSettings::theOne = nullptr;
+
+static const QLatin1String TRACE_FILE(           "tracing/file"           );
+static const QLatin1String TRACE_CAPACITY(       "tracing/capacity"       );
+
+static const int DEFAULT_TRACE_CAPACITY = 4096;
+
+void TracingSettings::_loadValues()
+{
+    m_traceFile = _value(TRACE_FILE).toString();
+    m_traceCapacity = qMax(1,_value(TRACE_CAPACITY,DEFAULT_TRACE_CAPACITY).toInt());
+}
+
+void TracingSettings::setTraceFile(const QString& fileName)
+{
+    m_traceFile = fileName;
+    _setValue(TRACE_FILE,fileName);
+}
+
+void TracingSettings::setTraceCapacity(int capacity)
+{
+    m_traceCapacity = capacity;
+    _setValue(TRACE_CAPACITY,capacity);
+}
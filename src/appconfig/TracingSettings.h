@@ -0,0 +1,60 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRACINGSETTINGS_H
+#define TRACINGSETTINGS_H
+
+#include "SettingsCore.h"
+
+class TracingSettings : public virtual SettingsCore
+{
+public:
+    static TracingSettings* get() {
+        Q_ASSERT(theOne != nullptr);
+        return theOne;
+    }
+
+    /*! @brief File, where recorded spans are written when application exits. Empty - spans are not written */
+    QString   traceFile() const             { return m_traceFile; }
+    void      setTraceFile(const QString& fileName);
+
+    /*! @brief Number of the last spans, which are kept in memory */
+    int       traceCapacity() const         { return m_traceCapacity; }
+    void      setTraceCapacity(int capacity);
+
+protected:
+    TracingSettings() {
+        //Save this, so some other code parts can access only this specific part of settings
+        Q_ASSERT(theOne == nullptr);
+        theOne = this;
+    }
+    void _loadValues();
+
+private:
+    static TracingSettings* theOne;
+
+    QString   m_traceFile;
+    int       m_traceCapacity;
+};
+#define tracingSettings TracingSettings::get()
+
+#endif // TRACINGSETTINGS_H
@@ -28,13 +28,22 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QtConcurrent>
 
 #include "core/commands/CommandList.h"
+#include "core/commands/MembershipCommand.h"
+
+static const int KEY_SET_RELOAD_DELAY = 500;
 
 CommandsListManager::CommandsListManager(QObject* parent)
        : QObject(parent),p_currentCommandList(nullptr)
 {
     connect(&m_fileWatcher,&QFileSystemWatcher::fileChanged,this,&CommandsListManager::_fileChangedWatcherSignal);
+    connect(&m_keySetWatcher,&QFileSystemWatcher::fileChanged,this,&CommandsListManager::_keySetFileChanged);
+
+    m_keySetReloadTimer.setSingleShot(true);
+    m_keySetReloadTimer.setInterval(KEY_SET_RELOAD_DELAY);
+    connect(&m_keySetReloadTimer,&QTimer::timeout,this,&CommandsListManager::_reloadChangedKeySets);
 }
 
 CommandsListManager::~CommandsListManager()
@@ -82,7 +91,7 @@ void CommandsListManager::reloadCurrentCommandFile()
     _setCurrentCommandList(newCommands);
 }
 
-void CommandsListManager::saveCurrentCommandsListAs(const QString& fileName)
+void CommandsListManager::saveCurrentCommandsListAs(const QString& fileName, bool hashKeys)
 {
     QFile file(fileName);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -94,8 +103,25 @@ void CommandsListManager::saveCurrentCommandsListAs(const QString& fileName)
     QJsonDocument jsonDoc;
     QJsonArray commandArray;
 
+    //Commands added to the hashed file are hashed as well
+    const bool hashedFile = hashKeys || p_currentCommandList->hasDigestCommands();
+    if (hashedFile && m_keyDigestSecret.isEmpty()) {
+        emit errorMessage(tr("Keys of file %1 can not be hashed, as no secret for key digests is configured.")
+                          .arg(fileName));
+        return;
+    }
+
+    if (hashedFile)
+        p_currentCommandList->hashKeys();
+
     QJsonObject rootObject;
     rootObject["commands"] = p_currentCommandList->toJsonArray();
+    if (hashedFile) {
+        rootObject["keyDigest"] = QJsonObject({
+            { "algorithm",   "hmac-sha256" },
+            { "secretId",    QString::fromLatin1(p_currentCommandList->keyDigestSecretId().toHex()) }
+        });
+    }
 
     jsonDoc.setObject(rootObject);
 
@@ -110,12 +136,41 @@ void CommandsListManager::saveCurrentCommandsListAs(const QString& fileName)
     return;
 }
 
+void CommandsListManager::setKeyDigestSecret(const QByteArray& secret)
+{
+    m_keyDigestSecret = secret;
+    if (p_currentCommandList != nullptr)
+        p_currentCommandList->setKeyDigestSecret(secret);
+}
+
 void CommandsListManager::closeCurrentFile()
 {
     _setCurrentCommandList(nullptr);
     _setCurrentFilePath(QString());
 }
 
+void CommandsListManager::reloadKeySets(const QString& fileName)
+{
+    if (p_currentCommandList == nullptr)
+        return;
+
+    QSet<QString> fileNames;
+    for (MembershipCommand* cmd : p_currentCommandList->membershipCommands()) {
+        if (fileName.isEmpty() || cmd->keySetFile() == fileName)
+            fileNames.insert(cmd->keySetFile());
+    }
+
+    //Loading plain list of millions of keys takes seconds, keys are dispatched with previous sets meanwhile
+    for (const QString& keySetFile : qAsConst(fileNames)) {
+        QFutureWatcher<KeySetLoadResult>* watcher = new QFutureWatcher<KeySetLoadResult>(this);
+        connect(watcher,&QFutureWatcher<KeySetLoadResult>::finished,this,[this,watcher](){
+            _setKeySet(watcher->result(),p_currentCommandList);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&CommandsListManager::_loadKeySet,keySetFile));
+    }
+}
+
 void CommandsListManager::_fileChangedWatcherSignal(const QString& filePath)
 {
     if (!QFile::exists(filePath)) {
@@ -131,6 +186,36 @@ void CommandsListManager::_fileChangedWatcherSignal(const QString& filePath)
     }
 }
 
+void CommandsListManager::_keySetFileChanged(const QString& filePath)
+{
+    //Files replaced by renaming are removed from the watcher
+    if (QFile::exists(filePath) && !m_keySetWatcher.files().contains(filePath))
+        m_keySetWatcher.addPath(filePath);
+
+    m_changedKeySetFiles.insert(filePath);
+    m_keySetReloadTimer.start();
+}
+
+void CommandsListManager::_reloadChangedKeySets()
+{
+    for (const QString& fileName : qAsConst(m_changedKeySetFiles)) {
+        if (QFile::exists(fileName))
+            reloadKeySets(fileName);
+    }
+    m_changedKeySetFiles.clear();
+}
+
+void CommandsListManager::_commandChanged(Command* cmd)
+{
+    //File of the set was changed by the user
+    MembershipCommand* membershipCommand = cmd->to<MembershipCommand>();
+    if (membershipCommand == nullptr || !membershipCommand->keySet().isNull())
+        return;
+
+    _watchKeySetFiles();
+    reloadKeySets(membershipCommand->keySetFile());
+}
+
 CommandList* CommandsListManager::_createCommandListFromFile(const QString& filePath)
 {
     QFile file(filePath);
@@ -160,7 +245,82 @@ CommandList* CommandsListManager::_createCommandListFromFile(const QString& file
 
     QJsonArray commandsArray = fileObject["commands"].toArray();
 
-    return CommandList::fromJsonArray(commandsArray);
+    if (fileObject.contains("keyDigest")) {
+        const QJsonObject digestObject = fileObject["keyDigest"].toObject();
+        if (digestObject["algorithm"].toString() != QLatin1String("hmac-sha256")) {
+            emit errorMessage(tr("File %1 contains hashed keys of unsupported format.").arg(filePath));
+            return nullptr;
+        }
+
+        //Digests made with another secret would silently match nothing
+        const QByteArray secretId = QByteArray::fromHex(digestObject["secretId"].toString().toLatin1());
+        if (m_keyDigestSecret.isEmpty() || secretId != KeyDigest(m_keyDigestSecret).secretId()) {
+            emit errorMessage(tr("Keys of file %1 were hashed with another secret. Copy the secret from settings of "
+                                 "the application, which has saved this file.").arg(filePath));
+            return nullptr;
+        }
+    }
+
+    CommandList* result = CommandList::fromJsonArray(commandsArray);
+    result->setKeyDigestSecret(m_keyDigestSecret);
+    _loadKeySets(result);
+    return result;
+}
+
+CommandsListManager::KeySetLoadResult CommandsListManager::_loadKeySet(const QString& fileName)
+{
+    KeySetLoadResult result;
+    result.fileName = fileName;
+
+    QSharedPointer<KeySet> keySet(new KeySet);
+    if (keySet->load(fileName,&result.errorString))
+        result.keySet = keySet;
+
+    return result;
+}
+
+void CommandsListManager::_loadKeySets(CommandList* list)
+{
+    //Commands using the same file share one set, commands are usable as soon as the list is loaded
+    QSet<QString> fileNames;
+    for (MembershipCommand* cmd : list->membershipCommands())
+        fileNames.insert(cmd->keySetFile());
+
+    for (const QString& fileName : qAsConst(fileNames))
+        _setKeySet(_loadKeySet(fileName),list);
+}
+
+void CommandsListManager::_setKeySet(const KeySetLoadResult& result, CommandList* list)
+{
+    if (result.keySet.isNull()) {
+        emit errorMessage(result.errorString);
+        return;
+    }
+
+    if (result.keySet->invalidCount() > 0)
+        qWarning() << result.keySet->invalidCount() << "invalid keys were skipped in" << result.fileName;
+
+    if (list == nullptr)
+        return;
+
+    for (MembershipCommand* cmd : list->membershipCommands()) {
+        if (cmd->keySetFile() == result.fileName)
+            cmd->setKeySet(result.keySet);
+    }
+}
+
+void CommandsListManager::_watchKeySetFiles()
+{
+    if (!m_keySetWatcher.files().isEmpty())
+        m_keySetWatcher.removePaths(m_keySetWatcher.files());
+
+    if (p_currentCommandList == nullptr)
+        return;
+
+    for (MembershipCommand* cmd : p_currentCommandList->membershipCommands()) {
+        if (QFile::exists(cmd->keySetFile()) && !m_keySetWatcher.files().contains(cmd->keySetFile()))
+            m_keySetWatcher.addPath(cmd->keySetFile());
+    }
 }
 
 void CommandsListManager::_setCurrentCommandList(CommandList* newList)
@@ -169,6 +329,12 @@ void CommandsListManager::_setCurrentCommandList(CommandList* newList)
         p_currentCommandList->deleteLater();
 
     p_currentCommandList = newList;
+    if (p_currentCommandList != nullptr) {
+        p_currentCommandList->setKeyDigestSecret(m_keyDigestSecret);
+        connect(p_currentCommandList,&CommandList::commandChanged,this,&CommandsListManager::_commandChanged);
+    }
+    _watchKeySetFiles();
+
     emit commandListChanged(p_currentCommandList);
 }
 
@@ -27,8 +27,13 @@
 #include <QFileDevice>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
 
+class Command;
 class CommandList;
+class KeySet;
 
 /*!
  *  @class CommandsListManager core/CommandsListManager.h
@@ -52,12 +57,23 @@ public:
     /*! @brief Reloads CommandList from currently opened file */
     void      reloadCurrentCommandFile();
 
-    /*! @brief Saves current CommandList as fileName */
-    void      saveCurrentCommandsListAs(const QString& fileName);
+    /*! @brief Saves current CommandList as fileName. If hashKeys is true, or the list already has hashed keys - keys
+     *         are replaced with keyed digests (see CommandList::hashKeys), so plain files can be converted. File gets
+     *         only id of the secret, not the secret itself */
+    void      saveCurrentCommandsListAs(const QString& fileName, bool hashKeys = false);
+
+    /*! @brief Secret used for key digests of all command lists (see KeyDigest). Files hashed with another secret are
+     *         not opened. Should be set before the first file is opened */
+    void      setKeyDigestSecret(const QByteArray& secret);
 
     /*! @brief Deletes current CommandList and closes current file */
     void      closeCurrentFile();
 
+    /*! @brief Reloads sets of keys of MembershipCommand objects (all, or only loaded from fileName) on worker thread.
+     *         Commands keep using previous sets, until new ones are loaded. Sets are also reloaded, when their files
+     *         are changed on disk */
+    void      reloadKeySets(const QString& fileName = QString());
+
     /*! @brief Returns true if any file is opened and current CommandList was loaded from it. */
     bool      fileOpened() const { return ( !m_currentFileInfo.fileName().isEmpty() ) && ( m_currentFileInfo.fileName() != defaultNewFileName() ); }
 
@@ -88,12 +104,30 @@ signals:
 
 private slots:
     void _fileChangedWatcherSignal(const QString& filePath);
+    void _keySetFileChanged(const QString& filePath);
+    void _reloadChangedKeySets();
+    void _commandChanged(Command* cmd);
 
 private:
     CommandList*   _createCommandListFromFile(const QString& fileName);
 
+    struct KeySetLoadResult {
+        QString                        fileName;
+        QSharedPointer<const KeySet>   keySet;
+        QString                        errorString;
+    };
+
+    static KeySetLoadResult _loadKeySet(const QString& fileName);
+    void           _loadKeySets(CommandList* list);
+    void           _setKeySet(const KeySetLoadResult& result, CommandList* list);
+    void           _watchKeySetFiles();
+    QFileSystemWatcher  m_keySetWatcher;
+    QTimer              m_keySetReloadTimer;          //!< @brief Files are often written in several steps
+    QSet<QString>       m_changedKeySetFiles;
+
     void           _setCurrentCommandList(CommandList* newList);
     CommandList*   p_currentCommandList;
+    QByteArray     m_keyDigestSecret;
 
     void                _setCurrentFilePath(const QString& fileName);
     QFileSystemWatcher  m_fileWatcher;
@@ -0,0 +1,88 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyEvent.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <string.h>
+
+static std::atomic<quint64> lastTraceId{0};
+
+KeyEvent::KeyEvent()
+    : m_keyLength(0),m_vendorId(0),m_productId(0),m_traceId(0),m_timestamp(0),m_decodedAt(0)
+{}
+
+KeyEvent::KeyEvent(const char* key, int length, quint64 timestamp, const QString& source)
+    : m_source(source),m_vendorId(0),m_productId(0)
+{
+    _init(key,length,timestamp);
+}
+
+KeyEvent::KeyEvent(const QString& key, quint64 timestamp, const QString& source)
+    : m_source(source),m_vendorId(0),m_productId(0)
+{
+    const QByteArray latin1 = key.toLatin1();
+    _init(latin1.constData(),latin1.size(),timestamp);
+}
+
+void KeyEvent::_init(const char* key, int length, quint64 timestamp)
+{
+    m_keyLength = qBound(0,length,MAX_KEY_LENGTH);
+    memcpy(m_keyData,key,m_keyLength);
+    m_keyId = KeyId::fromBytes(m_keyData,m_keyLength);
+
+    m_traceId = lastTraceId.fetch_add(1,std::memory_order_relaxed) + 1;
+    m_timestamp = timestamp;
+    m_decodedAt = now();
+
+    //Timestamp can not be in the future. This can happen if realtime clock was adjusted after event was produced
+    if (m_timestamp > m_decodedAt)
+        m_timestamp = m_decodedAt;
+}
+
+quint64 KeyEvent::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+quint64 KeyEvent::realtimeToMonotonic(quint64 realtimeNs)
+{
+    const quint64 monotonicNow = now();
+    const quint64 realtimeNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    const quint64 age = (realtimeNow > realtimeNs) ? realtimeNow - realtimeNs : 0;
+    return (monotonicNow > age) ? monotonicNow - age : 0;
+}
+
+quint64 KeyEvent::monotonicToRealtime(quint64 monotonicNs)
+{
+    const quint64 monotonicNow = now();
+    const quint64 realtimeNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    const quint64 age = (monotonicNow > monotonicNs) ? monotonicNow - monotonicNs : 0;
+    return (realtimeNow > age) ? realtimeNow - age : 0;
+}
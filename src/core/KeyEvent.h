@@ -0,0 +1,106 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYEVENT_H
+#define KEYEVENT_H
+
+#include <QMetaType>
+#include <QString>
+
+#include "./core/KeyId.h"
+
+/*!
+ *  @class KeyEvent core/KeyEvent.h
+ *  @brief This class represents key read by one of the devices together with timing information, which is passed
+ *         from the device through RfidController up to the Command objects.
+ *  @details All timestamps are values of the monotonic clock in nanoseconds (see KeyEvent::now). Every KeyEvent
+ *           gets its own traceId, so that all spans recorded for one tap can be matched together.
+ *
+ *           Key is stored as raw bytes within KeyEvent together with its KeyId, so creating and passing KeyEvent from
+ *           the device to the commands does not allocate memory. QString of the key is created only when
+ *           KeyEvent::key is called (GUI, logs).
+ */
+
+class KeyEvent
+{
+public:
+    /*! @brief Maximal length of the key in bytes. Longer keys are truncated */
+    static const int MAX_KEY_LENGTH = 128;
+
+    KeyEvent();
+
+    /*! @brief Creates KeyEvent for length bytes of key. timestamp - monotonic time, when the first part of the key
+     *         was produced by the device (kernel timestamp for HID devices, time of receiving bytes for serial
+     *         devices). */
+    KeyEvent(const char* key, int length, quint64 timestamp, const QString& source = QString());
+
+    /*! @brief Creates KeyEvent for Latin-1 representation of key */
+    explicit KeyEvent(const QString& key, quint64 timestamp, const QString& source = QString());
+
+    /*! @brief Returns key as a string. Allocates memory, so should not be used while dispatching the key */
+    QString   key() const                              { return QString::fromLatin1(m_keyData,m_keyLength); }
+    const char* keyData() const                        { return m_keyData; }
+    int       keyLength() const                        { return m_keyLength; }
+    KeyId     keyId() const                            { return m_keyId; }
+    QString   source() const                           { return m_source; }
+
+    /*! @brief USB vendor and product ids of the device, which has read the key. 0 if they are not known */
+    quint16   vendorId() const                         { return m_vendorId; }
+    quint16   productId() const                        { return m_productId; }
+    void      setDeviceIds(quint16 vendorId, quint16 productId) { m_vendorId = vendorId; m_productId = productId; }
+    quint64   traceId() const                          { return m_traceId; }
+
+    /*! @brief Returns monotonic time, when the first part of the key was produced by the device */
+    quint64   timestamp() const                        { return m_timestamp; }
+
+    /*! @brief Returns monotonic time, when the whole key was decoded and KeyEvent was created */
+    quint64   decodedAt() const                        { return m_decodedAt; }
+
+    bool      isValid() const                          { return m_traceId != 0; }
+
+    /*! @brief Returns current value of the monotonic clock in nanoseconds */
+    static quint64 now();
+
+    /*! @brief Converts timestamp of the realtime clock (e.g. kernel timestamp of input_event) in nanoseconds to
+     *         the monotonic clock */
+    static quint64 realtimeToMonotonic(quint64 realtimeNs);
+
+    /*! @brief Converts timestamp of the monotonic clock in nanoseconds to the realtime clock (nanoseconds since
+     *         Unix epoch) */
+    static quint64 monotonicToRealtime(quint64 monotonicNs);
+
+private:
+    void      _init(const char* key, int length, quint64 timestamp);
+
+    char      m_keyData[MAX_KEY_LENGTH];
+    int       m_keyLength;
+    KeyId     m_keyId;
+    QString   m_source;
+    quint16   m_vendorId;
+    quint16   m_productId;
+    quint64   m_traceId;
+    quint64   m_timestamp;
+    quint64   m_decodedAt;
+};
+Q_DECLARE_METATYPE(KeyEvent)
+
+#endif // KEYEVENT_H
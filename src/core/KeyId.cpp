@@ -0,0 +1,73 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyId.h"
+
+#include <string.h>
+
+static const quint64 SEED = Q_UINT64_C(0x9E3779B97F4A7C15);
+static const quint64 K1   = Q_UINT64_C(0x87C37B91114253D5);
+static const quint64 K2   = Q_UINT64_C(0x4CF5AD432745937F);
+
+static inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+//Finalizer of MurmurHash3 - every input bit affects every output bit
+static inline quint64 finalize(quint64 value)
+{
+    value ^= value >> 33;
+    value *= Q_UINT64_C(0xFF51AFD7ED558CCD);
+    value ^= value >> 33;
+    value *= Q_UINT64_C(0xC4CEB9FE1A85EC53);
+    value ^= value >> 33;
+    return value;
+}
+
+KeyId KeyId::fromBytes(const char* data, int size)
+{
+    //Keys are short (usually 8...16 characters), so they are processed by whole 64-bit words
+    quint64 hash = SEED ^ quint64(size);
+
+    int offset = 0;
+    for (; offset + 8 <= size; offset += 8) {
+        quint64 word;
+        memcpy(&word,data + offset,sizeof(word));
+        hash = rotateLeft(hash ^ (word * K1),31) * K2;
+    }
+
+    if (offset < size) {
+        quint64 word = 0;
+        for (int i = size - 1; i >= offset; i--)
+            word = (word << 8) | quint8(data[i]);
+        hash = rotateLeft(hash ^ (word * K1),31) * K2;
+    }
+
+    return KeyId(finalize(hash));
+}
+
+KeyId KeyId::fromString(const QString& key)
+{
+    const QByteArray latin1 = key.toLatin1();
+    return fromBytes(latin1.constData(),latin1.size());
+}
@@ -0,0 +1,64 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYID_H
+#define KEYID_H
+
+#include <QHashFunctions>
+#include <QString>
+
+/*!
+ *  @class KeyId core/KeyId.h
+ *  @brief Compact 64-bit identifier of the key, used to find commands without comparing strings.
+ *  @details KeyId is a hash of raw key bytes, as they were produced by the reader. Command keys are Latin-1 strings,
+ *           so KeyId::fromString hashes Latin-1 representation of the string and gives the same value as
+ *           KeyId::fromBytes for the bytes read from the device. Different keys can share one KeyId, so match has to
+ *           be confirmed by comparing bytes (see Command::matches).
+ */
+
+class KeyId
+{
+public:
+    KeyId() : m_value(0) {}
+    explicit KeyId(quint64 value) : m_value(value) {}
+
+    quint64       value() const                          { return m_value; }
+
+    /*! @brief Returns KeyId of size bytes of data. Does not allocate */
+    static KeyId  fromBytes(const char* data, int size);
+
+    /*! @brief Returns KeyId of Latin-1 representation of key */
+    static KeyId  fromString(const QString& key);
+
+    bool operator==(const KeyId& other) const            { return m_value == other.m_value; }
+    bool operator!=(const KeyId& other) const            { return m_value != other.m_value; }
+
+private:
+    quint64   m_value;
+};
+
+inline uint qHash(const KeyId& keyId, uint seed = 0)
+{
+    return qHash(keyId.value(),seed);
+}
+
+#endif // KEYID_H
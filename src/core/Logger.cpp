@@ -28,9 +28,25 @@
 
 #include "appconfig/LoggerSettings.h"
 
+#ifdef METRICS
+    #include <QMetaEnum>
+
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
 Logger::Logger(QObject *parent)
     : QObject{parent},p_logFile(nullptr)
-{}
+{
+#ifdef METRICS
+    const QMetaEnum eventTypes = QMetaEnum::fromType<EventType>();
+    for (int type = KeyLogEvent; type <= ApplicationEvent; type++) {
+        p_linesCounters[type] = metricsRegistry->counter("rfid_log_lines_total","Lines passed to the log.",
+                                                         MetricsRegistry::label("type",eventTypes.valueToKey(type)));
+    }
+    p_writeDuration = metricsRegistry->histogram("rfid_log_write_duration_seconds",
+                                                 "Time spent formatting and writing one log line.");
+#endif //METRICS
+}
 
 Logger::~Logger()
 {
@@ -47,7 +63,7 @@ void Logger::start()
         createLogFile(loggerSettings->logFile());
     }
 
-    _logString(QString("%1 started").arg(qApp->applicationName()));
+    _logString(ApplicationEvent,QString("%1 started").arg(qApp->applicationName()));
 }
 
 void Logger::createLogFile(const QString& filePath)
@@ -62,7 +78,7 @@ void Logger::createLogFile(const QString& filePath)
     QFile* newLogFile = new QFile(filePath);
     if (!newLogFile->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
         qDebug() << "p_logFile->open() failed...";
-        _logString(tr("Error opening log file %1 for writing. Error string: %2")
+        _logString(ErrorEvent,tr("Error opening log file %1 for writing. Error string: %2")
                    .arg(filePath).arg(newLogFile->errorString()));
         newLogFile->deleteLater();
         return;
@@ -83,7 +99,7 @@ void Logger::createLogFile(const QString& filePath)
 
     //Inform everybody about this
     emit currentLogFileChanged(m_logFileInfo);
-    _logString(tr("Creating new log: %1").arg(filePath));
+    _logString(ApplicationEvent,tr("Creating new log: %1").arg(filePath));
 }
 
 void Logger::openLogFile(const QString& filePath)
@@ -98,7 +114,7 @@ void Logger::openLogFile(const QString& filePath)
     QFile* newLogFile = new QFile(filePath);
     if (!newLogFile->open(QIODevice::WriteOnly | QIODevice::Text)) {
         qDebug() << "p_logFile->open() failed...";
-        _logString(tr("Error opening log file %1 for writing. Error string: %2")
+        _logString(ErrorEvent,tr("Error opening log file %1 for writing. Error string: %2")
                    .arg(filePath).arg(newLogFile->errorString()));
         newLogFile->deleteLater();
         return;
@@ -118,12 +134,12 @@ void Logger::openLogFile(const QString& filePath)
     p_logFile = newLogFile;
 
     emit currentLogFileChanged(m_logFileInfo);
-    _logString(tr("Appending to log: %1").arg(filePath));
+    _logString(ApplicationEvent,tr("Appending to log: %1").arg(filePath));
 }
 
 void Logger::closeLogFile()
 {
-    _logString(tr("Closing log file %1").arg(m_logFileInfo.filePath()));
+    _logString(ApplicationEvent,tr("Closing log file %1").arg(m_logFileInfo.filePath()));
     m_logFileInfo = QFileInfo();
     loggerSettings->setLogFile(QString());
     emit currentLogFileChanged(m_logFileInfo);
@@ -210,6 +226,16 @@ void Logger::setClosedDeviceLogging(bool state)
     loggerSettings->setClosedDeviceLogging(state);
 }
 
+bool Logger::logCommands() const
+{
+    return loggerSettings->logCommands();
+}
+
+void Logger::setCommandsLogging(bool state)
+{
+    loggerSettings->setCommandsLogging(state);
+}
+
 /*
  **********************************************************************************************************************
  * Logging keys
@@ -222,7 +248,7 @@ void Logger::logKey(const QString& key)
 
     QString keyString(tr("Key: %1").arg(key));
 
-    _logString(keyString);
+    _logString(KeyLogEvent,keyString);
 }
 
 void Logger::logMatchedKey(const QString& key)
@@ -232,7 +258,7 @@ void Logger::logMatchedKey(const QString& key)
 
     QString keyString(tr("Key: %1").arg(key));
 
-    _logString(keyString);
+    _logString(KeyLogEvent,keyString);
 }
 
 void Logger::logErrorMessage(const QString& errorMessage)
@@ -240,18 +266,54 @@ void Logger::logErrorMessage(const QString& errorMessage)
     if ( !(logErrors()) )
         return;
 
-    _logString(errorMessage);
+    _logString(ErrorEvent,errorMessage);
 }
 
-void Logger::_logString(const QString& logText)
+void Logger::logChildExit(const ChildExit& exit)
 {
+    if ( !(logCommands() || (!exit.isSuccess() && logErrors())) )
+        return;
+
+    if (exit.status() == ChildExit::FailedToStart) {
+        _logString(CommandEvent,tr("Command %1 could not be started: %2").arg(exit.program()).arg(exit.errorString()));
+        return;
+    }
+
+    const qint64 runtimeMs = qint64(exit.runtime() / (1000 * 1000));
+    QString exitString = (exit.status() == ChildExit::Exited)
+            ? tr("Command %1 (pid %2) exited with code %3 after %4 ms").arg(exit.program()).arg(exit.pid())
+                  .arg(exit.exitCode()).arg(runtimeMs)
+            : tr("Command %1 (pid %2) was killed by signal %3 after %4 ms").arg(exit.program()).arg(exit.pid())
+                  .arg(exit.signal()).arg(runtimeMs);
+
+    if (exit.timedOut())
+        exitString.append(tr(" (timed out)"));
+    _logString(CommandEvent,exitString);
+
+    if (!exit.standardOutput().isEmpty())
+        _logString(CommandEvent,tr("stdout of %1 (pid %2): %3").arg(exit.program()).arg(exit.pid())
+                   .arg(QString::fromLocal8Bit(exit.standardOutput()).trimmed()));
+    if (!exit.standardError().isEmpty())
+        _logString(CommandEvent,tr("stderr of %1 (pid %2): %3").arg(exit.program()).arg(exit.pid())
+                   .arg(QString::fromLocal8Bit(exit.standardError()).trimmed()));
+    if (exit.outputTruncated())
+        _logString(CommandEvent,tr("Output of %1 (pid %2) was truncated").arg(exit.program()).arg(exit.pid()));
+}
+
+void Logger::_logString(EventType type, const QString& logText)
+{
+#ifdef METRICS
+    p_linesCounters[type]->increment();
+    ScopedDuration writeDuration(p_writeDuration);
+#endif //METRICS
+
     QString displayString("[");
     displayString.append(QDateTime::currentDateTime().toString("dd.MM.yyyy - hh:mm:ss"));
     displayString.append("] ");
     displayString.append(logText);
 
     //Emit signal that we are doing sth
-    emit loggerEvent(displayString);
+    emit loggerEvent(type,displayString);
 
     if (p_logFile == nullptr) {
         return;
@@ -283,7 +345,7 @@ void Logger::logAttachedInputDevice(const InputDeviceInfo& deviceInfo)
     if ( !(logAttachedDevices()) )
         return;
 
-    _logString(tr("HID device attached (vendorId=%1; productId=%2; systemPath=%3")
+    _logString(DeviceEvent,tr("HID device attached (vendorId=%1; productId=%2; systemPath=%3")
                .arg(deviceInfo.vendorId())
                .arg(deviceInfo.productId())
                .arg(deviceInfo.deviceFilePath()));
@@ -294,7 +356,7 @@ void Logger::logDetachedInputDevice(const InputDeviceInfo& deviceInfo)
     if ( !(logDetachedDevices()) )
         return;
 
-    _logString(tr("HID device detached (vendorId=%1; productId=%2; systemPath=%3")
+    _logString(DeviceEvent,tr("HID device detached (vendorId=%1; productId=%2; systemPath=%3")
                .arg(deviceInfo.vendorId())
                .arg(deviceInfo.productId())
                .arg(deviceInfo.deviceFilePath()));
@@ -305,7 +367,7 @@ void Logger::logOpenedInputDevice(const InputDeviceInfo& deviceInfo)
     if ( !(logOpenedDevices()) )
         return;
 
-    _logString(tr("HID device opened (vendorId=%1; productId=%2; systemPath=%3")
+    _logString(DeviceEvent,tr("HID device opened (vendorId=%1; productId=%2; systemPath=%3")
                .arg(deviceInfo.vendorId())
                .arg(deviceInfo.productId())
                .arg(deviceInfo.deviceFilePath()));
@@ -316,7 +378,7 @@ void Logger::logClosedInputDevice(const InputDeviceInfo& deviceInfo)
     if ( !(logClosedDevices()) )
         return;
 
-    _logString(tr("HID device closed (vendorId=%1; productId=%2; systemPath=%3")
+    _logString(DeviceEvent,tr("HID device closed (vendorId=%1; productId=%2; systemPath=%3")
                .arg(deviceInfo.vendorId())
                .arg(deviceInfo.productId())
                .arg(deviceInfo.deviceFilePath()));
@@ -336,7 +398,7 @@ void Logger::logAttachedSerialDevice(const QSerialPortInfo& portInfo)
     if ( !(logAttachedDevices()) )
         return;
 
-    _logString(tr("Serial device attached (vendorId=%1; productId=%2; portName=%3")
+    _logString(DeviceEvent,tr("Serial device attached (vendorId=%1; productId=%2; portName=%3")
                .arg(portInfo.vendorIdentifier())
                .arg(portInfo.productIdentifier())
                .arg(portInfo.portName()));
@@ -347,7 +409,7 @@ void Logger::logDetachedSerialDevice(const QSerialPortInfo& portInfo)
     if ( !(logDetachedDevices()) )
         return;
 
-    _logString(tr("Serial device detached (vendorId=%1; productId=%2; portName=%3")
+    _logString(DeviceEvent,tr("Serial device detached (vendorId=%1; productId=%2; portName=%3")
                .arg(portInfo.vendorIdentifier())
                .arg(portInfo.productIdentifier())
                .arg(portInfo.portName()));
@@ -358,7 +420,7 @@ void Logger::logOpenedSerialDevice(const QSerialPortInfo& portInfo)
     if ( !(logOpenedDevices()) )
         return;
 
-    _logString(tr("Serial device opened (vendorId=%1; productId=%2; portName=%3")
+    _logString(DeviceEvent,tr("Serial device opened (vendorId=%1; productId=%2; portName=%3")
                .arg(portInfo.vendorIdentifier())
                .arg(portInfo.productIdentifier())
                .arg(portInfo.portName()));
@@ -369,7 +431,7 @@ void Logger::logClosedSerialDevice(const QSerialPortInfo& portInfo)
     if ( !(logClosedDevices()) )
         return;
 
-    _logString(tr("Serial device closed (vendorId=%1; productId=%2; portName=%3")
+    _logString(DeviceEvent,tr("Serial device closed (vendorId=%1; productId=%2; portName=%3")
                .arg(portInfo.vendorIdentifier())
                .arg(portInfo.productIdentifier())
                .arg(portInfo.portName()));
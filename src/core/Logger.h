@@ -28,6 +28,8 @@
 #include <QFile>
 #include <QFileInfo>
 
+#include "core/commands/ChildExit.h"
+
 #ifdef HID
     #include "core/input/InputDeviceInfo.h"
 #endif //HID
@@ -36,6 +38,10 @@
     #include <QSerialPortInfo>
 #endif //SERIAL
 
+#ifdef METRICS
+    #include "core/metrics/Metrics.h"
+#endif //METRICS
+
 /*!
  *  @class Logger core/Logger.h
  *  @brief This class is responsible for logging events inside the app.
@@ -45,6 +51,16 @@ class Logger : public QObject
 {
     Q_OBJECT
 public:
+    /*! @brief This enum holds information about kinds of events, which are placed to log */
+    enum EventType {
+        KeyLogEvent,         /*!< @brief Discovered or matched key */
+        ErrorEvent,          /*!< @brief Error message */
+        DeviceEvent,         /*!< @brief Device was attached, detached, opened or closed */
+        CommandEvent,        /*!< @brief Process started by command has finished */
+        ApplicationEvent     /*!< @brief Internal events of the application and Logger itself */
+    };
+    Q_ENUM(EventType)
+
     explicit Logger(QObject *parent = nullptr);
     ~Logger();
 
@@ -84,13 +100,17 @@ public:
     /*! @brief Returns true if this Logger object will log closed devices. */
     bool logClosedDevices() const;
 
+    /*! @brief Returns true if this Logger object will log finished processes of commands. Failed processes are
+     *         logged also if errors are logged. */
+    bool logCommands() const;
+
 signals:
     /*! @brief This signal is emitted when current log file changes. */
     void currentLogFileChanged(const QFileInfo& newFileInfo);
 
     /*! @brief This signal is emitted when Logger class has recieved information about some event, which needs to be
      *         placed to log. Or in case of some Logger internal events, which needs to be displayed to user. */
-    void loggerEvent(const QString& line);
+    void loggerEvent(Logger::EventType type, const QString& line);
 
 public slots:
     /*! @brief Pass true to enable logging of discovered keys. */
@@ -114,6 +134,9 @@ public slots:
     /*! @brief Pass true to enable logging of closed devices. */
     void setClosedDeviceLogging(bool state);
 
+    /*! @brief Pass true to enable logging of finished processes of commands. */
+    void setCommandsLogging(bool state);
+
     /*! @brief This slot should be invoked to log discovered key. */
     void logKey(const QString& key);
 
@@ -123,13 +146,21 @@ public slots:
     /*! @brief This slot should be invoked to log error message. */
     void logErrorMessage(const QString& errorMessage);
 
+    /*! @brief This slot should be invoked to log finished process of command (see ChildSupervisor). */
+    void logChildExit(const ChildExit& exit);
+
 private:
     static QString _defaultLogPath();
-    void           _logString(const QString& logText);
+    void           _logString(EventType type, const QString& logText);
 
     QFileInfo m_logFileInfo;
     QFile*    p_logFile;
 
+#ifdef METRICS
+    Counter*    p_linesCounters[ApplicationEvent + 1];
+    Histogram*  p_writeDuration;
+#endif //METRICS
+
 #ifdef HID
 //
 // This part is needed only if we have HID support enabled
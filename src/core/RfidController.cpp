@@ -22,13 +22,54 @@
 
 #include "RfidController.h"
 
+#include <QDebug>
+#include <QTimer>
+
 #include "appconfig/RfidControllerSettings.h"
+#include "cards/CardNormalizer.h"
 #include "commands/Command.h"
 #include "commands/CommandList.h"
+#include "commands/ChildSupervisor.h"
+#include "commands/CommandScheduler.h"
+#include "devices/DeviceMultiplexer.h"
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
 
 RfidController::RfidController(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      m_startingManagers(0),
+      m_started(false),
+      m_fuzzyDistance(0)
+#ifdef METRICS
+    ,p_keysCounter(metricsRegistry->counter("rfid_keys_total","Keys read by all devices.")),
+    p_matchedKeysCounter(metricsRegistry->counter("rfid_keys_matched_total","Keys, which matched at least one command.")),
+    p_dispatchDuration(metricsRegistry->histogram("rfid_key_dispatch_duration_seconds",
+                                                  "Time spent matching key and starting commands.")),
+    p_fuzzyAmbiguousCounter(metricsRegistry->counter("rfid_keys_fuzzy_ambiguous_total",
+                                                     "Keys, which were equally near to several keys of commands."))
+#endif //METRICS
 {
+    qRegisterMetaType<KeyEvent>("KeyEvent");
+
+#ifdef METRICS
+    for (int i = 0; i <= FuzzyKeyIndex::MAX_DISTANCE; i++) {
+        p_fuzzyMatchedCounters[i] = metricsRegistry->counter("rfid_keys_fuzzy_matched_total",
+                                                             "Keys, which matched commands with flipped bits.",
+                                                             MetricsRegistry::label("distance",QString::number(i)));
+    }
+#endif //METRICS
+
+    //Keys of commands are normalized when commands are loaded, so normalizer has to be configured first
+    RfidControllerSettings::get()->configureCardNormalizer(cardNormalizer);
+    RfidControllerSettings::get()->configureCommandScheduler(commandScheduler);
+    m_commandListManager.setKeyDigestSecret(RfidControllerSettings::get()->keyDigestSecret());
+
     connect(&m_commandListManager,&CommandsListManager::errorMessage,this,&RfidController::errorMessage);
 
     connect(&m_commandListManager,&CommandsListManager::commandListChanged,this,&RfidController::commandListChanged);
@@ -38,6 +79,7 @@ RfidController::RfidController(QObject *parent)
     connect(&m_commandListManager,&CommandsListManager::commandsFileModified,this,&RfidController::commandsFileModified);
 
 #ifdef HID
+    connect(&m_inputDeviceManager,&InputDeviceManager::started,this,&RfidController::_deviceManagerStarted);
     connect(&m_inputDeviceManager,&InputDeviceManager::keyFound,this,&RfidController::_keyDiscovered);
     connect(&m_inputDeviceManager,&InputDeviceManager::errorMessage,this,&RfidController::errorMessage);
 
@@ -54,6 +96,7 @@ RfidController::RfidController(QObject *parent)
 #endif //HID
 
 #ifdef SERIAL
+    connect(&m_serialDeviceManager,&SerialDeviceManager::started,this,&RfidController::_deviceManagerStarted);
     connect(&m_serialDeviceManager,&SerialDeviceManager::keyFound,this,&RfidController::_keyDiscovered);
     connect(&m_serialDeviceManager,&SerialDeviceManager::errorMessage,this,&RfidController::errorMessage);
 
@@ -75,6 +118,17 @@ RfidController::RfidController(QObject *parent)
     connect(&m_nfcManager,&NfcManager::keyFound,this,&RfidController::_keyDiscovered);
     connect(&m_nfcManager,&NfcManager::errorMessage,this,&RfidController::errorMessage);
 #endif
+
+#ifdef METRICS
+    connect(&m_metricsExporter,&MetricsExporter::errorMessage,this,&RfidController::errorMessage);
+#ifdef LOG
+    connect(&m_metricsExporter,&MetricsExporter::errorMessage,&m_logger,&Logger::logErrorMessage);
+#endif //LOG
+#endif //METRICS
+
+#ifdef LOG
+    connect(childSupervisor,&ChildSupervisor::childFinished,&m_logger,&Logger::logChildExit);
+#endif //LOG
 }
 
 RfidController::~RfidController()
@@ -83,13 +137,36 @@ RfidController::~RfidController()
         RfidControllerSettings::get()->setOpenedCommandsFileName(m_commandListManager.currentFileInfo().absoluteFilePath());
     else
         RfidControllerSettings::get()->setOpenedCommandsFileName(QString());
+
+#ifdef TRACING
+    if (!RfidControllerSettings::get()->traceFile().isEmpty())
+        tracer->writeToFile(RfidControllerSettings::get()->traceFile());
+#endif //TRACING
 }
 
 void RfidController::start()
 {
-#ifdef LOG
-    m_logger.start();
-#endif //LOG
+    m_fuzzyDistance = RfidControllerSettings::get()->fuzzyMatchingDistance();
+
+#ifdef TRACING
+    tracer->setCapacity(RfidControllerSettings::get()->traceCapacity());
+#endif //TRACING
+
+    //Backend has to be selected before the first device is opened
+    const DeviceMultiplexer::Backend ioBackend = RfidControllerSettings::get()->ioBackend();
+    if (!deviceMultiplexer->setBackend(ioBackend)) {
+        qWarning() << "I/O backend" << DeviceMultiplexer::backendName(ioBackend) << "is not available, using"
+                   << DeviceMultiplexer::backendName(deviceMultiplexer->backend());
+    }
+
+    //Devices are started first, so that they are being opened while the rest of the app is initialized
+#ifdef HID
+    m_startingManagers++;
+#endif //HID
+
+#ifdef SERIAL
+    m_startingManagers++;
+#endif //SERIAL
 
 #ifdef HID
     m_inputDeviceManager.start();
@@ -99,6 +176,15 @@ void RfidController::start()
     m_serialDeviceManager.start();
 #endif //SERIAL
 
+#ifdef LOG
+    //Log file is opened from the event loop, it should not delay opening of devices and creation of GUI
+    QTimer::singleShot(0,&m_logger,&Logger::start);
+#endif //LOG
+
+#ifdef METRICS
+    m_metricsExporter.start();
+#endif //METRICS
+
 #ifdef NFC
     m_nfcManager.start();
 
@@ -106,23 +192,121 @@ void RfidController::start()
         qWarning() << "App was build with NFC support, hovever current device has no NFC!";
     }
 #endif //NFC
+
+    //Managers without devices to open can report start synchronously, then started() is already emitted
+    _emitStartedIfReady();
+}
+
+void RfidController::_deviceManagerStarted()
+{
+    if (m_startingManagers == 0)
+        return;
+
+    m_startingManagers--;
+    _emitStartedIfReady();
 }
 
-void RfidController::_keyDiscovered(const QString& key)
+void RfidController::_emitStartedIfReady()
 {
+    if (m_startingManagers != 0 || m_started)
+        return;
+
+    m_started = true;
+    emit started();
+}
+
+void RfidController::_keyDiscovered(const KeyEvent& event)
+{
+    const quint64 dispatchStart = KeyEvent::now();
+
     CommandList* cmdList = m_commandListManager.currentCommandsList();
     if (cmdList == nullptr) {
         qDebug() << "m_commandListManager.currentCommandsList() == nullptr";
         return;
     }
 
-    for (int i = 0; i < cmdList->count(); i++) {
-        Command* cmd = cmdList->at(i);
-        if (cmd->key() == key) {
-            cmd->run();
+#ifdef METRICS
+    p_keysCounter->increment();
+    bool matched = false;
+#endif //METRICS
+
+    //Lookup by KeyId and comparing raw bytes do not allocate, QString of the key is created only for GUI and logs
+    bool exactMatched = false;
+    const QVector<Command*> commands = cmdList->commandsForKey(event.keyId());
+    for (Command* cmd : commands) {
+        if (cmd->matches(event)) {
+            cmd->run(event);
+            exactMatched = true;
         }
     }
 
+    //Hashed keys are looked up by digest of the key, computed once per key
+    if (cmdList->hasDigestCommands()) {
+        cmdList->digestCommandsFor(event,&m_matchedCommands);
+        for (Command* cmd : qAsConst(m_matchedCommands))
+            cmd->run(event);
+        exactMatched = exactMatched || !m_matchedCommands.isEmpty();
+    }
+
+    //Fuzzy lookup is slower, so it is done only for keys, which match no command exactly
+    if (!exactMatched && m_fuzzyDistance > 0) {
+        bool ambiguous = false;
+        const int distance = cmdList->fuzzyCommandsFor(event,m_fuzzyDistance,&m_matchedCommands,&ambiguous);
+        if (distance >= 0) {
+            qDebug() << "Key"<<event.key()<<"matched commands with"<<distance<<"flipped bits";
+            for (Command* cmd : qAsConst(m_matchedCommands))
+                cmd->run(event);
+            exactMatched = true;
+#ifdef METRICS
+            p_fuzzyMatchedCounters[distance]->increment();
+#endif //METRICS
+        } else if (ambiguous) {
+            qDebug() << "Key"<<event.key()<<"is equally near to several keys of commands, ignoring.";
+#ifdef METRICS
+            p_fuzzyAmbiguousCounter->increment();
+#endif //METRICS
+        }
+    }
+
+#ifdef METRICS
+    matched = exactMatched;
+#endif //METRICS
+
+    //Prefixes, ranges and regular expressions are checked after exact keys
+    if (cmdList->hasPatternCommands()) {
+        cmdList->patternCommandsFor(event,&m_matchedCommands);
+        for (Command* cmd : qAsConst(m_matchedCommands))
+            cmd->run(event);
+#ifdef METRICS
+        matched = matched || !m_matchedCommands.isEmpty();
+#endif //METRICS
+    }
+
+    //Large allow/deny lists are checked by membership of the key within their sets
+    if (cmdList->hasMembershipCommands()) {
+        cmdList->membershipCommandsFor(event,&m_matchedCommands);
+        for (Command* cmd : qAsConst(m_matchedCommands))
+            cmd->run(event);
+#ifdef METRICS
+        matched = matched || !m_matchedCommands.isEmpty();
+#endif //METRICS
+    }
+
+    const quint64 dispatchEnd = KeyEvent::now();
+
+#ifdef METRICS
+    p_dispatchDuration->record(dispatchEnd - dispatchStart);
+    if (matched)
+        p_matchedKeysCounter->increment();
+#endif //METRICS
+
+#ifdef TRACING
+    tracer->addSpan(event,"delivery",event.decodedAt(),dispatchStart);
+    tracer->addSpan(event,"dispatch",dispatchStart,dispatchEnd);
+    tracer->addSpan(event,"tap",event.timestamp(),dispatchEnd);
+#endif //TRACING
+
+    const QString key = event.key();
     emit keyFound(key);
 
 #ifdef LOG
@@ -26,6 +26,7 @@
 #include <QObject>
 
 #include "core/CommandListManager.h"
+#include "core/KeyEvent.h"
 
 #ifdef HID
     #include "core/input/InputDeviceManager.h"
@@ -43,6 +44,12 @@
     #include "Logger.h"
 #endif //LOG
 
+#ifdef METRICS
+    #include "core/commands/FuzzyKeyIndex.h"
+    #include "core/metrics/Metrics.h"
+    #include "core/metrics/MetricsExporter.h"
+#endif //METRICS
+
 /*!
  *  @class RfidController core/RfidController.h
  *  @brief Main class where almost everything is happening.
@@ -58,6 +65,8 @@ public:
     }
     ~RfidController();
 
+    /*! @brief Starts all device managers. Devices are opened asynchronously, RfidController::started is emitted when
+     *         all devices matching autoconnect criteria are processed. */
     void start();
 
     /*! @brief This method creates new CommandList. See CommandListManager::newCommandList. */
@@ -70,7 +79,11 @@ public:
     void           reloadCurrentCommandFile()                             { m_commandListManager.reloadCurrentCommandFile(); }
 
     /*! @brief Saves current CommandList as fileName. See CommandListManager::saveCurrentCommandsListAs. */
-    void           saveCurrentCommandsListAs(const QString& fileName)     { m_commandListManager.saveCurrentCommandsListAs(fileName); }
+    void           saveCurrentCommandsListAs(const QString& fileName, bool hashKeys = false)
+                                                                          { m_commandListManager.saveCurrentCommandsListAs(fileName,hashKeys); }
+
+    /*! @brief Reloads sets of keys of MembershipCommand objects. See CommandListManager::reloadKeySets. */
+    void           reloadKeySets()                                        { m_commandListManager.reloadKeySets(); }
 
     /*! @brief Deletes current CommandList and closes current file. See CommandListManager::closeCurrentFile. */
     void           closeCurrentFile()                                     { m_commandListManager.closeCurrentFile(); };
@@ -79,6 +92,9 @@ public:
     CommandList*   currentCommandsList()                                  { return m_commandListManager.currentCommandsList(); }
 
 signals:
+    /*! @brief This signal is emitted when all devices, which should be opened on start, were processed */
+    void started();
+
     /*! @brief This signal is emitted when any key was read by any of the connected devices */
     void keyFound(const QString& key);
 
@@ -100,13 +116,21 @@ signals:
     void commandListChanged(CommandList* model);
 
 private slots:
-    void _keyDiscovered(const QString& key);
+    void _keyDiscovered(const KeyEvent& event);
+    void _deviceManagerStarted();
 
 private:
     explicit RfidController(QObject *parent = nullptr);
     Q_DISABLE_COPY(RfidController);
 
+    /*! @brief Emits started() once, when all device managers have reported start */
+    void _emitStartedIfReady();
+
     CommandsListManager      m_commandListManager;
+    int                      m_startingManagers;
+    bool                     m_started;
+    int                      m_fuzzyDistance;             //!< @brief 0 if fuzzy matching is disabled
+    QVector<Command*>        m_matchedCommands;           //!< @brief Kept between keys, so dispatch does not allocate
 
 #ifdef HID
 //
@@ -155,6 +179,24 @@ public:
 private:
     Logger              m_logger;
 #endif //LOG
+
+#ifdef METRICS
+//
+// This part is needed only if we have metrics support enabled
+//
+
+public:
+    MetricsExporter*    metricsExporter() { return &m_metricsExporter; }
+
+private:
+    MetricsExporter     m_metricsExporter;
+
+    Counter*            p_keysCounter;
+    Counter*            p_matchedKeysCounter;
+    Histogram*          p_dispatchDuration;
+    Counter*            p_fuzzyMatchedCounters[FuzzyKeyIndex::MAX_DISTANCE + 1];
+    Counter*            p_fuzzyAmbiguousCounter;
+#endif //METRICS
 };
 
 #endif // RFIDCONTROLLER_H
@@ -0,0 +1,104 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+/*!
+ *  @class RingBuffer core/RingBuffer.h
+ *  @brief Fixed-capacity FIFO container. When it is full - appending new item overwrites the oldest one.
+ *  @details Items are accessed by logical index, where 0 is the oldest item and count()-1 is the newest one. Storage
+ *           is allocated once, when capacity is set, so appending items is not allocating memory by itself.
+ */
+
+template<class T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0)
+        : m_head(0),m_count(0)                           { m_data.resize(capacity); }
+
+    int       capacity() const                           { return m_data.size(); }
+    int       count() const                              { return m_count; }
+    bool      isEmpty() const                            { return m_count == 0; }
+    bool      isFull() const                             { return m_count == m_data.size(); }
+
+    /*! @brief Returns item at logical position index. 0 is the oldest item */
+    const T&  at(int index) const {
+        Q_ASSERT(index >= 0 && index < m_count);
+        return m_data.at((m_head + index) % m_data.size());
+    }
+
+    /*! @brief Appends item to the end of the buffer. If buffer is full - the oldest item is overwritten */
+    void      append(const T& item) {
+        if (m_data.isEmpty())
+            return;
+
+        if (m_count < m_data.size()) {
+            m_data[(m_head + m_count) % m_data.size()] = item;
+            m_count++;
+        } else {
+            m_data[m_head] = item;
+            m_head = (m_head + 1) % m_data.size();
+        }
+    }
+
+    /*! @brief Removes the oldest item */
+    void      removeFirst() {
+        Q_ASSERT(m_count > 0);
+        m_data[m_head] = T();
+        m_head = (m_head + 1) % m_data.size();
+        m_count--;
+    }
+
+    void      clear() {
+        for (int i = 0; i < m_data.size(); i++)
+            m_data[i] = T();
+
+        m_head = 0;
+        m_count = 0;
+    }
+
+    /*! @brief Changes capacity of the buffer. If new capacity is less than count() - only the newest items are kept */
+    void      setCapacity(int capacity) {
+        if (capacity == m_data.size())
+            return;
+
+        QVector<T> newData(capacity);
+        int keep = qMin(m_count,capacity);
+        for (int i = 0; i < keep; i++)
+            newData[i] = at(m_count - keep + i);
+
+        m_data = newData;
+        m_head = 0;
+        m_count = keep;
+    }
+
+private:
+    QVector<T>  m_data;
+    int         m_head;
+    int         m_count;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,59 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "StartupProfiler.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+StartupProfiler::StartupProfiler()
+    : m_enabled(false)
+{
+    m_timer.start();
+}
+
+void StartupProfiler::mark(const QString& phase)
+{
+    if (!m_enabled)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    m_phases.append(qMakePair(m_timer.nsecsElapsed(),phase));
+}
+
+void StartupProfiler::print()
+{
+    if (!m_enabled)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+
+    qInfo("Startup profile:");
+    qint64 previous = 0;
+    for (const QPair<qint64,QString>& phase : qAsConst(m_phases)) {
+        qInfo("  %9.3f ms (+%8.3f ms)  %s",phase.first / 1e6,(phase.first - previous) / 1e6,qUtf8Printable(phase.second));
+        previous = phase.first;
+    }
+
+    m_phases.clear();
+    m_enabled = false;
+}
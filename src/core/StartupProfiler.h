@@ -0,0 +1,69 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+#include <atomic>
+
+/*!
+ *  @class StartupProfiler core/StartupProfiler.h
+ *  @brief This class collects timeline of application startup phases. Enabled by --startup-profile option.
+ *  @details Time is measured from the first call of StartupProfiler::get (which is done at the beginning of main).
+ *           When profiler is disabled - StartupProfiler::mark does nothing. Can be used from any thread.
+ */
+
+class StartupProfiler
+{
+public:
+    static StartupProfiler* get() {
+        static StartupProfiler theOne;
+        return &theOne;
+    }
+
+    void      setEnabled(bool state)                    { m_enabled = state; }
+    bool      isEnabled() const                         { return m_enabled; }
+
+    /*! @brief Remembers that phase was reached at the current moment */
+    void      mark(const QString& phase);
+
+    /*! @brief Prints collected timeline (with time between phases) and stops collecting */
+    void      print();
+
+private:
+    StartupProfiler();
+    Q_DISABLE_COPY(StartupProfiler)
+
+    std::atomic<bool>             m_enabled;
+    QElapsedTimer                 m_timer;
+    QMutex                        m_mutex;
+    QList<QPair<qint64,QString>>  m_phases;
+};
+#define startupProfiler StartupProfiler::get()
+
+#endif // STARTUPPROFILER_H
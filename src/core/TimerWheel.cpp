@@ -0,0 +1,142 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TimerWheel.h"
+
+#include <algorithm>
+
+#include "core/KeyEvent.h"
+
+TimerWheel::Client::~Client()
+{
+    if (m_scheduled)
+        timerWheel->cancel(this);
+
+    timerWheel->_forget(this);
+}
+
+TimerWheel::TimerWheel()
+    : m_clock(&KeyEvent::now),m_currentTick(0),m_pendingCount(0)
+{
+    m_timer.setInterval(int(TICK_NS / (1000 * 1000)));
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer,&QTimer::timeout,this,&TimerWheel::_timerTicked);
+}
+
+void TimerWheel::schedule(Client* client, quint64 deadline)
+{
+    Q_ASSERT(client != nullptr);
+
+    if (m_pendingCount == 0) {
+        //Wheel was idle, so it's position is outdated
+        m_currentTick = m_clock() / TICK_NS;
+    }
+
+    //Old entry (if any) becomes stale and is dropped when its slot is processed
+    client->m_generation++;
+    if (!client->m_scheduled) {
+        client->m_scheduled = true;
+        m_pendingCount++;
+    }
+
+    //Deadline is rounded up to the tick, but never to the tick which was already processed
+    const quint64 tick = qMax((deadline + TICK_NS - 1) / TICK_NS,m_currentTick + 1);
+    m_slots[tick % SLOT_COUNT].push_back({client,deadline,client->m_generation});
+
+    if (!m_timer.isActive())
+        m_timer.start();
+}
+
+void TimerWheel::cancel(Client* client)
+{
+    Q_ASSERT(client != nullptr);
+
+    if (!client->m_scheduled)
+        return;
+
+    client->m_generation++;
+    client->m_scheduled = false;
+    m_pendingCount--;
+
+    if (m_pendingCount == 0)
+        m_timer.stop();
+}
+
+void TimerWheel::advance(quint64 now)
+{
+    const quint64 nowTick = now / TICK_NS;
+    if (nowTick <= m_currentTick)
+        return;
+
+    //There is no need to visit one slot more than once
+    const quint64 ticks = qMin(nowTick - m_currentTick,quint64(SLOT_COUNT));
+    const quint64 firstTick = nowTick - ticks + 1;
+    m_currentTick = nowTick;
+
+    for (quint64 tick = firstTick; tick <= nowTick; tick++) {
+        std::vector<Entry>& slot = m_slots[tick % SLOT_COUNT];
+        if (slot.empty())
+            continue;
+
+        //Clients can schedule or cancel deadlines while being notified, so slot is processed from the copy
+        m_expiring.swap(slot);
+        for (size_t i = 0; i < m_expiring.size(); i++) {
+            const Entry entry = m_expiring[i];
+            if (entry.client == nullptr || entry.generation != entry.client->m_generation)
+                continue;   //Stale entry
+
+            if (entry.deadline > now) {
+                //Deadline is on one of the next turns of the wheel
+                slot.push_back(entry);
+                continue;
+            }
+
+            entry.client->m_scheduled = false;
+            m_pendingCount--;
+            entry.client->_timerWheelExpired(now);
+        }
+        m_expiring.clear();
+    }
+
+    if (m_pendingCount == 0)
+        m_timer.stop();
+}
+
+void TimerWheel::_timerTicked()
+{
+    advance(m_clock());
+}
+
+void TimerWheel::_forget(Client* client)
+{
+    for (std::vector<Entry>& slot : m_slots) {
+        slot.erase(std::remove_if(slot.begin(),slot.end(),[client](const Entry& entry){
+            return entry.client == client;
+        }),slot.end());
+    }
+
+    //Client can be destroyed by another client, which is being notified right now
+    for (Entry& entry : m_expiring) {
+        if (entry.client == client)
+            entry.client = nullptr;
+    }
+}
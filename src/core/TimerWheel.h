@@ -0,0 +1,119 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <vector>
+
+/*!
+ *  @class TimerWheel core/TimerWheel.h
+ *  @brief This class provides coarse timeouts for large number of objects (e.g. inter-character timeouts of all
+ *         opened devices) driven by one QTimer.
+ *  @details Deadlines are monotonic times in nanoseconds (see KeyEvent::now). They are placed into one of SLOT_COUNT
+ *           slots, each covering TICK_NS; deadlines further than one turn of the wheel simply stay in their slot for
+ *           the next turns. QTimer is running only while something is scheduled. Each Client can have only one
+ *           pending deadline - scheduling it again replaces the previous one. Must be used from the main thread.
+ *
+ *           Time source can be replaced with TimerWheel::setClock and wheel can be moved forward manually with
+ *           TimerWheel::advance, so behaviour does not depend on the real clock.
+ */
+
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+public:
+    /*! @brief Base class for objects, which need timeouts from TimerWheel. Pending deadline is cancelled when Client
+     *         object is destroyed. */
+    class Client
+    {
+        friend class TimerWheel;
+    public:
+        Client() : m_generation(0),m_scheduled(false) {}
+        virtual ~Client();
+
+    protected:
+        /*! @brief Called by TimerWheel when deadline of this client has passed. now - current time of the wheel */
+        virtual void _timerWheelExpired(quint64 now) = 0;
+
+    private:
+        Q_DISABLE_COPY(Client)
+
+        quint32   m_generation;
+        bool      m_scheduled;
+    };
+
+    typedef quint64 (*Clock)();
+
+    static const int      SLOT_COUNT = 64;
+    static const quint64  TICK_NS    = 10 * 1000 * 1000;
+
+    static TimerWheel* get() {
+        static TimerWheel theOne;
+        return &theOne;
+    }
+
+    /*! @brief Replaces time source of the wheel. By default KeyEvent::now is used */
+    void      setClock(Clock clock)                       { m_clock = clock; }
+    quint64   now() const                                 { return m_clock(); }
+
+    /*! @brief Schedules client to be notified once deadline has passed. Replaces previous deadline of this client */
+    void      schedule(Client* client, quint64 deadline);
+
+    /*! @brief Cancels pending deadline of the client (if any) */
+    void      cancel(Client* client);
+
+    bool      isScheduled(const Client* client) const     { return client->m_scheduled; }
+    int       pendingCount() const                        { return m_pendingCount; }
+
+    /*! @brief Notifies all clients with deadlines before now. Called by internal QTimer with current time */
+    void      advance(quint64 now);
+
+private slots:
+    void      _timerTicked();
+
+private:
+    TimerWheel();
+    Q_DISABLE_COPY(TimerWheel)
+
+    struct Entry {
+        Client*   client;
+        quint64   deadline;
+        quint32   generation;
+    };
+
+    /*! @brief Removes all entries of client, which is being destroyed */
+    void      _forget(Client* client);
+
+    Clock               m_clock;
+    QTimer              m_timer;
+    std::vector<Entry>  m_slots[SLOT_COUNT];
+    std::vector<Entry>  m_expiring;       //!< @brief Entries of the slot being processed by TimerWheel::advance
+    quint64             m_currentTick;
+    int                 m_pendingCount;
+};
+#define timerWheel TimerWheel::get()
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,378 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CardNormalizer.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+static const quint64 ONES = Q_UINT64_C(0x0101010101010101);
+static const quint64 HIGH = Q_UINT64_C(0x8080808080808080);
+
+static const int     PROX_DIGITS = 10;
+static const int     EM4100_BITS = 40;
+static const int     EM4100_DIGITS = 13;       //Digits of the largest 40-bit number
+static const int     MAX_UID_BYTES = 10;
+
+//High bit of each byte is set, if this byte of value is not less than limit. Bytes of value must be below 0x80
+static inline quint64 bytesAtLeast(quint64 value, quint8 limit)
+{
+    return ((value | HIGH) - ONES * limit) & HIGH;
+}
+
+//High bit of each byte is set, if this byte of value is not greater than limit. Bytes of value must be below 0x80
+static inline quint64 bytesAtMost(quint64 value, quint8 limit)
+{
+    return ((ONES * limit | HIGH) - value) & HIGH;
+}
+
+//Converts 8 hex digits within one register. First character is the most significant digit
+static inline bool parseHex8(const char* data, quint32* value)
+{
+    const quint64 chars = qFromLittleEndian<quint64>(data);
+    if (chars & HIGH)
+        return false;
+
+    const quint64 digits = bytesAtLeast(chars,'0') & bytesAtMost(chars,'9');
+    const quint64 lower = chars | (ONES * 0x20);
+    const quint64 letters = bytesAtLeast(lower,'a') & bytesAtMost(lower,'f');
+    if ((digits | letters) != HIGH)
+        return false;
+
+    //'0'...'9' have low nibble 0...9, 'a'...'f' - 1...6
+    quint64 nibbles = (lower & (ONES * 0x0F)) + (letters >> 7) * 9;
+
+    nibbles = ((nibbles & Q_UINT64_C(0x0F000F000F000F00)) >> 8) | ((nibbles & Q_UINT64_C(0x000F000F000F000F)) << 4);
+    nibbles = ((nibbles & Q_UINT64_C(0x000000FF000000FF)) << 8) | ((nibbles & Q_UINT64_C(0x00FF000000FF0000)) >> 16);
+    *value = quint32(((nibbles & 0xFFFF) << 16) | ((nibbles >> 32) & 0xFFFF));
+    return true;
+}
+
+//Converts 8 decimal digits within one register, by merging pairs of digits, then pairs of pairs, etc.
+static inline bool parseDecimal8(const char* data, quint32* value)
+{
+    quint64 chars = qFromLittleEndian<quint64>(data);
+    if (chars & HIGH)
+        return false;
+
+    if ((bytesAtLeast(chars,'0') & bytesAtMost(chars,'9')) != HIGH)
+        return false;
+
+    chars = ((chars & (ONES * 0x0F)) * 2561) >> 8;
+    chars = ((chars & Q_UINT64_C(0x00FF00FF00FF00FF)) * 6553601) >> 16;
+    *value = quint32(((chars & Q_UINT64_C(0x0000FFFF0000FFFF)) * Q_UINT64_C(42949672960001)) >> 32);
+    return true;
+}
+
+static inline int hexDigit(char character)
+{
+    if (character >= '0' && character <= '9')
+        return character - '0';
+    if (character >= 'a' && character <= 'f')
+        return character - 'a' + 10;
+    if (character >= 'A' && character <= 'F')
+        return character - 'A' + 10;
+    return -1;
+}
+
+static inline bool isSeparator(char character)
+{
+    return character == ':' || character == '-' || character == ' ';
+}
+
+CardNormalizer::CardNormalizer()
+    : m_enabled(true),
+    m_proxBits(32),
+    m_reverseUid(false)
+{
+#ifdef METRICS
+    for (int i = 0; i < FormatCount; i++) {
+        const QString labels = MetricsRegistry::label("format",formatName(static_cast<Format>(i)));
+        p_normalizedCounters[i] = metricsRegistry->counter("rfid_cards_normalized_total","Keys by detected card format.",labels);
+        p_invalidCounters[i] = metricsRegistry->counter("rfid_cards_invalid_total","Keys rejected because of checksum or parity error.",labels);
+    }
+#endif //METRICS
+}
+
+int CardNormalizer::normalize(const char* key, int length, char* output, Format* format) const
+{
+    Format detected = Unknown;
+    int outputLength = 0;
+
+    if (m_enabled)
+        detected = _detect(key,length,output,&outputLength);
+
+    if (detected == Unknown) {
+        memcpy(output,key,length);
+        outputLength = length;
+    }
+
+#ifdef METRICS
+    if (outputLength < 0) {
+        p_invalidCounters[detected]->increment();
+    } else {
+        p_normalizedCounters[detected]->increment();
+    }
+#endif //METRICS
+
+    if (format != nullptr)
+        *format = detected;
+
+    return outputLength;
+}
+
+const char* CardNormalizer::formatName(Format format)
+{
+    switch (format) {
+    case Unknown:           return "unknown";
+    case Em4100:            return "em4100";
+    case Em4100Checksum:    return "em4100-checksum";
+    case Decimal:           return "decimal";
+    case FacilityCard:      return "facility-card";
+    case Wiegand26:         return "wiegand26";
+    case Wiegand34:         return "wiegand34";
+    case HidProx37:         return "hid-prox37";
+    case MifareUid:         return "mifare-uid";
+    case FormatCount:       break;
+    }
+    Q_ASSERT(false);
+    return "";
+}
+
+bool CardNormalizer::parseHex(const char* data, int length, quint64* value)
+{
+    Q_ASSERT(length >= 0 && length <= 16);
+
+    quint64 result = 0;
+    int offset = 0;
+    for (; offset + 8 <= length; offset += 8) {
+        quint32 chunk;
+        if (!parseHex8(data + offset,&chunk))
+            return false;
+        result = (result << 32) | chunk;
+    }
+
+    for (; offset < length; offset++) {
+        const int digit = hexDigit(data[offset]);
+        if (digit < 0)
+            return false;
+        result = (result << 4) | quint64(digit);
+    }
+
+    *value = result;
+    return true;
+}
+
+bool CardNormalizer::parseDecimal(const char* data, int length, quint64* value)
+{
+    Q_ASSERT(length >= 0 && length <= 19);
+
+    quint64 result = 0;
+    int offset = 0;
+    for (; offset + 8 <= length; offset += 8) {
+        quint32 chunk;
+        if (!parseDecimal8(data + offset,&chunk))
+            return false;
+        result = result * 100000000 + chunk;
+    }
+
+    for (; offset < length; offset++) {
+        if (data[offset] < '0' || data[offset] > '9')
+            return false;
+        result = result * 10 + quint64(data[offset] - '0');
+    }
+
+    *value = result;
+    return true;
+}
+
+CardNormalizer::Format CardNormalizer::_detect(const char* key, int length, char* output, int* outputLength) const
+{
+    //Serial readers often wrap the frame into STX/ETX and pad it with spaces
+    while (length > 0 && (key[0] == 0x02 || key[0] == ' ' || key[0] == '\t')) {
+        key++;
+        length--;
+    }
+    while (length > 0 && (key[length - 1] == 0x03 || key[length - 1] == ' ' || key[length - 1] == '\t'))
+        length--;
+
+    if (length == 0)
+        return Unknown;
+
+    quint8 uid[MAX_UID_BYTES];
+
+    //MIFARE UID with separators: "XX:XX:XX:XX"
+    if (length >= 11 && (length + 1) % 3 == 0 && isSeparator(key[2])) {
+        const int count = (length + 1) / 3;
+        if (count == 4 || count == 7 || count == 10) {
+            bool valid = true;
+            for (int i = 0; i < count && valid; i++) {
+                quint64 byte = 0;
+                valid = parseHex(key + i * 3,2,&byte) && (i == count - 1 || key[i * 3 + 2] == key[2]);
+                uid[i] = quint8(byte);
+            }
+            if (valid) {
+                *outputLength = _writeUid(uid,count,output);
+                return MifareUid;
+            }
+        }
+    }
+
+    //Wiegand frames as strings of bits
+    if (length == 26 || length == 34 || length == 37) {
+        bool bits = true;
+        for (int i = 0; i < length && bits; i++)
+            bits = (key[i] == '0' || key[i] == '1');
+
+        if (bits) {
+            const Format format = (length == 26) ? Wiegand26 : (length == 34) ? Wiegand34 : HidProx37;
+            const int evenEnd = (length == 26) ? 12 : (length == 34) ? 16 : 18;
+            const int oddStart = (length == 26) ? 13 : (length == 34) ? 17 : 18;
+
+            quint64 cardNumber = 0;
+            *outputLength = _checkWiegand(key,length,evenEnd,oddStart,&cardNumber) ? _writeProx(cardNumber,length - 2,output) : -1;
+            return format;
+        }
+    }
+
+    //"facility,card"
+    for (int comma = 1; comma <= 3 && comma < length; comma++) {
+        if (key[comma] != ',')
+            continue;
+
+        quint64 facility = 0;
+        quint64 card = 0;
+        const int cardLength = length - comma - 1;
+        if (cardLength >= 1 && cardLength <= 5 && parseDecimal(key,comma,&facility)
+                && parseDecimal(key + comma + 1,cardLength,&card) && facility <= 0xFF && card <= 0xFFFF) {
+            *outputLength = _writeProx((facility << 16) | card,24,output);
+            return FacilityCard;
+        }
+        break;
+    }
+
+    quint64 value = 0;
+
+    //EM4100 with XOR checksum of 5 data bytes. Other 12-digit hex keys (6-byte UIDs, UPC-A barcodes) are passed
+    //unchanged if checksum does not match
+    if (length == 12 && parseHex(key,12,&value)) {
+        quint8 checksum = 0;
+        for (int i = 1; i <= 5; i++)
+            checksum ^= quint8(value >> (i * 8));
+
+        if (checksum == quint8(value)) {
+            *outputLength = _writeProx(value >> 8,EM4100_BITS,output);
+            return Em4100Checksum;
+        }
+    }
+
+    //Decimal card number. Digits-only keys are valid hex too, so this check goes before hex formats. Shorter numbers
+    //are not accepted, as 8 digits are also 4-byte UIDs
+    if (length == PROX_DIGITS && parseDecimal(key,length,&value) && value <= 0xFFFFFFFF) {
+        *outputLength = _writeProx(value,32,output);
+        return Decimal;
+    }
+
+    if (length == 10 && parseHex(key,10,&value)) {
+        *outputLength = _writeProx(value,EM4100_BITS,output);
+        return Em4100;
+    }
+
+    //MIFARE UID without separators
+    if (length == 8 || length == 14 || length == 20) {
+        const int count = length / 2;
+        const int headLength = qMin(length,16);
+        quint64 head = 0;
+        quint64 tail = 0;
+        if (parseHex(key,headLength,&head) && parseHex(key + headLength,length - headLength,&tail)) {
+            const int headBytes = headLength / 2;
+            for (int i = 0; i < headBytes; i++)
+                uid[i] = quint8(head >> ((headBytes - 1 - i) * 8));
+            for (int i = headBytes; i < count; i++)
+                uid[i] = quint8(tail >> ((count - 1 - i) * 8));
+
+            *outputLength = _writeUid(uid,count,output);
+            return MifareUid;
+        }
+    }
+
+    return Unknown;
+}
+
+int CardNormalizer::_writeProx(quint64 cardNumber, int bits, char* output) const
+{
+    //Dropping upper bits of wider numbers would make different cards (e.g. EM4100 with other version byte) equal
+    quint64 value = (bits <= 32) ? (cardNumber & ((Q_UINT64_C(1) << m_proxBits) - 1)) : cardNumber;
+
+    int digits = (bits == EM4100_BITS) ? EM4100_DIGITS : PROX_DIGITS;
+    if (bits != EM4100_BITS) {
+        for (quint64 rest = value / Q_UINT64_C(10000000000); rest != 0; rest /= 10)
+            digits++;
+    }
+
+    for (int i = digits - 1; i >= 0; i--) {
+        output[i] = char('0' + value % 10);
+        value /= 10;
+    }
+
+    return digits;
+}
+
+int CardNormalizer::_writeUid(const quint8* bytes, int count, char* output) const
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    for (int i = 0; i < count; i++) {
+        const quint8 byte = m_reverseUid ? bytes[count - 1 - i] : bytes[i];
+        output[i * 2] = HEX_DIGITS[byte >> 4];
+        output[i * 2 + 1] = HEX_DIGITS[byte & 0x0F];
+    }
+
+    return count * 2;
+}
+
+bool CardNormalizer::_checkWiegand(const char* bits, int length, int evenEnd, int oddStart, quint64* value)
+{
+    int evenOnes = 0;
+    int oddOnes = 0;
+    quint64 frame = 0;
+
+    for (int i = 0; i < length; i++) {
+        const int bit = bits[i] - '0';
+        frame = (frame << 1) | quint64(bit);
+        if (i <= evenEnd)
+            evenOnes += bit;
+        if (i >= oddStart)
+            oddOnes += bit;
+    }
+
+    if ((evenOnes % 2) != 0 || (oddOnes % 2) != 1)
+        return false;
+
+    *value = (frame >> 1) & ((Q_UINT64_C(1) << (length - 2)) - 1);
+    return true;
+}
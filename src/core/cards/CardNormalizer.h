@@ -0,0 +1,141 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CARDNORMALIZER_H
+#define CARDNORMALIZER_H
+
+#include <QObject>
+
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
+/*!
+ *  @class CardNormalizer core/cards/CardNormalizer.h
+ *  @brief This class converts keys produced by readers in different encodings of the same card to one canonical form.
+ *  @details Same card can be reported as 10-digit decimal, as "facility,card" pair, or as raw Wiegand bits, depending
+ *           on the reader. All these proximity formats are reduced to the card number printed as 10-digit decimal, e.g.
+ *           "0012345678". Card numbers of formats up to 32 bits are reduced to lower proxBits bits. H10304 (35 bits)
+ *           numbers are kept whole, so they get 11 digits when their upper bits are set. EM4100 numbers (40 bits, hex
+ *           with or without XOR checksum) are printed as 13-digit decimal, e.g. "0000012345678": digits-only hex can
+ *           not be told apart from decimal, so EM4100 keys are not mixed with other card numbers. MIFARE UIDs (4, 7 or
+ *           10 bytes in hex, with or without separators) become uppercase hex without separators, optionally with
+ *           reversed byte order. Canonical forms of EM4100 cards, other proximity cards and UIDs differ in length, so
+ *           keys of different kinds never get the same one. Keys, which do not look like any known format, are not
+ *           changed.
+ *           Keys, which have the structure of known format, but fail its checksum or parity check, are invalid. The only
+ *           exception is EM4100 with checksum: 12 hex digits are also used by 6-byte UIDs and UPC-A barcodes, so such
+ *           keys are passed unchanged when checksum does not match.
+ *
+ *           Recognised formats (checked in this order):
+ *           - MIFARE UID with separators: "04:A1:B2:C3", "04 A1 B2 C3", "04-A1-B2-C3";
+ *           - Wiegand 26 (HID Prox H10301), Wiegand 34 and HID Prox H10304 (37 bits) as strings of '0'/'1' with
+ *             leading even and trailing odd parity bits;
+ *           - "facility,card" pair ("188,24910");
+ *           - EM4100 with checksum: 12 hex digits, last two are XOR of the data bytes (only if checksum matches);
+ *           - decimal card number: 10 digits;
+ *           - EM4100: 10 hex digits (digits-only keys, which fit 32 bits, are decimal);
+ *           - MIFARE UID: 8, 14 or 20 hex digits.
+ *
+ *           Hex and decimal digits are validated and converted 8 characters at a time within one 64-bit register
+ *           (SWAR), so normalizing a key takes few dozens of instructions and does not allocate memory.
+ *
+ *           Command keys are normalized in the same way (see Command::keyId), so command file needs only one entry
+ *           per card. As both sides use the same rules, keys, which were matching before, keep matching.
+ */
+
+class CardNormalizer
+{
+public:
+    enum Format {
+        Unknown,        /*!< @brief Key was passed unchanged */
+        Em4100,
+        Em4100Checksum,
+        Decimal,
+        FacilityCard,
+        Wiegand26,
+        Wiegand34,
+        HidProx37,
+        MifareUid,
+        FormatCount
+    };
+
+    static CardNormalizer* get() {
+        static CardNormalizer theOne;
+        return &theOne;
+    }
+
+    /*! @brief If disabled - all keys are passed unchanged */
+    void      setEnabled(bool state)                     { m_enabled = state; }
+    bool      isEnabled() const                          { return m_enabled; }
+
+    /*! @brief Number of lower bits of proximity card number, which are used (24...32), for formats up to 32 bits.
+     *         24 allows matching cards read by Wiegand 26 readers, which do not report upper bits, with cards read by
+     *         other readers */
+    void      setProxBits(int bits)                      { m_proxBits = qBound(24,bits,32); }
+    int       proxBits() const                           { return m_proxBits; }
+
+    /*! @brief If true - bytes of MIFARE UIDs are reversed (for readers reporting UIDs in little-endian order) */
+    void      setReverseUid(bool state)                  { m_reverseUid = state; }
+    bool      reverseUid() const                         { return m_reverseUid; }
+
+    /*! @brief Writes canonical form of length bytes of key to output, which must be able to hold at least length
+     *         bytes and 20 bytes. Returns length of canonical form, or -1 if key is invalid (checksum or parity
+     *         error). If format is not nullptr - detected format is stored there. Does not allocate memory */
+    int       normalize(const char* key, int length, char* output, Format* format = nullptr) const;
+
+    static const char* formatName(Format format);
+
+    /*! @brief Parses length (0...16) hex digits. Returns false if any character is not a hex digit */
+    static bool parseHex(const char* data, int length, quint64* value);
+
+    /*! @brief Parses length (0...19) decimal digits. Returns false if any character is not a digit */
+    static bool parseDecimal(const char* data, int length, quint64* value);
+
+private:
+    CardNormalizer();
+    Q_DISABLE_COPY(CardNormalizer)
+
+    Format    _detect(const char* key, int length, char* output, int* outputLength) const;
+
+    /*! @brief Writes card number of format with given width in bits. Numbers of formats up to 32 bits are reduced
+     *         to proxBits lower bits, wider ones are written whole. EM4100 numbers always get 13 digits */
+    int       _writeProx(quint64 cardNumber, int bits, char* output) const;
+    int       _writeUid(const quint8* bytes, int count, char* output) const;
+
+    /*! @brief Checks parity of Wiegand frame of '0'/'1' characters: bits 0...evenEnd should have even parity and
+     *         bits oddStart...length-1 - odd parity. If parity is correct - writes data bits (all bits without first
+     *         and last parity bits) to value */
+    static bool _checkWiegand(const char* bits, int length, int evenEnd, int oddStart, quint64* value);
+
+    bool      m_enabled;
+    int       m_proxBits;
+    bool      m_reverseUid;
+
+#ifdef METRICS
+    Counter*  p_normalizedCounters[FormatCount];
+    Counter*  p_invalidCounters[FormatCount];
+#endif //METRICS
+};
+#define cardNormalizer CardNormalizer::get()
+
+#endif // CARDNORMALIZER_H
@@ -0,0 +1,397 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "BatchCommand.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ChildSupervisor.h"
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+
+/*! @brief Metrics shared by all BatchCommand objects */
+struct BatchMetrics {
+    Counter*    records     = metricsRegistry->counter("rfid_batch_records_total","Records written to spools of batch commands.");
+    Counter*    spoolErrors = metricsRegistry->counter("rfid_batch_spool_errors_total","Records, which could not be written to spool.");
+    Counter*    delivered   = metricsRegistry->counter("rfid_batch_deliveries_total","Batches passed to programs.",
+                                                       MetricsRegistry::label("status","success"));
+    Counter*    failed      = metricsRegistry->counter("rfid_batch_deliveries_total","Batches passed to programs.",
+                                                       MetricsRegistry::label("status","failure"));
+};
+
+static BatchMetrics* batchMetrics()
+{
+    static BatchMetrics theOne;
+    return &theOne;
+}
+#endif //METRICS
+
+static const char DEFAULT_RECORD_TEMPLATE[] = "{ts}\t{device}\t{key}";
+
+/*! @brief Inflight files, which are being delivered. Kept apart from commands, so command, which replaces deleted one
+ *         (e.g. when file of commands is reloaded), does not deliver the same batch again while it is running */
+static QSet<QString>& activeDeliveries()
+{
+    static QSet<QString> theOne;
+    return theOne;
+}
+
+BatchCommand::BatchCommand(QObject* parent) :
+    ShellCommand(parent),
+    m_batchSize(DEFAULT_BATCH_SIZE),
+    m_interval(DEFAULT_INTERVAL),
+    m_delivery(FileDelivery),
+    m_recordTemplate(QLatin1String(DEFAULT_RECORD_TEMPLATE)),
+    m_spoolFd(-1),
+    m_pending(0)
+{}
+
+BatchCommand::BatchCommand(const QJsonObject& jsonObject, QObject* parent) :
+    ShellCommand(jsonObject,parent),
+    m_batchSize(qMax(1,jsonObject.value("batchSize").toInt(DEFAULT_BATCH_SIZE))),
+    m_interval(qMax(1,jsonObject.value("interval").toInt(DEFAULT_INTERVAL))),
+    m_delivery(deliveryFromName(jsonObject.value("delivery").toString())),
+    m_recordTemplate(jsonObject.value("record").toString(QLatin1String(DEFAULT_RECORD_TEMPLATE))),
+    m_spoolFile(jsonObject.value("spool").toString()),
+    m_spoolFd(-1),
+    m_pending(0)
+{
+    //Records left by previous run are delivered without waiting for the next tap
+    _openSpool();
+}
+
+BatchCommand::~BatchCommand()
+{
+    _closeSpool();
+}
+
+void BatchCommand::setBatchSize(int size)
+{
+    m_batchSize = qMax(1,size);
+    emit commandChanged();
+}
+
+void BatchCommand::setInterval(int intervalMs)
+{
+    m_interval = qMax(1,intervalMs);
+    emit commandChanged();
+}
+
+void BatchCommand::setDelivery(Delivery delivery)
+{
+    m_delivery = delivery;
+    emit commandChanged();
+}
+
+void BatchCommand::setRecordTemplate(const QString& recordTemplate)
+{
+    m_recordTemplate = CommandTemplate(recordTemplate);
+    emit commandChanged();
+}
+
+void BatchCommand::setSpoolFile(const QString& fileName)
+{
+    //Records of the previous spool stay there, new spool is opened (and recovered) with the next tap
+    _closeSpool();
+    m_spoolFile = fileName;
+    m_spoolPath.clear();
+    m_pending = 0;
+    emit commandChanged();
+}
+
+bool BatchCommand::execute(const KeyEvent& event, quint64 execution)
+{
+#ifdef TRACING
+    const quint64 spoolStart = KeyEvent::now();
+#endif //TRACING
+
+    if (m_spoolFd < 0)
+        _openSpool();
+
+    m_recordTemplate.render(event,&m_record);
+    m_record.replace('\n',' ');
+    m_record.append('\n');
+
+    //Spool is opened with O_APPEND, so record is written as a whole unless disk is full
+    const char* data = m_record.constData();
+    qint64 left = m_record.size();
+    while ((m_spoolFd >= 0) && (left > 0)) {
+        const ssize_t written = ::write(m_spoolFd,data,size_t(left));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+
+#ifdef TRACING
+    tracer->addSpan(event,"spool",spoolStart,KeyEvent::now());
+#endif //TRACING
+
+    if (left > 0) {
+        qWarning() << "Record of key"<<event.key()<<"was not written to spool"<<m_spoolPath<<":"<<strerror(errno);
+#ifdef METRICS
+        batchMetrics()->spoolErrors->increment();
+#endif //METRICS
+        finishExecution(execution,false);
+        return false;
+    }
+
+#ifdef METRICS
+    batchMetrics()->records->increment();
+#endif //METRICS
+
+    m_pending++;
+    if (m_pending >= m_batchSize) {
+        flush();
+    } else {
+        _scheduleFlush();
+    }
+
+    return true;
+}
+
+void BatchCommand::flush()
+{
+    timerWheel->cancel(this);
+
+    if (m_spoolPath.isEmpty())
+        _openSpool();
+
+    const QString inflightPath = _inflightPath();
+    if (activeDeliveries().contains(inflightPath)) {
+        //Spooled records are flushed when previous batch is delivered, or after interval if it belongs to command,
+        //which was deleted
+        _scheduleFlush();
+        return;
+    }
+
+    //Batch, which has failed before, is delivered first, so records are not reordered
+    if (!QFile::exists(inflightPath)) {
+        if (m_pending == 0)
+            return;
+
+        _closeSpool();
+        if (::rename(QFile::encodeName(m_spoolPath).constData(),QFile::encodeName(inflightPath).constData()) < 0) {
+            qWarning() << "Spool"<<m_spoolPath<<"can not be flushed:"<<strerror(errno);
+            _openSpool();
+            _scheduleFlush();
+            return;
+        }
+        m_pending = 0;
+    }
+
+    const QByteArray encodedInflightPath = QFile::encodeName(inflightPath);
+    QVector<QByteArray> encodedArguments;
+    for (const QString& argument : arguments())
+        encodedArguments.append(argument.toLocal8Bit());
+
+    QVector<QByteArray> encodedEnvironment;
+    const QMap<QString,QString> variables = environment();
+    for (auto it = variables.constBegin(); it != variables.constEnd(); ++it)
+        encodedEnvironment.append((it.key() + QLatin1Char('=') + it.value()).toLocal8Bit());
+
+    ChildSupervisor::Options options;
+    options.timeout = quint64(timeout()) * 1000 * 1000;
+    options.killTimeout = quint64(killTimeout()) * 1000 * 1000;
+    options.outputLimit = captureOutput();
+    options.environment = &encodedEnvironment;
+
+    switch (m_delivery) {
+    case FileDelivery:
+        encodedArguments.append(encodedInflightPath);
+        break;
+    case StdinDelivery:
+        options.input = encodedInflightPath.constData();
+        break;
+    case ArgumentsDelivery: {
+        QFile inflightFile(inflightPath);
+        if (inflightFile.open(QIODevice::ReadOnly)) {
+            for (const QByteArray& record : inflightFile.readAll().split('\n')) {
+                if (!record.isEmpty())
+                    encodedArguments.append(record);
+            }
+        }
+        break;
+    }
+    }
+
+    //Callback does not rely on this command, inflight file is removed also if command was deleted meanwhile
+    QPointer<BatchCommand> self(this);
+    const auto delivered = [self,inflightPath](const ChildExit& exit) {
+        activeDeliveries().remove(inflightPath);
+        if (exit.isSuccess())
+            QFile::remove(inflightPath);
+
+#ifdef METRICS
+        (exit.isSuccess() ? batchMetrics()->delivered : batchMetrics()->failed)->increment();
+#endif //METRICS
+
+        if (!self.isNull())
+            self->_delivered(exit.isSuccess());
+    };
+
+    activeDeliveries().insert(inflightPath);
+    if (childSupervisor->spawn(program(),encodedArguments,options,delivered) == 0) {
+        activeDeliveries().remove(inflightPath);
+#ifdef METRICS
+        batchMetrics()->failed->increment();
+#endif //METRICS
+        _delivered(false);
+    }
+}
+
+void BatchCommand::_delivered(bool success)
+{
+    //Failed batch stays in place and is retried after interval together with records spooled meanwhile
+    if (success && (m_pending >= m_batchSize)) {
+        flush();
+    } else if (!success || (m_pending > 0)) {
+        _scheduleFlush();
+    }
+}
+
+void BatchCommand::_scheduleFlush()
+{
+    if (!timerWheel->isScheduled(this))
+        timerWheel->schedule(this,timerWheel->now() + quint64(m_interval) * 1000 * 1000);
+}
+
+void BatchCommand::_openSpool()
+{
+    if (m_spoolPath.isEmpty())
+        m_spoolPath = m_spoolFile.isEmpty() ? _defaultSpoolPath() : m_spoolFile;
+
+    QDir().mkpath(QFileInfo(m_spoolPath).absolutePath());
+    m_spoolFd = ::open(QFile::encodeName(m_spoolPath).constData(),O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,0600);
+    if (m_spoolFd < 0) {
+        qWarning() << "Spool"<<m_spoolPath<<"can not be opened:"<<strerror(errno);
+        return;
+    }
+
+    //Records left by previous run (or by deleted command with the same spool)
+    m_pending = 0;
+    QFile spool(m_spoolPath);
+    if (spool.open(QIODevice::ReadOnly)) {
+        char buffer[4096];
+        qint64 length = 0;
+        while ((length = spool.read(buffer,sizeof(buffer))) > 0)
+            m_pending += int(std::count(buffer,buffer + length,'\n'));
+    }
+
+    if ((m_pending > 0) || QFile::exists(_inflightPath()))
+        _scheduleFlush();
+}
+
+void BatchCommand::_closeSpool()
+{
+    if (m_spoolFd >= 0)
+        ::close(m_spoolFd);
+    m_spoolFd = -1;
+}
+
+QString BatchCommand::_defaultSpoolPath() const
+{
+    //Key alone is shared by all batch commands of one card. Records go to the program, so it is a part of the name
+    QCryptographicHash name(QCryptographicHash::Sha1);
+    name.addData(hasKeyDigest() ? keyDigest() : key().toUtf8());
+    name.addData("\0",1);
+    name.addData(program().toUtf8());
+    for (const QString& argument : arguments()) {
+        name.addData("\0",1);
+        name.addData(argument.toUtf8());
+    }
+    const QString hash = QString::fromLatin1(name.result().toHex().left(16));
+
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+            + QLatin1String("/spool/batch-") + hash + QLatin1String(".spool");
+}
+
+QString BatchCommand::deliveryName(Delivery delivery)
+{
+    switch (delivery) {
+    case FileDelivery:
+        return QStringLiteral("file");
+    case StdinDelivery:
+        return QStringLiteral("stdin");
+    case ArgumentsDelivery:
+        return QStringLiteral("arguments");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+BatchCommand::Delivery BatchCommand::deliveryFromName(const QString& name)
+{
+    if (name == QLatin1String("stdin"))
+        return StdinDelivery;
+    if (name == QLatin1String("arguments"))
+        return ArgumentsDelivery;
+
+    return FileDelivery;
+}
+
+QJsonObject BatchCommand::toJson() const
+{
+    QJsonObject result = ShellCommand::toJson();
+    result.insert("type","batch");
+
+    //Only settings, which differ from defaults, are written
+    if (m_batchSize != DEFAULT_BATCH_SIZE)
+        result.insert("batchSize",m_batchSize);
+    if (m_interval != DEFAULT_INTERVAL)
+        result.insert("interval",m_interval);
+    if (m_delivery != FileDelivery)
+        result.insert("delivery",deliveryName(m_delivery));
+    if (m_recordTemplate.text() != QLatin1String(DEFAULT_RECORD_TEMPLATE))
+        result.insert("record",m_recordTemplate.text());
+
+    //Default file is named after the key, which changes e.g. when keys are hashed on save, so it is written as well
+    if (!m_spoolFile.isEmpty()) {
+        result.insert("spool",m_spoolFile);
+    } else {
+        result.insert("spool",m_spoolPath.isEmpty() ? _defaultSpoolPath() : m_spoolPath);
+    }
+
+    return result;
+}
@@ -0,0 +1,138 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BATCHCOMMAND_H
+#define BATCHCOMMAND_H
+
+#include "ShellCommand.h"
+#include "core/TimerWheel.h"
+
+/*!
+ *  @class BatchCommand core/commands/BatchCommand.h
+ *  @brief This class collects taps of its key and runs program once for the whole batch of them.
+ *  @details Every matched tap is rendered with recordTemplate (see CommandTemplate) into one line and appended to the
+ *           spool file, so e.g. 2000 badges at shift change cost a few processes instead of 2000. Batch is flushed
+ *           when batchSize records are spooled, or interval milliseconds after the first of them. Flushing renames
+ *           spool file to "<spool>.inflight" and runs program with records passed according to delivery:
+ *           - FileDelivery - path of the inflight file is appended to the arguments;
+ *           - StdinDelivery - inflight file is connected to stdin of the process;
+ *           - ArgumentsDelivery - each record is appended to the arguments.
+ *
+ *           Inflight file is removed only when program exits with code 0, otherwise it is delivered again after
+ *           interval. Records are written to the spool before tap is finished, and files left by previous run of
+ *           this program are delivered after start, so every record is delivered at least once (records are not
+ *           synced to disk, so they survive crash of this program, but not of the system). Program must tolerate
+ *           duplicates. Only one batch of the spool is delivered at a time, spool must not be shared between
+ *           commands. Commands with the same key, program and arguments must set different spool files.
+ *
+ *           Arguments and environment of the command are passed as they are - templates are rendered only into
+ *           records.
+ */
+
+class BatchCommand : public ShellCommand, private TimerWheel::Client
+{
+    Q_OBJECT
+public:
+    explicit BatchCommand(QObject* parent = nullptr);
+    explicit BatchCommand(const QJsonObject& jsonObject, QObject* parent = nullptr);
+    ~BatchCommand();
+
+    /*! @brief This enum describes how records of the batch are passed to the program */
+    enum Delivery {
+        FileDelivery,
+        StdinDelivery,
+        ArgumentsDelivery
+    };
+
+    static const int DEFAULT_BATCH_SIZE = 100;
+    static const int DEFAULT_INTERVAL = 10000;
+
+    /*! @brief Type of this object. Represented by Batch value from Command::Type enum */
+    Type           type() const override { return Batch; };
+
+    /*! @brief Number of records, which triggers flush */
+    void           setBatchSize(int size);
+    int            batchSize() const                            { return m_batchSize; }
+
+    /*! @brief Milliseconds between the first spooled record and flush. Also delay between failed delivery and retry */
+    void           setInterval(int intervalMs);
+    int            interval() const                             { return m_interval; }
+
+    void           setDelivery(Delivery delivery);
+    Delivery       delivery() const                             { return m_delivery; }
+
+    /*! @brief Template of one record, see CommandTemplate. Newlines in rendered records are replaced by spaces */
+    void           setRecordTemplate(const QString& recordTemplate);
+    QString        recordTemplate() const                       { return m_recordTemplate.text(); }
+
+    /*! @brief Spool file of this command. If not set - file within application data directory, named after the key,
+     *         program and arguments of the command, so only commands running the same program for the same key share
+     *         it. Steps of PipelineCommand have no keys and need spool set explicitly. File is chosen, when spool is
+     *         opened for the first time, and is saved to JSON - so records are not left behind in the old file when
+     *         key is hashed or command is edited */
+    void           setSpoolFile(const QString& fileName);
+    QString        spoolFile() const                            { return m_spoolFile; }
+    QString        spoolFilePath() const                        { return m_spoolPath; }
+
+    /*! @brief Number of records in the spool, which are not being delivered */
+    int            pendingCount() const                         { return m_pending; }
+
+    /*! @brief Starts delivery of spooled records (and of batch, which has failed before), if it is not running */
+    void           flush();
+
+    static QString  deliveryName(Delivery delivery);
+    static Delivery deliveryFromName(const QString& name);
+
+    /*! @brief Serialize this BatchCommand object to JSON. */
+    QJsonObject    toJson() const override;
+
+protected:
+    /*! @brief Appends record of event to the spool. Execution succeeds, when record is written */
+    bool           execute(const KeyEvent& event, quint64 execution) override;
+    void           _timerWheelExpired(quint64 now) override     { Q_UNUSED(now); flush(); }
+
+private:
+    Q_DISABLE_COPY(BatchCommand);
+
+    /*! @brief Opens spool, counts records left by previous run and schedules their delivery */
+    void           _openSpool();
+    void           _closeSpool();
+
+    /*! @brief Called when program, which has got batch, has exited (or could not be started) */
+    void           _delivered(bool success);
+    void           _scheduleFlush();
+
+    QString        _defaultSpoolPath() const;
+    QString        _inflightPath() const                        { return m_spoolPath + QLatin1String(".inflight"); }
+
+    int            m_batchSize;
+    int            m_interval;
+    Delivery       m_delivery;
+    CommandTemplate m_recordTemplate;
+    QString        m_spoolFile;
+    QString        m_spoolPath;       //!< @brief Spool file in use (m_spoolFile or default one)
+    int            m_spoolFd;
+    int            m_pending;
+    QByteArray     m_record;          //!< @brief Kept between taps, so rendering does not allocate
+};
+
+#endif // BATCHCOMMAND_H
@@ -0,0 +1,93 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CHILDEXIT_H
+#define CHILDEXIT_H
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+
+/*!
+ *  @class ChildExit core/commands/ChildExit.h
+ *  @brief This class holds information about finished child process, see ChildSupervisor.
+ */
+
+class ChildExit
+{
+public:
+    /*! @brief This enum describes how child process has finished */
+    enum Status {
+        Exited,         /*!< @brief Process has exited, see ChildExit::exitCode */
+        Killed,         /*!< @brief Process was terminated by signal, see ChildExit::signal */
+        FailedToStart   /*!< @brief Process could not be started, see ChildExit::errorString */
+    };
+
+    ChildExit()
+        : m_child(0),m_pid(0),m_status(FailedToStart),m_exitCode(-1),m_signal(0),m_timedOut(false),m_runtime(0),
+          m_outputTruncated(false) {}
+
+    /*! @brief Id returned by ChildSupervisor::spawn, 0 if process could not be started */
+    quint64     child() const                      { return m_child; }
+    QString     program() const                    { return m_program; }
+    qint64      pid() const                        { return m_pid; }
+
+    Status      status() const                     { return m_status; }
+    int         exitCode() const                   { return m_exitCode; }
+    int         signal() const                     { return m_signal; }
+
+    /*! @brief True if process was signalled, because it has not finished within timeout */
+    bool        timedOut() const                   { return m_timedOut; }
+
+    /*! @brief Time between start and exit of the process in nanoseconds */
+    quint64     runtime() const                    { return m_runtime; }
+
+    /*! @brief Captured output of the process, empty if capturing was not requested */
+    QByteArray  standardOutput() const             { return m_standardOutput; }
+    QByteArray  standardError() const              { return m_standardError; }
+
+    /*! @brief True if process has written more, than was captured */
+    bool        outputTruncated() const            { return m_outputTruncated; }
+
+    QString     errorString() const                { return m_errorString; }
+
+    bool        isSuccess() const                  { return (m_status == Exited) && (m_exitCode == 0) && !m_timedOut; }
+
+private:
+    friend class ChildSupervisor;
+
+    quint64     m_child;
+    QString     m_program;
+    qint64      m_pid;
+    Status      m_status;
+    int         m_exitCode;
+    int         m_signal;
+    bool        m_timedOut;
+    quint64     m_runtime;
+    QByteArray  m_standardOutput;
+    QByteArray  m_standardError;
+    bool        m_outputTruncated;
+    QString     m_errorString;
+};
+Q_DECLARE_METATYPE(ChildExit)
+
+#endif // CHILDEXIT_H
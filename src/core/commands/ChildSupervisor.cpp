@@ -0,0 +1,500 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ChildSupervisor.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QVector>
+
+#include "core/KeyEvent.h"
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <spawn.h>
+    #include <string.h>
+    #include <sys/epoll.h>
+    #include <sys/syscall.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#elif
+    #error("Builds for other platforms are not supported")
+#endif
+
+#ifndef __NR_pidfd_open
+    #define __NR_pidfd_open 434
+#endif
+
+extern char** environ;
+
+static const int MAX_READ_SIZE = 4096;
+
+//Child, which writes without pause, should not hold the event loop. Pipe is level-triggered, so the rest is read
+//on the next wakeup
+static const int MAX_READS_PER_WAKEUP = 16;
+
+static inline quint64 epollData(quint64 child, int descriptor)
+{
+    return (child << 2) | quint64(descriptor);
+}
+
+ChildSupervisor::ChildSupervisor()
+    : QObject(nullptr),
+    m_epollHandle(-1),
+    p_epollNotifier(nullptr),
+    m_pidfdSupported(false),
+    m_nextChild(0)
+#ifdef METRICS
+    ,p_runningGauge(metricsRegistry->gauge("rfid_children_running","Child processes of commands, which are running.")),
+    p_spawnedCounter(metricsRegistry->counter("rfid_children_spawned_total","Child processes started by commands.")),
+    p_succeededCounter(metricsRegistry->counter("rfid_children_exited_total","Child processes, which have finished.",
+                                                MetricsRegistry::label("status","success"))),
+    p_failedCounter(metricsRegistry->counter("rfid_children_exited_total","Child processes, which have finished.",
+                                             MetricsRegistry::label("status","failure"))),
+    p_killedCounter(metricsRegistry->counter("rfid_children_exited_total","Child processes, which have finished.",
+                                             MetricsRegistry::label("status","signal"))),
+    p_timedOutCounter(metricsRegistry->counter("rfid_children_exited_total","Child processes, which have finished.",
+                                               MetricsRegistry::label("status","timeout"))),
+    p_notStartedCounter(metricsRegistry->counter("rfid_children_spawn_errors_total","Child processes, which could not be started.")),
+    p_truncatedCounter(metricsRegistry->counter("rfid_children_output_truncated_total",
+                                                "Child processes, which have written more than was captured.")),
+    p_runtime(metricsRegistry->histogram("rfid_child_runtime_seconds","Time between start and exit of child processes.")),
+    p_spawnDuration(metricsRegistry->histogram("rfid_child_spawn_duration_seconds","Time spent starting child processes."))
+#endif //METRICS
+{
+    //Children are TimerWheel clients, so TimerWheel has to be created first and destroyed after this object
+    timerWheel->now();
+
+    m_pollTimer.setInterval(POLL_INTERVAL_MS);
+    connect(&m_pollTimer,&QTimer::timeout,this,&ChildSupervisor::_pollChildren);
+
+    m_epollHandle = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollHandle < 0) {
+        qDebug() << "epoll_create1() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return;
+    }
+
+    p_epollNotifier = new QSocketNotifier(m_epollHandle,QSocketNotifier::Read,this);
+    connect(p_epollNotifier,&QSocketNotifier::activated,this,&ChildSupervisor::_epollReady);
+
+    //pidfd of this process tells whether kernel supports them at all
+    const int pidfd = int(syscall(__NR_pidfd_open,getpid(),0));
+    if (pidfd >= 0) {
+        m_pidfdSupported = true;
+        ::close(pidfd);
+    }
+}
+
+ChildSupervisor::~ChildSupervisor()
+{
+    //Running children are left alone, as detached processes were
+    for (Child* child : qAsConst(m_children)) {
+        if (child->m_pidfd >= 0)
+            ::close(child->m_pidfd);
+        for (int stream = 0; stream < 2; stream++) {
+            if (child->m_outputFds[stream] >= 0)
+                ::close(child->m_outputFds[stream]);
+        }
+        delete child;
+    }
+
+    if (m_epollHandle >= 0)
+        ::close(m_epollHandle);
+}
+
+quint64 ChildSupervisor::spawn(const QString& program, const QStringList& arguments, const Options& options,
+                               const Callback& finished, QString* errorString)
+{
+    QVector<QByteArray> encodedArguments;
+    encodedArguments.reserve(arguments.size());
+    for (const QString& argument : arguments)
+        encodedArguments.append(argument.toLocal8Bit());
+
+    return spawn(program,encodedArguments,options,finished,errorString);
+}
+
+quint64 ChildSupervisor::spawn(const QString& program, const QVector<QByteArray>& arguments, const Options& options,
+                               const Callback& finished, QString* errorString)
+{
+#ifdef METRICS
+    ScopedDuration spawnDuration(p_spawnDuration);
+#endif //METRICS
+
+    //posix_spawn does not modify argv and envp, they are declared non-const only for compatibility
+    const QByteArray encodedProgram = QFile::encodeName(program);
+    QVector<char*> argv;
+    argv.reserve(arguments.size() + 2);
+    argv.append(const_cast<char*>(encodedProgram.constData()));
+    for (const QByteArray& argument : arguments)
+        argv.append(const_cast<char*>(argument.constData()));
+    argv.append(nullptr);
+
+    QVector<char*> envp;
+    if (options.environment != nullptr && !options.environment->isEmpty()) {
+        for (char** variable = environ; *variable != nullptr; variable++) {
+            if (!_overridden(*variable,*options.environment))
+                envp.append(*variable);
+        }
+        for (const QByteArray& variable : *options.environment)
+            envp.append(const_cast<char*>(variable.constData()));
+        envp.append(nullptr);
+    }
+
+    const bool capture = (options.outputLimit > 0) && (m_epollHandle >= 0);
+    int pipes[2][2] = { { -1, -1 }, { -1, -1 } };
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions,STDIN_FILENO,(options.input != nullptr) ? options.input : "/dev/null",
+                                     O_RDONLY,0);
+
+    int error = 0;
+    for (int stream = 0; capture && (stream < 2) && (error == 0); stream++) {
+        //Both ends are closed on exec, dup2 clears the flag of the end given to the child
+        if (pipe2(pipes[stream],O_CLOEXEC) < 0) {
+            error = errno;
+            break;
+        }
+        posix_spawn_file_actions_adddup2(&actions,pipes[stream][1],STDOUT_FILENO + stream);
+    }
+
+    //Own process group, so timeouts reach processes started by the child as well
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signalMask;
+    sigemptyset(&signalMask);
+    posix_spawnattr_setsigmask(&attributes,&signalMask);
+    posix_spawnattr_setpgroup(&attributes,0);
+    posix_spawnattr_setflags(&attributes,POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid = 0;
+    if (error == 0)
+        error = posix_spawnp(&pid,argv.at(0),&actions,&attributes,argv.data(),envp.isEmpty() ? environ : envp.data());
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+
+    for (int stream = 0; stream < 2; stream++) {
+        if (pipes[stream][1] >= 0)
+            ::close(pipes[stream][1]);
+        if ((error != 0) && (pipes[stream][0] >= 0))
+            ::close(pipes[stream][0]);
+    }
+
+    if (error != 0) {
+        const QString message = QString::fromLocal8Bit(strerror(error));
+        if (errorString != nullptr)
+            *errorString = message;
+        _failed(program,message);
+        return 0;
+    }
+
+    Child* child = new Child(this);
+    child->m_exit.m_child = ++m_nextChild;
+    child->m_exit.m_program = program;
+    child->m_exit.m_pid = pid;
+    child->m_outputLimit = capture ? options.outputLimit : 0;
+    child->m_startedAt = KeyEvent::now();
+    child->m_killTimeout = options.killTimeout;
+    child->m_finished = finished;
+    m_children.insert(child->m_exit.m_child,child);
+
+    //Child is not reaped till its pidfd is readable, so pid can not be reused before pidfd_open
+    if (m_pidfdSupported && (m_epollHandle >= 0)) {
+        child->m_pidfd = int(syscall(__NR_pidfd_open,pid,0));
+        if ((child->m_pidfd >= 0) && !_watch(child,PidDescriptor,child->m_pidfd)) {
+            ::close(child->m_pidfd);
+            child->m_pidfd = -1;
+        }
+    }
+    if ((child->m_pidfd < 0) && !m_pollTimer.isActive())
+        m_pollTimer.start();
+
+    for (int stream = 0; capture && (stream < 2); stream++) {
+        child->m_outputFds[stream] = pipes[stream][0];
+        const int flags = fcntl(pipes[stream][0],F_GETFL);
+        if ((flags < 0) || (fcntl(pipes[stream][0],F_SETFL,flags | O_NONBLOCK) < 0)
+                || !_watch(child,Descriptor(OutputDescriptor + stream),pipes[stream][0])) {
+            qDebug() << "Output of"<<program<<"can not be captured; strerror(errno)="<<strerror(errno);
+            ::close(pipes[stream][0]);
+            child->m_outputFds[stream] = -1;
+        }
+    }
+
+    if (options.timeout > 0)
+        timerWheel->schedule(child,timerWheel->now() + options.timeout);
+
+#ifdef METRICS
+    p_spawnedCounter->increment();
+    p_runningGauge->set(m_children.size());
+#endif //METRICS
+
+    return child->m_exit.m_child;
+}
+
+bool ChildSupervisor::_overridden(const char* variable, const QVector<QByteArray>& environment)
+{
+    const char* separator = strchr(variable,'=');
+    const int nameLength = (separator == nullptr) ? int(strlen(variable)) : int(separator - variable);
+
+    for (const QByteArray& entry : environment) {
+        if ((entry.size() > nameLength) && (entry.at(nameLength) == '=')
+                && (memcmp(entry.constData(),variable,nameLength) == 0))
+            return true;
+    }
+    return false;
+}
+
+void ChildSupervisor::_epollReady()
+{
+    //If more descriptors are ready - epoll descriptor stays readable and we will be called again
+    static const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    const int ready = epoll_wait(m_epollHandle, events, MAX_EVENTS, 0);
+    if (ready < 0) {
+        if (errno != EINTR)
+            qDebug() << "epoll_wait() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return;
+    }
+
+    for (int i = 0; i < ready; i++) {
+        //Child can be finished by processing of the previous events
+        Child* child = m_children.value(events[i].data.u64 >> 2);
+        if (child == nullptr)
+            continue;
+
+        const int descriptor = int(events[i].data.u64 & 3);
+        if (descriptor == PidDescriptor) {
+            if (_reap(child))
+                _finish(child);
+        } else {
+            _readOutput(child,descriptor - OutputDescriptor);
+        }
+    }
+}
+
+void ChildSupervisor::_pollChildren()
+{
+    QVector<Child*> exited;
+    int polled = 0;
+    for (Child* child : qAsConst(m_children)) {
+        if (child->m_pidfd >= 0)
+            continue;
+
+        polled++;
+        if (_reap(child))
+            exited.append(child);
+    }
+
+    //Callbacks can start new polled children, which restart the timer
+    if (polled == exited.size())
+        m_pollTimer.stop();
+
+    for (Child* child : qAsConst(exited))
+        _finish(child);
+}
+
+bool ChildSupervisor::_watch(Child* child, Descriptor descriptor, int fd)
+{
+    struct epoll_event event;
+    memset(&event,0,sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = epollData(child->m_exit.m_child,descriptor);
+    return epoll_ctl(m_epollHandle, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void ChildSupervisor::_unwatch(int fd)
+{
+    if (epoll_ctl(m_epollHandle, EPOLL_CTL_DEL, fd, nullptr) < 0)
+        qDebug() << "epoll_ctl(EPOLL_CTL_DEL) call failed for fd="<<fd<<"; strerror(errno)="<<strerror(errno);
+}
+
+void ChildSupervisor::_readOutput(Child* child, int stream)
+{
+    char buffer[MAX_READ_SIZE];
+    QByteArray& output = (stream == 0) ? child->m_exit.m_standardOutput : child->m_exit.m_standardError;
+
+    for (int reads = 0; reads < MAX_READS_PER_WAKEUP; reads++) {
+        const int fd = child->m_outputFds[stream];
+        if (fd < 0)
+            return;
+
+        const ssize_t reading = read(fd, buffer, sizeof(buffer));
+        if (reading > 0) {
+            const int kept = qMin(int(reading),qMax(0,child->m_outputLimit - output.size()));
+            output.append(buffer,kept);
+            if (kept < reading)
+                child->m_exit.m_outputTruncated = true;
+            continue;
+        }
+
+        if (reading < 0 && errno == EINTR)
+            continue;
+
+        if (reading < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        //End of file, or pipe can not be read anymore
+        _closeOutput(child,stream);
+        return;
+    }
+}
+
+void ChildSupervisor::_closeOutput(Child* child, int stream)
+{
+    if (child->m_outputFds[stream] < 0)
+        return;
+
+    _unwatch(child->m_outputFds[stream]);
+    ::close(child->m_outputFds[stream]);
+    child->m_outputFds[stream] = -1;
+}
+
+bool ChildSupervisor::_reap(Child* child)
+{
+    siginfo_t info;
+    memset(&info,0,sizeof(info));
+
+    int result;
+    do {
+        result = waitid(P_PID, id_t(child->m_exit.m_pid), &info, WEXITED | WNOHANG);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        //Reaped by somebody else (e.g. SIGCHLD is ignored), exit status is lost
+        qDebug() << "waitid() call failed for pid="<<child->m_exit.m_pid<<"; strerror(errno)="<<strerror(errno);
+        child->m_exit.m_status = ChildExit::Exited;
+        child->m_exit.m_exitCode = -1;
+        return true;
+    }
+
+    if (info.si_pid == 0)
+        return false;
+
+    if (info.si_code == CLD_EXITED) {
+        child->m_exit.m_status = ChildExit::Exited;
+        child->m_exit.m_exitCode = info.si_status;
+    } else {
+        child->m_exit.m_status = ChildExit::Killed;
+        child->m_exit.m_signal = info.si_status;
+    }
+    return true;
+}
+
+void ChildSupervisor::_timeout(Child* child, quint64 now)
+{
+    if (!child->m_exit.m_timedOut) {
+        child->m_exit.m_timedOut = true;
+        if (child->m_killTimeout > 0) {
+            _signal(child,SIGTERM);
+            timerWheel->schedule(child,now + child->m_killTimeout);
+            return;
+        }
+    }
+
+    _signal(child,SIGKILL);
+}
+
+void ChildSupervisor::_signal(Child* child, int signal)
+{
+    //Child is not reaped yet, so its process group still exists, even if child itself has exited
+    if (kill(-pid_t(child->m_exit.m_pid), signal) < 0)
+        qDebug() << "kill() call failed for pid="<<child->m_exit.m_pid<<"; strerror(errno)="<<strerror(errno);
+}
+
+void ChildSupervisor::_finish(Child* child)
+{
+    m_children.remove(child->m_exit.m_child);
+    timerWheel->cancel(child);
+
+    //Output written right before exit is still in the pipes (MAX_READS_PER_WAKEUP reads take the whole pipe buffer).
+    //Processes started by the child can keep pipes opened, their output is not waited for
+    for (int stream = 0; stream < 2; stream++) {
+        _readOutput(child,stream);
+        _closeOutput(child,stream);
+    }
+
+    if (child->m_pidfd >= 0) {
+        _unwatch(child->m_pidfd);
+        ::close(child->m_pidfd);
+        child->m_pidfd = -1;
+    }
+
+    child->m_exit.m_runtime = KeyEvent::now() - child->m_startedAt;
+    _count(child->m_exit);
+
+    //Callback can start new children, so this child is already forgotten
+    if (child->m_finished)
+        child->m_finished(child->m_exit);
+    emit childFinished(child->m_exit);
+
+    delete child;
+}
+
+void ChildSupervisor::_failed(const QString& program, const QString& errorString)
+{
+    qWarning() << "Failed to start"<<program<<":"<<errorString;
+
+    ChildExit exit;
+    exit.m_program = program;
+    exit.m_errorString = errorString;
+    _count(exit);
+
+    emit childFinished(exit);
+}
+
+void ChildSupervisor::_count(const ChildExit& exit)
+{
+#ifdef METRICS
+    p_runningGauge->set(m_children.size());
+
+    if (exit.status() == ChildExit::FailedToStart) {
+        p_notStartedCounter->increment();
+        return;
+    }
+
+    if (exit.timedOut()) {
+        p_timedOutCounter->increment();
+    } else if (exit.status() == ChildExit::Killed) {
+        p_killedCounter->increment();
+    } else if (exit.exitCode() == 0) {
+        p_succeededCounter->increment();
+    } else {
+        p_failedCounter->increment();
+    }
+
+    if (exit.outputTruncated())
+        p_truncatedCounter->increment();
+    p_runtime->record(exit.runtime());
+#else
+    Q_UNUSED(exit);
+#endif //METRICS
+}
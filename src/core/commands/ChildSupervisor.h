@@ -0,0 +1,194 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CHILDSUPERVISOR_H
+#define CHILDSUPERVISOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+#if defined(Q_OS_LINUX) && !defined (Q_OS_ANDROID)
+    #include <QSocketNotifier>
+    #include <QTimer>
+#elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
+    #error("Android builds currently not supported")
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#else
+    #error("Builds for other platforms are not supported")
+#endif //PLATFORM SPECIFIC
+
+#include "core/TimerWheel.h"
+#include "ChildExit.h"
+
+#ifdef METRICS
+    #include "core/metrics/Metrics.h"
+#endif //METRICS
+
+/*!
+ *  @class ChildSupervisor core/commands/ChildSupervisor.h
+ *  @brief This class starts child processes of commands and tracks them till they exit.
+ *  @details Processes are started with posix_spawn in their own process group, with stdin connected to /dev/null
+ *           (or to the input file given in options).
+ *           Each child is watched through pidfd, all pidfds (and pipes of captured output) are registered within one
+ *           epoll instance and only the epoll descriptor itself is watched by Qt event loop, so thousands of running
+ *           children cost neither QObject nor QSocketNotifier each. On kernels without pidfd (before 5.3) children
+ *           are polled with waitid every POLL_INTERVAL_MS.
+ *
+ *           If timeout is set - process group of the child gets SIGTERM when it expires and SIGKILL if it is still
+ *           running after killTimeout more. Timeouts are driven by the TimerWheel.
+ *
+ *           Output is captured only if outputLimit is set. Pipes are read without blocking as data comes, first
+ *           outputLimit bytes of stdout and stderr are kept, the rest is read and discarded, so child never blocks
+ *           on the full pipe. Otherwise output goes to the output of this program.
+ *
+ *           Children are not killed when this program exits. Must be used from the main thread.
+ */
+
+class ChildSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    static ChildSupervisor* get() {
+        static ChildSupervisor theOne;
+        return &theOne;
+    }
+    ~ChildSupervisor();
+
+    static const int POLL_INTERVAL_MS = 100;
+    static const quint64 DEFAULT_KILL_TIMEOUT_NS = Q_UINT64_C(5) * 1000 * 1000 * 1000;
+
+    /*! @brief Limits applied to one child */
+    struct Options {
+        quint64   timeout = 0;                              //!< @brief Nanoseconds, 0 - no timeout
+        quint64   killTimeout = DEFAULT_KILL_TIMEOUT_NS;    //!< @brief Nanoseconds between SIGTERM and SIGKILL
+        int       outputLimit = 0;                          //!< @brief Bytes of each stream kept, 0 - not captured
+
+        /*! @brief "NAME=value" entries, which are added to (or replace) environment of this program. Must stay
+         *         valid during ChildSupervisor::spawn call */
+        const QVector<QByteArray>* environment = nullptr;
+
+        /*! @brief File (in local 8-bit encoding), which is connected to stdin of the child instead of /dev/null */
+        const char* input = nullptr;
+    };
+
+    typedef std::function<void(const ChildExit&)> Callback;
+
+    /*! @brief Starts program with arguments. finished is called (before ChildSupervisor::childFinished is emitted)
+     *         when process exits. Returns id of the child, or 0 if process could not be started - in this case
+     *         finished is not called, errorString is set and ChildSupervisor::childFinished is emitted */
+    quint64   spawn(const QString& program, const QStringList& arguments, const Options& options,
+                    const Callback& finished, QString* errorString = nullptr);
+
+    /*! @brief Same as above, arguments are already in local 8-bit encoding */
+    quint64   spawn(const QString& program, const QVector<QByteArray>& arguments, const Options& options,
+                    const Callback& finished, QString* errorString = nullptr);
+
+    /*! @brief Number of children, which are running */
+    int       childCount() const                         { return m_children.size(); }
+
+    /*! @brief Returns true if children are watched through pidfds, false if they are polled */
+    bool      usesPidfd() const                          { return m_pidfdSupported; }
+
+signals:
+    /*! @brief This signal is emitted when child has exited, or could not be started */
+    void      childFinished(const ChildExit& exit);
+
+private slots:
+    void      _epollReady();
+    void      _pollChildren();
+
+private:
+    ChildSupervisor();
+    Q_DISABLE_COPY(ChildSupervisor)
+
+    enum Descriptor {
+        PidDescriptor,
+        OutputDescriptor,
+        ErrorDescriptor
+    };
+
+    class Child : public TimerWheel::Client
+    {
+    public:
+        Child(ChildSupervisor* supervisor) : p_supervisor(supervisor) {}
+
+        ChildSupervisor*   p_supervisor;
+        ChildExit          m_exit;
+        int                m_pidfd = -1;
+        int                m_outputFds[2] = { -1, -1 };
+        int                m_outputLimit = 0;
+        quint64            m_startedAt = 0;
+        quint64            m_killTimeout = 0;
+        Callback           m_finished;
+
+    protected:
+        void  _timerWheelExpired(quint64 now) override   { p_supervisor->_timeout(this,now); }
+    };
+
+    /*! @brief Returns true if "NAME=value" variable of this program is replaced by one of environment entries */
+    static bool _overridden(const char* variable, const QVector<QByteArray>& environment);
+
+    bool      _watch(Child* child, Descriptor descriptor, int fd);
+    void      _unwatch(int fd);
+
+    /*! @brief Reads captured stream (0 - stdout, 1 - stderr). Number of reads is limited, the rest is read on the
+     *         next wakeup */
+    void      _readOutput(Child* child, int stream);
+    void      _closeOutput(Child* child, int stream);
+
+    /*! @brief Collects exit status of the child. Returns false if it is still running */
+    bool      _reap(Child* child);
+    void      _timeout(Child* child, quint64 now);
+    void      _signal(Child* child, int signal);
+    void      _finish(Child* child);
+
+    void      _failed(const QString& program, const QString& errorString);
+    void      _count(const ChildExit& exit);
+
+    int                       m_epollHandle;
+    QSocketNotifier*          p_epollNotifier;
+    QTimer                    m_pollTimer;
+    bool                      m_pidfdSupported;
+    quint64                   m_nextChild;
+    QHash<quint64,Child*>     m_children;
+
+#ifdef METRICS
+    Gauge*                    p_runningGauge;
+    Counter*                  p_spawnedCounter;
+    Counter*                  p_succeededCounter;
+    Counter*                  p_failedCounter;
+    Counter*                  p_killedCounter;
+    Counter*                  p_timedOutCounter;
+    Counter*                  p_notStartedCounter;
+    Counter*                  p_truncatedCounter;
+    Histogram*                p_runtime;
+    Histogram*                p_spawnDuration;
+#endif //METRICS
+};
+#define childSupervisor ChildSupervisor::get()
+
+#endif // CHILDSUPERVISOR_H
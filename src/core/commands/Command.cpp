@@ -22,35 +22,217 @@
 
 #include "Command.h"
 
+#include <string.h>
+
+#include "BatchCommand.h"
+#include "CommandScheduler.h"
+#include "MembershipCommand.h"
+#include "PipelineCommand.h"
 #include "ShellCommand.h"
+#include "SocketCommand.h"
+#include "core/cards/CardNormalizer.h"
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+
+/*! @brief Metrics shared by all Command objects. Registered once, when first command is run */
+struct CommandMetrics {
+    Counter*    executed   = metricsRegistry->counter("rfid_commands_executed_total","Commands, which were executed.");
+    Counter*    disabled   = metricsRegistry->counter("rfid_commands_disabled_total","Matched commands, which were disabled.");
+    Counter*    failed     = metricsRegistry->counter("rfid_commands_failed_total","Executions of commands, which have failed.");
+    Histogram*  duration   = metricsRegistry->histogram("rfid_command_execute_duration_seconds",
+                                                        "Time spent starting command (e.g. spawning process).");
+};
+
+static CommandMetrics* commandMetrics()
+{
+    static CommandMetrics theOne;
+    return &theOne;
+}
+#endif //METRICS
 
 Command::Command(QObject* parent) :
-    QObject(parent)
-{}
+    QObject(parent),
+    m_enabled(true),
+    m_matchMode(ExactKey)
+{
+    _updateKeyId();
+}
 
 Command::Command(const QJsonObject& jsonObject, QObject* parent) :
     QObject(parent),
     m_enabled(jsonObject.value("enabled").toBool()),
-    m_key(jsonObject.value("key").toString())
-{}
+    m_matchMode(matchModeFromName(jsonObject.value("match").toString())),
+    m_key(jsonObject.value("key").toString()),
+    m_keyDigest(QByteArray::fromHex(jsonObject.value("keyDigest").toString().toLatin1())),
+    m_executionPolicy(jsonObject.value("schedule").toObject())
+{
+    _updateKeyId();
+}
 
-void Command::run()
+void Command::run(const KeyEvent& event)
 {
     if (!m_enabled) {
         qDebug() << "Command for key "<<m_key<<" is disabled, ignoring.";
+#ifdef METRICS
+        commandMetrics()->disabled->increment();
+#endif //METRICS
         return;
     }
 
+    commandScheduler->submit(this,event);
+}
+
+void Command::setExecutionPolicy(const ExecutionPolicy& policy)
+{
+    m_executionPolicy = policy;
+    emit commandChanged();
+}
+
+void Command::finishExecution(quint64 execution, bool success)
+{
+#ifdef METRICS
+    if (!success)
+        commandMetrics()->failed->increment();
+#endif //METRICS
+
+    commandScheduler->finished(execution,success);
+}
+
+void Command::writeExecutionPolicy(QJsonObject* jsonObject) const
+{
+    //Files of commands without limits stay the same as before scheduling was introduced
+    if (!m_executionPolicy.isDefault())
+        jsonObject->insert("schedule",m_executionPolicy.toJson());
+}
+
+void Command::writeKeyMatching(QJsonObject* jsonObject) const
+{
+    //Files of exact-key commands stay the same as before patterns were introduced
+    if (m_matchMode != ExactKey)
+        jsonObject->insert("match",matchModeName(m_matchMode));
+
+    if (hasKeyDigest()) {
+        jsonObject->remove("key");
+        jsonObject->insert("keyDigest",QString::fromLatin1(m_keyDigest.toHex()));
+    }
+}
+
+void Command::_execute(const KeyEvent& event, quint64 execution)
+{
     qDebug() << "Executing command for key: "<<m_key;
-    this->execute();
+    bool finished = false;
+    {
+#ifdef METRICS
+        commandMetrics()->executed->increment();
+        ScopedDuration executeDuration(commandMetrics()->duration);
+#endif //METRICS
+#ifdef TRACING
+        const quint64 executeStart = KeyEvent::now();
+#endif //TRACING
+        finished = this->execute(event,execution);
+#ifdef TRACING
+        tracer->addSpan(event,"command",executeStart,KeyEvent::now());
+#endif //TRACING
+    }
+
+    if (finished)
+        commandScheduler->finished(execution);
 }
 
 void Command::setKey(const QString& key)
 {
     m_key = key;
+    m_keyDigest.clear();
+    _updateKeyId();
+    emit commandChanged();
+}
+
+void Command::setKeyDigest(const QByteArray& digest)
+{
+    m_key.clear();
+    m_keyDigest = digest;
+    m_matchMode = ExactKey;
+    _updateKeyId();
     emit commandChanged();
 }
 
+void Command::setMatchMode(MatchMode mode)
+{
+    m_matchMode = mode;
+    _updateKeyId();
+    emit commandChanged();
+}
+
+QString Command::matchModeName(MatchMode mode)
+{
+    switch (mode) {
+    case ExactKey:
+        return QStringLiteral("exact");
+    case KeyPrefix:
+        return QStringLiteral("prefix");
+    case KeyRange:
+        return QStringLiteral("range");
+    case KeyRegex:
+        return QStringLiteral("regex");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+Command::MatchMode Command::matchModeFromName(const QString& name)
+{
+    if (name == QLatin1String("prefix"))
+        return KeyPrefix;
+    if (name == QLatin1String("range"))
+        return KeyRange;
+    if (name == QLatin1String("regex"))
+        return KeyRegex;
+
+    return ExactKey;
+}
+
+bool Command::matches(const KeyEvent& event) const
+{
+    return (m_matchMode == ExactKey)
+            && (m_keyId == event.keyId())
+            && (m_keyBytes.size() == event.keyLength())
+            && (memcmp(m_keyBytes.constData(),event.keyData(),event.keyLength()) == 0);
+}
+
+void Command::_updateKeyId()
+{
+    //Key is normalized in the same way as keys read by devices, so any encoding of the card matches this command.
+    //Patterns are matched against normalized keys as they are
+    if (hasKeyDigest()) {
+        m_keyBytes.clear();
+        m_keyId = KeyId::fromBytes(m_keyDigest.constData(),m_keyDigest.size());
+        return;
+    }
+
+    const QByteArray latin1 = m_key.toLatin1();
+    if (m_matchMode != ExactKey) {
+        m_keyBytes = latin1;
+        m_keyId = KeyId::fromBytes(m_keyBytes.constData(),m_keyBytes.size());
+        return;
+    }
+
+    m_keyBytes.resize(qMax(latin1.size(),KeyEvent::MAX_KEY_LENGTH));
+
+    const int length = cardNormalizer->normalize(latin1.constData(),latin1.size(),m_keyBytes.data());
+    if (length < 0) {
+        m_keyBytes = latin1;
+    } else {
+        m_keyBytes.resize(length);
+    }
+
+    m_keyId = KeyId::fromBytes(m_keyBytes.constData(),m_keyBytes.size());
+}
+
 void Command::setEnabled(bool state)
 {
     m_enabled = state;
@@ -62,6 +244,14 @@ Command* Command::create(Command::Type type)
     switch (type) {
     case Shell:
         return new ShellCommand;
+    case Membership:
+        return new MembershipCommand;
+    case Batch:
+        return new BatchCommand;
+    case Socket:
+        return new SocketCommand;
+    case Pipeline:
+        return new PipelineCommand;
     case Unknown:
         return nullptr;
     }
@@ -77,5 +267,21 @@ Command* Command::fromJson(const QJsonObject& jsonObject)
         return new ShellCommand(jsonObject);
     }
 
+    if (type == QLatin1String("membership")) {
+        return new MembershipCommand(jsonObject);
+    }
+
+    if (type == QLatin1String("batch")) {
+        return new BatchCommand(jsonObject);
+    }
+
+    if (type == QLatin1String("socket")) {
+        return new SocketCommand(jsonObject);
+    }
+
+    if (type == QLatin1String("pipeline")) {
+        return new PipelineCommand(jsonObject);
+    }
+
     return nullptr;
 }
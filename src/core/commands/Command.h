@@ -27,9 +27,15 @@
 
 #include <QJsonObject>
 
+#include "core/KeyEvent.h"
+#include "CommandTask.h"
+#include "ExecutionPolicy.h"
+
 /*!
  *  @class Command core/commands/Command.h
  *  @brief This class provides general interface to commands, which can be executed by this program.
+ *  @details Matched commands are not executed at once - Command::run submits them to the CommandScheduler, which
+ *           starts them according to ExecutionPolicy of the command.
  */
 
 class Command : public QObject
@@ -38,8 +44,21 @@ class Command : public QObject
 public:
     /*! @brief This enum holds information about currently supported command types */
     enum Type {
-        Shell,     /*!< @brief Shell command, to launch applications and execute scripts */
-        Unknown    /*!< @brief Type of command can not be determined */
+        Shell,      /*!< @brief Shell command, to launch applications and execute scripts */
+        Membership, /*!< @brief Shell command, which is run for keys within large set of keys, see MembershipCommand */
+        Batch,      /*!< @brief Shell command, which is run once for batch of taps, see BatchCommand */
+        Socket,     /*!< @brief Record of the tap is sent over persistent connection, see SocketCommand */
+        Pipeline,   /*!< @brief Chain of other commands, see PipelineCommand */
+        Unknown     /*!< @brief Type of command can not be determined */
+    };
+
+    /*! @brief This enum describes how key of the command is compared with keys read by devices */
+    enum MatchMode {
+        ExactKey,  /*!< @brief Key equals to the key of the command (both are normalized) */
+        KeyPrefix, /*!< @brief Key starts with the key of the command */
+        KeyRange,  /*!< @brief Key is a card number within range given by the key of the command, e.g. "1000-1999"
+                    *          or "facility:123". See KeyPatternMatcher::parseRange */
+        KeyRegex   /*!< @brief Key fully matches regular expression given by the key of the command */
     };
 
     virtual ~Command() {}
@@ -48,10 +67,41 @@ public:
      *         Command subclasses */
     virtual Type   type() const = 0;
 
-    void      run();
+    /*! @brief Submits this command for event to the CommandScheduler, if command is enabled */
+    void      run(const KeyEvent& event);
+
+    /*! @brief Same as Command::run, but returns awaitable object, which resumes coroutine (see CommandTask) when
+     *         execution has finished or after timeout nanoseconds (0 - no timeout) */
+    CommandExecution runAsync(const KeyEvent& event, quint64 timeout = 0)  { return CommandExecution(this,event,timeout); }
+
+    /*! @brief Limits applied by CommandScheduler to invocations of this command */
+    const ExecutionPolicy& executionPolicy() const         { return m_executionPolicy; }
+    void      setExecutionPolicy(const ExecutionPolicy& policy);
 
     QString   key() const                                  { return m_key; }
     void      setKey(const QString& key);
+    KeyId     keyId() const                                { return m_keyId; }
+
+    /*! @brief Returns key in the form compared with keys of KeyEvent objects (normalized for ExactKey commands) */
+    QByteArray keyBytes() const                            { return m_keyBytes; }
+
+    /*! @brief Replaces key of the command with its digest (see KeyDigest). Such commands are found by CommandList
+     *         using digest of the read key. Setting new key with Command::setKey removes the digest */
+    void      setKeyDigest(const QByteArray& digest);
+    QByteArray keyDigest() const                           { return m_keyDigest; }
+    bool      hasKeyDigest() const                         { return !m_keyDigest.isEmpty(); }
+
+    /*! @brief Key of the command is a pattern, if mode is not ExactKey. Such commands are found by CommandList using
+     *         KeyPatternMatcher */
+    void      setMatchMode(MatchMode mode);
+    MatchMode matchMode() const                            { return m_matchMode; }
+
+    static QString   matchModeName(MatchMode mode);
+    static MatchMode matchModeFromName(const QString& name);
+
+    /*! @brief Returns true if event carries key of this command. Only for ExactKey commands. Does not allocate
+     *         memory */
+    bool      matches(const KeyEvent& event) const;
 
     void      setEnabled(bool state);
     bool      isEnabled() const                            { return m_enabled; }
@@ -77,12 +127,39 @@ signals:
 protected:
     explicit Command(QObject* parent = nullptr);
     explicit Command(const QJsonObject& jsonObject,QObject* parent = nullptr);
-    virtual void execute() = 0;
+
+    /*! @brief Starts execution of this command for event. Returns true if execution has succeeded (or does not need
+     *         to be tracked) by the time method returns. Otherwise Command::finishExecution must be called with
+     *         the same execution id - later (e.g. when spawned process has exited), or before returning false to
+     *         report, that execution has failed at once */
+    virtual bool execute(const KeyEvent& event, quint64 execution) = 0;
+
+    /*! @brief Reports to the CommandScheduler, that execution started by Command::execute has finished. success is
+     *         passed to the pipelines awaiting this execution (see CommandExecution) */
+    static void finishExecution(quint64 execution, bool success = true);
+
+    /*! @brief Adds "schedule" object to JSON of the command, if its ExecutionPolicy is not the default one */
+    void      writeExecutionPolicy(QJsonObject* jsonObject) const;
+
+    /*! @brief Adds "match" to JSON of the command, if it is not ExactKey, and replaces "key" with "keyDigest", if key
+     *         of the command is hashed */
+    void      writeKeyMatching(QJsonObject* jsonObject) const;
 
 private:
     Q_DISABLE_COPY(Command);
+    friend class CommandScheduler;
+
+    /*! @brief Called by CommandScheduler, when invocation of this command is started */
+    void      _execute(const KeyEvent& event, quint64 execution);
+    void      _updateKeyId();
+
     bool      m_enabled;
+    MatchMode m_matchMode;
     QString   m_key;
+    QByteArray m_keyBytes;     //!< @brief Normalized Latin-1 representation of m_key, compared with bytes of KeyEvent
+    QByteArray m_keyDigest;
+    KeyId     m_keyId;
+    ExecutionPolicy m_executionPolicy;
 };
 Q_DECLARE_METATYPE(Command*)
 
@@ -25,10 +25,18 @@
 #include <QDebug>
 #include <QJsonArray>
 
+#include <string.h>
+
 #include "Command.h"
+#include "MembershipCommand.h"
 
 CommandList::CommandList(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    m_digestCount(0),
+    m_hashingKeys(false),
+    m_patternCount(0),
+    m_patternsChanged(false),
+    m_fuzzyIndexChanged(true)
 {}
 
 CommandList::~CommandList()
@@ -38,20 +46,33 @@ CommandList::~CommandList()
 
 void CommandList::append(Command* cmd)
 {
+    emit commandAboutToBeAdded(m_commandsList.count());
     m_commandsList.append(cmd);
+    _indexCommand(cmd);
     emit commandListChanged();
     emit commandAdded(cmd);
-    connect(cmd,&Command::commandChanged,this,&CommandList::commandListChanged);
+    connect(cmd,&Command::commandChanged,this,&CommandList::_commandChanged);
 }
 
 void CommandList::clear()
 {
+    emit commandListAboutToBeCleared();
     for (Command* cmd : m_commandsList) {
         emit commandRemoved(cmd);
         cmd->deleteLater();
     }
 
     m_commandsList.clear();
+    m_keyIndex.clear();
+    m_digestIndex.clear();
+    m_digestCount = 0;
+    m_patternCount = 0;
+    m_patternsChanged = false;
+    m_patternMatcher.clear();
+    m_patternCommands.clear();
+    m_membershipCommands.clear();
+    m_fuzzyIndexChanged = true;
+    emit commandListCleared();
     emit commandListChanged();
 }
 
@@ -60,7 +81,7 @@ QJsonArray CommandList::toJsonArray() const
     QJsonArray result;
 
     for (int i = 0; i < count(); i++) {
-        if (!at(i)->key().isEmpty())
+        if (!at(i)->key().isEmpty() || at(i)->hasKeyDigest() || at(i)->type() == Command::Membership)
             result.append(at(i)->toJson());
     }
 
@@ -76,7 +97,7 @@ CommandList* CommandList::fromJsonArray(const QJsonArray& array)
         if (cmd == nullptr)
             continue;
 
-        if (cmd->key().isEmpty())
+        if (cmd->key().isEmpty() && cmd->keyDigest().size() != KeyDigest::SIZE && cmd->type() != Command::Membership)
             continue;
 
         result->append(cmd);
@@ -87,9 +108,187 @@ CommandList* CommandList::fromJsonArray(const QJsonArray& array)
 
 void CommandList::removeCommand(Command* cmd)
 {
-    m_commandsList.removeAll(cmd);
+    int index = m_commandsList.indexOf(cmd);
+    if (index < 0)
+        return;
+
+    emit commandAboutToBeRemoved(index);
+    m_commandsList.removeAt(index);
+    _rebuildKeyIndex();
     emit commandRemoved(cmd);
     emit commandListChanged();
 
     cmd->deleteLater();
 }
+
+void CommandList::patternCommandsFor(const KeyEvent& event, QVector<Command*>* result)
+{
+    result->clear();
+    if (m_patternCount == 0)
+        return;
+
+    if (m_patternsChanged)
+        _compilePatterns();
+
+    m_patternMatcher.match(event.keyData(),event.keyLength(),&m_matchedRules);
+    for (int rule : qAsConst(m_matchedRules))
+        result->append(m_patternCommands.at(rule));
+}
+
+void CommandList::hashKeys()
+{
+    Q_ASSERT(m_keyDigest.hasSecret());
+
+    //Index is rebuilt once, not after every converted command
+    m_hashingKeys = true;
+    for (Command* cmd : qAsConst(m_commandsList)) {
+        if (cmd->matchMode() == Command::ExactKey && !cmd->hasKeyDigest() && !cmd->key().isEmpty())
+            cmd->setKeyDigest(m_keyDigest.digest(cmd->keyBytes()));
+    }
+    m_hashingKeys = false;
+
+    _rebuildKeyIndex();
+    emit commandListChanged();
+}
+
+void CommandList::digestCommandsFor(const KeyEvent& event, QVector<Command*>* result) const
+{
+    result->clear();
+
+    quint8 digest[KeyDigest::SIZE];
+    m_keyDigest.digest(event.keyData(),event.keyLength(),digest);
+
+    const QVector<Command*> commands = m_digestIndex.value(KeyId::fromBytes(reinterpret_cast<const char*>(digest),KeyDigest::SIZE));
+    for (Command* cmd : commands) {
+        if (memcmp(cmd->keyDigest().constData(),digest,KeyDigest::SIZE) == 0)
+            result->append(cmd);
+    }
+}
+
+void CommandList::membershipCommandsFor(const KeyEvent& event, QVector<Command*>* result) const
+{
+    result->clear();
+    for (MembershipCommand* cmd : m_membershipCommands) {
+        if (cmd->accepts(event))
+            result->append(cmd);
+    }
+}
+
+int CommandList::fuzzyCommandsFor(const KeyEvent& event, int maxDistance, QVector<Command*>* result, bool* ambiguous)
+{
+    if (m_fuzzyIndexChanged || m_fuzzyIndex.maxDistance() != maxDistance)
+        _buildFuzzyIndex(maxDistance);
+
+    result->clear();
+    const int distance = m_fuzzyIndex.find(event.keyData(),event.keyLength(),&m_fuzzyEntries,ambiguous);
+    for (int entry : qAsConst(m_fuzzyEntries))
+        result->append(m_fuzzyCommands.at(entry));
+
+    return distance;
+}
+
+void CommandList::_rebuildKeyIndex()
+{
+    //Lists are changed only by the user, so simple rebuild is enough. It also keeps order of commands within the list
+    m_keyIndex.clear();
+    m_digestIndex.clear();
+    m_digestCount = 0;
+    m_patternCount = 0;
+    m_membershipCommands.clear();
+    for (Command* cmd : qAsConst(m_commandsList))
+        _indexCommand(cmd);
+    m_patternsChanged = true;
+    m_fuzzyIndexChanged = true;
+}
+
+void CommandList::_indexCommand(Command* cmd)
+{
+    //Commands are appended to the end, so order of the list is kept without full rebuild (e.g. when loading files)
+    if (cmd->type() == Command::Membership) {
+        m_membershipCommands.append(cmd->to<MembershipCommand>());
+    } else if (cmd->hasKeyDigest()) {
+        m_digestIndex[cmd->keyId()].append(cmd);
+        m_digestCount++;
+    } else if (cmd->matchMode() == Command::ExactKey) {
+        m_keyIndex[cmd->keyId()].append(cmd);
+        m_fuzzyIndexChanged = true;
+    } else {
+        m_patternCount++;
+        m_patternsChanged = true;
+    }
+}
+
+void CommandList::_compilePatterns()
+{
+    m_patternMatcher.clear();
+    m_patternCommands.clear();
+
+    for (Command* cmd : qAsConst(m_commandsList)) {
+        const int rule = m_patternCommands.size();
+        if (cmd->type() == Command::Membership)
+            continue;
+
+        switch (cmd->matchMode()) {
+        case Command::ExactKey:
+            continue;
+        case Command::KeyPrefix:
+            m_patternMatcher.addPrefix(cmd->key().toLatin1(),rule);
+            break;
+        case Command::KeyRange: {
+            quint64 low = 0;
+            quint64 high = 0;
+            if (!KeyPatternMatcher::parseRange(cmd->key(),&low,&high)) {
+                qWarning() << "Invalid range of keys:"<<cmd->key();
+                continue;
+            }
+            m_patternMatcher.addRange(low,high,rule);
+            break;
+        }
+        case Command::KeyRegex: {
+            QString errorString;
+            if (!m_patternMatcher.addRegex(cmd->key(),rule,&errorString)) {
+                qWarning() << "Invalid regular expression"<<cmd->key()<<":"<<errorString;
+                continue;
+            }
+            break;
+        }
+        }
+        m_patternCommands.append(cmd);
+    }
+
+    m_patternMatcher.compile();
+    m_patternsChanged = false;
+}
+
+void CommandList::_buildFuzzyIndex(int maxDistance)
+{
+    m_fuzzyIndex.clear();
+    m_fuzzyCommands.clear();
+
+    for (Command* cmd : qAsConst(m_commandsList)) {
+        if (cmd->matchMode() != Command::ExactKey || cmd->type() == Command::Membership)
+            continue;
+
+        const QByteArray key = cmd->keyBytes();
+        if (m_fuzzyIndex.add(key.constData(),key.size(),m_fuzzyCommands.size()))
+            m_fuzzyCommands.append(cmd);
+    }
+
+    m_fuzzyIndex.build(maxDistance);
+    m_fuzzyIndexChanged = false;
+}
+
+void CommandList::_commandChanged()
+{
+    Command* cmd = qobject_cast<Command*>(sender());
+    Q_ASSERT(cmd != nullptr);
+
+    if (m_hashingKeys) {
+        emit commandChanged(cmd);
+        return;
+    }
+
+    _rebuildKeyIndex();
+    emit commandChanged(cmd);
+    emit commandListChanged();
+}
@@ -25,14 +25,25 @@
 
 #include <QObject>
 
+#include <QHash>
 #include <QJsonArray>
+#include <QVector>
+
+#include "core/KeyId.h"
+#include "FuzzyKeyIndex.h"
+#include "KeyDigest.h"
+#include "KeyPatternMatcher.h"
 
 class Command;
+class KeyEvent;
+class MembershipCommand;
 
 /*!
  *  @class CommandList core/commands/CommandList.h
  *  @brief This class holds information about currently loaded Command objects, provides access to them and
  *         serialization to JSON.
+ *  @details Commands are indexed by KeyId of their keys, so finding commands for the key does not depend on the
+ *           number of loaded commands. Index is rebuilt when list or key of any command changes.
  */
 
 class CommandList : public QObject
@@ -47,6 +58,46 @@ public:
 
     void      clear();
     Command*  at(int index) const                          { return m_commandsList.at(index); }
+    int       indexOf(Command* cmd) const                  { return m_commandsList.indexOf(cmd); }
+
+    /*! @brief Returns commands, which keys have keyId, in order of this list. Commands still have to be checked with
+     *         Command::matches, as different keys can share one KeyId. Returned vector is shared with the index, so
+     *         no memory is allocated */
+    QVector<Command*>        commandsForKey(KeyId keyId) const   { return m_keyIndex.value(keyId); }
+
+    /*! @brief Secret of key digests of commands within this list (see KeyDigest). It is not stored in command files */
+    void                     setKeyDigestSecret(const QByteArray& secret) { m_keyDigest.setSecret(secret); }
+    QByteArray               keyDigestSecretId() const           { return m_keyDigest.secretId(); }
+
+    /*! @brief Replaces keys of all ExactKey commands with their digests (see Command::setKeyDigest). Secret has to be
+     *         set before. Keys can not be restored from digests. Patterns are left as they are */
+    void                     hashKeys();
+
+    /*! @brief Replaces content of result with commands, which key digest equals to the digest of key of event. Key
+     *         is hashed once, commands are looked up by KeyId of the digest */
+    void                     digestCommandsFor(const KeyEvent& event, QVector<Command*>* result) const;
+    bool                     hasDigestCommands() const           { return m_digestCount > 0; }
+
+    /*! @brief Replaces content of result with commands having key patterns (Command::matchMode is not ExactKey),
+     *         which match key of event, in order of this list. All patterns are checked within one pass over the key,
+     *         see KeyPatternMatcher. Matcher is compiled by the first call after patterns were changed */
+    void                     patternCommandsFor(const KeyEvent& event, QVector<Command*>* result);
+    bool                     hasPatternCommands() const          { return m_patternCount > 0; }
+
+    /*! @brief Replaces content of result with commands, which key is the nearest to the key of event within
+     *         maxDistance flipped bits, see FuzzyKeyIndex. Returns the distance, or -1 if there is no such key or
+     *         several keys are equally near (ambiguous is set to true then). Index is built by the first call after
+     *         the list was changed. Should be used only if there is no command for the exact key */
+    int                      fuzzyCommandsFor(const KeyEvent& event, int maxDistance, QVector<Command*>* result,
+                                              bool* ambiguous = nullptr);
+
+    /*! @brief Replaces content of result with MembershipCommand objects, which accept key of event, in order of this
+     *         list */
+    void                     membershipCommandsFor(const KeyEvent& event, QVector<Command*>* result) const;
+    bool                     hasMembershipCommands() const       { return !m_membershipCommands.isEmpty(); }
+
+    /*! @brief Returns MembershipCommand objects of this list, e.g. to load their sets of keys */
+    QVector<MembershipCommand*> membershipCommands() const       { return m_membershipCommands; }
 
     QJsonArray               toJsonArray() const;
     static CommandList*      fromJsonArray(const QJsonArray& array);
@@ -56,11 +107,53 @@ signals:
     void commandRemoved(Command* cmd);
     void commandAdded(Command* cmd);
 
+    /*! @brief This signal is emitted when one of the Command objects within this list has changed */
+    void commandChanged(Command* cmd);
+
+    /*! @brief This signal is emitted right before Command will be inserted at position index */
+    void commandAboutToBeAdded(int index);
+
+    /*! @brief This signal is emitted right before Command at position index will be removed */
+    void commandAboutToBeRemoved(int index);
+
+    /*! @brief This signal is emitted right before all Command objects will be removed from this list */
+    void commandListAboutToBeCleared();
+
+    /*! @brief This signal is emitted after all Command objects were removed from this list */
+    void commandListCleared();
+
 public slots:
     void removeCommand(Command* cmd);
 
+private slots:
+    void _commandChanged();
+
 private:
+    void      _rebuildKeyIndex();
+    void      _indexCommand(Command* cmd);
+    void      _compilePatterns();
+    void      _buildFuzzyIndex(int maxDistance);
+
     QList<Command*>  m_commandsList;
+    QHash<KeyId,QVector<Command*>> m_keyIndex;
+
+    KeyDigest           m_keyDigest;
+    QHash<KeyId,QVector<Command*>> m_digestIndex;
+    int                 m_digestCount;
+    bool                m_hashingKeys;
+
+    int                 m_patternCount;
+    bool                m_patternsChanged;
+    KeyPatternMatcher   m_patternMatcher;
+    QVector<Command*>   m_patternCommands;    //!< @brief Commands by rule numbers of m_patternMatcher
+    QVector<int>        m_matchedRules;
+
+    QVector<MembershipCommand*> m_membershipCommands;
+
+    bool                m_fuzzyIndexChanged;
+    FuzzyKeyIndex       m_fuzzyIndex;
+    QVector<Command*>   m_fuzzyCommands;      //!< @brief Commands by entries of m_fuzzyIndex
+    QVector<int>        m_fuzzyEntries;
 };
 
 #endif // currentCommandsModel_H
@@ -0,0 +1,369 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandScheduler.h"
+
+#include <QSet>
+#include <QVector>
+
+#include <string.h>
+
+#include "Command.h"
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+static const int DEFAULT_QUEUE_CAPACITY = 1024;
+
+CommandScheduler::CommandScheduler()
+    : QObject(nullptr),
+    m_nextExecution(0),
+    m_maxInFlight(0),
+    m_queueCapacity(DEFAULT_QUEUE_CAPACITY),
+    m_inFlight(0),
+    m_awaiting(0),
+    m_queued(0),
+    m_pumping(false),
+    m_pumpAgain(false)
+{
+    //States are TimerWheel clients, so TimerWheel has to be created first and destroyed after this object
+    timerWheel->now();
+
+#ifdef METRICS
+    static const char* const outcomes[OUTCOME_COUNT] = { "started", "queued", "coalesced", "dropped" };
+    for (int outcome = 0; outcome < OUTCOME_COUNT; outcome++) {
+        for (int priority = 0; priority < ExecutionPolicy::PRIORITY_COUNT; priority++) {
+            const QString labels = MetricsRegistry::label("outcome",outcomes[outcome]) + ','
+                    + MetricsRegistry::label("priority",ExecutionPolicy::priorityName(ExecutionPolicy::Priority(priority)));
+            p_invocationCounters[outcome][priority] = metricsRegistry->counter("rfid_command_invocations_total",
+                                                                               "Invocations of matched commands by scheduling outcome.",
+                                                                               labels);
+        }
+    }
+    p_inFlightGauge = metricsRegistry->gauge("rfid_commands_in_flight","Invocations of commands, which are running.");
+    p_queuedGauge = metricsRegistry->gauge("rfid_commands_queued","Invocations of commands, which wait for free slot or rate limit.");
+    p_queueWait = metricsRegistry->histogram("rfid_command_queue_wait_seconds",
+                                             "Time between matching command and starting its invocation.");
+#endif //METRICS
+}
+
+CommandScheduler::~CommandScheduler()
+{
+    //States of deleted commands are kept only by their running invocations
+    QSet<State*> states;
+    for (State* state : qAsConst(m_states))
+        states.insert(state);
+    for (State* state : qAsConst(m_executions))
+        states.insert(state);
+
+    qDeleteAll(states);
+}
+
+void CommandScheduler::setMaxInFlight(int count)
+{
+    m_maxInFlight = qMax(0,count);
+    _pump();
+}
+
+CommandScheduler::Outcome CommandScheduler::submit(Command* command, const KeyEvent& event,
+                                                   const Completion& completion)
+{
+    State* state = _state(command);
+    const ExecutionPolicy& policy = command->executionPolicy();
+    const quint64 now = timerWheel->now();
+
+    //Awaited invocation must be executed, its result can not be taken from the merged one
+    if (policy.coalesce() && !completion) {
+        for (const Invocation& invocation : state->m_queue) {
+            if ((invocation.event.keyId() == event.keyId())
+                    && (invocation.event.keyLength() == event.keyLength())
+                    && (memcmp(invocation.event.keyData(),event.keyData(),event.keyLength()) == 0)) {
+                _count(Coalesced,policy.priority());
+                return Coalesced;
+            }
+        }
+    }
+
+    //Pending invocations are started as soon as slots are freed (see CommandScheduler::_pump), so if this command
+    //can be started now - nothing else is waiting for the slot
+    if (state->m_queue.empty() && _canStart(state,now)) {
+        _start(state,event,completion,now,now);
+        return Started;
+    }
+
+    Completion droppedCompletion;
+    if ((int(state->m_queue.size()) >= policy.maxQueued()) || (m_queued >= m_queueCapacity)) {
+        if ((policy.overflow() == ExecutionPolicy::DropNewest) || state->m_queue.empty()) {
+            _count(Dropped,policy.priority());
+            if (completion)
+                completion(false);
+            return Dropped;
+        }
+
+        droppedCompletion = state->m_queue.front().completion;
+        state->m_queue.pop_front();
+        m_queued--;
+        _count(Dropped,policy.priority());
+    }
+
+    _enqueue(state,event,completion,now);
+    _count(Queued,policy.priority());
+
+    //Called last, as it may submit other invocations
+    if (droppedCompletion)
+        droppedCompletion(false);
+
+    return Queued;
+}
+
+void CommandScheduler::finished(quint64 execution, bool success)
+{
+    State* state = m_executions.take(execution);
+    if (state == nullptr)
+        return;
+
+    const Completion completion = m_completions.take(execution);
+
+    state->m_inFlight--;
+    m_inFlight--;
+    if (!state->m_holdsSlot)
+        m_awaiting--;
+#ifdef METRICS
+    p_inFlightGauge->set(m_inFlight);
+#endif //METRICS
+
+    if (state->p_command == nullptr) {
+        if (state->m_inFlight == 0)
+            delete state;
+    }
+
+    //Pending invocations get freed slot before the next step of awaiting pipeline
+    _pump();
+
+    if (completion)
+        completion(success);
+}
+
+int CommandScheduler::inFlight(const Command* command) const
+{
+    const State* state = m_states.value(command);
+    return (state == nullptr) ? 0 : state->m_inFlight;
+}
+
+int CommandScheduler::queued(const Command* command) const
+{
+    const State* state = m_states.value(command);
+    return (state == nullptr) ? 0 : int(state->m_queue.size());
+}
+
+void CommandScheduler::_commandDestroyed(QObject* command)
+{
+    State* state = m_states.take(command);
+    if (state == nullptr)
+        return;
+
+    QVector<Completion> completions;
+    for (const Invocation& invocation : state->m_queue) {
+        if (invocation.completion)
+            completions.append(invocation.completion);
+    }
+    _dropPending(state);
+    timerWheel->cancel(state);
+
+    //Running invocations are not affected, State is deleted when the last of them is finished
+    if (state->m_inFlight == 0) {
+        delete state;
+    } else {
+        state->p_command = nullptr;
+    }
+
+    for (const Completion& completion : qAsConst(completions))
+        completion(false);
+}
+
+CommandScheduler::State* CommandScheduler::_state(Command* command)
+{
+    State* state = m_states.value(command);
+    if (state != nullptr)
+        return state;
+
+    state = new State(this,command);
+    state->m_tokens = command->executionPolicy().burst();
+    state->m_refilledAt = timerWheel->now();
+    state->m_holdsSlot = (command->type() != Command::Pipeline);
+    m_states.insert(command,state);
+
+    connect(command,&QObject::destroyed,this,&CommandScheduler::_commandDestroyed);
+    return state;
+}
+
+bool CommandScheduler::_canStart(State* state, quint64 now)
+{
+    if (_globalLimitReached())
+        return false;
+
+    const ExecutionPolicy& policy = state->p_command->executionPolicy();
+    if ((policy.maxInFlight() > 0) && (state->m_inFlight >= policy.maxInFlight()))
+        return false;
+
+    if (policy.rate() <= 0.0)
+        return true;
+
+    if (now > state->m_refilledAt) {
+        state->m_tokens = qMin(double(policy.burst()),state->m_tokens + double(now - state->m_refilledAt) * policy.rate() / 1e9);
+        state->m_refilledAt = now;
+    }
+
+    if (state->m_tokens >= 1.0)
+        return true;
+
+    timerWheel->schedule(state,now + quint64((1.0 - state->m_tokens) * 1e9 / policy.rate()) + 1);
+    return false;
+}
+
+void CommandScheduler::_start(State* state, const KeyEvent& event, const Completion& completion, quint64 submittedAt,
+                              quint64 now)
+{
+    const ExecutionPolicy& policy = state->p_command->executionPolicy();
+    if (policy.rate() > 0.0)
+        state->m_tokens -= 1.0;
+
+    const quint64 execution = ++m_nextExecution;
+    m_executions.insert(execution,state);
+    if (completion)
+        m_completions.insert(execution,completion);
+    state->m_inFlight++;
+    m_inFlight++;
+    if (!state->m_holdsSlot)
+        m_awaiting++;
+
+#ifdef METRICS
+    _count(Started,policy.priority());
+    p_inFlightGauge->set(m_inFlight);
+    p_queueWait->record(now - submittedAt);
+#endif //METRICS
+
+#ifdef TRACING
+    if (now > submittedAt)
+        tracer->addSpan(event,"queue",submittedAt,now);
+#endif //TRACING
+
+#if !defined(METRICS) && !defined(TRACING)
+    Q_UNUSED(submittedAt);
+    Q_UNUSED(now);
+#endif
+
+    state->p_command->_execute(event,execution);
+}
+
+void CommandScheduler::_pump()
+{
+    //Invocation can be finished while it is being started, then slots are checked once again by the outer call
+    if (m_pumping) {
+        m_pumpAgain = true;
+        return;
+    }
+    m_pumping = true;
+
+    const quint64 now = timerWheel->now();
+    do {
+        m_pumpAgain = false;
+
+        for (int priority = 0; (priority < ExecutionPolicy::PRIORITY_COUNT) && !_globalLimitReached(); priority++) {
+            //Commands of the same priority take free slots in turns, so one busy command does not starve others
+            QList<State*>& ready = m_ready[priority];
+            int blocked = 0;
+            while ((blocked < ready.size()) && !_globalLimitReached()) {
+                State* state = ready.takeFirst();
+                if (!_canStart(state,now)) {
+                    ready.append(state);
+                    blocked++;
+                    continue;
+                }
+
+                const Invocation invocation = state->m_queue.front();
+                state->m_queue.pop_front();
+                m_queued--;
+
+                if (state->m_queue.empty()) {
+                    state->m_ready = false;
+                } else {
+                    ready.append(state);
+                }
+
+                blocked = 0;
+                _start(state,invocation.event,invocation.completion,invocation.submittedAt,now);
+            }
+        }
+    } while (m_pumpAgain);
+
+    m_pumping = false;
+#ifdef METRICS
+    p_queuedGauge->set(m_queued);
+#endif //METRICS
+}
+
+void CommandScheduler::_enqueue(State* state, const KeyEvent& event, const Completion& completion, quint64 now)
+{
+    state->m_queue.push_back({event,now,completion});
+    m_queued++;
+
+    if (!state->m_ready) {
+        state->m_priority = state->p_command->executionPolicy().priority();
+        state->m_ready = true;
+        m_ready[state->m_priority].append(state);
+    }
+
+#ifdef METRICS
+    p_queuedGauge->set(m_queued);
+#endif //METRICS
+}
+
+void CommandScheduler::_dropPending(State* state)
+{
+    m_queued -= int(state->m_queue.size());
+    state->m_queue.clear();
+
+    if (state->m_ready) {
+        m_ready[state->m_priority].removeOne(state);
+        state->m_ready = false;
+    }
+
+#ifdef METRICS
+    p_queuedGauge->set(m_queued);
+#endif //METRICS
+}
+
+void CommandScheduler::_count(Outcome outcome, ExecutionPolicy::Priority priority)
+{
+#ifdef METRICS
+    p_invocationCounters[outcome][priority]->increment();
+#else
+    Q_UNUSED(outcome);
+    Q_UNUSED(priority);
+#endif //METRICS
+}
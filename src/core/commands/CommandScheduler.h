@@ -0,0 +1,180 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+
+#include <deque>
+#include <functional>
+
+#include "core/KeyEvent.h"
+#include "core/TimerWheel.h"
+#include "ExecutionPolicy.h"
+
+#ifdef METRICS
+    #include "core/metrics/Metrics.h"
+#endif //METRICS
+
+class Command;
+
+/*!
+ *  @class CommandScheduler core/commands/CommandScheduler.h
+ *  @brief This class decides, when matched commands are executed.
+ *  @details Command::run submits invocation of the command to the scheduler, which applies ExecutionPolicy of the
+ *           command:
+ *           - invocation is started at once, if command has less than maxInFlight running invocations and token
+ *             bucket of the command (refilled with rate tokens per second up to burst tokens) is not empty;
+ *           - otherwise it waits in the queue of the command. If coalescing is enabled - invocation for the key,
+ *             which is already waiting, is merged with it (e.g. badge held on the reader);
+ *           - when queue of the command holds maxQueued invocations, or all queues together hold queueCapacity
+ *             invocations - overflow policy of the command drops new or the oldest invocation.
+ *
+ *           Global limit of running invocations can be set with CommandScheduler::setMaxInFlight. When it is
+ *           reached - freed slots are given to pending invocations by priority classes, commands of the same class
+ *           take them in turns. Pipelines (see PipelineCommand) wait for a free slot to start, but do not hold it
+ *           while running, as they only await their steps - otherwise steps could wait for the slot of their own
+ *           pipeline forever.
+ *
+ *           Each started invocation gets execution id. Invocation is running until Command reports it finished
+ *           (e.g. spawned process has exited). Invocations submitted with completion callback (see CommandExecution)
+ *           are never coalesced, callback gets result of the execution, or false if invocation was dropped. Waiting for tokens is driven by the TimerWheel, so it follows the
+ *           clock set by TimerWheel::setClock. Must be used from the main thread.
+ */
+
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static CommandScheduler* get() {
+        static CommandScheduler theOne;
+        return &theOne;
+    }
+    ~CommandScheduler();
+
+    /*! @brief This enum describes what happened with submitted invocation */
+    enum Outcome {
+        Started,
+        Queued,
+        Coalesced,
+        Dropped
+    };
+    static const int OUTCOME_COUNT = Dropped + 1;
+
+    /*! @brief Called with result of the execution, when invocation has finished or was dropped */
+    typedef std::function<void(bool success)> Completion;
+
+    /*! @brief Maximal number of invocations of all commands running at once, 0 - unlimited */
+    void      setMaxInFlight(int count);
+    int       maxInFlight() const                        { return m_maxInFlight; }
+
+    /*! @brief Maximal number of pending invocations of all commands */
+    void      setQueueCapacity(int count)                { m_queueCapacity = qMax(0,count); }
+    int       queueCapacity() const                      { return m_queueCapacity; }
+
+    /*! @brief Executes command for event now or later, according to its ExecutionPolicy. completion may be called
+     *         before this method returns */
+    Outcome   submit(Command* command, const KeyEvent& event, const Completion& completion = Completion());
+
+    /*! @brief Invocation with specified execution id has finished. Pending invocations are started, if they can be,
+     *         then completion of the invocation is called */
+    void      finished(quint64 execution, bool success = true);
+
+    int       inFlight() const                           { return m_inFlight; }
+    int       queued() const                             { return m_queued; }
+    int       inFlight(const Command* command) const;
+    int       queued(const Command* command) const;
+
+private slots:
+    void      _commandDestroyed(QObject* command);
+
+private:
+    CommandScheduler();
+    Q_DISABLE_COPY(CommandScheduler)
+
+    struct Invocation {
+        KeyEvent  event;
+        quint64   submittedAt;
+        Completion completion;
+    };
+
+    /*! @brief Invocations of one command */
+    class State : public TimerWheel::Client
+    {
+    public:
+        State(CommandScheduler* scheduler, Command* command)
+            : p_scheduler(scheduler),p_command(command),m_inFlight(0),m_tokens(0.0),m_refilledAt(0),
+              m_priority(ExecutionPolicy::Normal),m_ready(false),m_holdsSlot(true) {}
+
+        CommandScheduler*        p_scheduler;
+        Command*                 p_command;       //!< @brief nullptr if command was deleted while running
+        std::deque<Invocation>   m_queue;
+        int                      m_inFlight;
+        double                   m_tokens;
+        quint64                  m_refilledAt;
+        ExecutionPolicy::Priority m_priority;     //!< @brief Class, in which this State waits for slots
+        bool                     m_ready;         //!< @brief State is within one of m_ready lists
+        bool                     m_holdsSlot;     //!< @brief Running invocations count to the global limit
+
+    protected:
+        void  _timerWheelExpired(quint64 now) override   { Q_UNUSED(now); p_scheduler->_pump(); }
+    };
+
+    State*    _state(Command* command);
+    bool      _globalLimitReached() const    { return m_maxInFlight > 0 && (m_inFlight - m_awaiting) >= m_maxInFlight; }
+
+    /*! @brief Returns true if next invocation of state can be started now. If token bucket is empty - wakeup is
+     *         scheduled for the moment, when token will be available */
+    bool      _canStart(State* state, quint64 now);
+    void      _start(State* state, const KeyEvent& event, const Completion& completion, quint64 submittedAt, quint64 now);
+
+    /*! @brief Starts pending invocations while there are free slots */
+    void      _pump();
+    void      _enqueue(State* state, const KeyEvent& event, const Completion& completion, quint64 now);
+    void      _dropPending(State* state);
+    void      _count(Outcome outcome, ExecutionPolicy::Priority priority);
+
+    QHash<const QObject*,State*>  m_states;
+    QHash<quint64,State*>         m_executions;
+    QHash<quint64,Completion>     m_completions;  //!< @brief Completions of running invocations, which have them
+    QList<State*>                 m_ready[ExecutionPolicy::PRIORITY_COUNT];
+    quint64                       m_nextExecution;
+    int                           m_maxInFlight;
+    int                           m_queueCapacity;
+    int                           m_inFlight;
+    int                           m_awaiting;     //!< @brief Running invocations, which do not hold slots
+    int                           m_queued;
+    bool                          m_pumping;
+    bool                          m_pumpAgain;
+
+#ifdef METRICS
+    Counter*                      p_invocationCounters[OUTCOME_COUNT][ExecutionPolicy::PRIORITY_COUNT];
+    Gauge*                        p_inFlightGauge;
+    Gauge*                        p_queuedGauge;
+    Histogram*                    p_queueWait;
+#endif //METRICS
+};
+#define commandScheduler CommandScheduler::get()
+
+#endif // COMMANDSCHEDULER_H
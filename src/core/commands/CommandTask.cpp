@@ -0,0 +1,90 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandTask.h"
+
+#include <utility>
+
+#include "Command.h"
+#include "CommandScheduler.h"
+
+CommandExecution::CommandExecution(Command* command, const KeyEvent& event, quint64 timeout) :
+    p_command(command),
+    m_event(event),
+    m_timeout(timeout),
+    m_state(std::make_shared<State>())
+{}
+
+bool CommandExecution::await_ready() const
+{
+    if (p_command->isEnabled())
+        return false;
+
+    m_state->m_result = Skipped;
+    return true;
+}
+
+bool CommandExecution::await_suspend(std::coroutine_handle<> handle)
+{
+    //Result after timeout is ignored, state is kept alive by the callback till execution finishes
+    const std::shared_ptr<State> state = m_state;
+    commandScheduler->submit(p_command,m_event,[state](bool success) {
+        if (!state->m_done)
+            state->resume(success ? Succeeded : Failed);
+    });
+
+    //Execution, which has finished while being submitted, continues the coroutine without suspending it
+    if (m_state->m_done)
+        return false;
+
+    m_state->m_handle = handle;
+    if (m_timeout > 0)
+        timerWheel->schedule(m_state.get(),timerWheel->now() + m_timeout);
+
+    return true;
+}
+
+void CommandExecution::State::resume(Result result)
+{
+    timerWheel->cancel(this);
+    m_result = result;
+    m_done = true;
+
+    if (std::coroutine_handle<> handle = std::exchange(m_handle,nullptr))
+        handle.resume();
+}
+
+QString CommandExecution::resultName(Result result)
+{
+    switch (result) {
+    case Succeeded:
+        return QStringLiteral("succeeded");
+    case Failed:
+        return QStringLiteral("failed");
+    case TimedOut:
+        return QStringLiteral("timed out");
+    case Skipped:
+        return QStringLiteral("skipped");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
@@ -0,0 +1,107 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDTASK_H
+#define COMMANDTASK_H
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+
+#include "core/KeyEvent.h"
+#include "core/TimerWheel.h"
+
+class Command;
+
+/*!
+ *  @class CommandTask core/commands/CommandTask.h
+ *  @brief Return type of coroutines, which run commands (see PipelineCommand).
+ *  @details Coroutine starts at once and is not awaited by anybody - it runs till the first co_await and is resumed
+ *           from the event loop, when awaited CommandExecution has finished. Frame of the coroutine is released,
+ *           when it returns, so waiting coroutine costs only its frame, without threads or event loops. Coroutine
+ *           must take its arguments by value and must check, that objects it refers to still exist after each
+ *           co_await. CommandExecution objects should be stored in variables before co_await, as GCC (at least up
+ *           to 12) destroys temporary awaiter too early, if execution has finished without suspending.
+ */
+
+class CommandTask
+{
+public:
+    struct promise_type {
+        CommandTask           get_return_object() noexcept      { return CommandTask(); }
+        std::suspend_never    initial_suspend() noexcept        { return {}; }
+        std::suspend_never    final_suspend() noexcept          { return {}; }
+        void                  return_void() noexcept            {}
+        void                  unhandled_exception() noexcept    { std::terminate(); }
+    };
+};
+
+/*!
+ *  @class CommandExecution core/commands/CommandTask.h
+ *  @brief Awaitable execution of the command, see Command::runAsync.
+ *  @details Command is submitted to the CommandScheduler (so its ExecutionPolicy is applied), co_await resumes the
+ *           coroutine with result of the execution. If command is disabled - it is not executed and the result is
+ *           Skipped. If timeout has passed first - the result is TimedOut, execution itself is not stopped (e.g.
+ *           ShellCommand has its own timeout to terminate processes). Timeouts are driven by the TimerWheel.
+ */
+
+class CommandExecution
+{
+public:
+    enum Result {
+        Succeeded,
+        Failed,       /*!< @brief Execution has failed, or invocation was dropped by the CommandScheduler */
+        TimedOut,
+        Skipped
+    };
+
+    /*! @brief timeout - nanoseconds, 0 - no timeout */
+    CommandExecution(Command* command, const KeyEvent& event, quint64 timeout = 0);
+
+    bool      await_ready() const;
+    bool      await_suspend(std::coroutine_handle<> handle);
+    Result    await_resume() const noexcept                 { return m_state->m_result; }
+
+    static QString resultName(Result result);
+
+private:
+    /*! @brief Shared with completion callback, which can outlive the awaiting coroutine (e.g. after timeout) */
+    class State : public TimerWheel::Client
+    {
+    public:
+        void      resume(Result result);
+
+        std::coroutine_handle<> m_handle;
+        Result    m_result = Failed;
+        bool      m_done = false;
+
+    protected:
+        void      _timerWheelExpired(quint64 now) override  { Q_UNUSED(now); resume(TimedOut); }
+    };
+
+    Command*                 p_command;
+    KeyEvent                 m_event;
+    quint64                  m_timeout;
+    std::shared_ptr<State>   m_state;
+};
+
+#endif // COMMANDTASK_H
@@ -0,0 +1,223 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandTemplate.h"
+
+#include "core/KeyEvent.h"
+
+static const char* const FIELD_NAMES[CommandTemplate::Literal] = {
+    "key", "device", "ts", "vid", "pid", "trace"
+};
+
+/*! @brief Appends decimal representation of value without allocating temporary strings */
+static inline void appendDecimal(QByteArray* output, quint64 value)
+{
+    char buffer[20];
+    int position = sizeof(buffer);
+    do {
+        buffer[--position] = char('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    output->append(buffer + position,int(sizeof(buffer)) - position);
+}
+
+static inline void appendHex16(QByteArray* output, quint16 value)
+{
+    static const char digits[] = "0123456789abcdef";
+    const char buffer[4] = {
+        digits[(value >> 12) & 0xF], digits[(value >> 8) & 0xF], digits[(value >> 4) & 0xF], digits[value & 0xF]
+    };
+    output->append(buffer,4);
+}
+
+/*! @brief Device names are ASCII almost always, so they are appended without conversion */
+static inline void appendString(QByteArray* output, const QString& string)
+{
+    const QChar* data = string.constData();
+    const int size = string.size();
+    for (int i = 0; i < size; i++) {
+        if (data[i].unicode() >= 0x80) {
+            output->append(string.mid(i).toLocal8Bit());
+            return;
+        }
+        output->append(char(data[i].unicode()));
+    }
+}
+
+CommandTemplate::CommandTemplate(const QString& text, const QString& literalPrefix)
+    : m_text(text),m_fields(0)
+{
+    QString literal = literalPrefix;
+    int position = 0;
+    while (position < text.size()) {
+        const QChar character = text.at(position);
+
+        if (character == QLatin1Char('{')) {
+            const int end = text.indexOf(QLatin1Char('}'),position + 1);
+            const QString name = (end > 0) ? text.mid(position + 1,end - position - 1) : QString();
+
+            int field = 0;
+            while ((field < Literal) && (name != QLatin1String(FIELD_NAMES[field])))
+                field++;
+
+            if (field < Literal) {
+                _appendLiteral(literal.toLocal8Bit());
+                literal.clear();
+
+                m_instructions.append({Field(field),0,0});
+                m_fields |= 1u << field;
+                position = end + 1;
+                continue;
+            }
+        }
+
+        literal.append(character);
+        position++;
+    }
+
+    _appendLiteral(literal.toLocal8Bit());
+    m_instructions.squeeze();
+}
+
+void CommandTemplate::render(const KeyEvent& event, QByteArray* output) const
+{
+    //Reserved capacity is kept by QByteArray::resize, so buffer reused for the next events does not reallocate
+    output->reserve(qMax(output->capacity(),m_literals.size() + KeyEvent::MAX_KEY_LENGTH));
+    output->resize(0);
+
+    for (const Instruction& instruction : m_instructions) {
+        switch (instruction.field) {
+        case Literal:
+            output->append(m_literals.constData() + instruction.offset,instruction.length);
+            break;
+        case KeyField:
+            output->append(event.keyData(),event.keyLength());
+            break;
+        case DeviceField:
+            appendString(output,event.source());
+            break;
+        case TimestampField:
+            appendDecimal(output,KeyEvent::monotonicToRealtime(event.timestamp()) / (1000 * 1000));
+            break;
+        case VendorIdField:
+            appendHex16(output,event.vendorId());
+            break;
+        case ProductIdField:
+            appendHex16(output,event.productId());
+            break;
+        case TraceIdField:
+            appendDecimal(output,event.traceId());
+            break;
+        }
+    }
+}
+
+QByteArray CommandTemplate::render(const KeyEvent& event) const
+{
+    QByteArray result;
+    render(event,&result);
+    return result;
+}
+
+QString CommandTemplate::fieldName(Field field)
+{
+    Q_ASSERT(field >= KeyField && field < Literal);
+    return QLatin1String(FIELD_NAMES[field]);
+}
+
+QStringList CommandTemplate::splitArguments(const QString& arguments)
+{
+    QStringList result;
+    QString current;
+    bool inArgument = false;
+    QChar quote;
+
+    for (int i = 0; i < arguments.size(); i++) {
+        const QChar character = arguments.at(i);
+
+        if (character == QLatin1Char('\\') && (i + 1 < arguments.size()) && (quote != QLatin1Char('\''))) {
+            current.append(arguments.at(++i));
+            inArgument = true;
+        } else if (!quote.isNull()) {
+            if (character == quote) {
+                quote = QChar();
+            } else {
+                current.append(character);
+            }
+        } else if (character == QLatin1Char('"') || character == QLatin1Char('\'')) {
+            quote = character;
+            inArgument = true;
+        } else if (character.isSpace()) {
+            if (inArgument)
+                result.append(current);
+            current.clear();
+            inArgument = false;
+        } else {
+            current.append(character);
+            inArgument = true;
+        }
+    }
+
+    if (inArgument)
+        result.append(current);
+
+    return result;
+}
+
+QString CommandTemplate::joinArguments(const QStringList& arguments)
+{
+    QStringList quoted;
+    quoted.reserve(arguments.size());
+
+    for (const QString& argument : arguments) {
+        bool needsQuotes = argument.isEmpty();
+        for (const QChar& character : argument) {
+            if (character.isSpace() || character == QLatin1Char('"') || character == QLatin1Char('\'')
+                    || character == QLatin1Char('\\')) {
+                needsQuotes = true;
+                break;
+            }
+        }
+
+        if (!needsQuotes) {
+            quoted.append(argument);
+            continue;
+        }
+
+        //Inside single quotes nothing is escaped, so single quote itself is closed, escaped and opened again
+        QString escaped = argument;
+        escaped.replace(QLatin1Char('\''),QLatin1String("'\\''"));
+        quoted.append(QLatin1Char('\'') + escaped + QLatin1Char('\''));
+    }
+
+    return quoted.join(QLatin1Char(' '));
+}
+
+void CommandTemplate::_appendLiteral(const QByteArray& literal)
+{
+    if (literal.isEmpty())
+        return;
+
+    m_instructions.append({Literal,m_literals.size(),literal.size()});
+    m_literals.append(literal);
+}
@@ -0,0 +1,108 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDTEMPLATE_H
+#define COMMANDTEMPLATE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class KeyEvent;
+
+/*!
+ *  @class CommandTemplate core/commands/CommandTemplate.h
+ *  @brief This class renders arguments and environment variables of commands from data of KeyEvent.
+ *  @details Template is a text with placeholders:
+ *           - {key} - normalized key;
+ *           - {device} - device, which has read the key (device file or port name);
+ *           - {ts} - time of the tap in milliseconds since Unix epoch;
+ *           - {vid}, {pid} - USB vendor and product ids of the device (4 hex digits, 0000 if not known);
+ *           - {trace} - trace id of the tap (see Tracer).
+ *
+ *           Only these names are placeholders. All other braces are kept as they are, so arguments like JSON
+ *           documents or awk programs need no escaping. There is no escape sequence, "{{key}}" is written as the key
+ *           in braces.
+ *
+ *           Text is parsed once, when template is created, into the list of instructions: copy literal bytes or
+ *           write field of the event. CommandTemplate::render executes instructions in one pass into the buffer of
+ *           the caller, so rendering into reused buffer does not allocate memory.
+ */
+
+class CommandTemplate
+{
+public:
+    /*! @brief Fields of KeyEvent, which can be placed into templates */
+    enum Field {
+        KeyField,
+        DeviceField,
+        TimestampField,
+        VendorIdField,
+        ProductIdField,
+        TraceIdField,
+        Literal        /*!< @brief Not a field - instruction copies literal bytes */
+    };
+
+    CommandTemplate() : m_fields(0) {}
+    /*! @brief literalPrefix is written before text as it is, without looking for placeholders (e.g. name of
+     *         environment variable). CommandTemplate::text does not include it */
+    explicit CommandTemplate(const QString& text, const QString& literalPrefix = QString());
+
+    QString   text() const                               { return m_text; }
+
+    /*! @brief Returns true if template has no placeholders, so it is rendered to the same bytes for every event */
+    bool      isConstant() const                         { return m_fields == 0; }
+
+    /*! @brief Returns true if template has placeholder of field */
+    bool      uses(Field field) const                    { return (m_fields & (1u << field)) != 0; }
+
+    /*! @brief Replaces content of output with template rendered for event (in local 8-bit encoding) */
+    void      render(const KeyEvent& event, QByteArray* output) const;
+    QByteArray render(const KeyEvent& event) const;
+
+    /*! @brief Returns name of the field used in placeholders, e.g. "key" */
+    static QString fieldName(Field field);
+
+    /*! @brief Splits command line into arguments. Arguments are separated by spaces, single and double quotes group
+     *         text with spaces, backslash escapes the next character */
+    static QStringList splitArguments(const QString& arguments);
+
+    /*! @brief Joins arguments into command line, which is split back by CommandTemplate::splitArguments */
+    static QString     joinArguments(const QStringList& arguments);
+
+private:
+    struct Instruction {
+        Field     field;
+        int       offset;   //!< @brief Offset of literal within m_literals
+        int       length;
+    };
+
+    void      _appendLiteral(const QByteArray& literal);
+
+    QString               m_text;
+    QByteArray            m_literals;
+    QVector<Instruction>  m_instructions;
+    quint32               m_fields;      //!< @brief Bit mask of fields used by template
+};
+
+#endif // COMMANDTEMPLATE_H
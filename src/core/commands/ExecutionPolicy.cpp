@@ -0,0 +1,107 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ExecutionPolicy.h"
+
+static const ExecutionPolicy DEFAULT_POLICY;
+
+ExecutionPolicy::ExecutionPolicy(const QJsonObject& jsonObject)
+{
+    setMaxInFlight(jsonObject.value("maxInFlight").toInt(DEFAULT_POLICY.m_maxInFlight));
+    setRate(jsonObject.value("rate").toDouble(DEFAULT_POLICY.m_rate));
+    setBurst(jsonObject.value("burst").toInt(DEFAULT_POLICY.m_burst));
+    setCoalesce(jsonObject.value("coalesce").toBool(DEFAULT_POLICY.m_coalesce));
+    setPriority(priorityFromName(jsonObject.value("priority").toString()));
+    setMaxQueued(jsonObject.value("maxQueued").toInt(DEFAULT_POLICY.m_maxQueued));
+    setOverflow(overflowFromName(jsonObject.value("overflow").toString()));
+}
+
+bool ExecutionPolicy::isDefault() const
+{
+    return toJson().isEmpty();
+}
+
+QJsonObject ExecutionPolicy::toJson() const
+{
+    QJsonObject result;
+
+    if (m_maxInFlight != DEFAULT_POLICY.m_maxInFlight)
+        result.insert("maxInFlight",m_maxInFlight);
+    if (m_rate != DEFAULT_POLICY.m_rate)
+        result.insert("rate",m_rate);
+    if (m_burst != DEFAULT_POLICY.m_burst)
+        result.insert("burst",m_burst);
+    if (m_coalesce != DEFAULT_POLICY.m_coalesce)
+        result.insert("coalesce",m_coalesce);
+    if (m_priority != DEFAULT_POLICY.m_priority)
+        result.insert("priority",priorityName(m_priority));
+    if (m_maxQueued != DEFAULT_POLICY.m_maxQueued)
+        result.insert("maxQueued",m_maxQueued);
+    if (m_overflow != DEFAULT_POLICY.m_overflow)
+        result.insert("overflow",overflowName(m_overflow));
+
+    return result;
+}
+
+QString ExecutionPolicy::priorityName(Priority priority)
+{
+    switch (priority) {
+    case High:
+        return QStringLiteral("high");
+    case Normal:
+        return QStringLiteral("normal");
+    case Low:
+        return QStringLiteral("low");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+ExecutionPolicy::Priority ExecutionPolicy::priorityFromName(const QString& name)
+{
+    if (name == QLatin1String("high"))
+        return High;
+    if (name == QLatin1String("low"))
+        return Low;
+
+    return Normal;
+}
+
+QString ExecutionPolicy::overflowName(Overflow overflow)
+{
+    switch (overflow) {
+    case DropNewest:
+        return QStringLiteral("dropNewest");
+    case DropOldest:
+        return QStringLiteral("dropOldest");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+ExecutionPolicy::Overflow ExecutionPolicy::overflowFromName(const QString& name)
+{
+    if (name == QLatin1String("dropOldest"))
+        return DropOldest;
+
+    return DropNewest;
+}
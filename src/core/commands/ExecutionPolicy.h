@@ -0,0 +1,106 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXECUTIONPOLICY_H
+#define EXECUTIONPOLICY_H
+
+#include <QJsonObject>
+
+/*!
+ *  @class ExecutionPolicy core/commands/ExecutionPolicy.h
+ *  @brief This class holds limits, which CommandScheduler applies to invocations of one Command.
+ *  @details Policy is stored in the command file as "schedule" object of the command, e.g.
+ *           { "maxInFlight": 1, "rate": 0.5, "burst": 2, "coalesce": true, "priority": "high", "maxQueued": 8,
+ *             "overflow": "dropOldest" }. All fields are optional, default policy does not limit anything, so
+ *           commands without "schedule" are started as soon as they are matched.
+ */
+
+class ExecutionPolicy
+{
+public:
+    /*! @brief Priority classes. When global limit of running commands is reached - pending invocations of commands
+     *         with higher priority are started first */
+    enum Priority {
+        High,
+        Normal,
+        Low
+    };
+    static const int PRIORITY_COUNT = Low + 1;
+
+    /*! @brief This enum describes what happens with new invocation, when queue of the command is full */
+    enum Overflow {
+        DropNewest,  /*!< @brief New invocation is dropped */
+        DropOldest   /*!< @brief The oldest pending invocation is dropped, new one is queued */
+    };
+
+    ExecutionPolicy() {}
+    explicit ExecutionPolicy(const QJsonObject& jsonObject);
+
+    /*! @brief Maximal number of invocations of the command running at once, 0 - unlimited */
+    int       maxInFlight() const                        { return m_maxInFlight; }
+    void      setMaxInFlight(int count)                  { m_maxInFlight = qMax(0,count); }
+
+    /*! @brief Token bucket refill rate in invocations per second, 0 - unlimited */
+    double    rate() const                               { return m_rate; }
+    void      setRate(double rate)                       { m_rate = qMax(0.0,rate); }
+
+    /*! @brief Token bucket size - number of invocations, which can be started at once after idle period */
+    int       burst() const                              { return m_burst; }
+    void      setBurst(int count)                        { m_burst = qMax(1,count); }
+
+    /*! @brief If true - invocation for the key, which is already waiting in the queue, is merged with it */
+    bool      coalesce() const                           { return m_coalesce; }
+    void      setCoalesce(bool state)                    { m_coalesce = state; }
+
+    Priority  priority() const                           { return m_priority; }
+    void      setPriority(Priority priority)             { m_priority = priority; }
+
+    /*! @brief Maximal number of pending invocations of the command */
+    int       maxQueued() const                          { return m_maxQueued; }
+    void      setMaxQueued(int count)                    { m_maxQueued = qMax(0,count); }
+
+    Overflow  overflow() const                           { return m_overflow; }
+    void      setOverflow(Overflow overflow)             { m_overflow = overflow; }
+
+    /*! @brief Returns true if nothing differs from defaults. Default policy is not written to command files */
+    bool      isDefault() const;
+
+    /*! @brief Returns fields, which differ from default values */
+    QJsonObject toJson() const;
+
+    static QString   priorityName(Priority priority);
+    static Priority  priorityFromName(const QString& name);
+
+    static QString   overflowName(Overflow overflow);
+    static Overflow  overflowFromName(const QString& name);
+
+private:
+    int       m_maxInFlight = 0;
+    double    m_rate = 0.0;
+    int       m_burst = 1;
+    bool      m_coalesce = false;
+    Priority  m_priority = Normal;
+    int       m_maxQueued = 64;
+    Overflow  m_overflow = DropNewest;
+};
+
+#endif // EXECUTIONPOLICY_H
@@ -0,0 +1,173 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FuzzyKeyIndex.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+#include "core/cards/CardNormalizer.h"
+
+FuzzyKeyIndex::FuzzyKeyIndex() :
+    m_maxDistance(1)
+{}
+
+void FuzzyKeyIndex::clear()
+{
+    m_groups.clear();
+    m_groupIndex.clear();
+}
+
+bool FuzzyKeyIndex::add(const char* key, int length, int entry)
+{
+    quint32 groupId = 0;
+    quint64 value = 0;
+    if (!encode(key,length,&groupId,&value))
+        return false;
+
+    int index = m_groupIndex.value(groupId,-1);
+    if (index < 0) {
+        index = m_groups.size();
+        m_groups.append(Group());
+        m_groupIndex.insert(groupId,index);
+    }
+
+    m_groups[index].slots.append(Slot{ value, 0, entry });
+    return true;
+}
+
+void FuzzyKeyIndex::build(int maxDistance)
+{
+    m_maxDistance = qBound(1,maxDistance,MAX_DISTANCE);
+    for (int i = 0; i < m_groups.size(); i++)
+        _buildGroup(&m_groups[i]);
+}
+
+int FuzzyKeyIndex::find(const char* key, int length, QVector<int>* entries, bool* ambiguous) const
+{
+    entries->clear();
+    if (ambiguous != nullptr)
+        *ambiguous = false;
+
+    quint32 groupId = 0;
+    quint64 value = 0;
+    if (!encode(key,length,&groupId,&value))
+        return -1;
+
+    const int groupIndex = m_groupIndex.value(groupId,-1);
+    if (groupIndex < 0)
+        return -1;
+    const Group& group = m_groups.at(groupIndex);
+
+    int bestDistance = m_maxDistance + 1;
+    quint64 bestValue = 0;
+    bool bestAmbiguous = false;
+
+    for (int chunk = 0; chunk < group.chunkCount; chunk++) {
+        const Slot key{ 0, quint32((value >> group.chunkShift[chunk]) & group.chunkMask[chunk]), 0 };
+        const QVector<Slot>& table = group.tables[chunk];
+        auto it = std::lower_bound(table.constBegin(),table.constEnd(),key);
+
+        for (; it != table.constEnd() && it->chunk == key.chunk; ++it) {
+            const quint64 candidate = it->value;
+
+            //Candidate sharing one of the previous chunks was already checked
+            bool checked = false;
+            for (int previous = 0; previous < chunk && !checked; previous++) {
+                checked = ((candidate ^ value) >> group.chunkShift[previous] & group.chunkMask[previous]) == 0;
+            }
+            if (checked)
+                continue;
+
+            const int distance = qPopulationCount(candidate ^ value);
+            if (distance > m_maxDistance || distance > bestDistance)
+                continue;
+
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestValue = candidate;
+                bestAmbiguous = false;
+                entries->clear();
+            } else if (candidate != bestValue) {
+                bestAmbiguous = true;
+            }
+            entries->append(it->entry);
+        }
+    }
+
+    if (bestAmbiguous || entries->isEmpty()) {
+        entries->clear();
+        if (ambiguous != nullptr)
+            *ambiguous = bestAmbiguous;
+        return -1;
+    }
+
+    std::sort(entries->begin(),entries->end());
+    return bestDistance;
+}
+
+bool FuzzyKeyIndex::encode(const char* key, int length, quint32* group, quint64* value)
+{
+    if (length <= 0)
+        return false;
+
+    if (length <= 19 && CardNormalizer::parseDecimal(key,length,value)) {
+        *group = quint32(length);
+        return true;
+    }
+
+    if (length <= 16 && CardNormalizer::parseHex(key,length,value)) {
+        *group = 0x10000 | quint32(length);
+        return true;
+    }
+
+    return false;
+}
+
+void FuzzyKeyIndex::_buildGroup(Group* group)
+{
+    //Only significant bits are split, otherwise zero upper bits of card numbers would make chunks useless
+    quint64 usedBits = 0;
+    for (const Slot& slot : qAsConst(group->slots))
+        usedBits |= slot.value;
+
+    group->chunkCount = m_maxDistance + 1;
+    const int width = qMax(64 - int(qCountLeadingZeroBits(usedBits)),group->chunkCount);
+
+    int shift = 0;
+    for (int chunk = 0; chunk < group->chunkCount; chunk++) {
+        const int bits = width / group->chunkCount + (chunk < width % group->chunkCount ? 1 : 0);
+        group->chunkShift[chunk] = shift;
+        group->chunkMask[chunk] = (Q_UINT64_C(1) << bits) - 1;
+        shift += bits;
+
+        QVector<Slot>& table = group->tables[chunk];
+        table = group->slots;
+        for (int i = 0; i < table.size(); i++)
+            table[i].chunk = quint32((table.at(i).value >> group->chunkShift[chunk]) & group->chunkMask[chunk]);
+        std::stable_sort(table.begin(),table.end());
+    }
+
+    for (int chunk = group->chunkCount; chunk <= MAX_DISTANCE; chunk++)
+        group->tables[chunk].clear();
+}
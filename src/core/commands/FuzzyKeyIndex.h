@@ -0,0 +1,98 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FUZZYKEYINDEX_H
+#define FUZZYKEYINDEX_H
+
+#include <QHash>
+#include <QVector>
+
+/*!
+ *  @class FuzzyKeyIndex core/commands/FuzzyKeyIndex.h
+ *  @brief This class finds keys, which differ from the read key in few bits (Hamming distance).
+ *  @details Cheap 125 kHz readers sometimes flip a bit of the card number. Keys, which are numbers (canonical
+ *           proximity card numbers - up to 19 decimal digits, MIFARE UIDs - up to 16 hex digits), are indexed by
+ *           their value within groups of keys of the same kind and length. Other keys are not indexed.
+ *
+ *           Multi-index hashing is used: significant bits of the values of the group (W bits) are split into k + 1
+ *           chunks, where k is the maximal distance. If two values differ in at most k bits, at least one of the
+ *           chunks is equal, so only values sharing a chunk with the read value are checked. Each chunk has a table
+ *           of values sorted by this chunk, so candidates are read sequentially from memory.
+ *
+ *           Latency of FuzzyKeyIndex::find for group of N keys is k + 1 binary searches (log N each) plus about
+ *           (k + 1) * N / 2^(W / (k + 1)) comparisons (XOR and popcount) of candidates. For 1M proximity cards
+ *           (W = 32) it is ~30 candidates for k = 1, ~1.5k for k = 2 and ~16k for k = 3, so k is limited by
+ *           FuzzyKeyIndex::MAX_DISTANCE.
+ */
+
+class FuzzyKeyIndex
+{
+public:
+    FuzzyKeyIndex();
+    ~FuzzyKeyIndex() {}
+
+    static const int MAX_DISTANCE = 3;
+
+    void      clear();
+    bool      isEmpty() const                          { return m_groups.isEmpty(); }
+
+    /*! @brief Adds key with value entry. Returns false if key is not a number and was not indexed */
+    bool      add(const char* key, int length, int entry);
+
+    /*! @brief Builds tables for distance up to maxDistance (1...MAX_DISTANCE). Must be called after keys were added */
+    void      build(int maxDistance);
+    int       maxDistance() const                      { return m_maxDistance; }
+
+    /*! @brief Replaces content of entries with entries of the nearest key within maxDistance and returns distance to
+     *         it. If there is no such key, or several different keys are equally near (ambiguous is set to true
+     *         then), entries are cleared and -1 is returned */
+    int       find(const char* key, int length, QVector<int>* entries, bool* ambiguous = nullptr) const;
+
+    /*! @brief Converts key to group (kind and length) and its value. Returns false if key is not a number */
+    static bool encode(const char* key, int length, quint32* group, quint64* value);
+
+private:
+    Q_DISABLE_COPY(FuzzyKeyIndex)
+
+    struct Slot {
+        quint64           value;
+        quint32           chunk;
+        int               entry;
+        bool operator<(const Slot& other) const { return chunk < other.chunk; }
+    };
+
+    struct Group {
+        int               chunkCount;
+        int               chunkShift[MAX_DISTANCE + 1];
+        quint64           chunkMask[MAX_DISTANCE + 1];
+        QVector<Slot>     slots;                      //!< @brief Added keys, chunk is not used
+        QVector<Slot>     tables[MAX_DISTANCE + 1];   //!< @brief Keys sorted by chunk
+    };
+
+    void      _buildGroup(Group* group);
+
+    QVector<Group>        m_groups;
+    QHash<quint32,int>    m_groupIndex;
+    int                   m_maxDistance;
+};
+
+#endif // FUZZYKEYINDEX_H
@@ -0,0 +1,265 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyDigest.h"
+
+#include <QRandomGenerator>
+#include <QtEndian>
+
+#include <string.h>
+
+#include "core/KeyEvent.h"
+
+#if defined(Q_PROCESSOR_X86_64) && defined(Q_CC_GNU)
+    #define KEYDIGEST_SHA_NI
+    #include <cpuid.h>
+    #include <immintrin.h>
+#endif
+
+static const quint32 SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const quint32 SHA256_INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+typedef void (*CompressFunction)(quint32* state, const quint8* data, int blocks);
+
+static inline quint32 rotateRight(quint32 value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void compressGeneric(quint32* state, const quint8* data, int blocks)
+{
+    for (; blocks > 0; blocks--, data += 64) {
+        quint32 w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = qFromBigEndian<quint32>(data + 4 * i);
+        for (int i = 16; i < 64; i++) {
+            const quint32 s0 = rotateRight(w[i - 15],7) ^ rotateRight(w[i - 15],18) ^ (w[i - 15] >> 3);
+            const quint32 s1 = rotateRight(w[i - 2],17) ^ rotateRight(w[i - 2],19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        quint32 a = state[0], b = state[1], c = state[2], d = state[3];
+        quint32 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            const quint32 t1 = h + (rotateRight(e,6) ^ rotateRight(e,11) ^ rotateRight(e,25))
+                    + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+            const quint32 t2 = (rotateRight(a,2) ^ rotateRight(a,13) ^ rotateRight(a,22))
+                    + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef KEYDIGEST_SHA_NI
+
+/*! @brief Compresses blocks using SHA-NI. Each step does four rounds, message schedule is computed with
+ *         sha256msg1/sha256msg2 from the four previous groups of words */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void compressShaNi(quint32* state, const quint8* data, int blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,0x0405060700010203ULL);
+
+    //State is kept as ABEF and CDGH, as needed by sha256rnds2
+    __m128i temp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)),0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)),0x1B);
+    __m128i state0 = _mm_alignr_epi8(temp,state1,8);
+    state1 = _mm_blend_epi16(state1,temp,0xF0);
+
+    for (; blocks > 0; blocks--, data += 64) {
+        const __m128i savedState0 = state0;
+        const __m128i savedState1 = state1;
+
+        __m128i words[4];
+        for (int group = 0; group < 16; group++) {
+            __m128i current;
+            if (group < 4) {
+                current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * group)),byteSwap);
+            } else {
+                current = _mm_sha256msg1_epu32(words[group & 3],words[(group - 3) & 3]);
+                current = _mm_add_epi32(current,_mm_alignr_epi8(words[(group - 1) & 3],words[(group - 2) & 3],4));
+                current = _mm_sha256msg2_epu32(current,words[(group - 1) & 3]);
+            }
+            words[group & 3] = current;
+
+            __m128i message = _mm_add_epi32(current,_mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA256_K + 4 * group)));
+            state1 = _mm_sha256rnds2_epu32(state1,state0,message);
+            message = _mm_shuffle_epi32(message,0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0,state1,message);
+        }
+
+        state0 = _mm_add_epi32(state0,savedState0);
+        state1 = _mm_add_epi32(state1,savedState1);
+    }
+
+    temp = _mm_shuffle_epi32(state0,0x1B);
+    state1 = _mm_shuffle_epi32(state1,0xB1);
+    state0 = _mm_blend_epi16(temp,state1,0xF0);
+    state1 = _mm_alignr_epi8(state1,temp,8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state),state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),state1);
+}
+
+static bool cpuHasShaNi()
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1,&eax,&ebx,&ecx,&edx))
+        return false;
+    const bool sse41 = (ecx & bit_SSE4_1) != 0;
+    const bool ssse3 = (ecx & bit_SSSE3) != 0;
+
+    if (!__get_cpuid_count(7,0,&eax,&ebx,&ecx,&edx))
+        return false;
+    const bool sha = (ebx & (1u << 29)) != 0;
+
+    return sse41 && ssse3 && sha;
+}
+
+#endif //KEYDIGEST_SHA_NI
+
+static CompressFunction compressFunction()
+{
+#ifdef KEYDIGEST_SHA_NI
+    static const CompressFunction theOne = cpuHasShaNi() ? compressShaNi : compressGeneric;
+#else
+    static const CompressFunction theOne = compressGeneric;
+#endif //KEYDIGEST_SHA_NI
+    return theOne;
+}
+
+static const int SHA256_BLOCK_SIZE = 64;
+
+KeyDigest::KeyDigest(const QByteArray& secret) :
+    m_hasSecret(false)
+{
+    setSecret(secret);
+}
+
+void KeyDigest::setSecret(const QByteArray& secret)
+{
+    m_hasSecret = !secret.isEmpty();
+
+    quint8 hashedSecret[SIZE];
+    sha256(reinterpret_cast<const quint8*>(secret.constData()),secret.size(),hashedSecret);
+    memcpy(m_secretId,hashedSecret,SECRET_ID_SIZE);
+
+    quint8 block[SHA256_BLOCK_SIZE];
+    memset(block,0,SHA256_BLOCK_SIZE);
+    if (secret.size() > SHA256_BLOCK_SIZE) {
+        memcpy(block,hashedSecret,SIZE);
+    } else {
+        memcpy(block,secret.constData(),secret.size());
+    }
+
+    quint8 innerBlock[SHA256_BLOCK_SIZE];
+    quint8 outerBlock[SHA256_BLOCK_SIZE];
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        innerBlock[i] = block[i] ^ 0x36;
+        outerBlock[i] = block[i] ^ 0x5c;
+    }
+
+    memcpy(m_innerState,SHA256_INITIAL_STATE,sizeof(m_innerState));
+    memcpy(m_outerState,SHA256_INITIAL_STATE,sizeof(m_outerState));
+    compressFunction()(m_innerState,innerBlock,1);
+    compressFunction()(m_outerState,outerBlock,1);
+}
+
+QByteArray KeyDigest::secretId() const
+{
+    return QByteArray(reinterpret_cast<const char*>(m_secretId),SECRET_ID_SIZE);
+}
+
+void KeyDigest::digest(const char* key, int length, quint8* output) const
+{
+    Q_ASSERT(length >= 0 && length <= KeyEvent::MAX_KEY_LENGTH);
+
+    quint8 innerDigest[SIZE];
+    _finish(m_innerState,reinterpret_cast<const quint8*>(key),length,SHA256_BLOCK_SIZE,innerDigest);
+    _finish(m_outerState,innerDigest,SIZE,SHA256_BLOCK_SIZE,output);
+}
+
+QByteArray KeyDigest::digest(const QByteArray& key) const
+{
+    QByteArray result(SIZE,'\0');
+    digest(key.constData(),qMin(key.size(),int(KeyEvent::MAX_KEY_LENGTH)),reinterpret_cast<quint8*>(result.data()));
+    return result;
+}
+
+QByteArray KeyDigest::generateSecret()
+{
+    QByteArray result(SECRET_SIZE,'\0');
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(result.data()),SECRET_SIZE / sizeof(quint32));
+    return result;
+}
+
+const char* KeyDigest::implementationName()
+{
+#ifdef KEYDIGEST_SHA_NI
+    if (compressFunction() == compressShaNi)
+        return "sha-ni";
+#endif //KEYDIGEST_SHA_NI
+    return "generic";
+}
+
+void KeyDigest::sha256(const quint8* data, int length, quint8* output)
+{
+    _finish(SHA256_INITIAL_STATE,data,length,0,output);
+}
+
+void KeyDigest::_finish(const quint32* initialState, const quint8* data, int length, int prefixLength, quint8* output)
+{
+    quint32 state[8];
+    memcpy(state,initialState,sizeof(state));
+
+    const CompressFunction compress = compressFunction();
+    const int fullBlocks = length / 64;
+    compress(state,data,fullBlocks);
+
+    //Last one or two blocks: rest of data, 0x80, zeros and length in bits
+    quint8 tail[128];
+    const int rest = length - fullBlocks * 64;
+    memcpy(tail,data + fullBlocks * 64,rest);
+    tail[rest] = 0x80;
+    const int tailLength = (rest + 1 + 8 <= 64) ? 64 : 128;
+    memset(tail + rest + 1,0,tailLength - rest - 1);
+    qToBigEndian<quint64>(quint64(prefixLength + length) * 8,tail + tailLength - 8);
+    compress(state,tail,tailLength / 64);
+
+    for (int i = 0; i < 8; i++)
+        qToBigEndian<quint32>(state[i],output + 4 * i);
+}
@@ -0,0 +1,85 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYDIGEST_H
+#define KEYDIGEST_H
+
+#include <QByteArray>
+
+/*!
+ *  @class KeyDigest core/commands/KeyDigest.h
+ *  @brief This class computes keyed digests (HMAC-SHA256) of keys, so command files do not contain raw card numbers.
+ *  @details Digest is HMAC-SHA256 of the normalized key with the secret as HMAC key. Inner and outer padded secret
+ *           blocks are compressed once in setSecret, so digest of a short key takes two block compressions. On x86-64
+ *           CPUs with SHA extensions (SHA-NI) blocks are compressed with SHA instructions, otherwise - with portable
+ *           code. Digest is computed on the stack and does not allocate memory.
+ *
+ *           Threat model: card numbers are short (about 32 bits), so digests can be brute-forced by anyone knowing
+ *           the secret. Secret is therefore not stored in the command file, but in the application settings (see
+ *           KeyMatchingSettings::keyDigestSecret), command file holds only secretId to detect a wrong secret. A stolen
+ *           command file alone does not reveal keys. Whoever can read the settings as well (e.g. the same user
+ *           account, or a backup containing both) can recover keys, so settings file should be readable only by the
+ *           user running the controller. Moving hashed files to another machine requires moving the secret as well.
+ */
+
+class KeyDigest
+{
+public:
+    explicit KeyDigest(const QByteArray& secret = QByteArray());
+    ~KeyDigest() {}
+
+    static const int SIZE = 32;
+    static const int SECRET_SIZE = 32;
+    static const int SECRET_ID_SIZE = 8;
+
+    /*! @brief Secret longer than SHA-256 block (64 bytes) is replaced with its SHA-256, as HMAC requires */
+    void          setSecret(const QByteArray& secret);
+    bool          hasSecret() const                          { return m_hasSecret; }
+
+    /*! @brief First SECRET_ID_SIZE bytes of SHA-256 of the secret. Stored in command files instead of the secret, so
+     *         files hashed with another secret are detected */
+    QByteArray    secretId() const;
+
+    /*! @brief Writes SIZE bytes of digest of length (up to KeyEvent::MAX_KEY_LENGTH) bytes of key to output */
+    void          digest(const char* key, int length, quint8* output) const;
+    QByteArray    digest(const QByteArray& key) const;
+
+    /*! @brief Returns SECRET_SIZE random bytes from system random generator */
+    static QByteArray    generateSecret();
+
+    /*! @brief Name of the SHA-256 implementation used on this CPU: "sha-ni" or "generic" */
+    static const char*   implementationName();
+
+    /*! @brief Computes SHA-256 of length bytes of data */
+    static void          sha256(const quint8* data, int length, quint8* output);
+
+private:
+    /*! @brief Continues SHA-256 from state, after prefixLength bytes (multiple of 64) were compressed into it */
+    static void          _finish(const quint32* state, const quint8* data, int length, int prefixLength, quint8* output);
+
+    bool          m_hasSecret;
+    quint8        m_secretId[SECRET_ID_SIZE];
+    quint32       m_innerState[8];               //!< @brief State after compressing secret ^ ipad
+    quint32       m_outerState[8];               //!< @brief State after compressing secret ^ opad
+};
+
+#endif // KEYDIGEST_H
@@ -0,0 +1,828 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyPatternMatcher.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <climits>
+
+static const int DEAD_DFA_STATE  = 0;
+static const int START_DFA_STATE = 1;
+
+/*
+ **********************************************************************************************************************
+ * Parser of the regular expressions supported by DFA
+ */
+
+/*! @brief Parses regular expression into tree of nodes. Fails on everything, which DFA can not match exactly as
+ *         QRegularExpression would do it */
+class KeyPatternMatcher::RegexParser
+{
+public:
+    struct Node {
+        enum Kind { Set, Empty, Concat, Alternate, Repeat };
+        Kind          kind;
+        int           set;          //!< @brief Index of CharSet for Set node
+        int           min;
+        int           max;          //!< @brief -1 if Repeat node is unbounded
+        QVector<int>  children;
+    };
+
+    static const int MAX_NODES  = 4096;
+    static const int MAX_REPEAT = 1000;
+
+    RegexParser(const QByteArray& pattern, QVector<CharSet>* charSets) :
+        m_pattern(pattern),
+        m_position(0),
+        m_failed(false),
+        p_charSets(charSets)
+    {}
+
+    /*! @brief Returns root node, or -1 if expression is not supported */
+    int parse() {
+        const int root = _alternation();
+        if (m_failed || m_position != m_pattern.size())
+            return -1;
+        return root;
+    }
+
+    const Node& node(int index) const { return m_nodes.at(index); }
+
+private:
+    int  _alternation() {
+        QVector<int> branches{ _concatenation() };
+        while (!m_failed && _peek() == '|') {
+            m_position++;
+            branches.append(_concatenation());
+        }
+        if (branches.size() == 1)
+            return branches.first();
+
+        const int result = _addNode(Node::Alternate);
+        if (result >= 0)
+            m_nodes[result].children = branches;
+        return result;
+    }
+
+    int  _concatenation() {
+        QVector<int> items;
+        while (!m_failed && !_atEnd() && _peek() != '|' && _peek() != ')')
+            items.append(_repetition());
+        if (items.size() == 1)
+            return items.first();
+
+        const int result = _addNode(items.isEmpty() ? Node::Empty : Node::Concat);
+        if (result >= 0)
+            m_nodes[result].children = items;
+        return result;
+    }
+
+    int  _repetition() {
+        int result = _atom();
+        while (!m_failed && !_atEnd()) {
+            int min = 0;
+            int max = -1;
+            switch (_peek()) {
+            case '*': m_position++;                  break;
+            case '+': m_position++; min = 1;         break;
+            case '?': m_position++; max = 1;         break;
+            case '{':
+                m_position++;
+                if (!_bounds(&min,&max))
+                    return _fail();
+                break;
+            default:
+                return result;
+            }
+
+            //Lazy quantifiers do not change set of fully matched keys, possessive ones do
+            if (_peek() == '?')
+                m_position++;
+            else if (_peek() == '+')
+                return _fail();
+
+            const int repeat = _addNode(Node::Repeat);
+            if (repeat < 0)
+                return repeat;
+            m_nodes[repeat].min = min;
+            m_nodes[repeat].max = max;
+            m_nodes[repeat].children = { result };
+            result = repeat;
+        }
+        return result;
+    }
+
+    int  _atom() {
+        CharSet set = {};
+        const char c = m_pattern.at(m_position++);
+        switch (c) {
+        case '(':
+            if (_peek() == '?') {
+                //Only non-capturing groups, lookarounds, flags and named groups are not supported
+                if (m_position + 1 >= m_pattern.size() || m_pattern.at(m_position + 1) != ':')
+                    return _fail();
+                m_position += 2;
+            }
+            {
+                const int result = _alternation();
+                if (_peek() != ')')
+                    return _fail();
+                m_position++;
+                return result;
+            }
+        case '[':
+            if (!_class(&set))
+                return _fail();
+            break;
+        case '.':
+            _addRange(&set,0,255);
+            _removeChar(&set,'\n');
+            break;
+        case '\\':
+            if (!_escape(&set))
+                return _fail();
+            break;
+        case '^':
+            //Keys are matched as a whole, so anchors are allowed only at the ends of the expression
+            if (m_position != 1)
+                return _fail();
+            return _addNode(Node::Empty);
+        case '$':
+            if (m_position != m_pattern.size())
+                return _fail();
+            return _addNode(Node::Empty);
+        case '*': case '+': case '?': case '{': case ')': case '|':
+            return _fail();
+        default:
+            _addRange(&set,uchar(c),uchar(c));
+        }
+
+        const int result = _addNode(Node::Set);
+        if (result >= 0) {
+            m_nodes[result].set = p_charSets->size();
+            p_charSets->append(set);
+        }
+        return result;
+    }
+
+    bool _class(CharSet* set) {
+        bool negated = false;
+        if (_peek() == '^') {
+            negated = true;
+            m_position++;
+        }
+
+        bool first = true;
+        while (!_atEnd() && (_peek() != ']' || first)) {
+            first = false;
+            uchar low = uchar(m_pattern.at(m_position++));
+            if (low == '[' && _peek() == ':')
+                return false;           //POSIX classes
+            if (low == '\\') {
+                CharSet escaped = {};
+                if (!_escape(&escaped))
+                    return false;
+                if (!_singleChar(escaped,&low)) {
+                    for (int i = 0; i < 4; i++)
+                        set->bits[i] |= escaped.bits[i];
+                    continue;
+                }
+            }
+
+            uchar high = low;
+            if (_peek() == '-' && m_position + 1 < m_pattern.size() && m_pattern.at(m_position + 1) != ']') {
+                m_position++;
+                high = uchar(m_pattern.at(m_position++));
+                if (high == '\\') {
+                    CharSet escaped = {};
+                    if (!_escape(&escaped) || !_singleChar(escaped,&high))
+                        return false;
+                }
+                if (high < low)
+                    return false;
+            }
+            _addRange(set,low,high);
+        }
+
+        if (_atEnd())
+            return false;
+        m_position++;
+
+        if (negated) {
+            for (int i = 0; i < 4; i++)
+                set->bits[i] = ~set->bits[i];
+        }
+        return true;
+    }
+
+    bool _escape(CharSet* set) {
+        if (_atEnd())
+            return false;
+
+        const char c = m_pattern.at(m_position++);
+        switch (c) {
+        case 'd': _addRange(set,'0','9'); return true;
+        case 'w': _addWordChars(set);     return true;
+        case 's': _addSpaces(set);        return true;
+        case 'D': _addRange(set,'0','9'); _invert(set); return true;
+        case 'W': _addWordChars(set);     _invert(set); return true;
+        case 'S': _addSpaces(set);        _invert(set); return true;
+        case 't': _addRange(set,'\t','\t'); return true;
+        case 'n': _addRange(set,'\n','\n'); return true;
+        case 'r': _addRange(set,'\r','\r'); return true;
+        case 'f': _addRange(set,'\f','\f'); return true;
+        case 'v': _addRange(set,'\v','\v'); return true;
+        case 'x': {
+            if (m_position + 2 > m_pattern.size())
+                return false;
+            bool ok = false;
+            const int value = m_pattern.mid(m_position,2).toInt(&ok,16);
+            if (!ok)
+                return false;
+            m_position += 2;
+            _addRange(set,uchar(value),uchar(value));
+            return true;
+        }
+        default:
+            //Escaped letters and digits are assertions, backreferences, properties, etc.
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+                return false;
+            _addRange(set,uchar(c),uchar(c));
+            return true;
+        }
+    }
+
+    bool _bounds(int* min, int* max) {
+        const int close = m_pattern.indexOf('}',m_position);
+        if (close < 0)
+            return false;
+
+        const QList<QByteArray> parts = m_pattern.mid(m_position,close - m_position).split(',');
+        m_position = close + 1;
+        if (parts.size() > 2)
+            return false;
+
+        bool ok = false;
+        *min = parts.first().toInt(&ok);
+        if (!ok || *min < 0 || *min > MAX_REPEAT)
+            return false;
+
+        if (parts.size() == 1) {
+            *max = *min;
+            return true;
+        }
+
+        if (parts.last().isEmpty()) {
+            *max = -1;
+            return true;
+        }
+
+        *max = parts.last().toInt(&ok);
+        return ok && *max >= *min && *max <= MAX_REPEAT;
+    }
+
+    int  _addNode(Node::Kind kind) {
+        if (m_nodes.size() >= MAX_NODES)
+            return _fail();
+        m_nodes.append(Node{ kind, -1, 0, 0, {} });
+        return m_nodes.size() - 1;
+    }
+
+    int  _fail()                            { m_failed = true; return -1; }
+    bool _atEnd() const                     { return m_position >= m_pattern.size(); }
+    char _peek() const                      { return _atEnd() ? '\0' : m_pattern.at(m_position); }
+
+    static void _addRange(CharSet* set, uchar low, uchar high) {
+        for (int c = low; c <= high; c++)
+            set->bits[c >> 6] |= Q_UINT64_C(1) << (c & 63);
+    }
+    static void _removeChar(CharSet* set, uchar c) { set->bits[c >> 6] &= ~(Q_UINT64_C(1) << (c & 63)); }
+    static void _invert(CharSet* set)              { for (int i = 0; i < 4; i++) set->bits[i] = ~set->bits[i]; }
+    static void _addWordChars(CharSet* set) {
+        _addRange(set,'0','9');
+        _addRange(set,'A','Z');
+        _addRange(set,'a','z');
+        _addRange(set,'_','_');
+    }
+    static void _addSpaces(CharSet* set) {
+        _addRange(set,'\t','\r');
+        _addRange(set,' ',' ');
+    }
+    static bool _singleChar(const CharSet& set, uchar* c) {
+        int count = 0;
+        for (int i = 0; i < 256; i++) {
+            if (set.contains(uchar(i))) {
+                *c = uchar(i);
+                count++;
+            }
+        }
+        return count == 1;
+    }
+
+    const QByteArray   m_pattern;
+    int                m_position;
+    bool               m_failed;
+    QVector<Node>      m_nodes;
+    QVector<CharSet>*  p_charSets;
+};
+
+/*
+ **********************************************************************************************************************
+ * KeyPatternMatcher
+ */
+
+KeyPatternMatcher::KeyPatternMatcher() :
+    m_nfaOverflow(false),
+    m_classCount(1),
+    m_dfaMemory(0),
+    m_nfaGeneration(0),
+    m_dfaFlushes(0)
+{
+    std::fill(std::begin(m_byteClasses),std::end(m_byteClasses),0);
+    std::fill(std::begin(m_classBytes),std::end(m_classBytes),0);
+}
+
+void KeyPatternMatcher::clear()
+{
+    m_trieNodes.clear();
+    m_pendingPrefixes.clear();
+    m_trieRules.clear();
+    m_intervals.clear();
+    m_charSets.clear();
+    m_nfaStates.clear();
+    m_regexStarts.clear();
+    m_dfaStates.clear();
+    m_dfaNext.clear();
+    m_dfaIndex.clear();
+    m_dfaMemory = 0;
+    m_nfaMarks.clear();
+    m_fallbackRegexes.clear();
+}
+
+bool KeyPatternMatcher::isEmpty() const
+{
+    return m_trieNodes.isEmpty() && m_intervals.isEmpty() && m_regexStarts.isEmpty() && m_fallbackRegexes.isEmpty();
+}
+
+void KeyPatternMatcher::addPrefix(const QByteArray& prefix, int rule)
+{
+    if (m_trieNodes.isEmpty())
+        m_trieNodes.append(TrieNode{ -1, -1, 0, 0, 0 });
+
+    int node = 0;
+    for (char c : prefix) {
+        int child = _trieChild(node,uchar(c));
+        if (child < 0) {
+            child = m_trieNodes.size();
+            m_trieNodes.append(TrieNode{ -1, m_trieNodes.at(node).firstChild, 0, 0, uchar(c) });
+            m_trieNodes[node].firstChild = child;
+        }
+        node = child;
+    }
+
+    m_pendingPrefixes.append(qMakePair(node,rule));
+}
+
+void KeyPatternMatcher::addRange(quint64 low, quint64 high, int rule)
+{
+    Q_ASSERT(low <= high);
+    m_intervals.append(Interval{ low, high, high, rule });
+}
+
+bool KeyPatternMatcher::addRegex(const QString& pattern, int rule, QString* errorString)
+{
+    QRegularExpression regex(QRegularExpression::anchoredPattern(pattern));
+    if (!regex.isValid()) {
+        if (errorString != nullptr)
+            *errorString = regex.errorString();
+        return false;
+    }
+
+    const QByteArray latin1 = pattern.toLatin1();
+    const int firstCharSet = m_charSets.size();
+    const int firstState = m_nfaStates.size();
+
+    int root = -1;
+    if (QString::fromLatin1(latin1) == pattern) {
+        RegexParser parser(latin1,&m_charSets);
+        root = parser.parse();
+        if (root >= 0) {
+            m_nfaOverflow = false;
+            const int match = _addNfaState(NfaState::Match,rule,-1,-1);
+            const int start = _compileRegexNode(parser,root,match,firstState);
+            if (!m_nfaOverflow) {
+                m_regexStarts.append(start);
+                return true;
+            }
+        }
+    }
+
+    //Expression can not be converted to DFA, it will be matched by QRegularExpression
+    m_charSets.resize(firstCharSet);
+    m_nfaStates.resize(firstState);
+
+    qDebug() << "Regular expression"<<pattern<<"is not supported by DFA, using QRegularExpression";
+    regex.optimize();
+    m_fallbackRegexes.append(qMakePair(regex,rule));
+    return true;
+}
+
+void KeyPatternMatcher::compile()
+{
+    //Trie: rules of each node are stored contiguously in m_trieRules
+    std::stable_sort(m_pendingPrefixes.begin(),m_pendingPrefixes.end(),
+                     [](const QPair<int,int>& a, const QPair<int,int>& b) { return a.first < b.first; });
+    m_trieRules.clear();
+    m_trieRules.reserve(m_pendingPrefixes.size());
+    for (int i = 0; i < m_trieNodes.size(); i++)
+        m_trieNodes[i].rulesBegin = m_trieNodes[i].rulesEnd = 0;
+    for (const QPair<int,int>& prefix : qAsConst(m_pendingPrefixes)) {
+        TrieNode& node = m_trieNodes[prefix.first];
+        if (node.rulesBegin == node.rulesEnd)
+            node.rulesBegin = node.rulesEnd = m_trieRules.size();
+        m_trieRules.append(prefix.second);
+        node.rulesEnd++;
+    }
+
+    //Interval tree: implicit balanced tree over intervals sorted by lower bound
+    std::sort(m_intervals.begin(),m_intervals.end(),
+              [](const Interval& a, const Interval& b) { return a.low < b.low; });
+    _buildIntervalTree(0,m_intervals.size());
+
+    //DFA: states are created by the first keys
+    _buildByteClasses();
+    m_nfaMarks.fill(0,m_nfaStates.size());
+    m_nfaGeneration = 0;
+    _resetDfa();
+}
+
+void KeyPatternMatcher::match(const char* key, int length, QVector<int>* rules) const
+{
+    rules->clear();
+
+    int node = m_trieNodes.isEmpty() ? -1 : 0;
+    int dfa = m_regexStarts.isEmpty() ? DEAD_DFA_STATE : START_DFA_STATE;
+    bool decimal = !m_intervals.isEmpty() && length > 0 && length <= 19;
+    quint64 number = 0;
+
+    for (int i = 0; i < length; i++) {
+        const uchar c = uchar(key[i]);
+
+        if (node >= 0) {
+            _appendTrieRules(node,rules);
+            node = _trieChild(node,c);
+        }
+
+        if (dfa != DEAD_DFA_STATE)
+            dfa = _dfaStep(dfa,c);
+
+        if (decimal) {
+            const uint digit = uint(c) - '0';
+            decimal = (digit <= 9);
+            number = number * 10 + digit;
+        }
+
+        if (node < 0 && dfa == DEAD_DFA_STATE && !decimal)
+            break;
+    }
+
+    if (node >= 0)
+        _appendTrieRules(node,rules);
+
+    if (dfa != DEAD_DFA_STATE)
+        rules->append(m_dfaStates.at(dfa).rules);
+
+    if (decimal)
+        _queryIntervals(0,m_intervals.size(),number,rules);
+
+    if (!m_fallbackRegexes.isEmpty()) {
+        const QString keyString = QString::fromLatin1(key,length);
+        for (const QPair<QRegularExpression,int>& regex : m_fallbackRegexes) {
+            if (regex.first.match(keyString).hasMatch())
+                rules->append(regex.second);
+        }
+    }
+
+    std::sort(rules->begin(),rules->end());
+}
+
+bool KeyPatternMatcher::parseRange(const QString& text, quint64* low, quint64* high)
+{
+    static const QLatin1String FACILITY("facility:");
+
+    const QString trimmed = text.trimmed();
+    bool ok = false;
+
+    if (trimmed.startsWith(FACILITY)) {
+        const quint64 facility = trimmed.mid(FACILITY.size()).trimmed().toULongLong(&ok);
+        if (!ok || facility > 0xFFFF)
+            return false;
+        *low = facility << 16;
+        *high = *low | 0xFFFF;
+        return true;
+    }
+
+    const int dash = trimmed.indexOf('-');
+    if (dash < 0) {
+        *low = *high = trimmed.toULongLong(&ok);
+        return ok;
+    }
+
+    *low = trimmed.left(dash).trimmed().toULongLong(&ok);
+    if (!ok)
+        return false;
+    *high = trimmed.mid(dash + 1).trimmed().toULongLong(&ok);
+    return ok && *low <= *high;
+}
+
+int KeyPatternMatcher::_trieChild(int node, uchar c) const
+{
+    for (int child = m_trieNodes.at(node).firstChild; child >= 0; child = m_trieNodes.at(child).nextSibling) {
+        if (m_trieNodes.at(child).label == c)
+            return child;
+    }
+    return -1;
+}
+
+void KeyPatternMatcher::_appendTrieRules(int node, QVector<int>* rules) const
+{
+    const TrieNode& trieNode = m_trieNodes.at(node);
+    for (int i = trieNode.rulesBegin; i < trieNode.rulesEnd; i++)
+        rules->append(m_trieRules.at(i));
+}
+
+quint64 KeyPatternMatcher::_buildIntervalTree(int begin, int end)
+{
+    if (begin >= end)
+        return 0;
+
+    const int middle = begin + (end - begin) / 2;
+    const quint64 left = _buildIntervalTree(begin,middle);
+    const quint64 right = _buildIntervalTree(middle + 1,end);
+
+    Interval& interval = m_intervals[middle];
+    interval.maxHigh = qMax(interval.high,qMax(left,right));
+    return interval.maxHigh;
+}
+
+void KeyPatternMatcher::_queryIntervals(int begin, int end, quint64 value, QVector<int>* rules) const
+{
+    while (begin < end) {
+        const int middle = begin + (end - begin) / 2;
+        const Interval& interval = m_intervals.at(middle);
+        if (interval.maxHigh < value)
+            return;
+
+        _queryIntervals(begin,middle,value,rules);
+
+        //Intervals to the right start even later
+        if (interval.low > value)
+            return;
+        if (interval.high >= value)
+            rules->append(interval.rule);
+
+        begin = middle + 1;
+    }
+}
+
+int KeyPatternMatcher::_compileRegexNode(const RegexParser& parser, int index, int next, int firstState)
+{
+    //NFA is built from the end of expression, so every fragment knows state following it
+    if (m_nfaOverflow || m_nfaStates.size() - firstState > MAX_NFA_STATES_PER_PATTERN) {
+        m_nfaOverflow = true;
+        return next;
+    }
+
+    const RegexParser::Node& node = parser.node(index);
+    switch (node.kind) {
+    case RegexParser::Node::Set:
+        return _addNfaState(NfaState::Char,node.set,next,-1);
+
+    case RegexParser::Node::Empty:
+        return next;
+
+    case RegexParser::Node::Concat:
+        for (int i = node.children.size() - 1; i >= 0; i--)
+            next = _compileRegexNode(parser,node.children.at(i),next,firstState);
+        return next;
+
+    case RegexParser::Node::Alternate: {
+        int result = _compileRegexNode(parser,node.children.last(),next,firstState);
+        for (int i = node.children.size() - 2; i >= 0; i--) {
+            const int branch = _compileRegexNode(parser,node.children.at(i),next,firstState);
+            result = _addNfaState(NfaState::Split,0,branch,result);
+        }
+        return result;
+    }
+
+    case RegexParser::Node::Repeat: {
+        const int child = node.children.first();
+        int result = next;
+
+        if (node.max < 0) {
+            const int loop = _addNfaState(NfaState::Split,0,-1,next);
+            const int body = _compileRegexNode(parser,child,loop,firstState);
+            m_nfaStates[loop].out = body;
+            result = loop;
+        } else {
+            //x{0,2} is (x(x)?)?
+            for (int i = node.min; i < node.max; i++) {
+                const int body = _compileRegexNode(parser,child,result,firstState);
+                result = _addNfaState(NfaState::Split,0,body,next);
+            }
+        }
+
+        for (int i = 0; i < node.min; i++)
+            result = _compileRegexNode(parser,child,result,firstState);
+        return result;
+    }
+    }
+
+    Q_ASSERT(false);
+    return next;
+}
+
+int KeyPatternMatcher::_addNfaState(NfaState::Kind kind, int value, int out, int out1)
+{
+    m_nfaStates.append(NfaState{ kind, value, out, out1 });
+    return m_nfaStates.size() - 1;
+}
+
+void KeyPatternMatcher::_buildByteClasses()
+{
+    //Equal sets are merged, so each expression does not bring its own copy of e.g. \d
+    QHash<QByteArray,int> uniqueSets;
+    QVector<int> setIndexes(m_charSets.size());
+    QVector<CharSet> charSets;
+    for (int i = 0; i < m_charSets.size(); i++) {
+        const QByteArray bits(reinterpret_cast<const char*>(m_charSets.at(i).bits),sizeof(CharSet::bits));
+        int index = uniqueSets.value(bits,-1);
+        if (index < 0) {
+            index = charSets.size();
+            uniqueSets.insert(bits,index);
+            charSets.append(m_charSets.at(i));
+        }
+        setIndexes[i] = index;
+    }
+    for (int i = 0; i < m_nfaStates.size(); i++) {
+        if (m_nfaStates.at(i).kind == NfaState::Char)
+            m_nfaStates[i].value = setIndexes.at(m_nfaStates.at(i).value);
+    }
+    m_charSets = charSets;
+
+    //Each set splits classes to bytes within the set and outside of it
+    std::fill(std::begin(m_byteClasses),std::end(m_byteClasses),0);
+    m_classCount = 1;
+    for (const CharSet& set : qAsConst(m_charSets)) {
+        int splitClasses[2 * 256];
+        std::fill(std::begin(splitClasses),std::end(splitClasses),-1);
+
+        int count = 0;
+        for (int c = 0; c < 256; c++) {
+            int& splitClass = splitClasses[2 * m_byteClasses[c] + (set.contains(uchar(c)) ? 1 : 0)];
+            if (splitClass < 0)
+                splitClass = count++;
+            m_byteClasses[c] = uchar(splitClass);
+        }
+        m_classCount = count;
+        if (m_classCount == 256)
+            break;
+    }
+
+    for (int c = 255; c >= 0; c--)
+        m_classBytes[m_byteClasses[c]] = uchar(c);
+}
+
+void KeyPatternMatcher::_resetDfa() const
+{
+    m_dfaStates.clear();
+    m_dfaNext.clear();
+    m_dfaIndex.clear();
+    m_dfaMemory = 0;
+    m_dfaFlushes++;
+
+    m_dfaStates.append(DfaState());
+    m_dfaNext.fill(DEAD_DFA_STATE,m_classCount);
+    m_dfaIndex.insert(QVector<int>(),DEAD_DFA_STATE);
+
+    if (m_regexStarts.isEmpty())
+        return;
+
+    if (++m_nfaGeneration == INT_MAX) {
+        m_nfaMarks.fill(0);
+        m_nfaGeneration = 1;
+    }
+    QVector<int> start;
+    for (int state : m_regexStarts)
+        _addClosure(state,&start);
+    std::sort(start.begin(),start.end());
+
+    const int startState = _dfaState(start);
+    Q_ASSERT(startState == START_DFA_STATE);
+    Q_UNUSED(startState);
+}
+
+int KeyPatternMatcher::_dfaState(const QVector<int>& nfaStates) const
+{
+    const int existing = m_dfaIndex.value(nfaStates,-1);
+    if (existing >= 0)
+        return existing;
+
+    //Dead and start states are always kept
+    const int memory = int(sizeof(DfaState)) + (m_classCount + 2 * nfaStates.size()) * int(sizeof(int));
+    if (m_dfaMemory + memory > MAX_DFA_MEMORY && m_dfaStates.size() > START_DFA_STATE + 1) {
+        qDebug() << "DFA cache is full, flushing it";
+        _resetDfa();
+        return _dfaState(nfaStates);
+    }
+    m_dfaMemory += memory;
+
+    DfaState state;
+    state.nfaStates = nfaStates;
+    for (int nfaState : nfaStates) {
+        if (m_nfaStates.at(nfaState).kind == NfaState::Match)
+            state.rules.append(m_nfaStates.at(nfaState).value);
+    }
+    std::sort(state.rules.begin(),state.rules.end());
+
+    m_dfaStates.append(state);
+    m_dfaNext.resize(m_dfaNext.size() + m_classCount);
+    std::fill(m_dfaNext.end() - m_classCount,m_dfaNext.end(),-1);
+    m_dfaIndex.insert(nfaStates,m_dfaStates.size() - 1);
+    return m_dfaStates.size() - 1;
+}
+
+int KeyPatternMatcher::_dfaStep(int state, uchar c) const
+{
+    const int byteClass = m_byteClasses[c];
+    const int cached = m_dfaNext.at(state * m_classCount + byteClass);
+    if (cached >= 0)
+        return cached;
+
+    //All bytes of the class lead to the same state
+    c = m_classBytes[byteClass];
+
+    if (++m_nfaGeneration == INT_MAX) {
+        m_nfaMarks.fill(0);
+        m_nfaGeneration = 1;
+    }
+
+    m_nextNfaStates.clear();
+    for (int nfaState : m_dfaStates.at(state).nfaStates) {
+        const NfaState& nfa = m_nfaStates.at(nfaState);
+        if (nfa.kind == NfaState::Char && m_charSets.at(nfa.value).contains(c))
+            _addClosure(nfa.out,&m_nextNfaStates);
+    }
+    std::sort(m_nextNfaStates.begin(),m_nextNfaStates.end());
+
+    //If cache was flushed while adding new state - index of the current state is no longer valid
+    const int flushes = m_dfaFlushes;
+    const int next = _dfaState(m_nextNfaStates);
+    if (flushes == m_dfaFlushes)
+        m_dfaNext[state * m_classCount + byteClass] = next;
+
+    return next;
+}
+
+void KeyPatternMatcher::_addClosure(int nfaState, QVector<int>* result) const
+{
+    //Only Char and Match states are kept in DFA states, Split states are followed
+    m_closureStack.clear();
+    m_closureStack.append(nfaState);
+
+    while (!m_closureStack.isEmpty()) {
+        const int current = m_closureStack.takeLast();
+        if (m_nfaMarks.at(current) == m_nfaGeneration)
+            continue;
+        m_nfaMarks[current] = m_nfaGeneration;
+
+        const NfaState& nfa = m_nfaStates.at(current);
+        if (nfa.kind == NfaState::Split) {
+            m_closureStack.append(nfa.out1);
+            m_closureStack.append(nfa.out);
+        } else {
+            result->append(current);
+        }
+    }
+}
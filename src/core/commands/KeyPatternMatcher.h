@@ -0,0 +1,171 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYPATTERNMATCHER_H
+#define KEYPATTERNMATCHER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+/*!
+ *  @class KeyPatternMatcher core/commands/KeyPatternMatcher.h
+ *  @brief This class finds all key patterns (prefixes, numeric ranges and regular expressions) matching a key.
+ *  @details Patterns are identified by rule numbers given when they are added. After all patterns are added and
+ *           KeyPatternMatcher::compile is called, KeyPatternMatcher::match walks the key once, advancing at the same
+ *           time:
+ *           - a trie of all prefixes, which reports every prefix met on the way;
+ *           - the decimal value of the key, which is then looked up in an interval tree of all ranges (sorted array
+ *             of intervals augmented with the maximal upper bound of each subtree);
+ *           - one DFA merging all regular expressions, whose states are built lazily from the combined NFA and cached.
+ *             Transitions are stored per class of bytes, which no expression distinguishes, so for digits-only
+ *             expressions a state takes a few dozens of bytes. If the cache grows above
+ *             KeyPatternMatcher::MAX_DFA_MEMORY it is flushed and built again.
+ *
+ *           So cost of matching depends on the length of the key and on the number of matched rules, but not on the
+ *           number of rules. Regular expressions always match the whole key. DFA supports literals, ".", character
+ *           classes ("[0-9A-F]", "[^:]", "\d", "\w", "\s"), groups, alternation and "*", "+", "?", "{m}", "{m,}",
+ *           "{m,n}" quantifiers. Expressions using anything else (e.g. backreferences or lookarounds) are matched
+ *           with QRegularExpression one by one after the pass.
+ *
+ *           DFA cache is filled while matching, so one object must not be used from several threads.
+ */
+
+class KeyPatternMatcher
+{
+public:
+    KeyPatternMatcher();
+    ~KeyPatternMatcher() {}
+
+    static const int MAX_DFA_MEMORY = 8 * 1024 * 1024;
+    static const int MAX_NFA_STATES_PER_PATTERN = 4096;
+
+    void      clear();
+    bool      isEmpty() const;
+
+    /*! @brief Key starting with prefix matches rule. Empty prefix matches every key */
+    void      addPrefix(const QByteArray& prefix, int rule);
+
+    /*! @brief Key consisting only of decimal digits (up to 19) with value within low...high matches rule */
+    void      addRange(quint64 low, quint64 high, int rule);
+
+    /*! @brief Key fully matching regular expression pattern matches rule. Returns false and sets errorString if
+     *         pattern is not a valid regular expression */
+    bool      addRegex(const QString& pattern, int rule, QString* errorString = nullptr);
+
+    /*! @brief Prepares added patterns for matching. Must be called after patterns were added */
+    void      compile();
+
+    /*! @brief Replaces content of rules with numbers of all rules matching length bytes of key, sorted. Memory is
+     *         allocated only while caches are warming up, or if some regular expression is not supported by DFA */
+    void      match(const char* key, int length, QVector<int>* rules) const;
+
+    /*! @brief Parses range of card numbers: "1000-1999", single number "1234", or "facility:123" - all cards of
+     *         facility 123 (numbers (123 << 16) ... (123 << 16) | 0xFFFF). Returns false if text is not a range */
+    static bool parseRange(const QString& text, quint64* low, quint64* high);
+
+private:
+    Q_DISABLE_COPY(KeyPatternMatcher)
+    class RegexParser;
+
+    struct TrieNode {
+        int       firstChild;
+        int       nextSibling;
+        int       rulesBegin;
+        int       rulesEnd;
+        uchar     label;
+    };
+
+    struct Interval {
+        quint64   low;
+        quint64   high;
+        quint64   maxHigh;      //!< @brief Maximal high within subtree having this interval as a root
+        int       rule;
+    };
+
+    struct CharSet {
+        quint64   bits[4];
+        bool      contains(uchar c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+    };
+
+    struct NfaState {
+        enum Kind { Char, Split, Match };
+        Kind      kind;
+        int       value;        //!< @brief Index of CharSet for Char state, rule for Match state
+        int       out;
+        int       out1;         //!< @brief Second branch of Split state
+    };
+
+    struct DfaState {
+        QVector<int>  nfaStates;
+        QVector<int>  rules;
+    };
+
+    int       _trieChild(int node, uchar c) const;
+    void      _appendTrieRules(int node, QVector<int>* rules) const;
+
+    quint64   _buildIntervalTree(int begin, int end);
+    void      _queryIntervals(int begin, int end, quint64 value, QVector<int>* rules) const;
+
+    int       _compileRegexNode(const RegexParser& parser, int node, int next, int firstState);
+    int       _addNfaState(NfaState::Kind kind, int value, int out, int out1);
+
+    void      _buildByteClasses();
+    void      _resetDfa() const;
+    int       _dfaState(const QVector<int>& nfaStates) const;
+    int       _dfaStep(int state, uchar c) const;
+    void      _addClosure(int nfaState, QVector<int>* result) const;
+
+    //Trie
+    QVector<TrieNode>        m_trieNodes;
+    QVector<QPair<int,int>>  m_pendingPrefixes;   //!< @brief (node, rule) pairs, grouped by node in compile()
+    QVector<int>             m_trieRules;
+
+    //Interval tree
+    QVector<Interval>        m_intervals;
+
+    //Combined NFA and lazy DFA
+    QVector<CharSet>         m_charSets;
+    QVector<NfaState>        m_nfaStates;
+    QVector<int>             m_regexStarts;
+    bool                     m_nfaOverflow;
+    uchar                    m_byteClasses[256];
+    uchar                    m_classBytes[256];    //!< @brief One of the bytes of each class
+    int                      m_classCount;
+    mutable QVector<DfaState>         m_dfaStates;
+    mutable QVector<int>              m_dfaNext;    //!< @brief m_classCount transitions of each state, -1 - unknown
+    mutable int                       m_dfaMemory;
+    mutable QHash<QVector<int>,int>   m_dfaIndex;
+    mutable QVector<int>              m_nfaMarks;
+    mutable int                       m_nfaGeneration;
+    mutable QVector<int>              m_closureStack;
+    mutable QVector<int>              m_nextNfaStates;
+    mutable int                       m_dfaFlushes;
+
+    //Expressions, which DFA can not handle
+    QVector<QPair<QRegularExpression,int>> m_fallbackRegexes;
+};
+
+#endif // KEYPATTERNMATCHER_H
@@ -0,0 +1,583 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeySet.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QVector>
+
+#include <algorithm>
+#include <string.h>
+
+#include "core/KeyEvent.h"
+#include "core/cards/CardNormalizer.h"
+
+static const char    MAGIC[8]       = { 'R','F','I','D','K','S','E','T' };
+//2 - EM4100 and H10304 card numbers are not truncated to proxBits, so images of version 1 hold other keys
+//3 - EM4100 card numbers have 13 digits and 8...9 digit keys are not decimal card numbers anymore
+static const quint32 VERSION        = 3;
+static const quint32 ENDIAN_MARK    = 0x01020304;
+
+//Numbers up to 19 decimal digits and up to 16 hex digits, one group for every kind and length
+static const int     DECIMAL_GROUPS = 19;
+static const int     GROUP_COUNT    = DECIMAL_GROUPS + 16;
+
+//Position of every SAMPLE-th zero of upper bits is stored, so select takes few words of scanning
+static const quint64 SAMPLE         = 256;
+
+//Salts of split block Bloom filter, one for every 32-bit word of the block
+static const quint32 FILTER_SALT[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+struct KeySet::Group {
+    quint64   count;
+    quint64   maxValue;
+    quint64   lowBits;
+    quint64   lowOffset;
+    quint64   highOffset;
+    quint64   highWords;
+    quint64   sampleOffset;
+    quint64   sampleCount;
+};
+
+struct KeySet::Record {
+    quint64   keyId;
+    quint32   offset;            //!< @brief Offset of key bytes within blob
+    quint32   length;
+};
+
+struct KeySet::Header {
+    char      magic[8];
+    quint32   version;
+    quint32   byteOrder;
+    quint32   normalizer;
+    quint32   reserved;
+    quint64   imageSize;
+    quint64   keyCount;
+    quint64   filterOffset;
+    quint64   filterBlocks;
+    quint64   recordOffset;
+    quint64   recordCount;
+    quint64   blobOffset;
+    quint64   blobSize;
+    Group     groups[GROUP_COUNT];
+};
+
+static inline quint64 align(quint64 offset)
+{
+    return (offset + 63) & ~Q_UINT64_C(63);
+}
+
+static inline quint64 filterBlock(quint64 hash, quint64 blocks)
+{
+    return ((hash >> 32) * blocks) >> 32;
+}
+
+//Returns counts of set bits of word within bytes 0...i in byte i (SWAR, without popcnt instruction)
+static inline quint64 bytePrefixCounts(quint64 word)
+{
+    word = word - ((word >> 1) & Q_UINT64_C(0x5555555555555555));
+    word = (word & Q_UINT64_C(0x3333333333333333)) + ((word >> 2) & Q_UINT64_C(0x3333333333333333));
+    word = (word + (word >> 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    return word * Q_UINT64_C(0x0101010101010101);
+}
+
+//Returns position of rank-th (rank < number of set bits) set bit of word
+static inline int selectInWord(quint64 word, int rank)
+{
+    //Bytes, which prefix count is not greater than rank, are skipped without branches
+    const quint64 counts = bytePrefixCounts(word);
+    const quint64 skipped = (((quint64(rank) * Q_UINT64_C(0x0101010101010101)) | Q_UINT64_C(0x8080808080808080))
+                             - counts) & Q_UINT64_C(0x8080808080808080);
+    const int byte = int(((skipped >> 7) * Q_UINT64_C(0x0101010101010101)) >> 56);
+    if (byte > 0)
+        rank -= int((counts >> (byte * 8 - 8)) & 0xFF);
+
+    quint32 bits = quint32(word >> (byte * 8)) & 0xFF;
+    for (; rank > 0; rank--)
+        bits &= bits - 1;
+
+    return byte * 8 + qCountTrailingZeroBits(bits);
+}
+
+static inline quint64 readBits(const quint64* words, quint64 position, quint64 bits)
+{
+    if (bits == 0)
+        return 0;
+
+    const quint64 offset = position & 63;
+    quint64 result = words[position >> 6] >> offset;
+    if (offset + bits > 64)
+        result |= words[(position >> 6) + 1] << (64 - offset);
+
+    return result & ((Q_UINT64_C(1) << bits) - 1);
+}
+
+static inline void writeBits(quint64* words, quint64 position, quint64 bits, quint64 value)
+{
+    if (bits == 0)
+        return;
+
+    const quint64 offset = position & 63;
+    words[position >> 6] |= value << offset;
+    if (offset + bits > 64)
+        words[(position >> 6) + 1] |= value >> (64 - offset);
+}
+
+KeySet::KeySet() :
+    p_data(nullptr),
+    m_size(0),
+    m_invalidCount(0)
+{}
+
+KeySet::~KeySet()
+{
+    _reset();
+}
+
+bool KeySet::load(const QString& fileName, QString* errorString)
+{
+    _reset();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString != nullptr)
+            *errorString = tr("Error opening file %1.\r\n%2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    //Copy, not mapping: mapping would raise SIGBUS, if watched file is truncated or rewritten in place
+    const QByteArray data = file.readAll();
+    if (file.error() != QFileDevice::NoError) {
+        if (errorString != nullptr)
+            *errorString = tr("Error reading file %1.\r\n%2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    //Images are used as they are, plain lists are converted
+    if (data.size() >= int(sizeof(MAGIC)) && memcmp(data.constData(),MAGIC,sizeof(MAGIC)) == 0) {
+        m_image = data;
+        if (!_attach(reinterpret_cast<const uchar*>(m_image.constData()),m_image.size(),errorString)) {
+            _reset();
+            return false;
+        }
+        return true;
+    }
+
+    build(data.constData(),data.size());
+    return true;
+}
+
+void KeySet::build(const char* data, qint64 size)
+{
+    _reset();
+    m_image = _build(data,size,&m_invalidCount);
+    _attach(reinterpret_cast<const uchar*>(m_image.constData()),m_image.size(),nullptr);
+}
+
+bool KeySet::save(const QString& fileName, QString* errorString) const
+{
+    QSaveFile file(fileName);
+    if (p_data == nullptr || !file.open(QIODevice::WriteOnly)
+            || file.write(reinterpret_cast<const char*>(p_data),m_size) != m_size || !file.commit()) {
+        if (errorString != nullptr)
+            *errorString = tr("Error writing file %1.\r\n%2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool KeySet::contains(const char* key, int length, KeyId keyId) const
+{
+    if (p_data == nullptr || !_filterContains(keyId))
+        return false;
+
+    int group = 0;
+    quint64 value = 0;
+    if (_encode(key,length,&group,&value))
+        return _groupContains(_header()->groups[group],value);
+
+    return _recordsContain(key,length,keyId);
+}
+
+bool KeySet::contains(const KeyEvent& event) const
+{
+    return contains(event.keyData(),event.keyLength(),event.keyId());
+}
+
+qint64 KeySet::count() const
+{
+    return (p_data != nullptr) ? qint64(_header()->keyCount) : 0;
+}
+
+bool KeySet::_encode(const char* key, int length, int* group, quint64* value)
+{
+    if (length <= 0)
+        return false;
+
+    if (length <= DECIMAL_GROUPS && CardNormalizer::parseDecimal(key,length,value)) {
+        *group = length - 1;
+        return true;
+    }
+
+    //Lowercase hex is a different key, it is not normalized to uppercase unless it is MIFARE UID
+    if (length > GROUP_COUNT - DECIMAL_GROUPS)
+        return false;
+
+    for (int i = 0; i < length; i++) {
+        if (key[i] >= 'a' && key[i] <= 'f')
+            return false;
+    }
+
+    if (!CardNormalizer::parseHex(key,length,value))
+        return false;
+
+    *group = DECIMAL_GROUPS + length - 1;
+    return true;
+}
+
+quint32 KeySet::_normalizerSignature()
+{
+    return (cardNormalizer->isEnabled() ? 1 : 0)
+            | (quint32(cardNormalizer->proxBits()) << 8)
+            | (cardNormalizer->reverseUid() ? (1 << 16) : 0);
+}
+
+bool KeySet::_filterContains(KeyId keyId) const
+{
+    const Header* header = _header();
+    const quint64 hash = keyId.value();
+    const quint32* block = _at<quint32>(header->filterOffset) + filterBlock(hash,header->filterBlocks) * 8;
+
+    quint32 missing = 0;
+    for (int i = 0; i < 8; i++)
+        missing |= ~block[i] & (1U << ((quint32(hash) * FILTER_SALT[i]) >> 27));
+
+    return missing == 0;
+}
+
+bool KeySet::_groupContains(const Group& group, quint64 value) const
+{
+    if (group.count == 0 || value > group.maxValue)
+        return false;
+
+    const quint64 high = value >> group.lowBits;
+    const quint64 low = value & ((Q_UINT64_C(1) << group.lowBits) - 1);
+    const quint64* highWords = _at<quint64>(group.highOffset);
+    const quint64* lowWords = _at<quint64>(group.lowOffset);
+
+    //Values with the same upper bits are consecutive ones after (high - 1)-th zero, their lower bits are sorted
+    quint64 position = (high == 0) ? 0 : _selectZero(group,high - 1) + 1;
+    quint64 index = position - high;
+    const quint64 end = group.highWords * 64;
+
+    for (; index < group.count && position < end; position++, index++) {
+        if (((highWords[position >> 6] >> (position & 63)) & 1) == 0)
+            return false;
+
+        const quint64 elementLow = readBits(lowWords,index * group.lowBits,group.lowBits);
+        if (elementLow >= low)
+            return elementLow == low;
+    }
+
+    return false;
+}
+
+bool KeySet::_recordsContain(const char* key, int length, KeyId keyId) const
+{
+    const Header* header = _header();
+    const Record* begin = _at<Record>(header->recordOffset);
+    const Record* end = begin + header->recordCount;
+    const char* blob = _at<char>(header->blobOffset);
+
+    const Record* record = std::lower_bound(begin,end,keyId.value(),[](const Record& record, quint64 value) {
+        return record.keyId < value;
+    });
+
+    for (; record != end && record->keyId == keyId.value(); record++) {
+        if (record->length == quint32(length) && quint64(record->offset) + record->length <= header->blobSize
+                && memcmp(blob + record->offset,key,length) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+quint64 KeySet::_selectZero(const Group& group, quint64 rank) const
+{
+    const quint64 sample = rank / SAMPLE;
+    if (sample >= group.sampleCount)
+        return group.highWords * 64;
+
+    const quint64 position = _at<quint64>(group.sampleOffset)[sample];
+    const quint64* words = _at<quint64>(group.highOffset);
+
+    quint64 word = position >> 6;
+    if (word >= group.highWords)
+        return group.highWords * 64;
+
+    quint64 zeros = ~words[word] & (~Q_UINT64_C(0) << (position & 63));
+    rank -= sample * SAMPLE;
+
+    while (word < group.highWords) {
+        const quint64 count = bytePrefixCounts(zeros) >> 56;
+        if (rank < count)
+            return word * 64 + quint64(selectInWord(zeros,int(rank)));
+
+        rank -= count;
+        word++;
+        if (word < group.highWords)
+            zeros = ~words[word];
+    }
+
+    return group.highWords * 64;
+}
+
+QByteArray KeySet::_build(const char* data, qint64 size, qint64* invalidCount)
+{
+    QVector<quint64> values[GROUP_COUNT];
+    QVector<QByteArray> otherKeys;
+    *invalidCount = 0;
+
+    char normalized[KeyEvent::MAX_KEY_LENGTH];
+    const char* end = data + size;
+    while (data < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(data,'\n',size_t(end - data)));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+
+        const char* line = data;
+        const char* lineLast = lineEnd;
+        data = lineEnd + 1;
+
+        while (line < lineLast && (*line == ' ' || *line == '\t'))
+            line++;
+        while (lineLast > line && (lineLast[-1] == ' ' || lineLast[-1] == '\t' || lineLast[-1] == '\r'))
+            lineLast--;
+
+        if (line == lineLast || *line == '#')
+            continue;
+
+        //Longer keys are truncated by KeyEvent, so they can not match
+        const int length = (lineLast - line > KeyEvent::MAX_KEY_LENGTH) ? -1
+                                 : cardNormalizer->normalize(line,int(lineLast - line),normalized);
+        if (length <= 0) {
+            (*invalidCount)++;
+            continue;
+        }
+
+        int group = 0;
+        quint64 value = 0;
+        if (_encode(normalized,length,&group,&value))
+            values[group].append(value);
+        else
+            otherKeys.append(QByteArray(normalized,length));
+    }
+
+    quint64 keyCount = 0;
+    for (QVector<quint64>& groupValues : values) {
+        std::sort(groupValues.begin(),groupValues.end());
+        groupValues.erase(std::unique(groupValues.begin(),groupValues.end()),groupValues.end());
+        keyCount += quint64(groupValues.size());
+    }
+
+    std::sort(otherKeys.begin(),otherKeys.end());
+    otherKeys.erase(std::unique(otherKeys.begin(),otherKeys.end()),otherKeys.end());
+    keyCount += quint64(otherKeys.size());
+
+    //Layout of the image: header, filter, Elias-Fano sequences of groups, records, key bytes of records
+    Header header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,MAGIC,sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = ENDIAN_MARK;
+    header.normalizer = _normalizerSignature();
+    header.keyCount = keyCount;
+
+    quint64 offset = align(sizeof(Header));
+    header.filterOffset = offset;
+    header.filterBlocks = qMax(Q_UINT64_C(1),(keyCount * FILTER_BITS_PER_KEY + 255) / 256);
+    offset = align(offset + header.filterBlocks * 32);
+
+    for (int i = 0; i < GROUP_COUNT; i++) {
+        const QVector<quint64>& groupValues = values[i];
+        Group& group = header.groups[i];
+        group.count = quint64(groupValues.size());
+        if (group.count == 0)
+            continue;
+
+        group.maxValue = groupValues.last();
+        const quint64 ratio = group.maxValue / group.count;
+        group.lowBits = (ratio == 0) ? 0 : quint64(63 - qCountLeadingZeroBits(ratio));
+
+        //One more word, so bits can be read by two words without checking the end
+        group.lowOffset = offset;
+        offset = align(offset + ((group.count * group.lowBits + 63) / 64 + 1) * 8);
+
+        const quint64 zeros = (group.maxValue >> group.lowBits) + 1;
+        group.highOffset = offset;
+        group.highWords = (group.count + zeros + 63) / 64 + 1;
+        offset = align(offset + group.highWords * 8);
+
+        group.sampleOffset = offset;
+        group.sampleCount = (zeros + SAMPLE - 1) / SAMPLE;
+        offset = align(offset + group.sampleCount * 8);
+    }
+
+    header.recordOffset = offset;
+    header.recordCount = quint64(otherKeys.size());
+    offset = align(offset + header.recordCount * sizeof(Record));
+
+    header.blobOffset = offset;
+    for (const QByteArray& key : qAsConst(otherKeys))
+        header.blobSize += quint64(key.size());
+    offset = align(offset + header.blobSize);
+
+    header.imageSize = offset;
+
+    QByteArray image(int(offset),'\0');
+    uchar* imageData = reinterpret_cast<uchar*>(image.data());
+    memcpy(imageData,&header,sizeof(header));
+
+    quint32* filter = reinterpret_cast<quint32*>(imageData + header.filterOffset);
+    auto addToFilter = [filter,&header](KeyId keyId) {
+        const quint64 hash = keyId.value();
+        quint32* block = filter + filterBlock(hash,header.filterBlocks) * 8;
+        for (int i = 0; i < 8; i++)
+            block[i] |= 1U << ((quint32(hash) * FILTER_SALT[i]) >> 27);
+    };
+
+    for (int i = 0; i < GROUP_COUNT; i++) {
+        const QVector<quint64>& groupValues = values[i];
+        const Group& group = header.groups[i];
+        if (group.count == 0)
+            continue;
+
+        quint64* lowWords = reinterpret_cast<quint64*>(imageData + group.lowOffset);
+        quint64* highWords = reinterpret_cast<quint64*>(imageData + group.highOffset);
+        quint64* samples = reinterpret_cast<quint64*>(imageData + group.sampleOffset);
+        const quint64 lowMask = (Q_UINT64_C(1) << group.lowBits) - 1;
+
+        //Filter is indexed by KeyId of the key, so the key is printed back from its value
+        const bool decimal = (i < DECIMAL_GROUPS);
+        const int length = decimal ? (i + 1) : (i - DECIMAL_GROUPS + 1);
+        char key[DECIMAL_GROUPS];
+
+        for (int index = 0; index < groupValues.size(); index++) {
+            const quint64 value = groupValues.at(index);
+            writeBits(lowWords,quint64(index) * group.lowBits,group.lowBits,value & lowMask);
+
+            const quint64 position = (value >> group.lowBits) + quint64(index);
+            highWords[position >> 6] |= Q_UINT64_C(1) << (position & 63);
+
+            quint64 rest = value;
+            for (int digit = length - 1; digit >= 0; digit--) {
+                key[digit] = decimal ? char('0' + rest % 10) : "0123456789ABCDEF"[rest & 0xF];
+                rest = decimal ? rest / 10 : rest >> 4;
+            }
+            addToFilter(KeyId::fromBytes(key,length));
+        }
+
+        const quint64 bits = group.count + (group.maxValue >> group.lowBits) + 1;
+        quint64 zero = 0;
+        for (quint64 position = 0; position < bits; position++) {
+            if ((highWords[position >> 6] >> (position & 63)) & 1)
+                continue;
+            if (zero % SAMPLE == 0)
+                samples[zero / SAMPLE] = position;
+            zero++;
+        }
+    }
+
+    Record* records = reinterpret_cast<Record*>(imageData + header.recordOffset);
+    char* blob = reinterpret_cast<char*>(imageData + header.blobOffset);
+    quint32 blobOffset = 0;
+    for (const QByteArray& key : qAsConst(otherKeys)) {
+        const KeyId keyId = KeyId::fromBytes(key.constData(),key.size());
+        *records++ = Record{ keyId.value(), blobOffset, quint32(key.size()) };
+        memcpy(blob + blobOffset,key.constData(),size_t(key.size()));
+        blobOffset += quint32(key.size());
+        addToFilter(keyId);
+    }
+
+    records = reinterpret_cast<Record*>(imageData + header.recordOffset);
+    std::sort(records,records + header.recordCount,[](const Record& left, const Record& right) {
+        return left.keyId < right.keyId;
+    });
+
+    return image;
+}
+
+bool KeySet::_attach(const uchar* data, qint64 size, QString* errorString)
+{
+    const Header* header = reinterpret_cast<const Header*>(data);
+
+    QString error;
+    if (size < qint64(sizeof(Header)) || memcmp(header->magic,MAGIC,sizeof(MAGIC)) != 0
+            || header->version != VERSION || header->byteOrder != ENDIAN_MARK || header->imageSize != quint64(size)) {
+        error = tr("Unsupported format of key set image.");
+    } else if (header->normalizer != _normalizerSignature()) {
+        error = tr("Key set image was built with different card format settings.");
+    } else {
+        //Only bounds of sections are checked, so loading does not walk the whole image
+        auto outside = [size](quint64 offset, quint64 count, quint64 itemSize) {
+            return offset > quint64(size) || count > (quint64(size) - offset) / itemSize;
+        };
+
+        bool valid = header->filterBlocks > 0 && header->keyCount <= quint64(size) * 8
+                && !outside(header->filterOffset,header->filterBlocks,32)
+                && !outside(header->recordOffset,header->recordCount,sizeof(Record))
+                && !outside(header->blobOffset,header->blobSize,1);
+        for (const Group& group : header->groups) {
+            if (group.count == 0)
+                continue;
+            valid = valid && group.count <= header->keyCount && group.lowBits < 64
+                    && !outside(group.lowOffset,(group.count * group.lowBits + 63) / 64 + 1,8)
+                    && !outside(group.highOffset,group.highWords,8)
+                    && !outside(group.sampleOffset,group.sampleCount,8);
+        }
+
+        if (!valid)
+            error = tr("Key set image is damaged.");
+    }
+
+    if (!error.isEmpty()) {
+        if (errorString != nullptr)
+            *errorString = error;
+        return false;
+    }
+
+    p_data = data;
+    m_size = size;
+    return true;
+}
+
+void KeySet::_reset()
+{
+    m_image.clear();
+    p_data = nullptr;
+    m_size = 0;
+    m_invalidCount = 0;
+}
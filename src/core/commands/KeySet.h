@@ -0,0 +1,127 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYSET_H
+#define KEYSET_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+
+#include "core/KeyId.h"
+
+class KeyEvent;
+
+/*!
+ *  @class KeySet core/commands/KeySet.h
+ *  @brief Compact read-only set of keys (allow/deny lists of millions of badges), see MembershipCommand.
+ *  @details Keys are normalized (see CardNormalizer) and stored within one flat image, which can be written to a
+ *           file and read back as it is, so large sets are loaded without parsing. Plain lists (one key per line) are
+ *           converted to the same image in memory.
+ *
+ *           Image files are copied into memory and not mapped: files are watched and reloaded, and mapping of a file,
+ *           which is rewritten or truncated in place, raises SIGBUS on the next lookup. Files can be updated in any
+ *           way, though replacing them by rename (as KeySet::save does) avoids reloading half-written files.
+ *
+ *           Keys, which are numbers (up to 19 decimal digits, up to 16 uppercase hex digits), are grouped by kind
+ *           and length, and values of every group are stored as Elias-Fano sequence: lower bits of sorted values
+ *           are packed as they are, upper bits - as unary coded gaps. 10M 10-digit card numbers take ~11 bits per
+ *           key instead of 64 bits of sorted array (~24 MB together with the filter). Other keys are stored as
+ *           array of records sorted by KeyId with key bytes.
+ *
+ *           Split block Bloom filter is checked first: KeyId of the read key selects 32-byte block and one bit
+ *           in each of its 8 words is tested, so most keys, which are not in the set, are rejected with one cache
+ *           miss and without touching the set itself.
+ *
+ *           Image depends on settings of CardNormalizer and on byte order, so images built with other settings
+ *           are rejected by KeySet::load. KeySet is not a QObject, so large sets can be loaded on worker threads.
+ */
+
+class KeySet
+{
+    Q_DECLARE_TR_FUNCTIONS(KeySet)
+public:
+    KeySet();
+    ~KeySet();
+
+    /*! @brief Bits of Bloom filter per key. ~3% of keys not within set pass the filter */
+    static const int FILTER_BITS_PER_KEY = 8;
+
+    /*! @brief Loads set from fileName. Image written by KeySet::save is used as it is, other files are read as plain
+     *         lists. Returns false and sets errorString if file can not be read */
+    bool      load(const QString& fileName, QString* errorString = nullptr);
+
+    /*! @brief Builds set from plain list of size bytes: one key per line, empty lines and lines starting with '#'
+     *         are skipped. Keys, which are invalid for CardNormalizer, are skipped as well */
+    void      build(const char* data, qint64 size);
+
+    /*! @brief Writes image of this set to fileName. File is replaced atomically, so processes watching it never
+     *         read half-written image */
+    bool      save(const QString& fileName, QString* errorString = nullptr) const;
+
+    /*! @brief Returns true if normalized key of length bytes with keyId is within this set. Does not allocate */
+    bool      contains(const char* key, int length, KeyId keyId) const;
+    bool      contains(const KeyEvent& event) const;
+
+    qint64    count() const;
+
+    /*! @brief Number of lines of the plain list, which were skipped as invalid keys */
+    qint64    invalidCount() const                       { return m_invalidCount; }
+
+    /*! @brief Size of the image in bytes */
+    qint64    size() const                               { return m_size; }
+
+private:
+    Q_DISABLE_COPY(KeySet)
+
+    struct Header;
+    struct Group;
+    struct Record;
+
+    /*! @brief Converts key to group (kind and length) and value. Returns false if key is not a number */
+    static bool   _encode(const char* key, int length, int* group, quint64* value);
+
+    /*! @brief Returns image built from plain list */
+    static QByteArray _build(const char* data, qint64 size, qint64* invalidCount);
+
+    /*! @brief Signature of CardNormalizer settings, which affect keys stored in image */
+    static quint32 _normalizerSignature();
+
+    bool      _filterContains(KeyId keyId) const;
+    bool      _groupContains(const Group& group, quint64 value) const;
+    bool      _recordsContain(const char* key, int length, KeyId keyId) const;
+    quint64   _selectZero(const Group& group, quint64 rank) const;
+
+    bool      _attach(const uchar* data, qint64 size, QString* errorString);
+    void      _reset();
+
+    const Header*  _header() const                       { return reinterpret_cast<const Header*>(p_data); }
+    template<class T>
+    const T*       _at(quint64 offset) const             { return reinterpret_cast<const T*>(p_data + offset); }
+
+    QByteArray    m_image;           //!< @brief Image read from file or built from plain list
+    const uchar*  p_data;
+    qint64        m_size;
+    qint64        m_invalidCount;
+};
+
+#endif // KEYSET_H
@@ -0,0 +1,69 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MembershipCommand.h"
+
+MembershipCommand::MembershipCommand(QObject* parent) :
+    ShellCommand(parent),
+    m_inverted(false)
+{}
+
+MembershipCommand::MembershipCommand(const QJsonObject& jsonObject, QObject* parent) :
+    ShellCommand(jsonObject,parent),
+    m_keySetFile(jsonObject.value("keySetFile").toString()),
+    m_inverted(jsonObject.value("inverted").toBool())
+{}
+
+void MembershipCommand::setKeySetFile(const QString& fileName)
+{
+    m_keySetFile = fileName;
+    m_keySet.reset();
+    emit commandChanged();
+}
+
+void MembershipCommand::setInverted(bool state)
+{
+    m_inverted = state;
+    emit commandChanged();
+}
+
+bool MembershipCommand::accepts(const KeyEvent& event) const
+{
+    //Deny list, which is not loaded, must not let every key through
+    if (m_keySet.isNull())
+        return false;
+
+    return m_keySet->contains(event) != m_inverted;
+}
+
+QJsonObject MembershipCommand::toJson() const
+{
+    QJsonObject result = ShellCommand::toJson();
+    result.insert("type","membership");
+    result.remove("key");
+    result.remove("match");
+    result.insert("keySetFile",m_keySetFile);
+    if (m_inverted)
+        result.insert("inverted",true);
+
+    return result;
+}
@@ -0,0 +1,77 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MEMBERSHIPCOMMAND_H
+#define MEMBERSHIPCOMMAND_H
+
+#include <QSharedPointer>
+
+#include "ShellCommand.h"
+#include "KeySet.h"
+
+/*!
+ *  @class MembershipCommand core/commands/MembershipCommand.h
+ *  @brief This class runs program for every key, which is within (or, if inverted, is not within) large set of keys.
+ *  @details One MembershipCommand replaces thousands of ShellCommand objects, which differ only by key, e.g. for
+ *           allow and deny lists of badges. Keys are stored in KeySet, loaded from keySetFile by CommandsListManager.
+ *           Commands using the same file share one KeySet. Until set is loaded (or if loading failed) command
+ *           accepts no keys, also when inverted.
+ */
+
+class MembershipCommand : public ShellCommand
+{
+    Q_OBJECT
+public:
+    explicit MembershipCommand(QObject* parent = nullptr);
+    explicit MembershipCommand(const QJsonObject& jsonObject, QObject* parent = nullptr);
+    ~MembershipCommand() {}
+
+    /*! @brief Type of this object. Represented by Membership value from Command::Type enum */
+    Type           type() const override { return Membership; };
+
+    /*! @brief Plain list of keys or image written by KeySet::save. Set is loaded by CommandsListManager */
+    void           setKeySetFile(const QString& fileName);
+    QString        keySetFile() const                           { return m_keySetFile; }
+
+    /*! @brief If true - program is run for keys, which are not within the set (e.g. for deny lists) */
+    void           setInverted(bool state);
+    bool           isInverted() const                           { return m_inverted; }
+
+    /*! @brief Replaces set of keys. Sets are replaced from the thread, which dispatches keys, so every key is
+     *         checked either against old or against new set. Old set is released with the last command using it */
+    void           setKeySet(const QSharedPointer<const KeySet>& keySet) { m_keySet = keySet; }
+    QSharedPointer<const KeySet> keySet() const                 { return m_keySet; }
+
+    /*! @brief Returns true if program should be run for key of event. Does not allocate memory */
+    bool           accepts(const KeyEvent& event) const;
+
+    /*! @brief Serialize this MembershipCommand object to JSON. */
+    QJsonObject    toJson() const override;
+
+private:
+    Q_DISABLE_COPY(MembershipCommand);
+    QString        m_keySetFile;
+    bool           m_inverted;
+    QSharedPointer<const KeySet> m_keySet;
+};
+
+#endif // MEMBERSHIPCOMMAND_H
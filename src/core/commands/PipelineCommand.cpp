@@ -0,0 +1,175 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PipelineCommand.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QPointer>
+
+PipelineCommand::PipelineCommand(QObject* parent) :
+    Command(parent),
+    m_invalidSteps(0)
+{}
+
+PipelineCommand::PipelineCommand(const QJsonObject& jsonObject, QObject* parent) :
+    Command(jsonObject,parent),
+    m_invalidSteps(0)
+{
+    for (const QJsonValue& stepValue : jsonObject.value("steps").toArray()) {
+        const QJsonObject stepObject = stepValue.toObject();
+
+        const Condition condition = conditionFromName(stepObject.value("when").toString());
+        const int timeout = qMax(0,stepObject.value("timeout").toInt(0));
+
+        //Steps are enabled, unless they are disabled explicitly
+        QJsonObject commandObject = stepObject.value("command").toObject();
+        if (!commandObject.contains("enabled"))
+            commandObject.insert("enabled",true);
+
+        //Keys of steps are not used, so default spools of all batch steps would be the same file
+        Command* command = nullptr;
+        if (commandObject.value("type").toString() == QLatin1String("batch") && !commandObject.contains("spool")) {
+            qWarning() << "Batch step"<<m_steps.size()<<"of pipeline for key"<<key()<<"has no spool file.";
+        } else {
+            command = Command::fromJson(commandObject);
+            if (command == nullptr)
+                qWarning() << "Step"<<m_steps.size()<<"of pipeline for key"<<key()<<"has unknown type.";
+        }
+
+        //Invalid step keeps its place, so that conditions of next steps refer to the same steps on next save
+        if (command == nullptr) {
+            m_steps.append({ nullptr, condition, timeout, stepObject.value("command").toObject() });
+            m_invalidSteps++;
+            continue;
+        }
+
+        appendStep(command,condition,timeout);
+    }
+}
+
+void PipelineCommand::appendStep(Command* command, Condition condition, int timeoutMs)
+{
+    command->setParent(this);
+    connect(command,&Command::commandChanged,this,&Command::commandChanged);
+
+    m_steps.append({ command, condition, qMax(0,timeoutMs), QJsonObject() });
+    emit commandChanged();
+}
+
+bool PipelineCommand::execute(const KeyEvent& event, quint64 execution)
+{
+    if (!isValid()) {
+        qWarning() << "Pipeline for key"<<event.key()<<"has"<<m_invalidSteps<<"invalid steps, not executing.";
+        finishExecution(execution,false);
+        return false;
+    }
+
+    //Coroutine finishes the execution itself, also if all steps have finished before it returns
+    _run(event,execution);
+    return false;
+}
+
+CommandTask PipelineCommand::_run(KeyEvent event, quint64 execution)
+{
+    QPointer<PipelineCommand> self(this);
+    bool success = true;
+
+    for (int i = 0; i < m_steps.size(); i++) {
+        const Step step = m_steps.at(i);
+        if (((step.condition == OnSuccess) && !success) || ((step.condition == OnFailure) && success))
+            continue;
+
+        //Awaiter is named - GCC destroys temporary awaiter too early, when it does not suspend
+        CommandExecution stepExecution = step.command->runAsync(event,quint64(step.timeout) * 1000 * 1000);
+        const CommandExecution::Result result = co_await stepExecution;
+
+        //Pipeline (and its steps) could be deleted meanwhile, e.g. when file of commands was reloaded
+        if (self.isNull()) {
+            finishExecution(execution,false);
+            co_return;
+        }
+
+        qDebug() << "Step"<<i<<"of pipeline for key"<<event.key()<<CommandExecution::resultName(result);
+        if (result != CommandExecution::Skipped)
+            success = (result == CommandExecution::Succeeded);
+    }
+
+    finishExecution(execution,success);
+}
+
+QString PipelineCommand::conditionName(Condition condition)
+{
+    switch (condition) {
+    case OnSuccess:
+        return QStringLiteral("success");
+    case OnFailure:
+        return QStringLiteral("failure");
+    case Always:
+        return QStringLiteral("always");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+PipelineCommand::Condition PipelineCommand::conditionFromName(const QString& name)
+{
+    if (name == QLatin1String("failure"))
+        return OnFailure;
+    if (name == QLatin1String("always"))
+        return Always;
+
+    return OnSuccess;
+}
+
+QJsonObject PipelineCommand::toJson() const
+{
+    QJsonArray stepsArray;
+    for (const Step& step : m_steps) {
+        QJsonObject commandObject = step.invalidCommand;
+        if (step.command != nullptr) {
+            commandObject = step.command->toJson();
+            commandObject.remove("key");
+        }
+
+        QJsonObject stepObject({
+            { "command",     commandObject }
+        });
+        if (step.condition != OnSuccess)
+            stepObject.insert("when",conditionName(step.condition));
+        if (step.timeout > 0)
+            stepObject.insert("timeout",step.timeout);
+
+        stepsArray.append(stepObject);
+    }
+
+    QJsonObject result({
+        { "type",        "pipeline" },
+        { "enabled",     isEnabled() },
+        { "key",         key() },
+        { "steps",       stepsArray }
+    });
+    writeExecutionPolicy(&result);
+    writeKeyMatching(&result);
+
+    return result;
+}
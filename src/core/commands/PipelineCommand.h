@@ -0,0 +1,100 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PIPELINECOMMAND_H
+#define PIPELINECOMMAND_H
+
+#include <QVector>
+
+#include "Command.h"
+
+/*!
+ *  @class PipelineCommand core/commands/PipelineCommand.h
+ *  @brief This class executes chain of other commands (steps), one after another.
+ *  @details Each step is a command of any type (also another pipeline) with condition and optional timeout:
+ *           - OnSuccess (default) - step is executed, if the last executed step has succeeded (or if it is the first
+ *             one), so e.g. next program is started only when previous one has exited with code 0;
+ *           - OnFailure - step is executed, if the last executed step has failed or timed out (e.g. to report error);
+ *           - Always - step is executed anyway.
+ *           Disabled steps are skipped. Pipeline succeeds, if the last executed step has succeeded.
+ *
+ *           Every run of the pipeline is a coroutine (see CommandTask), which awaits executions of steps, so the event
+ *           loop is never blocked and thousands of running pipelines cost one coroutine frame each. Steps are
+ *           submitted to the CommandScheduler, so their ExecutionPolicy is applied as well. Step commands are owned
+ *           by the pipeline, their keys are not used. Batch steps (see BatchCommand) must set "spool", as default spool
+ *           is named after the key. Invalid steps (unknown type or batch without spool) are kept as they were read
+ *           from JSON, so they are saved back unchanged and conditions of the next steps are not shifted; pipeline
+ *           with such steps is not executed at all.
+ */
+
+class PipelineCommand : public Command
+{
+    Q_OBJECT
+public:
+    explicit PipelineCommand(QObject* parent = nullptr);
+    explicit PipelineCommand(const QJsonObject& jsonObject, QObject* parent = nullptr);
+    ~PipelineCommand() {}
+
+    /*! @brief This enum describes, when step of the pipeline is executed */
+    enum Condition {
+        OnSuccess,
+        OnFailure,
+        Always
+    };
+
+    struct Step {
+        Command*    command;
+        Condition   condition;
+        int         timeout;        //!< @brief Milliseconds, 0 - no timeout
+        QJsonObject invalidCommand; //!< @brief JSON of invalid step, saved as it was read. command is nullptr then
+    };
+
+    /*! @brief Type of this object. Represented by Pipeline value from Command::Type enum */
+    Type           type() const override { return Pipeline; };
+
+    /*! @brief Appends step to the end of the pipeline. Pipeline takes ownership of the command */
+    void           appendStep(Command* command, Condition condition = OnSuccess, int timeoutMs = 0);
+    QVector<Step>  steps() const                                { return m_steps; }
+
+    /*! @brief Returns true if pipeline has no invalid steps, so it can be executed */
+    bool           isValid() const                              { return m_invalidSteps == 0; }
+
+    static QString   conditionName(Condition condition);
+    static Condition conditionFromName(const QString& name);
+
+    /*! @brief Serialize this PipelineCommand object to JSON. */
+    QJsonObject    toJson() const override;
+
+protected:
+    /*! @brief Starts coroutine, which executes steps. Execution is finished, when the coroutine returns */
+    bool           execute(const KeyEvent& event, quint64 execution) override;
+
+private:
+    Q_DISABLE_COPY(PipelineCommand);
+
+    CommandTask    _run(KeyEvent event, quint64 execution);
+
+    QVector<Step>  m_steps;
+    int            m_invalidSteps;
+};
+
+#endif // PIPELINECOMMAND_H
@@ -23,18 +23,37 @@
 #include "ShellCommand.h"
 
 #include <QJsonArray>
-#include <QProcess>
+
+#include "ChildSupervisor.h"
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+static const int DEFAULT_KILL_TIMEOUT = int(ChildSupervisor::DEFAULT_KILL_TIMEOUT_NS / (1000 * 1000));
 
 ShellCommand::ShellCommand(QObject* parent) :
-    Command(parent)
+    Command(parent),
+    m_timeout(0),
+    m_killTimeout(DEFAULT_KILL_TIMEOUT),
+    m_captureOutput(0)
 {}
 
 ShellCommand::ShellCommand(const QJsonObject& jsonObject, QObject* parent) :
     Command(jsonObject,parent),
-    m_program(jsonObject.value("program").toString())
+    m_program(jsonObject.value("program").toString()),
+    m_timeout(qMax(0,jsonObject.value("timeout").toInt(0))),
+    m_killTimeout(qMax(0,jsonObject.value("killTimeout").toInt(DEFAULT_KILL_TIMEOUT))),
+    m_captureOutput(qMax(0,jsonObject.value("captureOutput").toInt(0)))
 {
     for (QJsonValue jsonValue : jsonObject.value("arguments").toArray())
         m_arguments.append(jsonValue.toString());
+
+    const QJsonObject environmentObject = jsonObject.value("environment").toObject();
+    for (auto it = environmentObject.constBegin(); it != environmentObject.constEnd(); ++it)
+        m_environment.insert(it.key(),it.value().toString());
+
+    _compileTemplates();
 }
 
 void ShellCommand::setProgram(const QString& program)
@@ -46,27 +65,118 @@ void ShellCommand::setProgram(const QString& program)
 void ShellCommand::setArguments(const QStringList& argumentsList)
 {
     m_arguments = argumentsList;
+    _compileTemplates();
+    emit commandChanged();
+}
+
+void ShellCommand::setEnvironment(const QMap<QString,QString>& environment)
+{
+    m_environment = environment;
+    _compileTemplates();
+    emit commandChanged();
+}
+
+void ShellCommand::setTimeout(int timeoutMs)
+{
+    m_timeout = qMax(0,timeoutMs);
+    emit commandChanged();
+}
+
+void ShellCommand::setKillTimeout(int timeoutMs)
+{
+    m_killTimeout = qMax(0,timeoutMs);
+    emit commandChanged();
+}
+
+void ShellCommand::setCaptureOutput(int bytes)
+{
+    m_captureOutput = qMax(0,bytes);
     emit commandChanged();
 }
 
 void ShellCommand::setArgumentsString(const QString& argumentsString)
 {
-    m_arguments = argumentsString.split(' ');
+    m_arguments = CommandTemplate::splitArguments(argumentsString);
+    _compileTemplates();
+    emit commandChanged();
 }
 
 QJsonObject ShellCommand::toJson() const
 {
-    return QJsonObject({
+    QJsonObject result({
         { "type",        "shell" },
         { "enabled",     isEnabled() },
         { "key",         key() },
         { "program",     program() },
         { "arguments",   QJsonArray::fromStringList(arguments())}
     });
+    writeExecutionPolicy(&result);
+
+    if (!m_environment.isEmpty()) {
+        QJsonObject environmentObject;
+        for (auto it = m_environment.constBegin(); it != m_environment.constEnd(); ++it)
+            environmentObject.insert(it.key(),it.value());
+        result.insert("environment",environmentObject);
+    }
+
+    //Only limits, which were set, are written
+    if (m_timeout > 0)
+        result.insert("timeout",m_timeout);
+    if (m_killTimeout != DEFAULT_KILL_TIMEOUT)
+        result.insert("killTimeout",m_killTimeout);
+    if (m_captureOutput > 0)
+        result.insert("captureOutput",m_captureOutput);
+
+    writeKeyMatching(&result);
+
+    return result;
+}
+
+bool ShellCommand::execute(const KeyEvent& event, quint64 execution)
+{
+    ChildSupervisor::Options options;
+    options.timeout = quint64(m_timeout) * 1000 * 1000;
+    options.killTimeout = quint64(m_killTimeout) * 1000 * 1000;
+    options.outputLimit = m_captureOutput;
+
+    for (int i = 0; i < m_argumentTemplates.size(); i++)
+        m_argumentTemplates.at(i).render(event,&m_renderedArguments[i]);
+    for (int i = 0; i < m_environmentTemplates.size(); i++)
+        m_environmentTemplates.at(i).render(event,&m_renderedEnvironment[i]);
+    options.environment = &m_renderedEnvironment;
+
+    //Callback does not refer to this command, so command can be deleted while its processes are running
+    const auto finished = [execution](const ChildExit& exit) {
+        finishExecution(execution,exit.isSuccess());
+    };
+
+#ifdef TRACING
+    const quint64 spawnStart = KeyEvent::now();
+    const quint64 child = childSupervisor->spawn(m_program,m_renderedArguments,options,finished);
+    tracer->addSpan(event,"spawn",spawnStart,KeyEvent::now());
+#else
+    const quint64 child = childSupervisor->spawn(m_program,m_renderedArguments,options,finished);
+#endif //TRACING
+
+    //Process, which was not started, has failed already
+    if (child == 0)
+        finishExecution(execution,false);
+
+    return false;
 }
 
-void ShellCommand::execute()
+void ShellCommand::_compileTemplates()
 {
-//    qDebug() << "Executing command for key "<<this->key();
-    QProcess::startDetached(m_program,m_arguments);
+    m_argumentTemplates.clear();
+    m_argumentTemplates.reserve(m_arguments.size());
+    for (const QString& argument : qAsConst(m_arguments))
+        m_argumentTemplates.append(CommandTemplate(argument));
+
+    //Only value is a template, name is written as it is
+    m_environmentTemplates.clear();
+    for (auto it = m_environment.constBegin(); it != m_environment.constEnd(); ++it)
+        m_environmentTemplates.append(CommandTemplate(it.value(),it.key() + QLatin1Char('=')));
+
+    m_renderedArguments.resize(m_argumentTemplates.size());
+    m_renderedEnvironment.resize(m_environmentTemplates.size());
 }
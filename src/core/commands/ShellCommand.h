@@ -23,11 +23,23 @@
 #ifndef SHELLCOMMAND_H
 #define SHELLCOMMAND_H
 
+#include <QMap>
+
 #include "Command.h"
+#include "CommandTemplate.h"
 
 /*!
  *  @class ShellCommand core/commands/ShellCommand.h
  *  @brief This class implements launching processes, scripts and other simple stuff on computer.
+ *  @details Processes are started and tracked by the ChildSupervisor. Execution lasts till the process exits (and
+ *           succeeds, if it exits with code 0), so ExecutionPolicy::maxInFlight limits number of running processes.
+ *           Optional "timeout", "killTimeout" (milliseconds) and "captureOutput" (bytes) fields of the command are
+ *           passed to the ChildSupervisor.
+ *
+ *           Arguments and values of "environment" object of the command are templates (see CommandTemplate), e.g.
+ *           one command with "match": "prefix" and arguments ["--badge", "{key}", "--door", "{device}"] replaces
+ *           commands for every single key. Templates are compiled when arguments are set, rendered arguments are
+ *           kept between executions, so their buffers are reused.
  */
 
 class ShellCommand : public Command
@@ -47,19 +59,47 @@ public:
     void           setArguments(const QStringList& arguments);
     QStringList    arguments() const                            { return m_arguments; }
 
+    /*! @brief Sets arguments from command line, see CommandTemplate::splitArguments */
     void           setArgumentsString(const QString& argumentsString);
-    QString        argumentsString() const                      { return m_arguments.join(' '); }
+    QString        argumentsString() const                      { return CommandTemplate::joinArguments(m_arguments); }
+
+    /*! @brief Variables (name - value template), which are added to the environment of the process */
+    void           setEnvironment(const QMap<QString,QString>& environment);
+    QMap<QString,QString> environment() const                  { return m_environment; }
+
+    /*! @brief Process is terminated, if it runs longer than timeout milliseconds. 0 - no timeout */
+    void           setTimeout(int timeoutMs);
+    int            timeout() const                              { return m_timeout; }
+
+    /*! @brief Milliseconds between SIGTERM and SIGKILL sent to the process, which has timed out */
+    void           setKillTimeout(int timeoutMs);
+    int            killTimeout() const                          { return m_killTimeout; }
+
+    /*! @brief Bytes of stdout and stderr of the process passed to the log. 0 - output is not captured */
+    void           setCaptureOutput(int bytes);
+    int            captureOutput() const                        { return m_captureOutput; }
 
     /*! @brief Serialize this ShellCommand object to JSON. */
     QJsonObject    toJson() const override;
 
 protected:
-    void           execute() override;
+    bool           execute(const KeyEvent& event, quint64 execution) override;
 
 private:
     Q_DISABLE_COPY(ShellCommand);
+    void           _compileTemplates();
+
     QString        m_program;
     QStringList    m_arguments;
+    QMap<QString,QString> m_environment;
+    int            m_timeout;
+    int            m_killTimeout;
+    int            m_captureOutput;
+
+    QVector<CommandTemplate> m_argumentTemplates;
+    QVector<CommandTemplate> m_environmentTemplates;   //!< @brief Templates of whole "NAME=value" entries
+    QVector<QByteArray>      m_renderedArguments;
+    QVector<QByteArray>      m_renderedEnvironment;
 };
 
 #endif // SHELLCOMMAND_H
@@ -0,0 +1,381 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SocketCommand.h"
+
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QUrl>
+#include <QtEndian>
+
+#include "core/devices/ReconnectSupervisor.h"
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+
+/*! @brief Metrics shared by all SocketCommand objects */
+struct SocketMetrics {
+    Counter*    sent        = metricsRegistry->counter("rfid_socket_records_total","Records of socket commands.",
+                                                       MetricsRegistry::label("status","sent"));
+    Counter*    dropped     = metricsRegistry->counter("rfid_socket_records_total","Records of socket commands.",
+                                                       MetricsRegistry::label("status","dropped"));
+    Counter*    connects    = metricsRegistry->counter("rfid_socket_connects_total","Connections opened by socket commands.");
+    Gauge*      queued      = metricsRegistry->gauge("rfid_socket_records_queued","Records waiting for connection or for the socket.");
+};
+
+static SocketMetrics* socketMetrics()
+{
+    static SocketMetrics theOne;
+    return &theOne;
+}
+#endif //METRICS
+
+static const char DEFAULT_RECORD_TEMPLATE[] = "{ts}\t{device}\t{key}";
+
+SocketCommand::SocketCommand(QObject* parent) :
+    Command(parent),
+    m_transport(InvalidTransport),
+    m_port(0),
+    m_framing(LineFraming),
+    m_recordTemplate(QLatin1String(DEFAULT_RECORD_TEMPLATE)),
+    p_socket(nullptr),
+    m_connected(false),
+    m_attempt(0),
+    m_queue(DEFAULT_QUEUE_LIMIT)
+{}
+
+SocketCommand::SocketCommand(const QJsonObject& jsonObject, QObject* parent) :
+    Command(jsonObject,parent),
+    m_endpoint(jsonObject.value("endpoint").toString()),
+    m_transport(InvalidTransport),
+    m_port(0),
+    m_framing(framingFromName(jsonObject.value("framing").toString())),
+    m_recordTemplate(jsonObject.value("record").toString(QLatin1String(DEFAULT_RECORD_TEMPLATE))),
+    p_socket(nullptr),
+    m_connected(false),
+    m_attempt(0),
+    m_queue(qMax(1,jsonObject.value("queueLimit").toInt(DEFAULT_QUEUE_LIMIT)))
+{
+    //Connection is ready by the first tap
+    m_transport = parseEndpoint(m_endpoint,&m_host,&m_port);
+    _open();
+}
+
+SocketCommand::~SocketCommand()
+{
+    _close();
+#ifdef METRICS
+    socketMetrics()->queued->add(-m_queue.count());
+#endif //METRICS
+}
+
+void SocketCommand::setEndpoint(const QString& endpoint)
+{
+    _close();
+    m_endpoint = endpoint;
+    m_transport = parseEndpoint(m_endpoint,&m_host,&m_port);
+    _open();
+    emit commandChanged();
+}
+
+void SocketCommand::setFraming(Framing framing)
+{
+    m_framing = framing;
+    emit commandChanged();
+}
+
+void SocketCommand::setRecordTemplate(const QString& recordTemplate)
+{
+    m_recordTemplate = CommandTemplate(recordTemplate);
+    emit commandChanged();
+}
+
+void SocketCommand::setQueueLimit(int limit)
+{
+    const int queued = m_queue.count();
+    m_queue.setCapacity(qMax(1,limit));
+#ifdef METRICS
+    socketMetrics()->dropped->increment(queued - m_queue.count());
+    socketMetrics()->queued->add(m_queue.count() - queued);
+#endif //METRICS
+    emit commandChanged();
+}
+
+bool SocketCommand::execute(const KeyEvent& event, quint64 execution)
+{
+    Q_UNUSED(execution);
+
+#ifdef TRACING
+    const quint64 sendStart = KeyEvent::now();
+#endif //TRACING
+
+    _render(event);
+
+    //Records are written in order - new record goes directly to the socket only if nothing is waiting
+    if (m_connected && m_queue.isEmpty() && (p_socket->bytesToWrite() < WRITE_HIGH_WATERMARK)) {
+        p_socket->write(m_record);
+#ifdef METRICS
+        socketMetrics()->sent->increment();
+#endif //METRICS
+    } else {
+        _enqueue(m_record);
+    }
+
+#ifdef TRACING
+    tracer->addSpan(event,"send",sendStart,KeyEvent::now());
+#endif //TRACING
+
+    return true;
+}
+
+void SocketCommand::_render(const KeyEvent& event)
+{
+    m_recordTemplate.render(event,&m_record);
+
+    switch (m_framing) {
+    case LineFraming:
+        m_record.replace('\n',' ');
+        m_record.append('\n');
+        break;
+    case LengthFraming: {
+        uchar length[4];
+        qToBigEndian<quint32>(quint32(m_record.size()),length);
+        m_record.prepend(reinterpret_cast<const char*>(length),4);
+        break;
+    }
+    }
+}
+
+void SocketCommand::_enqueue(const QByteArray& record)
+{
+#ifdef METRICS
+    if (m_queue.isFull()) {
+        socketMetrics()->dropped->increment();
+    } else {
+        socketMetrics()->queued->add(1);
+    }
+#endif //METRICS
+
+    //The oldest record is overwritten, when queue is full
+    m_queue.append(record);
+}
+
+void SocketCommand::_flush()
+{
+    if (!m_connected)
+        return;
+
+    //Datagrams are not buffered by the socket, stream sockets send all records written here with as few writes as
+    //possible
+    int sent = 0;
+    while (!m_queue.isEmpty() && ((m_transport == UdpTransport) || (p_socket->bytesToWrite() < WRITE_HIGH_WATERMARK))) {
+        p_socket->write(m_queue.at(0));
+        m_queue.removeFirst();
+        sent++;
+    }
+
+#ifdef METRICS
+    socketMetrics()->sent->increment(sent);
+    socketMetrics()->queued->add(-sent);
+#endif //METRICS
+}
+
+void SocketCommand::_open()
+{
+    switch (m_transport) {
+    case TcpTransport: {
+        QTcpSocket* socket = new QTcpSocket(this);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption,1);
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption,1);
+        p_socket = socket;
+        break;
+    }
+    case UdpTransport:
+        p_socket = new QUdpSocket(this);
+        break;
+    case UnixTransport:
+        p_socket = new QLocalSocket(this);
+        break;
+    case InvalidTransport:
+        if (!m_endpoint.isEmpty())
+            qWarning() << "Endpoint"<<m_endpoint<<"of socket command is not supported";
+        return;
+    }
+
+    if (m_transport == UnixTransport) {
+        connect(static_cast<QLocalSocket*>(p_socket),&QLocalSocket::stateChanged,
+                this,&SocketCommand::_localSocketStateChanged);
+    } else {
+        connect(static_cast<QAbstractSocket*>(p_socket),&QAbstractSocket::stateChanged,
+                this,&SocketCommand::_abstractSocketStateChanged);
+    }
+    connect(p_socket,&QIODevice::bytesWritten,this,&SocketCommand::_flush);
+
+    _connect();
+}
+
+void SocketCommand::_close()
+{
+    timerWheel->cancel(this);
+    m_connected = false;
+    m_attempt = 0;
+
+    if (p_socket == nullptr)
+        return;
+
+    //Socket is closed without reporting state changes back to this object
+    p_socket->disconnect(this);
+    delete p_socket;
+    p_socket = nullptr;
+}
+
+void SocketCommand::_connect()
+{
+    if (p_socket == nullptr)
+        return;
+
+    if (m_transport == UnixTransport) {
+        static_cast<QLocalSocket*>(p_socket)->connectToServer(m_host);
+    } else {
+        static_cast<QAbstractSocket*>(p_socket)->connectToHost(m_host,m_port);
+    }
+}
+
+void SocketCommand::_abstractSocketStateChanged(QAbstractSocket::SocketState state)
+{
+    if (state == QAbstractSocket::ConnectedState) {
+        _connected();
+    } else if (state == QAbstractSocket::UnconnectedState) {
+        _disconnected();
+    }
+}
+
+void SocketCommand::_localSocketStateChanged(QLocalSocket::LocalSocketState state)
+{
+    if (state == QLocalSocket::ConnectedState) {
+        _connected();
+    } else if (state == QLocalSocket::UnconnectedState) {
+        _disconnected();
+    }
+}
+
+void SocketCommand::_connected()
+{
+    qDebug() << "Socket command connected to"<<m_endpoint;
+#ifdef METRICS
+    socketMetrics()->connects->increment();
+#endif //METRICS
+
+    m_connected = true;
+    m_attempt = 0;
+    _flush();
+}
+
+void SocketCommand::_disconnected()
+{
+    m_connected = false;
+    if (timerWheel->isScheduled(this))
+        return;
+
+    const quint64 delay = ReconnectSupervisor::backoffDelay(m_attempt,INITIAL_RECONNECT_DELAY_NS,MAXIMUM_RECONNECT_DELAY_NS,
+                                                            QRandomGenerator::global()->generate());
+    m_attempt++;
+
+    qDebug() << "Socket command lost connection to"<<m_endpoint<<":"<<p_socket->errorString()
+             <<". Reconnecting in "<<(delay / 1000000)<<" ms (attempt "<<m_attempt<<")";
+
+    timerWheel->schedule(this,timerWheel->now() + delay);
+}
+
+SocketCommand::Transport SocketCommand::parseEndpoint(const QString& endpoint, QString* host, quint16* port)
+{
+    const QUrl url(endpoint);
+    const QString scheme = url.scheme();
+
+    if (scheme == QLatin1String("unix")) {
+        *host = url.path();
+        *port = 0;
+        return host->isEmpty() ? InvalidTransport : UnixTransport;
+    }
+
+    *host = url.host();
+    const int portNumber = url.port(-1);
+    *port = (portNumber > 0 && portNumber <= 0xFFFF) ? quint16(portNumber) : 0;
+    if (host->isEmpty() || (*port == 0))
+        return InvalidTransport;
+
+    if (scheme == QLatin1String("tcp"))
+        return TcpTransport;
+    if (scheme == QLatin1String("udp"))
+        return UdpTransport;
+
+    return InvalidTransport;
+}
+
+QString SocketCommand::framingName(Framing framing)
+{
+    switch (framing) {
+    case LineFraming:
+        return QStringLiteral("line");
+    case LengthFraming:
+        return QStringLiteral("length");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+SocketCommand::Framing SocketCommand::framingFromName(const QString& name)
+{
+    if (name == QLatin1String("length"))
+        return LengthFraming;
+
+    return LineFraming;
+}
+
+QJsonObject SocketCommand::toJson() const
+{
+    QJsonObject result({
+        { "type",        "socket" },
+        { "enabled",     isEnabled() },
+        { "key",         key() },
+        { "endpoint",    m_endpoint }
+    });
+    writeExecutionPolicy(&result);
+
+    //Only settings, which differ from defaults, are written
+    if (m_framing != LineFraming)
+        result.insert("framing",framingName(m_framing));
+    if (m_recordTemplate.text() != QLatin1String(DEFAULT_RECORD_TEMPLATE))
+        result.insert("record",m_recordTemplate.text());
+    if (m_queue.capacity() != DEFAULT_QUEUE_LIMIT)
+        result.insert("queueLimit",m_queue.capacity());
+
+    writeKeyMatching(&result);
+
+    return result;
+}
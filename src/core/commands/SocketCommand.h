@@ -0,0 +1,149 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SOCKETCOMMAND_H
+#define SOCKETCOMMAND_H
+
+#include <QAbstractSocket>
+#include <QLocalSocket>
+
+#include "Command.h"
+#include "CommandTemplate.h"
+#include "core/RingBuffer.h"
+#include "core/TimerWheel.h"
+
+/*!
+ *  @class SocketCommand core/commands/SocketCommand.h
+ *  @brief This class sends records of taps over persistent connection to local or remote endpoint.
+ *  @details Endpoint is "tcp://host:port", "udp://host:port" or "unix:/path/to/socket". Connection is opened when
+ *           command is loaded and kept open, so taps cost neither process spawn nor handshake, as with ShellCommand
+ *           running curl or nc. Every tap is rendered with recordTemplate (see CommandTemplate) and framed:
+ *           - LineFraming - record is followed by newline (newlines within record are replaced by spaces);
+ *           - LengthFraming - record is preceded by its length (32-bit unsigned, big-endian).
+ *           Over UDP each record is sent as one datagram.
+ *
+ *           Records are written without waiting for replies (pipelined). When WRITE_HIGH_WATERMARK bytes are waiting
+ *           within the socket - records are kept in queue of queueLimit records and written together as soon as
+ *           socket has sent previous data, so under load many records go out with one write. Records are queued
+ *           as well while connection is being (re)established. When queue is full - the oldest records are dropped.
+ *
+ *           Lost connections are reopened after backoff (see ReconnectSupervisor::backoffDelay). Records, which were
+ *           written to the lost connection, are not sent again - see BatchCommand for at-least-once delivery.
+ */
+
+class SocketCommand : public Command, private TimerWheel::Client
+{
+    Q_OBJECT
+public:
+    explicit SocketCommand(QObject* parent = nullptr);
+    explicit SocketCommand(const QJsonObject& jsonObject, QObject* parent = nullptr);
+    ~SocketCommand();
+
+    /*! @brief This enum describes how records are delimited within the stream */
+    enum Framing {
+        LineFraming,
+        LengthFraming
+    };
+
+    enum Transport {
+        TcpTransport,
+        UdpTransport,
+        UnixTransport,
+        InvalidTransport
+    };
+
+    static const int DEFAULT_QUEUE_LIMIT = 1024;
+    static const qint64 WRITE_HIGH_WATERMARK = 64 * 1024;
+    static const quint64 INITIAL_RECONNECT_DELAY_NS = Q_UINT64_C(100) * 1000 * 1000;
+    static const quint64 MAXIMUM_RECONNECT_DELAY_NS = Q_UINT64_C(30) * 1000 * 1000 * 1000;
+
+    /*! @brief Type of this object. Represented by Socket value from Command::Type enum */
+    Type           type() const override { return Socket; };
+
+    /*! @brief Changing endpoint closes current connection, queued records are sent to the new endpoint */
+    void           setEndpoint(const QString& endpoint);
+    QString        endpoint() const                             { return m_endpoint; }
+    Transport      transport() const                            { return m_transport; }
+
+    void           setFraming(Framing framing);
+    Framing        framing() const                              { return m_framing; }
+
+    /*! @brief Template of one record, see CommandTemplate */
+    void           setRecordTemplate(const QString& recordTemplate);
+    QString        recordTemplate() const                       { return m_recordTemplate.text(); }
+
+    /*! @brief Maximal number of records waiting for connection or for the socket */
+    void           setQueueLimit(int limit);
+    int            queueLimit() const                           { return m_queue.capacity(); }
+    int            queuedCount() const                          { return m_queue.count(); }
+
+    bool           isConnected() const                          { return m_connected; }
+
+    /*! @brief Parses endpoint. Returns InvalidTransport if endpoint is not supported. For unix sockets host is set
+     *         to the path of the socket */
+    static Transport parseEndpoint(const QString& endpoint, QString* host, quint16* port);
+
+    static QString framingName(Framing framing);
+    static Framing framingFromName(const QString& name);
+
+    /*! @brief Serialize this SocketCommand object to JSON. */
+    QJsonObject    toJson() const override;
+
+protected:
+    /*! @brief Writes (or queues) record of event. Execution is finished at once, delivery is not tracked */
+    bool           execute(const KeyEvent& event, quint64 execution) override;
+    void           _timerWheelExpired(quint64 now) override     { Q_UNUSED(now); _connect(); }
+
+private slots:
+    void           _abstractSocketStateChanged(QAbstractSocket::SocketState state);
+    void           _localSocketStateChanged(QLocalSocket::LocalSocketState state);
+    void           _flush();
+
+private:
+    Q_DISABLE_COPY(SocketCommand);
+
+    /*! @brief Creates socket for the endpoint and connects it */
+    void           _open();
+    void           _close();
+    void           _connect();
+    void           _connected();
+    void           _disconnected();
+
+    /*! @brief Renders record of event, framed, into m_record */
+    void           _render(const KeyEvent& event);
+    void           _enqueue(const QByteArray& record);
+
+    QString        m_endpoint;
+    Transport      m_transport;
+    QString        m_host;
+    quint16        m_port;
+    Framing        m_framing;
+    CommandTemplate m_recordTemplate;
+
+    QIODevice*     p_socket;
+    bool           m_connected;
+    int            m_attempt;             //!< @brief Reconnection attempts since connection was lost
+    RingBuffer<QByteArray> m_queue;
+    QByteArray     m_record;              //!< @brief Kept between taps, so rendering does not allocate
+};
+
+#endif // SOCKETCOMMAND_H
@@ -0,0 +1,110 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DeviceMultiplexer.h"
+
+#include <QDebug>
+
+#include "./EpollBackend.h"
+#include "./IoUringBackend.h"
+
+DeviceMultiplexer::DeviceMultiplexer()
+    : m_backendType(Epoll),p_backend(new EpollBackend(this))
+{}
+
+DeviceMultiplexer::~DeviceMultiplexer()
+{}
+
+bool DeviceMultiplexer::setBackend(Backend backend)
+{
+    if (backend == m_backendType)
+        return true;
+
+    if (p_backend->deviceCount() > 0) {
+        qDebug() << "Backend can not be changed while devices are registered";
+        return false;
+    }
+
+    MultiplexerBackend* newBackend = nullptr;
+    switch (backend) {
+    case Epoll:
+        newBackend = new EpollBackend(this);
+        break;
+    case IoUring:
+        newBackend = new IoUringBackend(this);
+        break;
+    }
+
+    if (newBackend == nullptr || !newBackend->isValid()) {
+        qDebug() << "Backend "<<backendName(backend)<<" is not available";
+        delete newBackend;
+        return false;
+    }
+
+    delete p_backend;
+    p_backend = newBackend;
+    m_backendType = backend;
+    return true;
+}
+
+bool DeviceMultiplexer::addDevice(int fd, Handler* handler, int bufferSize)
+{
+    Q_ASSERT(handler != nullptr);
+    Q_ASSERT(bufferSize > 0);
+
+    return p_backend->addDevice(fd,handler,bufferSize);
+}
+
+void DeviceMultiplexer::removeDevice(int fd)
+{
+    p_backend->removeDevice(fd);
+}
+
+int DeviceMultiplexer::deviceCount() const
+{
+    return p_backend->deviceCount();
+}
+
+QString DeviceMultiplexer::backendName(Backend backend)
+{
+    switch (backend) {
+    case Epoll:
+        return QStringLiteral("epoll");
+    case IoUring:
+        return QStringLiteral("io_uring");
+    }
+    Q_ASSERT(false);
+    return QString();
+}
+
+bool DeviceMultiplexer::backendFromName(const QString& name, Backend* backend)
+{
+    Q_ASSERT(backend != nullptr);
+
+    for (Backend candidate : { Epoll, IoUring }) {
+        if (name.compare(backendName(candidate),Qt::CaseInsensitive) == 0) {
+            *backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
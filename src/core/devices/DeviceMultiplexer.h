@@ -0,0 +1,102 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEVICEMULTIPLEXER_H
+#define DEVICEMULTIPLEXER_H
+
+#include <QObject>
+
+class MultiplexerBackend;
+
+/*!
+ *  @class DeviceMultiplexer core/devices/DeviceMultiplexer.h
+ *  @brief This class reads file descriptors of all opened reader devices and passes received data to their Handler
+ *         objects.
+ *  @details Actual waiting and reading is done by one of backends:
+ *           - EpollBackend - all descriptors are registered within one edge-triggered epoll instance, only the epoll
+ *             descriptor itself is watched by Qt event loop. Wakeup costs O(ready devices), not O(opened devices);
+ *           - IoUringBackend - read requests are kept posted for every descriptor in io_uring, completions are
+ *             harvested in batches and reads are posted again with one io_uring_enter call.
+ *
+ *           Backend can be selected with DeviceMultiplexer::setBackend while no devices are registered. If io_uring
+ *           is not available - epoll is used. Must be used from the main thread.
+ */
+
+class DeviceMultiplexer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Backend {
+        Epoll,
+        IoUring
+    };
+    Q_ENUM(Backend)
+
+    /*! @brief Interface of objects, which own registered descriptors */
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+
+        /*! @brief Called with data read from descriptor. Data is valid only during this call */
+        virtual void _deviceDataRead(int fd, const char* data, int size) = 0;
+
+        /*! @brief Called when reading failed. error - errno value (EIO for end of file). Descriptor is not read
+         *         anymore, but it is still registered till DeviceMultiplexer::removeDevice */
+        virtual void _deviceReadFailed(int fd, int error) = 0;
+    };
+
+    static DeviceMultiplexer* get() {
+        static DeviceMultiplexer theOne;
+        return &theOne;
+    }
+
+    /*! @brief Switches to the backend. Returns false if it is not available (or some devices are registered) - in
+     *         this case current backend stays */
+    bool      setBackend(Backend backend);
+    Backend   backend() const                             { return m_backendType; }
+
+    /*! @brief Starts reading fd. Each read requests up to bufferSize bytes (for devices, which return only whole
+     *         records, bufferSize must be multiple of record size). Returns false (and leaves errno set) if backend
+     *         refused the descriptor */
+    bool      addDevice(int fd, Handler* handler, int bufferSize);
+
+    /*! @brief Stops reading fd. Must be called before descriptor is closed */
+    void      removeDevice(int fd);
+
+    int       deviceCount() const;
+
+    /*! @brief Converts between Backend values and names used in config and command line ("epoll", "io_uring") */
+    static QString  backendName(Backend backend);
+    static bool     backendFromName(const QString& name, Backend* backend);
+
+private:
+    DeviceMultiplexer();
+    ~DeviceMultiplexer();
+    Q_DISABLE_COPY(DeviceMultiplexer)
+
+    Backend               m_backendType;
+    MultiplexerBackend*   p_backend;
+};
+#define deviceMultiplexer DeviceMultiplexer::get()
+
+#endif // DEVICEMULTIPLEXER_H
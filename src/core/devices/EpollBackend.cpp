@@ -0,0 +1,165 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpollBackend.h"
+
+#include <QDebug>
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <string.h>
+    #include <sys/epoll.h>
+    #include <unistd.h>
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#elif
+    #error("Builds for other platforms are not supported")
+#endif
+
+//Data is passed to handlers from the stack buffer, so no per-device buffers are needed
+static const int MAX_READ_SIZE = 4096;
+
+EpollBackend::EpollBackend(QObject* parent)
+    : MultiplexerBackend(parent),m_epollHandle(-1),p_epollNotifier(nullptr)
+#ifdef METRICS
+    ,p_wakeupsCounter(metricsRegistry->counter("rfid_multiplexer_wakeups_total","Wakeups of the device multiplexer.",
+                                               MetricsRegistry::label("backend","epoll"))),
+    p_readyCounter(metricsRegistry->counter("rfid_multiplexer_ready_total","Ready descriptors or completed reads.",
+                                            MetricsRegistry::label("backend","epoll"))),
+    p_readsCounter(metricsRegistry->counter("rfid_multiplexer_syscalls_total","System calls made by the device multiplexer.",
+                                            MetricsRegistry::label("backend","epoll")))
+#endif //METRICS
+{
+    m_epollHandle = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollHandle < 0) {
+        qDebug() << "epoll_create1() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return;
+    }
+
+    p_epollNotifier = new QSocketNotifier(m_epollHandle,QSocketNotifier::Read,this);
+    connect(p_epollNotifier,&QSocketNotifier::activated,this,&EpollBackend::_epollReady);
+}
+
+EpollBackend::~EpollBackend()
+{
+    if (m_epollHandle >= 0)
+        ::close(m_epollHandle);
+}
+
+bool EpollBackend::addDevice(int fd, DeviceMultiplexer::Handler* handler, int bufferSize)
+{
+    if (!isValid()) {
+        errno = ENOSYS;
+        return false;
+    }
+
+    //Notifications are edge-triggered, so descriptor is read till EAGAIN
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return false;
+
+    struct epoll_event event;
+    memset(&event,0,sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epollHandle, EPOLL_CTL_ADD, fd, &event) < 0)
+        return false;
+
+    //If descriptor already has data - epoll reports it right after registration, edge-triggered or not
+    m_devices.insert(fd,{handler,qMin(bufferSize,MAX_READ_SIZE)});
+    return true;
+}
+
+void EpollBackend::removeDevice(int fd)
+{
+    if (m_devices.remove(fd) == 0)
+        return;
+
+    //Closing descriptor removes it from epoll set anyway, but only when no other duplicates of it exist
+    if (epoll_ctl(m_epollHandle, EPOLL_CTL_DEL, fd, nullptr) < 0)
+        qDebug() << "epoll_ctl(EPOLL_CTL_DEL) call failed for fd="<<fd<<"; strerror(errno)="<<strerror(errno);
+}
+
+void EpollBackend::_epollReady()
+{
+    //If more descriptors are ready - epoll descriptor stays readable and we will be called again
+    static const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    const int ready = epoll_wait(m_epollHandle, events, MAX_EVENTS, 0);
+    if (ready < 0) {
+        if (errno != EINTR)
+            qDebug() << "epoll_wait() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return;
+    }
+
+#ifdef METRICS
+    p_wakeupsCounter->increment();
+    p_readyCounter->increment(ready);
+    p_readsCounter->increment();
+#endif //METRICS
+
+    for (int i = 0; i < ready; i++)
+        _readDevice(events[i].data.fd);
+}
+
+void EpollBackend::_readDevice(int fd)
+{
+    alignas(8) char buffer[MAX_READ_SIZE];
+
+    forever {
+        //Device can be removed by processing of the previous data (or previous descriptors)
+        const auto device = m_devices.constFind(fd);
+        if (device == m_devices.constEnd())
+            return;
+        DeviceMultiplexer::Handler* handler = device->handler;
+        const int bufferSize = device->bufferSize;
+
+        const ssize_t reading = read(fd, buffer, bufferSize);
+#ifdef METRICS
+        p_readsCounter->increment();
+#endif //METRICS
+        if (reading > 0) {
+            handler->_deviceDataRead(fd,buffer,int(reading));
+
+            //Short read means queue was drained. Data, which comes after read(), produces the next edge, so there is
+            //no need to spend one more syscall just to get EAGAIN
+            if (reading < bufferSize)
+                return;
+            continue;
+        }
+
+        if (reading < 0 && errno == EINTR)
+            continue;
+
+        if (reading < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        handler->_deviceReadFailed(fd,(reading == 0) ? EIO : errno);
+        return;
+    }
+}
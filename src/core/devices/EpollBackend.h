@@ -0,0 +1,86 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EPOLLBACKEND_H
+#define EPOLLBACKEND_H
+
+#include <QHash>
+
+#if defined(Q_OS_LINUX) && !defined (Q_OS_ANDROID)
+    #include <QSocketNotifier>
+#elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
+    #error("Android builds currently not supported")
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#else
+    #error("Builds for other platforms are not supported")
+#endif //PLATFORM SPECIFIC
+
+#include "./MultiplexerBackend.h"
+
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
+/*!
+ *  @class EpollBackend core/devices/EpollBackend.h
+ *  @brief MultiplexerBackend, which registers all descriptors within one edge-triggered epoll instance.
+ *  @details Descriptors are switched to O_NONBLOCK and read till EAGAIN on every notification.
+ */
+
+class EpollBackend : public MultiplexerBackend
+{
+    Q_OBJECT
+public:
+    explicit EpollBackend(QObject* parent = nullptr);
+    ~EpollBackend();
+
+    bool  isValid() const override                              { return m_epollHandle >= 0; }
+
+    bool  addDevice(int fd, DeviceMultiplexer::Handler* handler, int bufferSize) override;
+    void  removeDevice(int fd) override;
+    int   deviceCount() const override                          { return m_devices.size(); }
+
+private slots:
+    void  _epollReady();
+
+private:
+    struct Device {
+        DeviceMultiplexer::Handler*  handler;
+        int                          bufferSize;
+    };
+
+    /*! @brief Reads fd till EAGAIN (or till it is removed by its handler) */
+    void  _readDevice(int fd);
+
+    int                   m_epollHandle;
+    QSocketNotifier*      p_epollNotifier;
+    QHash<int,Device>     m_devices;
+
+#ifdef METRICS
+    Counter*              p_wakeupsCounter;
+    Counter*              p_readyCounter;
+    Counter*              p_readsCounter;
+#endif //METRICS
+};
+
+#endif // EPOLLBACKEND_H
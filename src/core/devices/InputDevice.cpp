@@ -24,13 +24,25 @@
 
 #include <QDebug>
 
+#include "core/cards/CardNormalizer.h"
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
     #include <QFile>
-    #include <QSocketNotifier>
 
     #include <errno.h>
     #include <fcntl.h>
     #include <linux/input.h>
+    #include <string.h>
+    #include <sys/ioctl.h>
+    #include <time.h>
     #include <unistd.h>
 #elif defined(Q_OS_WINDOWS)
     #error("Windows builds currently not supported")
@@ -38,6 +50,28 @@
     #error("Builds for other platforms are not supported")
 #endif
 
+#ifdef METRICS
+static Gauge* openedDevicesGauge()
+{
+    static Gauge* gauge = metricsRegistry->gauge("rfid_devices_opened","Currently opened devices.",
+                                                 MetricsRegistry::label("bus","hid"));
+    return gauge;
+}
+
+void InputDevice::_registerMetrics()
+{
+    const QString labels = MetricsRegistry::label("bus","hid") + ','
+            + MetricsRegistry::label("device",m_deviceDetails.deviceFileName());
+
+    p_keysCounter = metricsRegistry->counter("rfid_device_keys_total","Keys read by the device.",labels);
+    p_errorsCounter = metricsRegistry->counter("rfid_device_errors_total","Errors of the device.",labels);
+    p_readsCounter = metricsRegistry->counter("rfid_device_reads_total","read() calls made for the device.",labels);
+    p_eventsCounter = metricsRegistry->counter("rfid_device_events_total","Input events read from the device.",labels);
+    p_overflowsCounter = metricsRegistry->counter("rfid_device_overflows_total","Kernel event buffer overflows (SYN_DROPPED).",labels);
+    p_discardedKeysCounter = metricsRegistry->counter("rfid_device_discarded_keys_total","Partially read keys, which were discarded.",labels);
+}
+#endif //METRICS
+
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
 //
 // Linux-specific code
@@ -46,43 +80,160 @@
 InputDevice::InputDevice(QObject *parent) : QObject(parent),
     m_exclusiveAccess(true),
     m_errorCode(NoError),
-    m_deviceHandler(-1),
-    p_libevdev(nullptr),
-    p_socketNotifier(nullptr)
-{}
+    m_monotonicClock(false),
+    m_synDropped(false),
+    m_deviceHandler(-1)
+#ifdef METRICS
+    ,p_keysCounter(nullptr),
+    p_errorsCounter(nullptr),
+    p_readsCounter(nullptr),
+    p_eventsCounter(nullptr),
+    p_overflowsCounter(nullptr),
+    p_discardedKeysCounter(nullptr)
+#endif //METRICS
+{
+    _initKeyDecoder();
+}
 
 InputDevice::InputDevice(const InputDeviceInfo& deviceInfo, QObject* parent) : QObject(parent),
     m_deviceDetails(deviceInfo),
     m_exclusiveAccess(true),
     m_errorCode(NoError),
-    m_deviceHandler(-1),
-    p_libevdev(nullptr),
-    p_socketNotifier(nullptr)
-{}
+    m_monotonicClock(false),
+    m_synDropped(false),
+    m_deviceHandler(-1)
+#ifdef METRICS
+    ,p_keysCounter(nullptr),
+    p_errorsCounter(nullptr),
+    p_readsCounter(nullptr),
+    p_eventsCounter(nullptr),
+    p_overflowsCounter(nullptr),
+    p_discardedKeysCounter(nullptr)
+#endif //METRICS
+{
+    _initKeyDecoder();
+}
+
+void InputDevice::_initKeyDecoder()
+{
+    //HID readers finish the key with ENTER (and InputEvent::charCode returns '\0' for it). Key without ENTER is
+    //considered broken, so it is not emitted on timeout.
+    m_keyDecoder.setTerminators(QByteArray(1,'\0'));
+    m_keyDecoder.setEmitOnTimeout(false);
+
+    connect(&m_keyDecoder,&KeyDecoder::keyDecoded,this,&InputDevice::_keyDecoded);
+    connect(&m_keyDecoder,&KeyDecoder::keyDiscarded,this,&InputDevice::_keyDiscarded);
+}
 
 InputDevice::~InputDevice()
 {
-    if (m_deviceHandler > 0)
+    if (m_deviceHandler > 0) {
+        deviceMultiplexer->removeDevice(m_deviceHandler);
         ::close(m_deviceHandler);
+    }
+}
+
+InputDevice::ProbeResult InputDevice::probe(const InputDeviceInfo& deviceInfo, OpenMode mode, bool exclusiveAccess)
+{
+    ProbeResult result;
+    result.deviceInfo = deviceInfo;
+
+    //Blocking mode is set by DeviceMultiplexer backend
+    result.handle = ::open(deviceInfo.deviceFilePath().toStdString().c_str(), mode | O_NONBLOCK | O_CLOEXEC);
+    if (result.handle < 0) {
+        result.error = errno;
+        return result;
+    }
+
+    if (exclusiveAccess && ioctl(result.handle, EVIOCGRAB, 1) != 0) {
+        result.error = errno;
+        ::close(result.handle);
+        result.handle = -1;
+        return result;
+    }
+
+    //Both ioctls are optional. On older kernels (EINVAL/ENOTTY) device works as before, just with more wakeups
+    if (!_maskUnusedEvents(result.handle))
+        qDebug() << "EVIOCSMASK is not supported for device: "<<deviceInfo.deviceFileName()<<"; strerror(errno)="<<strerror(errno);
+
+    int clockId = CLOCK_MONOTONIC;
+    result.monotonicClock = (ioctl(result.handle, EVIOCSCLOCKID, &clockId) == 0);
+    if (!result.monotonicClock)
+        qDebug() << "EVIOCSCLOCKID is not supported for device: "<<deviceInfo.deviceFileName()<<"; strerror(errno)="<<strerror(errno);
 
-    if (p_socketNotifier != nullptr)
-        p_socketNotifier->deleteLater();
+    return result;
+}
+
+bool InputDevice::_maskUnusedEvents(int handle)
+{
+    //Only types, which device really can produce, are masked
+    unsigned long supportedTypes[EV_MAX / (8 * sizeof(unsigned long)) + 1] = {};
+    if (ioctl(handle, EVIOCGBIT(0, sizeof(supportedTypes)), supportedTypes) < 0)
+        return false;
+
+    const int bitsPerLong = 8 * sizeof(unsigned long);
+    int attempted = 0;
+    int masked = 0;
+    for (int type = EV_SYN + 1; type < EV_MAX; type++) {
+        //EV_SYN must stay (SYN_REPORT/SYN_DROPPED). Press and release of EV_KEY can not be told apart by mask.
+        //Kernel has no masks for EV_REP, EV_PWR and EV_FF_STATUS (keyboard-like readers advertise EV_REP)
+        if ((type == EV_KEY) || (type == EV_REP) || (type == EV_PWR) || (type == EV_FF_STATUS))
+            continue;
+
+        if ((supportedTypes[type / bitsPerLong] & (1UL << (type % bitsPerLong))) == 0)
+            continue;
+
+        //Empty mask - all codes of this type are filtered by kernel
+        struct input_mask mask;
+        mask.type = type;
+        mask.codes_size = 0;
+        mask.codes_ptr = 0;
+        //EINVAL - no mask for this type on this kernel, other types can still be masked
+        attempted++;
+        if (ioctl(handle, EVIOCSMASK, &mask) == 0) {
+            masked++;
+        } else if (errno != EINVAL) {
+            return false;
+        }
+    }
+
+    //Kernels without EVIOCSMASK reject every type with EINVAL as well
+    return (attempted == 0) || (masked > 0);
 }
 
 bool InputDevice::open(OpenMode mode)
 {
-    m_deviceHandler = ::open(m_deviceDetails.deviceFilePath().toStdString().c_str(), mode);
-    if (m_deviceHandler < 0) {
-        qDebug() << "open() call failed for device: "<<m_deviceDetails.deviceFileName()<<"; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
-        _setErrorState(QString(strerror(errno)),errno);
+    return open(probe(m_deviceDetails,mode,m_exclusiveAccess));
+}
+
+bool InputDevice::open(const ProbeResult& probeResult)
+{
+#ifdef METRICS
+    _registerMetrics();
+#endif //METRICS
+
+    if (probeResult.handle < 0) {
+        qDebug() << "open() call failed for device: "<<m_deviceDetails.deviceFileName()<<"; errno="<<probeResult.error<<"; strerror(errno)="<<strerror(probeResult.error);
+        _setErrorState(QString(strerror(probeResult.error)),probeResult.error);
         return false;
     }
 
-    setExclusiveAccess(m_exclusiveAccess);
+    //Whole packet (key event + SYN_REPORT) and some more fit to one read
+    static const int EVENTS_PER_READ = 64;
+    if (!deviceMultiplexer->addDevice(probeResult.handle,this,EVENTS_PER_READ * sizeof(struct input_event))) {
+        const int error = errno;
+        qDebug() << "DeviceMultiplexer::addDevice() call failed for device: "<<m_deviceDetails.deviceFileName()<<"; errno="<<error<<"; strerror(errno)="<<strerror(error);
+        ::close(probeResult.handle);
+        _setErrorState(QString(strerror(error)),error);
+        return false;
+    }
 
-    p_socketNotifier = new QSocketNotifier(m_deviceHandler,QSocketNotifier::Read);
-    connect(p_socketNotifier,&QSocketNotifier::activated,this,&InputDevice::_dataReadyForReading);
-    p_socketNotifier->setEnabled(true);
+    m_deviceHandler = probeResult.handle;
+    m_monotonicClock = probeResult.monotonicClock;
+
+#ifdef METRICS
+    openedDevicesGauge()->add(1);
+#endif //METRICS
 
     emit deviceOpened();
     return true;
@@ -90,11 +241,13 @@ bool InputDevice::open(OpenMode mode)
 
 void InputDevice::close()
 {
-    if (p_socketNotifier != nullptr) {
-        p_socketNotifier->setEnabled(false);
-        p_socketNotifier->deleteLater();
-        p_socketNotifier = nullptr;
-    }
+    if (isOpened())
+        deviceMultiplexer->removeDevice(m_deviceHandler);
+
+#ifdef METRICS
+    if (isOpened())
+        openedDevicesGauge()->add(-1);
+#endif //METRICS
 
     ::close(m_deviceHandler);
     m_deviceHandler = -1;
@@ -127,6 +280,11 @@ bool InputDevice::hasExclusiveAccess() const
 
 void InputDevice::_setErrorState(const QString& msg,int errorCode)
 {
+#ifdef METRICS
+    if (p_errorsCounter != nullptr)
+        p_errorsCounter->increment();
+#endif //METRICS
+
     m_errorMessage = msg;
     switch (errorCode) {
     case EACCES:
@@ -150,6 +308,21 @@ void InputDevice::_setErrorState(const QString& msg,int errorCode)
 
 void InputDevice::_processInputEvent(const InputEvent& event)
 {
+    if (event.type() == InputEvent::Syn) {
+        if (event.code() == SYN_DROPPED) {
+            _handleSynDropped();
+        } else if (event.code() == SYN_REPORT) {
+            //First SYN_REPORT after SYN_DROPPED - next events are complete again
+            m_synDropped = false;
+        }
+        return;
+    }
+
+    //Events till the next SYN_REPORT are part of packet, which was partially dropped by kernel
+    if (m_synDropped) {
+        return;
+    }
+
     if (event.type() != InputEvent::Key) {
         return;
     }
@@ -159,32 +332,91 @@ void InputDevice::_processInputEvent(const InputEvent& event)
     }
 
     //----- KEY DOWN -----
-    char key = event.charCode();
-    m_inputBuffer.append(key);
-    if (key == '\0') {
-        emit keyFound(QString(m_inputBuffer));
-        m_inputBuffer.clear();
+    const quint64 timestamp = m_monotonicClock ? event.timestamp() : KeyEvent::realtimeToMonotonic(event.timestamp());
+    m_keyDecoder.feed(event.charCode(),timestamp);
+}
+
+void InputDevice::_keyDecoded(const char* key, int length, quint64 firstCharacterTime)
+{
+    //Same card is reported in different encodings by different readers, commands see only its canonical form
+    char normalized[KeyEvent::MAX_KEY_LENGTH];
+    const int normalizedLength = cardNormalizer->normalize(key,length,normalized);
+    if (normalizedLength < 0) {
+        qDebug() << "Key with wrong checksum discarded for device: "<<m_deviceDetails.deviceFileName();
+#ifdef METRICS
+        p_discardedKeysCounter->increment();
+#endif //METRICS
         return;
     }
+
+#ifdef METRICS
+    p_keysCounter->increment();
+#endif //METRICS
+    KeyEvent keyEvent(normalized,normalizedLength,firstCharacterTime,m_deviceDetails.deviceFileName());
+    keyEvent.setDeviceIds(m_deviceDetails.vendorId(),m_deviceDetails.productId());
+#ifdef TRACING
+    tracer->addSpan(keyEvent,"hid-input",keyEvent.timestamp(),keyEvent.decodedAt());
+#endif //TRACING
+    emit keyFound(keyEvent);
 }
 
-void InputDevice::_dataReadyForReading(int socket)
+void InputDevice::_keyDiscarded(KeyDecoder::DiscardReason reason, int length)
 {
-    Q_ASSERT(socket == m_deviceHandler);
+    qDebug() << "Partial key of "<<length<<" characters discarded for device: "<<m_deviceDetails.deviceFileName()<<"; reason="<<reason;
+#ifdef METRICS
+    p_discardedKeysCounter->increment();
+#else
+    Q_UNUSED(reason);
+    Q_UNUSED(length);
+#endif //METRICS
+}
 
-    struct input_event event;
+void InputDevice::_handleSynDropped()
+{
+    qDebug() << "SYN_DROPPED received for device: "<<m_deviceDetails.deviceFileName();
+    m_synDropped = true;
 
-    int reading = read(m_deviceHandler, &event, sizeof(struct input_event));
-    if (reading < (int) sizeof(struct input_event)) {
-        qDebug() << "read() call failed for device: "<<m_deviceDetails.deviceFileName()<<"; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
-        //We need to disable p_socketNotifier, otherwise somehow QSocketNotifier::activated() signal is continiuosly emitted.
-        p_socketNotifier->setEnabled(false);
-        //Than - emit errorOccured() signal and set some reasonable errorMessage text
-        _setErrorState(strerror(errno),errno);
-        return;
+#ifdef METRICS
+    p_overflowsCounter->increment();
+#endif //METRICS
+
+    //Some key presses of the current key can be lost, so neither what was read nor what is still queued till ENTER
+    //is a valid key. As we are tracking only key presses (not the state of keys) - there is nothing else to
+    //resynchronize.
+    m_keyDecoder.drop();
+
+    //Device stays opened, so _setErrorState is not used here
+    m_errorCode = BufferOverflowError;
+    m_errorMessage = tr("Kernel event buffer overflowed");
+    emit errorOccured(m_errorCode);
+}
+
+void InputDevice::_deviceDataRead(int fd, const char* data, int size)
+{
+    Q_ASSERT(fd == m_deviceHandler);
+
+    //Kernel returns only whole events, as many as are queued (up to the buffer size)
+    const int eventCount = size / sizeof(struct input_event);
+#ifdef METRICS
+    p_readsCounter->increment();
+    p_eventsCounter->increment(eventCount);
+#endif //METRICS
+
+    //Device can be closed while processing (e.g. by slot connected to keyFound)
+    for (int i = 0; i < eventCount && isOpened(); i++) {
+        struct input_event inputEvent;
+        memcpy(&inputEvent, data + i * sizeof(struct input_event), sizeof(struct input_event));
+        _processInputEvent(InputEvent(inputEvent));
     }
+}
+
+void InputDevice::_deviceReadFailed(int fd, int error)
+{
+    Q_ASSERT(fd == m_deviceHandler);
 
-    _processInputEvent(InputEvent(event));
+    qDebug() << "read() call failed for device: "<<m_deviceDetails.deviceFileName()<<"; errno="<<error<<"; strerror(errno)="<<strerror(error);
+    //Emit errorOccured() signal and set some reasonable errorMessage text. Device is closed there
+    _setErrorState(strerror(error),error);
 }
 
 #elif defined(Q_OS_WINDOWS)
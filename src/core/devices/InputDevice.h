@@ -26,7 +26,7 @@
 #include <QObject>
 
 #if defined(Q_OS_LINUX) && !defined (Q_OS_ANDROID)
-    #include <QSocketNotifier>
+    #include "./core/devices/DeviceMultiplexer.h"
 #elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
     #error("Android builds currently not supported")
 #elif defined(Q_OS_WINDOWS)
@@ -36,14 +36,21 @@
 #endif //PLATFORM SPECIFIC
 
 #include "./core/input/InputDeviceInfo.h"
+#include "./core/KeyEvent.h"
+#include "./core/devices/KeyDecoder.h"
 #include "./core/input/InputEvent.h"
 
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
 /*!
  * @class InputDevice devices/InputDevice.h
  * @brief Represents an input device.
+ * @details Device file is read by DeviceMultiplexer.
  */
 
-class InputDevice : public QObject
+class InputDevice : public QObject, private DeviceMultiplexer::Handler
 {
     Q_OBJECT
 public:
@@ -59,14 +66,33 @@ public:
         PermissionError,
         DeviceIsBusy,
         NoSuchDeviceError,
+        BufferOverflowError,    /*!< @brief Kernel dropped events (SYN_DROPPED), partially read key was discarded. Device stays opened */
         UnknownError,
     };
 
+    /*! @brief Result of opening device file by InputDevice::probe */
+    struct ProbeResult {
+        InputDeviceInfo  deviceInfo;
+        int              handle = -1;     //!< @brief Opened file descriptor, or -1 on error
+        int              error = 0;       //!< @brief errno value if opening failed
+        bool             monotonicClock = false; //!< @brief Kernel timestamps events with CLOCK_MONOTONIC
+    };
+
     explicit InputDevice(QObject *parent = nullptr);
     explicit InputDevice(const InputDeviceInfo& deviceInfo, QObject* parent = nullptr);
     ~InputDevice();
 
+    /*! @brief Opens device file and (if exclusiveAccess is true) grabs the device. Where kernel supports it - events
+     *         other than EV_KEY and EV_SYN are masked and timestamps are switched to CLOCK_MONOTONIC. This method is
+     *         not touching any QObject, so it can be called from worker threads. Result should be passed to
+     *         InputDevice::open */
+    static ProbeResult probe(const InputDeviceInfo& deviceInfo, OpenMode mode, bool exclusiveAccess = true);
+
     bool open(OpenMode mode);
+
+    /*! @brief Starts reading from the device file opened by InputDevice::probe. Must be called from the thread
+     *         of this object */
+    bool open(const ProbeResult& probeResult);
     void close();
     bool isOpened() const;
 
@@ -81,8 +107,11 @@ public:
     void              setExclusiveAccess(bool status);
     bool              hasExclusiveAccess() const;
 
+    /*! @brief Returns decoder, which assembles keys from key presses of this device */
+    KeyDecoder*       keyDecoder()                                             { return &m_keyDecoder; }
+
 signals:
-    void keyFound(const QString& keyString);
+    void keyFound(const KeyEvent& keyEvent);
 
     void deviceOpened();
 
@@ -104,21 +133,37 @@ private:
     QString             m_errorMessage;
     InputDeviceError    m_errorCode;
 
-    QByteArray          m_inputBuffer;
+    KeyDecoder          m_keyDecoder;
+    bool                m_monotonicClock;   //!< @brief Kernel timestamps are already in CLOCK_MONOTONIC
+
+    /*! @brief True after SYN_DROPPED till the next SYN_REPORT. Events in between belong to incomplete packet */
+    bool                m_synDropped;
+
+    /*! @brief This method is called when kernel reports that its event buffer for this device overflowed */
+    void                _handleSynDropped();
+
+    void                _initKeyDecoder();
+
+private slots:
+    void                _keyDecoded(const char* key, int length, quint64 firstCharacterTime);
+    void                _keyDiscarded(KeyDecoder::DiscardReason reason, int length);
 
 #if defined(Q_OS_LINUX) && !defined (Q_OS_ANDROID)
 //
 // Linux-specific part of InputDevice
 //
 
-private slots:
-    void _dataReadyForReading(int socket);
+protected:
+    /*! @brief Processes events read by DeviceMultiplexer */
+    void                _deviceDataRead(int fd, const char* data, int size) override;
+    void                _deviceReadFailed(int fd, int error) override;
 
 private:
+    /*! @brief Asks kernel to drop all event types except EV_KEY and EV_SYN for this file descriptor. Returns false
+     *         if EVIOCSMASK is not supported */
+    static bool         _maskUnusedEvents(int handle);
+
     int                 m_deviceHandler;
-    struct libevdev*    p_libevdev;
-    int                 m_libevdevId;
-    QSocketNotifier*    p_socketNotifier;
 
 #elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
     #error("Android builds currently not supported")
@@ -127,6 +172,19 @@ private:
 #else
     #error("Builds for other platforms are not supported")
 #endif //PLATFORM SPECIFIC
+
+#ifdef METRICS
+private:
+    /*! @brief Per-device metrics are registered when device is opened, as device name is known only then */
+    void                _registerMetrics();
+
+    Counter*            p_keysCounter;
+    Counter*            p_errorsCounter;
+    Counter*            p_readsCounter;
+    Counter*            p_eventsCounter;
+    Counter*            p_overflowsCounter;
+    Counter*            p_discardedKeysCounter;
+#endif //METRICS
 };
 
 #endif // INPUTDEVICE_H
@@ -0,0 +1,387 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "IoUringBackend.h"
+
+#include <QDebug>
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <linux/io_uring.h>
+    #include <string.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#elif
+    #error("Builds for other platforms are not supported")
+#endif
+
+static const unsigned SQ_ENTRIES = 256;
+static const unsigned CQ_ENTRIES = 4096;   //Enough for one completion of every opened device
+
+//Completions of cancel requests carry no device
+static const quint64 CANCEL_USER_DATA = 0;
+
+static inline unsigned loadAcquire(const unsigned* pointer)
+{
+    return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+}
+
+static inline void storeRelease(unsigned* pointer, unsigned value)
+{
+    __atomic_store_n(pointer, value, __ATOMIC_RELEASE);
+}
+
+IoUringBackend::IoUringBackend(QObject* parent)
+    : MultiplexerBackend(parent),
+    m_ringHandle(-1),
+    p_ringNotifier(nullptr),
+    p_sqRing(MAP_FAILED),m_sqRingSize(0),
+    p_cqRing(MAP_FAILED),m_cqRingSize(0),
+    p_sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)),m_sqesSize(0),
+    p_sqHead(nullptr),p_sqTail(nullptr),p_sqArray(nullptr),m_sqMask(0),m_sqEntries(0),
+    p_cqHead(nullptr),p_cqTail(nullptr),m_cqMask(0),p_cqes(nullptr),
+    m_unsubmitted(0),
+    m_pendingReads(0),
+    p_dispatching(nullptr)
+#ifdef METRICS
+    ,p_wakeupsCounter(metricsRegistry->counter("rfid_multiplexer_wakeups_total","Wakeups of the device multiplexer.",
+                                               MetricsRegistry::label("backend","io_uring"))),
+    p_readyCounter(metricsRegistry->counter("rfid_multiplexer_ready_total","Ready descriptors or completed reads.",
+                                            MetricsRegistry::label("backend","io_uring"))),
+    p_syscallsCounter(metricsRegistry->counter("rfid_multiplexer_syscalls_total","System calls made by the device multiplexer.",
+                                               MetricsRegistry::label("backend","io_uring")))
+#endif //METRICS
+{
+    if (!_setupRing()) {
+        _destroyRing();
+        return;
+    }
+
+    //Ring descriptor is readable while completion queue is not empty
+    p_ringNotifier = new QSocketNotifier(m_ringHandle,QSocketNotifier::Read,this);
+    connect(p_ringNotifier,&QSocketNotifier::activated,this,&IoUringBackend::_completionsReady);
+}
+
+IoUringBackend::~IoUringBackend()
+{
+    if (!isValid())
+        return;
+
+    //Kernel can write to buffers till read requests are finished, so all of them are cancelled and waited for
+    for (Device* device : qAsConst(m_devices)) {
+        device->removed = true;
+        if (device->readPending) {
+            _postCancel(device);
+        } else {
+            delete[] device->buffer;
+            delete device;
+        }
+    }
+    m_devices.clear();
+
+    while (m_pendingReads > 0 && _submit(1))
+        _harvest(false);
+
+    _destroyRing();
+}
+
+bool IoUringBackend::_setupRing()
+{
+    struct io_uring_params params;
+    memset(&params,0,sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+
+    m_ringHandle = syscall(__NR_io_uring_setup, SQ_ENTRIES, &params);
+    if (m_ringHandle < 0) {
+        //ENOSYS - old kernel, EPERM - disabled by kernel.io_uring_disabled or seccomp
+        qDebug() << "io_uring_setup() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return false;
+    }
+
+    const quint32 requiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+    if ((params.features & requiredFeatures) != requiredFeatures) {
+        qDebug() << "io_uring of this kernel lacks required features; features="<<params.features;
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    //With IORING_FEAT_SINGLE_MMAP both rings are in one mapping
+    m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize,m_cqRingSize);
+    p_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringHandle, IORING_OFF_SQ_RING);
+    if (p_sqRing == MAP_FAILED) {
+        qDebug() << "mmap() of io_uring rings failed; strerror(errno)="<<strerror(errno);
+        return false;
+    }
+    p_cqRing = p_sqRing;
+
+    p_sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                    m_ringHandle, IORING_OFF_SQES));
+    if (p_sqes == MAP_FAILED) {
+        qDebug() << "mmap() of io_uring entries failed; strerror(errno)="<<strerror(errno);
+        return false;
+    }
+
+    char* sqRing = static_cast<char*>(p_sqRing);
+    p_sqHead = reinterpret_cast<unsigned*>(sqRing + params.sq_off.head);
+    p_sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+    p_sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+    m_sqEntries = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_entries);
+
+    char* cqRing = static_cast<char*>(p_cqRing);
+    p_cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+    p_cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+    p_cqes = reinterpret_cast<struct io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+    return true;
+}
+
+void IoUringBackend::_destroyRing()
+{
+    if (p_sqes != MAP_FAILED)
+        munmap(p_sqes, m_sqesSize);
+    if (p_sqRing != MAP_FAILED)
+        munmap(p_sqRing, m_sqRingSize);
+    if (m_ringHandle >= 0)
+        ::close(m_ringHandle);
+
+    p_sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+    p_sqRing = p_cqRing = MAP_FAILED;
+    m_ringHandle = -1;
+}
+
+bool IoUringBackend::addDevice(int fd, DeviceMultiplexer::Handler* handler, int bufferSize)
+{
+    if (!isValid()) {
+        errno = ENOSYS;
+        return false;
+    }
+
+    //io_uring returns EAGAIN for O_NONBLOCK descriptors instead of waiting for data
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0)
+        return false;
+
+    Device* device = new Device{fd,handler,bufferSize,new char[bufferSize],false,false};
+    if (!_postRead(device) || !_submit()) {
+        const int error = errno;
+        if (!device->readPending) {
+            delete[] device->buffer;
+            delete device;
+        } else {
+            //Entry is already in the queue, it will be cancelled with the next submission
+            device->removed = true;
+            _postCancel(device);
+        }
+        errno = error;
+        return false;
+    }
+
+    m_devices.insert(fd,device);
+    return true;
+}
+
+void IoUringBackend::removeDevice(int fd)
+{
+    Device* device = m_devices.take(fd);
+    if (device == nullptr)
+        return;
+
+    device->removed = true;
+
+    if (device->readPending) {
+        //Device is released when completion of the cancelled read arrives. Cancel is submitted right now, as
+        //descriptor will be closed after this call
+        _postCancel(device);
+        _submit();
+        return;
+    }
+
+    //Device, which handler is being called right now, is released after that call
+    if (device == p_dispatching)
+        return;
+
+    delete[] device->buffer;
+    delete device;
+}
+
+struct io_uring_sqe* IoUringBackend::_nextSqe()
+{
+    unsigned tail = *p_sqTail;
+    if (tail - loadAcquire(p_sqHead) >= m_sqEntries) {
+        //Without SQPOLL kernel consumes all entries during io_uring_enter
+        if (!_submit() || tail - loadAcquire(p_sqHead) >= m_sqEntries)
+            return nullptr;
+    }
+
+    const unsigned index = tail & m_sqMask;
+    struct io_uring_sqe* sqe = &p_sqes[index];
+    memset(sqe,0,sizeof(*sqe));
+    p_sqArray[index] = index;
+    return sqe;
+}
+
+bool IoUringBackend::_postRead(Device* device)
+{
+    struct io_uring_sqe* sqe = _nextSqe();
+    if (sqe == nullptr) {
+        errno = EBUSY;
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = device->fd;
+    sqe->addr = reinterpret_cast<quint64>(device->buffer);
+    sqe->len = device->bufferSize;
+    sqe->off = quint64(-1);   //Current file position, devices are not seekable anyway
+    sqe->user_data = reinterpret_cast<quint64>(device);
+
+    storeRelease(p_sqTail, *p_sqTail + 1);
+    m_unsubmitted++;
+    m_pendingReads++;
+    device->readPending = true;
+    return true;
+}
+
+void IoUringBackend::_postCancel(Device* device)
+{
+    struct io_uring_sqe* sqe = _nextSqe();
+    if (sqe == nullptr) {
+        //Read stays posted, device is released when it completes (at the latest - when descriptor gets some data)
+        qDebug() << "io_uring submission queue is full, read of fd="<<device->fd<<" is not cancelled";
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<quint64>(device);
+    sqe->user_data = CANCEL_USER_DATA;
+
+    storeRelease(p_sqTail, *p_sqTail + 1);
+    m_unsubmitted++;
+}
+
+bool IoUringBackend::_submit(unsigned waitFor)
+{
+    if (m_unsubmitted == 0 && waitFor == 0)
+        return true;
+
+    const int submitted = syscall(__NR_io_uring_enter, m_ringHandle, m_unsubmitted, waitFor,
+                                  (waitFor > 0) ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+#ifdef METRICS
+    p_syscallsCounter->increment();
+#endif //METRICS
+    if (submitted < 0) {
+        //Entries stay in the queue and will be passed with the next call
+        if (errno != EINTR)
+            qDebug() << "io_uring_enter() call failed; errno="<<errno<<"; strerror(errno)="<<strerror(errno);
+        return false;
+    }
+
+    m_unsubmitted -= qMin(m_unsubmitted,unsigned(submitted));
+    return true;
+}
+
+void IoUringBackend::_completionsReady()
+{
+#ifdef METRICS
+    p_wakeupsCounter->increment();
+#endif //METRICS
+
+    _harvest(true);
+
+    //Reads of all handled devices are posted again with one syscall
+    _submit();
+}
+
+void IoUringBackend::_harvest(bool dispatch)
+{
+    unsigned head = *p_cqHead;
+    forever {
+        if (head == loadAcquire(p_cqTail))
+            return;
+
+        const struct io_uring_cqe cqe = p_cqes[head & m_cqMask];
+        head++;
+        //Entry is copied, so it can be returned to kernel before processing
+        storeRelease(p_cqHead, head);
+
+        if (cqe.user_data == CANCEL_USER_DATA)
+            continue;
+
+        Device* device = reinterpret_cast<Device*>(cqe.user_data);
+        device->readPending = false;
+        m_pendingReads--;
+
+#ifdef METRICS
+        p_readyCounter->increment();
+#endif //METRICS
+
+        if (device->removed || !dispatch) {
+            delete[] device->buffer;
+            delete device;
+            continue;
+        }
+
+        _processCompletion(device,cqe.res);
+    }
+}
+
+void IoUringBackend::_processCompletion(Device* device, int result)
+{
+    if (result == -EINTR || result == -EAGAIN) {
+        _postRead(device);
+        return;
+    }
+
+    p_dispatching = device;
+    if (result > 0) {
+        device->handler->_deviceDataRead(device->fd,device->buffer,result);
+    } else {
+        device->handler->_deviceReadFailed(device->fd,(result == 0) ? EIO : -result);
+    }
+    p_dispatching = nullptr;
+
+    if (device->removed) {
+        //Handler has removed the device
+        delete[] device->buffer;
+        delete device;
+        return;
+    }
+
+    //After failure device is not read anymore, till handler removes it
+    if (result > 0 && !_postRead(device))
+        device->handler->_deviceReadFailed(device->fd,errno);
+}
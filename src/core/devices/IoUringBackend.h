@@ -0,0 +1,133 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IOURINGBACKEND_H
+#define IOURINGBACKEND_H
+
+#include <QHash>
+
+#if defined(Q_OS_LINUX) && !defined (Q_OS_ANDROID)
+    #include <QSocketNotifier>
+#elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
+    #error("Android builds currently not supported")
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#else
+    #error("Builds for other platforms are not supported")
+#endif //PLATFORM SPECIFIC
+
+#include "./MultiplexerBackend.h"
+
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/*!
+ *  @class IoUringBackend core/devices/IoUringBackend.h
+ *  @brief MultiplexerBackend, which keeps one read request posted in io_uring for every descriptor.
+ *  @details Ring is used directly through io_uring_setup/io_uring_enter system calls. Ring descriptor is watched by
+ *           Qt event loop (it is readable while there are completions). On wakeup all completions are harvested, data
+ *           is passed to handlers and reads are posted again - all of them with one io_uring_enter call.
+ *
+ *           Kernel 5.7+ is required (IORING_FEAT_FAST_POLL - reads of idle devices wait in poll, not in kernel
+ *           worker threads). Buffer of the device is owned by this class and freed only when its read request is
+ *           completed or cancelled, as kernel can write to it till that moment.
+ */
+
+class IoUringBackend : public MultiplexerBackend
+{
+    Q_OBJECT
+public:
+    explicit IoUringBackend(QObject* parent = nullptr);
+    ~IoUringBackend();
+
+    bool  isValid() const override                              { return m_ringHandle >= 0; }
+
+    bool  addDevice(int fd, DeviceMultiplexer::Handler* handler, int bufferSize) override;
+    void  removeDevice(int fd) override;
+    int   deviceCount() const override                          { return m_devices.size(); }
+
+private slots:
+    void  _completionsReady();
+
+private:
+    struct Device {
+        int                          fd;
+        DeviceMultiplexer::Handler*  handler;
+        int                          bufferSize;
+        char*                        buffer;
+        bool                         readPending;
+        bool                         removed;
+    };
+
+    bool                  _setupRing();
+    void                  _destroyRing();
+
+    /*! @brief Returns free submission queue entry (submitting queued ones if queue is full) or nullptr */
+    struct io_uring_sqe*  _nextSqe();
+    bool                  _postRead(Device* device);
+    void                  _postCancel(Device* device);
+
+    /*! @brief Passes all queued entries to kernel. Returns false if io_uring_enter failed */
+    bool                  _submit(unsigned waitFor = 0);
+
+    /*! @brief Processes all completions. If dispatch is false - only releases devices (used on destruction) */
+    void                  _harvest(bool dispatch);
+    void                  _processCompletion(Device* device, int result);
+
+    int                   m_ringHandle;
+    QSocketNotifier*      p_ringNotifier;
+
+    void*                 p_sqRing;
+    size_t                m_sqRingSize;
+    void*                 p_cqRing;
+    size_t                m_cqRingSize;
+    struct io_uring_sqe*  p_sqes;
+    size_t                m_sqesSize;
+
+    unsigned*             p_sqHead;
+    unsigned*             p_sqTail;
+    unsigned*             p_sqArray;
+    unsigned              m_sqMask;
+    unsigned              m_sqEntries;
+    unsigned*             p_cqHead;
+    unsigned*             p_cqTail;
+    unsigned              m_cqMask;
+    struct io_uring_cqe*  p_cqes;
+
+    unsigned              m_unsubmitted;  //!< @brief Entries queued after the last io_uring_enter
+    int                   m_pendingReads;
+    Device*               p_dispatching;  //!< @brief Device, which handler is being called right now
+
+    QHash<int,Device*>    m_devices;
+
+#ifdef METRICS
+    Counter*              p_wakeupsCounter;
+    Counter*              p_readyCounter;
+    Counter*              p_syscallsCounter;
+#endif //METRICS
+};
+
+#endif // IOURINGBACKEND_H
@@ -0,0 +1,146 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyDecoder.h"
+
+static const quint64 DEFAULT_TIMEOUT_NS     = 100 * 1000 * 1000;
+static const int     DEFAULT_MAXIMUM_LENGTH = 64;
+
+KeyDecoder::KeyDecoder(QObject* parent)
+    : QObject(parent),
+    m_terminators(1,'\0'),
+    m_timeout(DEFAULT_TIMEOUT_NS),
+    m_maximumLength(DEFAULT_MAXIMUM_LENGTH),
+    m_emitOnTimeout(false),
+    m_length(0),
+    m_dropping(false),
+    m_firstCharacterTime(0),
+    m_lastCharacterTime(0)
+{}
+
+void KeyDecoder::setMaximumLength(int length)
+{
+    m_maximumLength = qBound(1,length,CAPACITY);
+}
+
+void KeyDecoder::feed(char character, quint64 time)
+{
+    //Timer wheel is coarse, so gap is checked here as well. Otherwise beginning of the next key can be glued to
+    //the partial key, which has not yet expired in the wheel
+    if ((m_length > 0 || m_dropping) && time > m_lastCharacterTime + m_timeout)
+        _timerWheelExpired(time);
+
+    if (_isTerminator(character)) {
+        if (m_length > 0)
+            _finishKey();
+        m_dropping = false;
+        timerWheel->cancel(this);
+        return;
+    }
+
+    m_lastCharacterTime = time;
+
+    if (m_dropping)
+        return;
+
+    if (m_length == m_maximumLength) {
+        _discardKey(OverflowDiscard);
+        m_dropping = true;
+        return;
+    }
+
+    if (m_length == 0) {
+        m_firstCharacterTime = time;
+        timerWheel->schedule(this,time + m_timeout);
+    }
+
+    m_buffer[m_length++] = character;
+}
+
+void KeyDecoder::feed(const char* data, int size, quint64 time)
+{
+    for (int i = 0; i < size; i++)
+        feed(data[i],time);
+}
+
+void KeyDecoder::reset()
+{
+    m_dropping = false;
+    timerWheel->cancel(this);
+
+    if (m_length > 0)
+        _discardKey(ResetDiscard);
+}
+
+void KeyDecoder::drop()
+{
+    m_dropping = true;
+    timerWheel->cancel(this);
+
+    if (m_length > 0)
+        _discardKey(InputLostDiscard);
+}
+
+void KeyDecoder::_timerWheelExpired(quint64 now)
+{
+    if (m_length == 0 && !m_dropping)
+        return;
+
+    //Wheel entry is created for the first character only, so deadline has to be moved if more characters came
+    const quint64 deadline = m_lastCharacterTime + m_timeout;
+    if (now <= deadline) {
+        timerWheel->schedule(this,deadline);
+        return;
+    }
+
+    timerWheel->cancel(this);
+
+    if (m_emitOnTimeout) {
+        m_dropping = false;
+        if (m_length > 0)
+            _finishKey();
+        return;
+    }
+
+    //Key without terminator is broken (e.g. reader or event loop stalled in the middle of it), so characters, which
+    //are still coming, are only a suffix of it and are dropped till the next terminator as well
+    m_dropping = true;
+    if (m_length > 0)
+        _discardKey(TimeoutDiscard);
+}
+
+void KeyDecoder::_finishKey()
+{
+    //Buffer is cleared before emitting, as slots can feed this decoder again. Key is passed without copying
+    const int length = m_length;
+    m_length = 0;
+
+    emit keyDecoded(m_buffer,length,m_firstCharacterTime);
+}
+
+void KeyDecoder::_discardKey(DiscardReason reason)
+{
+    const int length = m_length;
+    m_length = 0;
+
+    emit keyDiscarded(reason,length);
+}
@@ -0,0 +1,126 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef KEYDECODER_H
+#define KEYDECODER_H
+
+#include <QObject>
+#include <QByteArray>
+
+#include "./core/KeyEvent.h"
+#include "./core/TimerWheel.h"
+
+/*!
+ *  @class KeyDecoder core/devices/KeyDecoder.h
+ *  @brief This class assembles keys from characters produced by one device.
+ *  @details Characters are collected in fixed-size buffer till one of terminator characters. Key is dropped if it is
+ *           longer than maximumLength (the rest of it - till the next terminator - is dropped too) or if the gap
+ *           between two characters exceeds timeout. Such partial key is either discarded together with the rest of it
+ *           till the next terminator (HID readers, where missing ENTER means broken input), or emitted as a key (serial
+ *           readers, which are not terminating lines).
+ *
+ *           All times are monotonic times in nanoseconds passed by the caller, timeouts are driven by the TimerWheel,
+ *           so KeyDecoder does not read the clock by itself.
+ */
+
+class KeyDecoder : public QObject, private TimerWheel::Client
+{
+    Q_OBJECT
+public:
+    /*! @brief Size of the internal buffer. maximumLength can not exceed it */
+    static const int CAPACITY = KeyEvent::MAX_KEY_LENGTH;
+
+    enum DiscardReason {
+        TimeoutDiscard,     /*!< @brief No characters were received within timeout */
+        OverflowDiscard,    /*!< @brief Key was longer than maximumLength */
+        ResetDiscard,       /*!< @brief KeyDecoder::reset was called */
+        InputLostDiscard    /*!< @brief KeyDecoder::drop was called, because device lost some input */
+    };
+    Q_ENUM(DiscardReason)
+
+    explicit KeyDecoder(QObject* parent = nullptr);
+    ~KeyDecoder() {}
+
+    /*! @brief Sets characters, which end the key. Terminators are not part of the key */
+    void        setTerminators(const QByteArray& terminators)  { m_terminators = terminators; }
+    QByteArray  terminators() const                            { return m_terminators; }
+
+    /*! @brief Sets maximal allowed gap between two characters of one key (in nanoseconds) */
+    void        setTimeout(quint64 timeoutNs)                  { m_timeout = timeoutNs; }
+    quint64     timeout() const                                { return m_timeout; }
+
+    /*! @brief Sets maximal length of the key. Values are limited to 1...CAPACITY */
+    void        setMaximumLength(int length);
+    int         maximumLength() const                          { return m_maximumLength; }
+
+    /*! @brief If state is true - characters collected before timeout are emitted as a key instead of being
+     *         discarded */
+    void        setEmitOnTimeout(bool state)                   { m_emitOnTimeout = state; }
+    bool        emitOnTimeout() const                          { return m_emitOnTimeout; }
+
+    /*! @brief Returns number of characters collected for the current key */
+    int         pendingLength() const                          { return m_length; }
+
+    /*! @brief Processes one character received at time */
+    void        feed(char character, quint64 time);
+
+    /*! @brief Processes characters received at time */
+    void        feed(const char* data, int size, quint64 time);
+
+    /*! @brief Discards current partial key */
+    void        reset();
+
+    /*! @brief Discards current partial key and drops characters till the next terminator. Used when device lost some
+     *         input (e.g. kernel buffer overflowed), so characters received after the loss can be only a suffix of
+     *         the broken key */
+    void        drop();
+
+signals:
+    /*! @brief Emitted when the whole key was collected. firstCharacterTime - time of the first character of the key.
+     *         key points to the internal buffer - it is valid only till the decoder is fed again, so slots should
+     *         copy it (e.g. into KeyEvent) before doing anything else */
+    void        keyDecoded(const char* key, int length, quint64 firstCharacterTime);
+
+    /*! @brief Emitted when partial key of length characters was dropped */
+    void        keyDiscarded(KeyDecoder::DiscardReason reason, int length);
+
+protected:
+    void        _timerWheelExpired(quint64 now) override;
+
+private:
+    inline bool _isTerminator(char character) const        { return m_terminators.contains(character); }
+    void        _finishKey();
+    void        _discardKey(DiscardReason reason);
+
+    QByteArray  m_terminators;
+    quint64     m_timeout;
+    int         m_maximumLength;
+    bool        m_emitOnTimeout;
+
+    char        m_buffer[CAPACITY];
+    int         m_length;
+    bool        m_dropping;         //!< @brief Characters are dropped till the end of too long or broken key
+    quint64     m_firstCharacterTime;
+    quint64     m_lastCharacterTime;
+};
+
+#endif // KEYDECODER_H
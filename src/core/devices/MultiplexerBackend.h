@@ -0,0 +1,50 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPLEXERBACKEND_H
+#define MULTIPLEXERBACKEND_H
+
+#include <QObject>
+
+#include "./DeviceMultiplexer.h"
+
+/*!
+ *  @class MultiplexerBackend core/devices/MultiplexerBackend.h
+ *  @brief Base class for the ways DeviceMultiplexer can wait for and read device descriptors.
+ */
+
+class MultiplexerBackend : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MultiplexerBackend(QObject* parent = nullptr) : QObject(parent) {}
+    virtual ~MultiplexerBackend() {}
+
+    /*! @brief Returns false if backend could not be initialized (e.g. not supported by the kernel) */
+    virtual bool  isValid() const = 0;
+
+    virtual bool  addDevice(int fd, DeviceMultiplexer::Handler* handler, int bufferSize) = 0;
+    virtual void  removeDevice(int fd) = 0;
+    virtual int   deviceCount() const = 0;
+};
+
+#endif // MULTIPLEXERBACKEND_H
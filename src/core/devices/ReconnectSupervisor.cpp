@@ -0,0 +1,210 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ReconnectSupervisor.h"
+
+#include <QDebug>
+#include <QRandomGenerator>
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+#endif //METRICS
+
+static const quint64 DEFAULT_INITIAL_DELAY_NS = Q_UINT64_C(50) * 1000 * 1000;
+static const quint64 DEFAULT_MAXIMUM_DELAY_NS = Q_UINT64_C(30) * 1000 * 1000 * 1000;
+
+ReconnectSupervisor::ReconnectSupervisor(const QString& bus, QObject* parent)
+    : QObject(parent),
+    m_enabled(true),
+    m_initialDelay(DEFAULT_INITIAL_DELAY_NS),
+    m_maximumDelay(DEFAULT_MAXIMUM_DELAY_NS)
+{
+#ifdef METRICS
+    const QString labels = MetricsRegistry::label("bus",bus);
+    p_attemptsCounter = metricsRegistry->counter("rfid_device_reconnect_attempts_total","Attempts to reopen failed devices.",labels);
+    p_reconnectsCounter = metricsRegistry->counter("rfid_device_reconnects_total","Failed devices, which were reopened.",labels);
+    p_failuresCounter = metricsRegistry->counter("rfid_device_failures_total","Devices closed because of errors.",labels);
+    p_downGauge = metricsRegistry->gauge("rfid_devices_reconnecting","Failed devices, which are waiting for reconnection.",labels);
+#else
+    Q_UNUSED(bus);
+#endif //METRICS
+}
+
+ReconnectSupervisor::~ReconnectSupervisor()
+{
+    for (Device* device : qAsConst(m_devices))
+        _releaseDevice(device);
+}
+
+ReconnectSupervisor::State ReconnectSupervisor::state(const QString& deviceId) const
+{
+    const Device* device = m_devices.value(deviceId,nullptr);
+    return (device != nullptr) ? device->m_state : Connected;
+}
+
+int ReconnectSupervisor::attempt(const QString& deviceId) const
+{
+    const Device* device = m_devices.value(deviceId,nullptr);
+    return (device != nullptr) ? device->m_attempt : 0;
+}
+
+void ReconnectSupervisor::deviceConnected(const QString& deviceId)
+{
+    Device* device = _device(deviceId);
+    timerWheel->cancel(device);
+
+#ifdef METRICS
+    if (device->m_state == Reconnecting)
+        p_reconnectsCounter->increment();
+#endif //METRICS
+
+    device->m_connectedAt = timerWheel->now();
+    _setState(device,Connected);
+}
+
+void ReconnectSupervisor::deviceFailed(const QString& deviceId)
+{
+    if (!m_enabled) {
+        forgetDevice(deviceId);
+        return;
+    }
+
+    Device* device = _device(deviceId);
+    const quint64 now = timerWheel->now();
+
+    if (device->m_state == Connected) {
+#ifdef METRICS
+        p_failuresCounter->increment();
+#endif //METRICS
+        if (now - device->m_connectedAt >= STABLE_NS)
+            device->m_attempt = 0;
+    }
+
+    //Device, which was detached, is reopened only when it appears again
+    if (device->m_state == Detached)
+        return;
+
+    const quint64 delay = backoffDelay(device->m_attempt,m_initialDelay,m_maximumDelay,
+                                       QRandomGenerator::global()->generate());
+    device->m_attempt++;
+
+    qDebug() << "Device "<<deviceId<<" will be reopened in "<<(delay / 1000000)<<" ms (attempt "<<device->m_attempt<<")";
+
+    _setState(device,Waiting);
+    timerWheel->schedule(device,now + delay);
+}
+
+void ReconnectSupervisor::deviceDetached(const QString& deviceId)
+{
+    Device* device = m_devices.value(deviceId,nullptr);
+    if (device == nullptr)
+        return;
+
+    timerWheel->cancel(device);
+    _setState(device,Detached);
+}
+
+void ReconnectSupervisor::deviceAttached(const QString& deviceId)
+{
+    Device* device = m_devices.value(deviceId,nullptr);
+    if (device == nullptr || device->m_state == Connected)
+        return;
+
+    //Device has just appeared, so there is no reason to wait
+    timerWheel->cancel(device);
+    _retry(device);
+}
+
+void ReconnectSupervisor::forgetDevice(const QString& deviceId)
+{
+    Device* device = m_devices.take(deviceId);
+    if (device == nullptr)
+        return;
+
+    _releaseDevice(device);
+}
+
+quint64 ReconnectSupervisor::backoffDelay(int attempt, quint64 initialDelay, quint64 maximumDelay, quint32 random)
+{
+    //Fast first retry - transient failures are usually gone after a short moment
+    if (attempt <= 0)
+        return initialDelay;
+
+    quint64 delay = initialDelay;
+    for (int i = 0; i < attempt && delay < maximumDelay; i++)
+        delay *= 2;
+    delay = qMin(delay,maximumDelay);
+
+    //Half of the delay is fixed, another half is random
+    const quint64 half = delay / 2;
+    return half + (half > 0 ? random % (half + 1) : 0);
+}
+
+ReconnectSupervisor::Device* ReconnectSupervisor::_device(const QString& deviceId)
+{
+    Device* device = m_devices.value(deviceId,nullptr);
+    if (device == nullptr) {
+        device = new Device(this,deviceId);
+        m_devices.insert(deviceId,device);
+    }
+
+    return device;
+}
+
+void ReconnectSupervisor::_setState(Device* device, State state)
+{
+    if (device->m_state == state)
+        return;
+
+#ifdef METRICS
+    const bool wasDown = (device->m_state == Waiting || device->m_state == Reconnecting);
+    const bool isDown = (state == Waiting || state == Reconnecting);
+    if (wasDown != isDown)
+        p_downGauge->add(isDown ? 1 : -1);
+#endif //METRICS
+
+    device->m_state = state;
+    emit stateChanged(device->m_id,state);
+}
+
+void ReconnectSupervisor::_releaseDevice(Device* device)
+{
+#ifdef METRICS
+    if (device->m_state == Waiting || device->m_state == Reconnecting)
+        p_downGauge->add(-1);
+#endif //METRICS
+
+    delete device;
+}
+
+void ReconnectSupervisor::_retry(Device* device)
+{
+#ifdef METRICS
+    p_attemptsCounter->increment();
+#endif //METRICS
+
+    _setState(device,Reconnecting);
+
+    //Slots report the result with deviceConnected or deviceFailed. Device can be forgotten there, so id is copied
+    const QString deviceId = device->m_id;
+    emit reconnectRequested(deviceId);
+}
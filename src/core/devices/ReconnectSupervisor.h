@@ -0,0 +1,145 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RECONNECTSUPERVISOR_H
+#define RECONNECTSUPERVISOR_H
+
+#include <QObject>
+#include <QHash>
+
+#include "./core/TimerWheel.h"
+
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
+/*!
+ *  @class ReconnectSupervisor core/devices/ReconnectSupervisor.h
+ *  @brief This class decides, when devices closed because of errors should be reopened.
+ *  @details Devices are identified by strings (device file path, port name). Each supervised device has its own
+ *           state:
+ *           - Connected - device is opened;
+ *           - Waiting - device has failed, ReconnectSupervisor::reconnectRequested will be emitted after backoff;
+ *           - Reconnecting - reconnectRequested was emitted, manager is expected to report the result with
+ *             ReconnectSupervisor::deviceConnected or ReconnectSupervisor::deviceFailed;
+ *           - Detached - device was removed from the system, it is reopened as soon as it is attached again.
+ *
+ *           First retry is done after initialDelay, as most of the failures (USB hub resets, udev changing
+ *           permissions) are gone by then. Next delays are doubled up to maximumDelay with random jitter, so devices
+ *           behind one hub do not retry at the same moment. Number of attempts is reset only if device stayed
+ *           connected for STABLE_NS, so device, which fails right after opening, keeps backing off.
+ *
+ *           Backoffs are driven by the TimerWheel, so they follow the clock set by TimerWheel::setClock.
+ */
+
+class ReconnectSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    enum State {
+        Connected,
+        Waiting,
+        Reconnecting,
+        Detached
+    };
+    Q_ENUM(State)
+
+    static const quint64 STABLE_NS = Q_UINT64_C(10) * 1000 * 1000 * 1000;
+
+    /*! @brief bus - name of the bus (e.g. "hid" or "serial"), used as label of metrics */
+    explicit ReconnectSupervisor(const QString& bus, QObject* parent = nullptr);
+    ~ReconnectSupervisor();
+
+    /*! @brief If disabled - failed devices are forgotten instead of being reconnected */
+    void      setEnabled(bool state)                      { m_enabled = state; }
+    bool      isEnabled() const                           { return m_enabled; }
+
+    void      setInitialDelay(quint64 delayNs)            { m_initialDelay = delayNs; }
+    quint64   initialDelay() const                        { return m_initialDelay; }
+
+    void      setMaximumDelay(quint64 delayNs)            { m_maximumDelay = delayNs; }
+    quint64   maximumDelay() const                        { return m_maximumDelay; }
+
+    bool      isSupervised(const QString& deviceId) const { return m_devices.contains(deviceId); }
+    State     state(const QString& deviceId) const;
+    int       attempt(const QString& deviceId) const;
+
+    /*! @brief Device was opened (by the user, autoconnect or reconnect). Pending attempt is cancelled */
+    void      deviceConnected(const QString& deviceId);
+
+    /*! @brief Device was closed because of error, or reconnection attempt has failed */
+    void      deviceFailed(const QString& deviceId);
+
+    /*! @brief Device was removed from the system. No attempts are made till ReconnectSupervisor::deviceAttached */
+    void      deviceDetached(const QString& deviceId);
+
+    /*! @brief Device was attached to the system. If it was supervised - it is reconnected at once */
+    void      deviceAttached(const QString& deviceId);
+
+    /*! @brief Device was closed by the user - it is not supervised anymore */
+    void      forgetDevice(const QString& deviceId);
+
+    /*! @brief Returns delay before attempt (0 - first retry). random - any random value, used for jitter */
+    static quint64 backoffDelay(int attempt, quint64 initialDelay, quint64 maximumDelay, quint32 random);
+
+signals:
+    /*! @brief Emitted, when device should be opened again */
+    void      reconnectRequested(const QString& deviceId);
+
+    void      stateChanged(const QString& deviceId, ReconnectSupervisor::State state);
+
+private:
+    class Device : public TimerWheel::Client
+    {
+    public:
+        Device(ReconnectSupervisor* supervisor, const QString& id)
+            : p_supervisor(supervisor),m_id(id),m_state(Connected),m_attempt(0),m_connectedAt(0) {}
+
+        ReconnectSupervisor*  p_supervisor;
+        QString               m_id;
+        State                 m_state;
+        int                   m_attempt;
+        quint64               m_connectedAt;
+
+    protected:
+        void  _timerWheelExpired(quint64 now) override   { Q_UNUSED(now); p_supervisor->_retry(this); }
+    };
+
+    Device*   _device(const QString& deviceId);
+    void      _setState(Device* device, State state);
+    void      _retry(Device* device);
+    void      _releaseDevice(Device* device);
+
+    QHash<QString,Device*>  m_devices;
+    bool                    m_enabled;
+    quint64                 m_initialDelay;
+    quint64                 m_maximumDelay;
+
+#ifdef METRICS
+    Counter*                p_attemptsCounter;
+    Counter*                p_reconnectsCounter;
+    Counter*                p_failuresCounter;
+    Gauge*                  p_downGauge;
+#endif //METRICS
+};
+
+#endif // RECONNECTSUPERVISOR_H
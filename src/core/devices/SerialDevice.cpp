@@ -24,12 +24,76 @@
 
 #include <QDebug>
 
+#include "core/cards/CardNormalizer.h"
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <string.h>
+    #include <sys/ioctl.h>
+    #include <termios.h>
+    #include <unistd.h>
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#else
+    #error("Builds for other platforms are not supported")
+#endif
+
+#ifdef TRACING
+    #include "core/tracing/Tracer.h"
+#endif //TRACING
+
+#ifdef METRICS
+    #include "core/metrics/MetricsRegistry.h"
+
+static Gauge* openedDevicesGauge()
+{
+    static Gauge* gauge = metricsRegistry->gauge("rfid_devices_opened","Currently opened devices.",
+                                                 MetricsRegistry::label("bus","serial"));
+    return gauge;
+}
+#endif //METRICS
+
 SerialDevice::SerialDevice(QObject* parent)
-    : QObject(parent)
-{}
+    : QObject(parent),
+    p_baudDetector(nullptr),
+    m_handle(-1),
+    m_rawError(QSerialPort::NoError)
+#ifdef METRICS
+    ,p_keysCounter(nullptr),
+    p_bytesCounter(nullptr),
+    p_errorsCounter(nullptr),
+    p_discardedKeysCounter(nullptr)
+#endif //METRICS
+{
+    _initKeyDecoder();
+}
 SerialDevice::SerialDevice(const QSerialPortInfo& portInfo, QObject* parent)
-    : QObject{parent},m_portInfo(portInfo)
-{}
+    : QObject{parent},
+    m_portInfo(portInfo),
+    p_baudDetector(nullptr),
+    m_handle(-1),
+    m_rawError(QSerialPort::NoError)
+#ifdef METRICS
+    ,p_keysCounter(nullptr),
+    p_bytesCounter(nullptr),
+    p_errorsCounter(nullptr),
+    p_discardedKeysCounter(nullptr)
+#endif //METRICS
+{
+    _initKeyDecoder();
+}
+
+void SerialDevice::_initKeyDecoder()
+{
+    //Most serial readers send the key as one line. Readers, which do not terminate lines, are supported by emitting
+    //whatever was received before the pause.
+    m_keyDecoder.setTerminators(QByteArrayLiteral("\r\n"));
+    m_keyDecoder.setEmitOnTimeout(true);
+
+    connect(&m_keyDecoder,&KeyDecoder::keyDecoded,this,&SerialDevice::_keyDecoded);
+    connect(&m_keyDecoder,&KeyDecoder::keyDiscarded,this,&SerialDevice::_keyDiscarded);
+}
 
 SerialDevice::~SerialDevice()
 {
@@ -37,50 +101,307 @@ SerialDevice::~SerialDevice()
         close();
 }
 
+void SerialDevice::configureSerialPort(const SerialPortConfig& config)
+{
+    m_config = config;
+    config.configureSerialPort(&m_port);
+}
+
 bool SerialDevice::open(QIODevice::OpenMode openMode)
 {
-    m_port.setPort(m_portInfo);
+#ifdef METRICS
+    _registerMetrics();
+#endif //METRICS
 
+    if (m_config.backend() == SerialPortConfig::TermiosBackend)
+        return _openDescriptor(openMode);
+
+    m_port.setPort(m_portInfo);
     if (!m_port.open(openMode)) {
+#ifdef METRICS
+        p_errorsCounter->increment();
+#endif //METRICS
         emit errorOccured(m_port.error());
         return false;
     }
 
+#ifdef METRICS
+    openedDevicesGauge()->add(1);
+#endif //METRICS
+
     connect(&m_port,&QSerialPort::readyRead,this,&SerialDevice::_portReadyRead);
     connect(&m_port,&QSerialPort::errorOccurred,this,&SerialDevice::_portError);
     return true;
 }
 
+bool SerialDevice::_openDescriptor(QIODevice::OpenMode openMode)
+{
+    int flags = O_NOCTTY | O_NONBLOCK | O_CLOEXEC;
+    if ((openMode & QIODevice::ReadWrite) == QIODevice::ReadWrite) {
+        flags |= O_RDWR;
+    } else if (openMode & QIODevice::WriteOnly) {
+        flags |= O_WRONLY;
+    } else {
+        flags |= O_RDONLY;
+    }
+
+    const int handle = ::open(m_portInfo.systemLocation().toLocal8Bit().constData(), flags);
+    if (handle < 0) {
+        _setRawError(errno);
+        return false;
+    }
+
+    //Same as QSerialPort - other processes can not open this port while it is used by us
+    if (ioctl(handle, TIOCEXCL) < 0 || !m_config.configureTermios(handle)
+            || !deviceMultiplexer->addDevice(handle,this,m_config.readBufferSize())) {
+        const int error = errno;
+        ::close(handle);
+        _setRawError(error);
+        return false;
+    }
+
+    m_handle = handle;
+    m_rawError = QSerialPort::NoError;
+    m_rawErrorString.clear();
+
+#ifdef METRICS
+    openedDevicesGauge()->add(1);
+#endif //METRICS
+
+    return true;
+}
+
+void SerialDevice::_setRawError(int error)
+{
+    switch (error) {
+    case ENOENT:
+    case ENODEV:
+        m_rawError = QSerialPort::DeviceNotFoundError;
+        break;
+    case EACCES:
+    case EPERM:
+        m_rawError = QSerialPort::PermissionError;
+        break;
+    case EBUSY:
+        m_rawError = QSerialPort::OpenError;
+        break;
+    case EINVAL:
+        m_rawError = QSerialPort::UnsupportedOperationError;
+        break;
+    case EIO:
+    case ENXIO:
+        m_rawError = QSerialPort::ResourceError;
+        break;
+    default:
+        m_rawError = QSerialPort::UnknownError;
+        break;
+    }
+    m_rawErrorString = QString::fromLocal8Bit(strerror(error));
+
+#ifdef METRICS
+    p_errorsCounter->increment();
+#endif //METRICS
+
+    emit errorOccured(m_rawError);
+}
+
+void SerialDevice::startBaudRateDetection(const QList<QSerialPort::BaudRate>& candidates)
+{
+    Q_ASSERT(isOpened());
+    if (candidates.isEmpty())
+        return;
+
+    delete p_baudDetector;
+    p_baudDetector = new SerialBaudDetector(candidates,this);
+    connect(p_baudDetector,&SerialBaudDetector::candidateChanged,this,&SerialDevice::_applyBaudRate);
+    connect(p_baudDetector,&SerialBaudDetector::baudRateDetected,this,&SerialDevice::_baudRateDetected);
+
+    m_config.setAutodetectBaudRate(true);
+    p_baudDetector->start(KeyEvent::now());
+    _applyBaudRate(p_baudDetector->currentCandidate());
+}
+
+void SerialDevice::_applyBaudRate(QSerialPort::BaudRate rate)
+{
+    m_config.setBaudRate(rate);
+
+    //Bytes, which are waiting in the driver, were received with the previous baud rate
+    bool applied;
+    if (m_handle >= 0) {
+        applied = m_config.configureTermios(m_handle);
+        tcflush(m_handle,TCIFLUSH);
+    } else {
+        applied = m_port.setBaudRate(rate);
+        m_port.clear(QSerialPort::Input);
+    }
+
+    if (applied || p_baudDetector == nullptr)
+        return;
+
+    //Port keeps the previous rate, so frames probed now would be attributed to the wrong candidate
+    qWarning() << "Port "<<m_portInfo.portName()<<" does not accept baud rate "<<rate<<"; candidate skipped";
+    if (p_baudDetector->rejectCandidate(KeyEvent::now()))
+        return;
+
+    qWarning() << "Port "<<m_portInfo.portName()<<" accepts none of baud rate candidates, detection is stopped";
+    p_baudDetector->deleteLater();
+    p_baudDetector = nullptr;
+    m_config.setAutodetectBaudRate(false);
+}
+
+void SerialDevice::_baudRateDetected(QSerialPort::BaudRate rate, const QByteArray& frame, quint64 firstByteTime)
+{
+    qDebug() << "Baud rate of port "<<m_portInfo.portName()<<" detected: "<<rate;
+
+    p_baudDetector->deleteLater();
+    p_baudDetector = nullptr;
+    m_config.setAutodetectBaudRate(false);
+
+    emit baudRateDetected(rate);
+
+    //Frame, which was used for detection, is the key read by the user - so it is not lost
+    m_keyDecoder.feed(frame.constData(),frame.size(),firstByteTime);
+}
+
 void SerialDevice::close()
 {
+    delete p_baudDetector;
+    p_baudDetector = nullptr;
+
+    if (m_handle >= 0) {
+        deviceMultiplexer->removeDevice(m_handle);
+        ::close(m_handle);
+        m_handle = -1;
+#ifdef METRICS
+        openedDevicesGauge()->add(-1);
+#endif //METRICS
+        emit deviceClosed();
+        return;
+    }
+
     disconnect(&m_port,&QSerialPort::readyRead,this,&SerialDevice::_portReadyRead);
     disconnect(&m_port,&QSerialPort::errorOccurred,this,&SerialDevice::_portError);
+#ifdef METRICS
+    if (m_port.isOpen())
+        openedDevicesGauge()->add(-1);
+#endif //METRICS
+
     m_port.close();
     emit deviceClosed();
 }
 
 bool SerialDevice::isOpened() const
 {
-    return m_port.isOpen();
+    return (m_handle >= 0) || m_port.isOpen();
+}
+
+QSerialPort::SerialPortError SerialDevice::error() const
+{
+    return (m_config.backend() == SerialPortConfig::TermiosBackend) ? m_rawError : m_port.error();
+}
+
+QString SerialDevice::errorString() const
+{
+    return (m_config.backend() == SerialPortConfig::TermiosBackend) ? m_rawErrorString : m_port.errorString();
 }
 
 void SerialDevice::_portReadyRead()
 {
-    _processSerialInput(m_port.readAll());
+    const quint64 receiveTime = KeyEvent::now();
+    const QByteArray bytes = m_port.readAll();
+    _processSerialInput(bytes.constData(),bytes.size(),receiveTime);
+}
+
+void SerialDevice::_deviceDataRead(int fd, const char* data, int size)
+{
+    Q_ASSERT(fd == m_handle);
+
+    //Data is passed straight from the buffer of DeviceMultiplexer, without copying
+    _processSerialInput(data,size,KeyEvent::now());
+}
+
+void SerialDevice::_deviceReadFailed(int fd, int error)
+{
+    Q_ASSERT(fd == m_handle);
+
+    qDebug() << "read() call failed for port: "<<m_portInfo.portName()<<"; errno="<<error<<"; strerror(errno)="<<strerror(error);
+
+    //If we have something wrong - close the device. And inform anybody about this
+    close();
+    _setRawError(error);
 }
 
 void SerialDevice::_portError(QSerialPort::SerialPortError error)
 {
+#ifdef METRICS
+    p_errorsCounter->increment();
+#endif //METRICS
+
     //If we have something wrong - close the device
     close();
     //And inform anybody about this
     emit errorOccured(error);
 }
 
-void SerialDevice::_processSerialInput(const QByteArray& bytes)
+void SerialDevice::_processSerialInput(const char* data, int size, quint64 receiveTime)
+{
+#ifdef METRICS
+    p_bytesCounter->increment(size);
+#endif //METRICS
+
+    if (p_baudDetector != nullptr) {
+        p_baudDetector->feed(data,size,receiveTime);
+        return;
+    }
+
+    m_keyDecoder.feed(data,size,receiveTime);
+}
+
+void SerialDevice::_keyDecoded(const char* key, int length, quint64 firstCharacterTime)
+{
+    //Same card is reported in different encodings by different readers, commands see only its canonical form
+    char normalized[KeyEvent::MAX_KEY_LENGTH];
+    const int normalizedLength = cardNormalizer->normalize(key,length,normalized);
+    if (normalizedLength < 0) {
+        qDebug() << "Key with wrong checksum discarded for port: "<<m_portInfo.portName();
+#ifdef METRICS
+        p_discardedKeysCounter->increment();
+#endif //METRICS
+        return;
+    }
+
+#ifdef METRICS
+    p_keysCounter->increment();
+#endif //METRICS
+
+    KeyEvent keyEvent(normalized,normalizedLength,firstCharacterTime,m_portInfo.portName());
+    keyEvent.setDeviceIds(m_portInfo.vendorIdentifier(),m_portInfo.productIdentifier());
+#ifdef TRACING
+    tracer->addSpan(keyEvent,"serial-input",keyEvent.timestamp(),keyEvent.decodedAt());
+#endif //TRACING
+    emit keyFound(keyEvent);
+}
+
+void SerialDevice::_keyDiscarded(KeyDecoder::DiscardReason reason, int length)
+{
+    qDebug() << "Partial key of "<<length<<" characters discarded for port: "<<m_portInfo.portName()<<"; reason="<<reason;
+#ifdef METRICS
+    p_discardedKeysCounter->increment();
+#else
+    Q_UNUSED(reason);
+    Q_UNUSED(length);
+#endif //METRICS
+}
+
+#ifdef METRICS
+void SerialDevice::_registerMetrics()
 {
-    QString key = bytes;
-    key.remove('\r');
-    key.remove('\n');
-    emit keyFound(key);
+    const QString labels = MetricsRegistry::label("bus","serial") + ','
+            + MetricsRegistry::label("device",m_portInfo.portName());
+
+    p_keysCounter = metricsRegistry->counter("rfid_device_keys_total","Keys read by the device.",labels);
+    p_bytesCounter = metricsRegistry->counter("rfid_device_bytes_total","Bytes read from the device.",labels);
+    p_errorsCounter = metricsRegistry->counter("rfid_device_errors_total","Errors of the device.",labels);
+    p_discardedKeysCounter = metricsRegistry->counter("rfid_device_discarded_keys_total","Partially read keys, which were discarded.",labels);
 }
+#endif //METRICS
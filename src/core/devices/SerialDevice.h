@@ -25,14 +25,27 @@
 
 #include <QObject>
 
+#include "./core/KeyEvent.h"
+#include "./core/devices/DeviceMultiplexer.h"
+#include "./core/devices/KeyDecoder.h"
+#include "./core/serial/SerialBaudDetector.h"
 #include "./core/serial/SerialPortConfig.h"
 
+#ifdef METRICS
+    #include "./core/metrics/Metrics.h"
+#endif //METRICS
+
 /*!
  * @class SerialDevice devices/SerialDevice.h
  * @brief Represents an serial device.
+ * @details Depending on SerialPortConfig::backend port is read either by QSerialPort, or port descriptor is opened
+ *          and configured with termios directly and read by DeviceMultiplexer into its reusable buffer.
+ *
+ *          If baud rate of the port is unknown, SerialDevice::startBaudRateDetection switches port between candidate
+ *          baud rates (see SerialBaudDetector) till valid frame is received. This frame is decoded as the usual key.
  */
 
-class SerialDevice : public QObject
+class SerialDevice : public QObject, private DeviceMultiplexer::Handler
 {
     Q_OBJECT
 public:
@@ -45,14 +58,26 @@ public:
     bool isOpened() const;
 
     void setPortInfo(const QSerialPortInfo& portInfo)                { m_portInfo = portInfo; }
-    void configureSerialPort(const SerialPortConfig& config)         { config.configureSerialPort(&m_port); }
+    /*! @brief Sets configuration, which is used on the next SerialDevice::open */
+    void configureSerialPort(const SerialPortConfig& config);
     QSerialPortInfo portInfo() const                                 { return m_portInfo; }
+    SerialPortConfig configuration() const                           { return m_config; }
+
+    /*! @brief Starts detection of the baud rate of opened port. SerialDevice::baudRateDetected is emitted once
+     *         detection is finished */
+    void            startBaudRateDetection(const QList<QSerialPort::BaudRate>& candidates);
+    bool            isDetectingBaudRate() const                      { return p_baudDetector != nullptr; }
 
-    QSerialPort::SerialPortError error() const                       { return m_port.error(); }
-    QString errorString() const                                      { return m_port.errorString(); }
+    /*! @brief Returns decoder, which splits received data into keys */
+    KeyDecoder*     keyDecoder()                                     { return &m_keyDecoder; }
+
+    QSerialPort::SerialPortError error() const;
+    QString errorString() const;
 
 signals:
-    void keyFound(const QString& key);
+    void keyFound(const KeyEvent& keyEvent);
+
+    void baudRateDetected(QSerialPort::BaudRate rate);
 
     void deviceClosed();
     void errorOccured(QSerialPort::SerialPortError error);
@@ -61,13 +86,46 @@ signals:
 protected slots:
     void _portReadyRead();
     void _portError(QSerialPort::SerialPortError error);
+    void _keyDecoded(const char* key, int length, quint64 firstCharacterTime);
+    void _keyDiscarded(KeyDecoder::DiscardReason reason, int length);
+    void _applyBaudRate(QSerialPort::BaudRate rate);
+    void _baudRateDetected(QSerialPort::BaudRate rate, const QByteArray& frame, quint64 firstByteTime);
 
 protected:
-    void  _processSerialInput(const QByteArray& bytes);
+    /*! @brief Processes bytes received at receiveTime (monotonic time, see KeyEvent::now) */
+    void  _processSerialInput(const char* data, int size, quint64 receiveTime);
+
+    void  _deviceDataRead(int fd, const char* data, int size) override;
+    void  _deviceReadFailed(int fd, int error) override;
 
 private:
+    void                _initKeyDecoder();
+
+    /*! @brief Opens port descriptor for TermiosBackend */
+    bool                _openDescriptor(QIODevice::OpenMode openMode);
+
+    /*! @brief Converts errno value to QSerialPort::SerialPortError and emits errorOccured */
+    void                _setRawError(int error);
+
     QSerialPort         m_port;
     QSerialPortInfo     m_portInfo;
+    SerialPortConfig    m_config;
+    KeyDecoder          m_keyDecoder;
+    SerialBaudDetector* p_baudDetector;     //!< @brief Exists only while baud rate is being detected
+
+    int                           m_handle;     //!< @brief Port descriptor of TermiosBackend, -1 if not opened
+    QSerialPort::SerialPortError  m_rawError;
+    QString                       m_rawErrorString;
+
+#ifdef METRICS
+    /*! @brief Per-device metrics are registered when device is opened, as port name is known only then */
+    void                _registerMetrics();
+
+    Counter*            p_keysCounter;
+    Counter*            p_bytesCounter;
+    Counter*            p_errorsCounter;
+    Counter*            p_discardedKeysCounter;
+#endif //METRICS
 };
 
 #endif // SERIALDEVICE_H
@@ -70,6 +70,8 @@ InputDeviceInfo InputDeviceInfo::fromDeviceFileName(const QString& devInputFileN
 
     result.m_deviceFilePath = QString("/dev/input/%1").arg(devInputFileName);
     result.m_deviceName = _readDeviceName(devInputFileName);
+    result.m_physicalLocation = _readDeviceAttribute(devInputFileName,"phys");
+    result.m_uniqueId = _readDeviceAttribute(devInputFileName,"uniq");
 
     return result;
 }
@@ -99,6 +101,11 @@ QString InputDeviceInfo::_readDeviceName(const QString& entry)
     return QString(_readSysFile(QString("/sys/class/input/%1/device/name").arg(entry))).remove(QRegularExpression{R"-((\r\n?|\n))-"});
 }
 
+QString InputDeviceInfo::_readDeviceAttribute(const QString& entry, const char* attribute)
+{
+    return QString::fromUtf8(_readSysFile(QString("/sys/class/input/%1/device/%2").arg(entry,QLatin1String(attribute)))).trimmed();
+}
+
 QByteArray InputDeviceInfo::_readSysFile(const QString& fileName)
 {
     QFile file(fileName);
@@ -111,6 +118,15 @@ QByteArray InputDeviceInfo::_readSysFile(const QString& fileName)
     return result;
 }
 
+bool InputDeviceInfo::isSameDevice(const InputDeviceInfo& other) const
+{
+    return  (m_vendorId                 == other.m_vendorId)          &&
+            (m_productId                == other.m_productId)         &&
+            (m_deviceName               == other.m_deviceName)        &&
+            (m_physicalLocation         == other.m_physicalLocation)  &&
+            (m_uniqueId                 == other.m_uniqueId);
+}
+
 bool operator==(const InputDeviceInfo& lhs, const InputDeviceInfo& rhs)
 {
     return  (lhs.vendorId()             == rhs.vendorId())        &&
@@ -55,10 +55,21 @@ public:
     /*! @brief This method returns device name. Has nothind to do with device file name (linux) */
     QString    deviceName() const                          { return m_deviceName; }
 
+    /*! @brief Physical location of the device (e.g. "usb-0000:00:14.0-2/input0") and its unique id (e.g. serial
+     *         number), if driver reports them */
+    QString    physicalLocation() const                    { return m_physicalLocation; }
+    QString    uniqueId() const                            { return m_uniqueId; }
+
+    /*! @brief Returns true if other describes the same device, probably under another device file. Unlike
+     *         operator==, does not compare device files - they are reused by other devices after detaching */
+    bool       isSameDevice(const InputDeviceInfo& other) const;
+
 private:
     VendorId   m_vendorId;
     ProductId  m_productId;
     QString    m_deviceName;
+    QString    m_physicalLocation;
+    QString    m_uniqueId;
 
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
 //
@@ -89,6 +100,7 @@ private:
     static bool              _hasProductId(const QString& entry);
     static ProductId         _readProductId(const QString& entry);
     static QString           _readDeviceName(const QString& entry);
+    static QString           _readDeviceAttribute(const QString& entry, const char* attribute);
 
 #elif defined(Q_OS_LINUX) && defined(Q_OS_ANDROID)
     #error("Android builds currently not supported")#if defined(Q_OS_LINUX)
@@ -22,31 +22,50 @@
 
 #include "InputDeviceManager.h"
 
+#include <QtConcurrent>
+
+#include "core/StartupProfiler.h"
+
 InputDeviceManager::InputDeviceManager(QObject *parent)
-    : QObject{parent}
+    : QObject{parent},
+    m_reconnectSupervisor("hid")
 {
+    connect(&m_reconnectSupervisor,&ReconnectSupervisor::reconnectRequested,this,&InputDeviceManager::_reconnectInputDevice);
+
     connect(&m_inputDeviceWatcher,&InputDeviceWatcher::deviceWasAttached,this,&InputDeviceManager::_handleAttachedInputDevice);
     connect(&m_inputDeviceWatcher,&InputDeviceWatcher::deviceWasDetached,this,&InputDeviceManager::_handleDetachedInputDevice);
+
+    connect(&m_probeWatcher,&QFutureWatcher<InputDevice::ProbeResult>::resultReadyAt,this,&InputDeviceManager::_inputDeviceProbed);
+    connect(&m_probeWatcher,&QFutureWatcher<InputDevice::ProbeResult>::finished,this,&InputDeviceManager::_initialProbingFinished);
+}
+
+InputDeviceManager::~InputDeviceManager()
+{
+    m_probeWatcher.waitForFinished();
 }
 
 void InputDeviceManager::start()
 {
-    //Automatically connect all devices, which are matching autoconnect criteria
-    if (inputDeviceManagerSettings->inputDeviceAutoconnection()) {   //If autoconnect enabled
+    reconnectSettings->configureReconnectSupervisor(&m_reconnectSupervisor);
 
-        //Go through attached device list and connect enything which is fitting autoconnect rules
+    //Collect all devices, which are matching autoconnect criteria
+    InputDeviceInfoList candidates;
+    if (inputDeviceManagerSettings->inputDeviceAutoconnection()) {   //If autoconnect enabled
         for (const InputDeviceInfo& deviceInfo : m_inputDeviceWatcher.availableDevices()) {
-            if (!inputDeviceManagerSettings->inputDeviceFilter().isMatching(deviceInfo)) {
-                continue;
-            }
-
-            if (_tryOpeningInputDevice(deviceInfo)) {
-                emit inputDeviceWasOpened(deviceInfo);
-            }
+            if (inputDeviceManagerSettings->inputDeviceFilter().isMatching(deviceInfo))
+                candidates.append(deviceInfo);
         }
     }
 
-    m_inputDeviceWatcher.start();
+    if (candidates.isEmpty()) {
+        _initialProbingFinished();
+        return;
+    }
+
+    //open() and EVIOCGRAB can block for a while on some devices, so all candidates are opened in parallel on worker
+    //threads. Each opened device is attached (see _inputDeviceProbed) as soon as it is ready.
+    startupProfiler->mark(QString("HID probing started (%1 devices)").arg(candidates.count()));
+    m_probeWatcher.setFuture(QtConcurrent::mapped(candidates,&InputDeviceManager::_probeInputDevice));
 }
 
 InputDeviceInfoList InputDeviceManager::openedInputDevices() const
@@ -85,6 +104,10 @@ void InputDeviceManager::inputDeviceOpeningRequested(const InputDeviceInfo& devi
 
 void InputDeviceManager::inputDeviceClosureRequested(const InputDeviceInfo& deviceDetails)
 {
+    //Device closed by the user should stay closed
+    m_reconnectSupervisor.forgetDevice(deviceDetails.deviceFilePath());
+    m_supervisedDevices.remove(deviceDetails.deviceFilePath());
+
     for (InputDevice* device : m_openedInputDevices) {
         if (device->deviceInfo() == deviceDetails) {
             device->close();
@@ -96,6 +119,11 @@ void InputDeviceManager::inputDeviceClosureRequested(const InputDeviceInfo& devi
 void InputDeviceManager::_handleAttachedInputDevice(const InputDeviceInfo& deviceDetails)
 {
     //This method is invoked when new device is connected to the computer
+    if (_isSupervised(deviceDetails)) {                                        //If device has failed or was detached
+        m_reconnectSupervisor.deviceAttached(deviceDetails.deviceFilePath());  //Reopen it (and inform user there)
+        return;
+    }
+
     if (!inputDeviceManagerSettings->inputDeviceAutoconnection()) {   //If autoconnect disabled
         emit inputDeviceWasAttached(deviceDetails);   //Just inform user about new device
         return;
@@ -116,6 +144,7 @@ void InputDeviceManager::_handleAttachedInputDevice(const InputDeviceInfo& devic
 
 void InputDeviceManager::_handleDetachedInputDevice(const InputDeviceInfo& deviceDetails)
 {
+    m_reconnectSupervisor.deviceDetached(deviceDetails.deviceFilePath());
     emit inputDeviceWasDetached(deviceDetails);
 }
 
@@ -130,6 +159,24 @@ void InputDeviceManager::_handleClosedInputDevice()
     device->deleteLater();
 }
 
+void InputDeviceManager::_inputDeviceProbed(int index)
+{
+    const InputDevice::ProbeResult probeResult = m_probeWatcher.resultAt(index);
+    if (_attachInputDevice(probeResult)) {
+        startupProfiler->mark(QString("HID device %1 opened").arg(probeResult.deviceInfo.deviceFileName()));
+        emit inputDeviceWasOpened(probeResult.deviceInfo);
+    }
+}
+
+void InputDeviceManager::_initialProbingFinished()
+{
+    //Hotplug monitoring is started only now, so that devices being probed are not opened twice
+    m_inputDeviceWatcher.start();
+
+    startupProfiler->mark("HID devices ready");
+    emit started();
+}
+
 void InputDeviceManager::_inputDeviceErrorOccured(InputDevice::InputDeviceError error)
 {
     //Some device error happened
@@ -139,15 +186,66 @@ void InputDeviceManager::_inputDeviceErrorOccured(InputDevice::InputDeviceError
     if (error == InputDevice::NoError)
         return;
 
+    //Device stays opened after overflow, in all other cases it is closed and should be reopened later
+    if (error != InputDevice::BufferOverflowError)
+        m_reconnectSupervisor.deviceFailed(device->deviceInfo().deviceFilePath());
+
     emit errorMessage(_getInputErrorMessage(error,device->deviceInfo()));
 }
 
+void InputDeviceManager::_reconnectInputDevice(const QString& deviceFilePath)
+{
+    //Device could be opened by the user meanwhile
+    for (InputDevice* device : qAsConst(m_openedInputDevices)) {
+        if (device->deviceInfo().deviceFilePath() == deviceFilePath) {
+            m_reconnectSupervisor.deviceConnected(deviceFilePath);
+            return;
+        }
+    }
+
+    //File could be taken by another device meanwhile. Missing file is not checked - probing it fails
+    const InputDeviceInfo deviceDetails = m_supervisedDevices.value(deviceFilePath);
+    const InputDeviceInfo currentDetails = InputDeviceInfo::fromDeviceFileName(deviceDetails.deviceFileName());
+    if (currentDetails.isValid() && !_isSupervised(currentDetails))
+        return;
+
+    if (!_attachInputDevice(_probeInputDevice(deviceDetails),false)) {
+        m_reconnectSupervisor.deviceFailed(deviceFilePath);
+        return;
+    }
+
+    emit inputDeviceWasOpened(deviceDetails);
+}
+
+bool InputDeviceManager::_isSupervised(const InputDeviceInfo& deviceDetails)
+{
+    const QString deviceFilePath = deviceDetails.deviceFilePath();
+    if (!m_reconnectSupervisor.isSupervised(deviceFilePath))
+        return false;
+
+    if (m_supervisedDevices.value(deviceFilePath).isSameDevice(deviceDetails))
+        return true;
+
+    qDebug() << "Device "<<deviceDetails<<" has taken file of supervised device, which is not reconnected anymore";
+    m_reconnectSupervisor.forgetDevice(deviceFilePath);
+    m_supervisedDevices.remove(deviceFilePath);
+    return false;
+}
+
 bool InputDeviceManager::_tryOpeningInputDevice(const InputDeviceInfo& deviceDetails)
 {
+    return _attachInputDevice(_probeInputDevice(deviceDetails));
+}
+
+bool InputDeviceManager::_attachInputDevice(const InputDevice::ProbeResult& probeResult, bool reportErrors)
+{
+    const InputDeviceInfo& deviceDetails = probeResult.deviceInfo;
     InputDevice* device = new InputDevice(deviceDetails);
-    if (!device->open(InputDevice::ReadOnly)) {
+    decoderSettings->configureKeyDecoder(device->keyDecoder());
+    if (!device->open(probeResult)) {
         qDebug() << "Device "<<deviceDetails<<" opening failed. Reason: "<<device->errorString();
-        emit errorMessage(_getInputErrorMessage(device->error(),device->deviceInfo()));
+        if (reportErrors)
+            emit errorMessage(_getInputErrorMessage(device->error(),device->deviceInfo()));
         device->deleteLater();
         return false;
     }
@@ -157,9 +255,17 @@ bool InputDeviceManager::_tryOpeningInputDevice(const InputDeviceInfo& deviceDet
     connect(device,&InputDevice::errorOccured,this,&InputDeviceManager::_inputDeviceErrorOccured);
     connect(device,&InputDevice::keyFound,this,&InputDeviceManager::keyFound);
     m_openedInputDevices.append(device);
+
+    m_supervisedDevices.insert(deviceDetails.deviceFilePath(),deviceDetails);
+    m_reconnectSupervisor.deviceConnected(deviceDetails.deviceFilePath());
     return true;
 }
 
+InputDevice::ProbeResult InputDeviceManager::_probeInputDevice(const InputDeviceInfo& deviceInfo)
+{
+    return InputDevice::probe(deviceInfo,InputDevice::ReadOnly);
+}
+
 QString InputDeviceManager::_getInputErrorMessage(InputDevice::InputDeviceError error,const InputDeviceInfo& deviceDetails)
 {
     switch (error) {
@@ -171,6 +277,8 @@ QString InputDeviceManager::_getInputErrorMessage(InputDevice::InputDeviceError
         return tr("Device %1 not found anymore").arg(deviceDetails.deviceFilePath());
     case InputDevice::DeviceIsBusy:
         return tr("Device %1 is busy").arg(deviceDetails.deviceFilePath());
+    case InputDevice::BufferOverflowError:
+        return tr("Input events of device %1 were dropped by kernel, partial key discarded").arg(deviceDetails.deviceFilePath());
     case InputDevice::UnknownError:
         return tr("Unknown error with device %1").arg(deviceDetails.deviceFilePath());
     }
@@ -24,15 +24,20 @@
 #define INPUTDEVICEMANAGER_H
 
 #include <QObject>
+#include <QFutureWatcher>
 
 #include "./InputDeviceFilter.h"
 #include "./InputDeviceWatcher.h"
+#include "./appconfig/DecoderSettings.h"
 #include "./appconfig/InputDeviceManagerSettings.h"
+#include "./appconfig/ReconnectSettings.h"
 #include "./core/devices/InputDevice.h"
+#include "./core/devices/ReconnectSupervisor.h"
 
 /*!
  *  @class InputDeviceManager core/input/InputDeviceManager.h
  *  @brief This class is responsible for handling HID devices (manual opening, closure, autoconnection, etc.
+ *  @details Devices closed because of errors are reopened by ReconnectSupervisor, devices closed by the user are not.
  */
 
 class InputDeviceManager : public QObject
@@ -40,9 +45,11 @@ class InputDeviceManager : public QObject
     Q_OBJECT
 public:
     explicit InputDeviceManager(QObject *parent = nullptr);
-    ~InputDeviceManager() {}
+    ~InputDeviceManager();
 
 public:
+    /*! @brief Starts monitoring of HID devices. Devices matching autoconnect criteria are opened in parallel on
+     *         worker threads, InputDeviceManager::started is emitted when all of them are processed. */
     void                start();
     void                stop()                                  { m_inputDeviceWatcher.stop(); }
     void                updateInputDeviceList()                 { m_inputDeviceWatcher.updateDeviceList(); }
@@ -58,8 +65,11 @@ public:
     void                appendInputDeviceFilter(const InputDeviceFilter& sourceFilter);
 
 signals:
+    /*! @brief This signal is emitted when devices matching autoconnect criteria were opened after start() */
+    void started();
+
     /*! @brief This signal is emitted when any of the connected devices has read any key/tag/etc. */
-    void keyFound(const QString& key);
+    void keyFound(const KeyEvent& keyEvent);
 
     /*! @brief This signal is emitted when any error has happeded. Contains description of the error in human-readable
      *         form. */
@@ -83,12 +93,27 @@ private slots:
     void _handleDetachedInputDevice(const InputDeviceInfo& deviceDetails);
     void _handleClosedInputDevice();
     void _inputDeviceErrorOccured(InputDevice::InputDeviceError error);
+    void _inputDeviceProbed(int index);
+    void _initialProbingFinished();
+    void _reconnectInputDevice(const QString& deviceFilePath);
 
 private:
     InputDeviceWatcher            m_inputDeviceWatcher;
     QList<InputDevice*>           m_openedInputDevices;
+    QFutureWatcher<InputDevice::ProbeResult> m_probeWatcher;
+    ReconnectSupervisor           m_reconnectSupervisor;
+    QHash<QString,InputDeviceInfo> m_supervisedDevices;  //!< @brief Devices, which were opened, by file path
+
     bool _tryOpeningInputDevice(const InputDeviceInfo& portInfo);
 
+    /*! @brief Returns true if deviceDetails is supervised device. If its file is supervised, but belongs to another
+     *         device now - supervised device is forgotten, so the other device is not grabbed by reconnection */
+    bool _isSupervised(const InputDeviceInfo& deviceDetails);
+    /*! @brief If reportErrors is false - failure is not reported with errorMessage (e.g. for reconnection attempts) */
+    bool _attachInputDevice(const InputDevice::ProbeResult& probeResult, bool reportErrors = true);
+
+    static InputDevice::ProbeResult _probeInputDevice(const InputDeviceInfo& deviceInfo);
+
     static QString _getInputErrorMessage(InputDevice::InputDeviceError error,const InputDeviceInfo& deviceDetails);
 };
 
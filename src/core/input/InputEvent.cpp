@@ -32,6 +32,7 @@ InputEvent::InputEvent(const input_event& event)
     m_type   = _typeFromInt(event.type);
     m_code   = event.code;
     m_value  = event.value;
+    m_timestamp = quint64(event.input_event_sec) * 1000000000ull + quint64(event.input_event_usec) * 1000ull;
 }
 
 InputEvent::Type InputEvent::_typeFromInt(quint8 value)
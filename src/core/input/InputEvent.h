@@ -73,11 +73,16 @@ public:
     char    charCode() const                               { return _codeToChar(m_code); }
     qint8   value() const                                  { return m_value; }
 
+    /*! @brief Returns kernel timestamp of this event in nanoseconds. By default kernel uses CLOCK_REALTIME, unless
+     *         other clock was selected with EVIOCSCLOCKID (see InputDevice::probe) */
+    quint64 timestamp() const                              { return m_timestamp; }
+
 private:
     InputEvent() =delete;
     Type m_type;
     quint8 m_code;
     qint8  m_value;
+    quint64 m_timestamp;
 
     static Type _typeFromInt(quint8 value);
     static char _codeToChar(quint8 code);
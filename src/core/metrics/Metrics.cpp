@@ -0,0 +1,62 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Metrics.h"
+
+quint64 Histogram::count() const
+{
+    quint64 result = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        result += bucketCount(i);
+
+    return result;
+}
+
+quint64 Histogram::quantile(double fraction) const
+{
+    const quint64 total = count();
+    if (total == 0)
+        return 0;
+
+    const quint64 target = qMax<quint64>(1,quint64(qBound(0.0,fraction,1.0) * total));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += bucketCount(i);
+        if (seen >= target)
+            return bucketLowerBound(i);
+    }
+
+    return bucketLowerBound(BUCKET_COUNT - 1);
+}
+
+quint64 Histogram::bucketLowerBound(int index)
+{
+    Q_ASSERT(index >= 0 && index < BUCKET_COUNT);
+
+    if (index < SUB_BUCKET_COUNT)
+        return quint64(index);
+
+    const int group = index / SUB_BUCKET_COUNT;
+    const int subBucket = index % SUB_BUCKET_COUNT;
+    const int msb = group + SUB_BUCKET_BITS - 1;
+    return quint64(SUB_BUCKET_COUNT + subBucket) << (msb - SUB_BUCKET_BITS);
+}
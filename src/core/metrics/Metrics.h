@@ -0,0 +1,177 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+#include <atomic>
+#include <chrono>
+
+/*!
+ *  @file core/metrics/Metrics.h
+ *  @brief Metric primitives, which are updated from hot paths of the application. Updates are lock-free and are not
+ *         allocating memory. Objects of these classes are owned by MetricsRegistry.
+ */
+
+namespace Metrics {
+
+/*! @brief Size of the cache line. Shards of the counters are aligned to it to avoid false sharing */
+static constexpr int CACHE_LINE_SIZE = 64;
+
+/*! @brief Returns current value of the monotonic clock in nanoseconds */
+inline quint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace Metrics
+
+/*!
+ *  @class Counter core/metrics/Metrics.h
+ *  @brief Monotonically increasing counter. Value is split between several shards, each thread is updating its own
+ *         shard, so concurrent updates are not contending for one cache line.
+ */
+
+class Counter
+{
+public:
+    static constexpr int SHARD_COUNT = 8;
+
+    Counter() {}
+
+    void      increment(quint64 value = 1)  { m_shards[_shardIndex()].value.fetch_add(value,std::memory_order_relaxed); }
+
+    /*! @brief Returns sum of all shards. Value can be slightly outdated if counter is updated concurrently */
+    quint64   value() const {
+        quint64 result = 0;
+        for (int i = 0; i < SHARD_COUNT; i++)
+            result += m_shards[i].value.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    Q_DISABLE_COPY(Counter)
+
+    /*! @brief Each thread gets its shard index once, when it updates any counter for the first time */
+    static int _shardIndex() {
+        static std::atomic<int> nextShard{0};
+        thread_local const int shard = nextShard.fetch_add(1,std::memory_order_relaxed) % SHARD_COUNT;
+        return shard;
+    }
+
+    struct alignas(Metrics::CACHE_LINE_SIZE) Shard {
+        std::atomic<quint64> value{0};
+    };
+    Shard     m_shards[SHARD_COUNT];
+};
+
+/*!
+ *  @class Gauge core/metrics/Metrics.h
+ *  @brief Value, which can go up and down (e.g. number of opened devices).
+ */
+
+class Gauge
+{
+public:
+    Gauge() {}
+
+    void      set(qint64 value)             { m_value.store(value,std::memory_order_relaxed); }
+    void      add(qint64 delta)             { m_value.fetch_add(delta,std::memory_order_relaxed); }
+    qint64    value() const                 { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    Q_DISABLE_COPY(Gauge)
+    alignas(Metrics::CACHE_LINE_SIZE) std::atomic<qint64> m_value{0};
+};
+
+/*!
+ *  @class Histogram core/metrics/Metrics.h
+ *  @brief Histogram of durations in nanoseconds with log-linear buckets (similar to HdrHistogram).
+ *  @details Every power of two range is split into SUB_BUCKET_COUNT linear buckets, so relative error of recorded
+ *           value is not larger than 1/SUB_BUCKET_COUNT for any value from 0 to 2^64-1. Bucket index is calculated
+ *           with few shifts, so recording value is one relaxed atomic increment of the bucket and of the sum.
+ */
+
+class Histogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    Histogram() {}
+
+    void      record(quint64 value) {
+        m_buckets[bucketIndex(value)].fetch_add(1,std::memory_order_relaxed);
+        m_sum.fetch_add(value,std::memory_order_relaxed);
+    }
+
+    quint64   bucketCount(int index) const  { return m_buckets[index].load(std::memory_order_relaxed); }
+    quint64   sum() const                   { return m_sum.load(std::memory_order_relaxed); }
+    quint64   count() const;
+
+    /*! @brief Returns approximate value (lower bound of the bucket) below which specified fraction of values falls */
+    quint64   quantile(double fraction) const;
+
+    /*! @brief Returns index of the bucket, where value will be placed */
+    static int bucketIndex(quint64 value) {
+        if (value < SUB_BUCKET_COUNT)
+            return int(value);
+
+        const int msb = 63 - qCountLeadingZeroBits(value);
+        const int group = msb - SUB_BUCKET_BITS + 1;
+        const int subBucket = int(value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+        return group * SUB_BUCKET_COUNT + subBucket;
+    }
+
+    /*! @brief Returns the smallest value, which will be placed to bucket with specified index */
+    static quint64 bucketLowerBound(int index);
+
+private:
+    Q_DISABLE_COPY(Histogram)
+    std::atomic<quint64>  m_buckets[BUCKET_COUNT] = {};
+    std::atomic<quint64>  m_sum{0};
+};
+
+/*!
+ *  @class ScopedDuration core/metrics/Metrics.h
+ *  @brief Records time spent in the current scope to the specified Histogram.
+ */
+
+class ScopedDuration
+{
+public:
+    explicit ScopedDuration(Histogram* histogram)
+        : p_histogram(histogram),m_start(Metrics::now()) {}
+    ~ScopedDuration()                       { p_histogram->record(Metrics::now() - m_start); }
+
+private:
+    Q_DISABLE_COPY(ScopedDuration)
+    Histogram*  p_histogram;
+    quint64     m_start;
+};
+
+#endif // METRICS_H
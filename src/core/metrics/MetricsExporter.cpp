@@ -0,0 +1,75 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MetricsExporter.h"
+
+#include <QDebug>
+#include <QSaveFile>
+
+#include "appconfig/MetricsSettings.h"
+#include "MetricsRegistry.h"
+
+MetricsExporter::MetricsExporter(QObject* parent)
+    : QObject{parent}
+{
+    connect(&m_exportTimer,&QTimer::timeout,this,&MetricsExporter::exportMetrics);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    //Final values are also exported
+    if (m_exportTimer.isActive())
+        exportMetrics();
+}
+
+void MetricsExporter::start()
+{
+    m_fileName = metricsSettings->metricsFile();
+    if (m_fileName.isEmpty())
+        return;
+
+    m_exportTimer.start(metricsSettings->metricsExportInterval() * 1000);
+    exportMetrics();
+}
+
+void MetricsExporter::exportMetrics()
+{
+    if (m_fileName.isEmpty())
+        return;
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Can not open metrics file "<<m_fileName<<": "<<file.errorString();
+        m_exportTimer.stop();
+        emit errorMessage(tr("Error opening metrics file %1 for writing. Error string: %2")
+                          .arg(m_fileName).arg(file.errorString()));
+        return;
+    }
+
+    file.write(metricsRegistry->toPrometheusText());
+    if (!file.commit()) {
+        qDebug() << "Can not write metrics file "<<m_fileName<<": "<<file.errorString();
+        m_exportTimer.stop();
+        emit errorMessage(tr("Error writing metrics file %1. Error string: %2")
+                          .arg(m_fileName).arg(file.errorString()));
+    }
+}
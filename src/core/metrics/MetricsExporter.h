@@ -0,0 +1,59 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QTimer>
+
+/*!
+ *  @class MetricsExporter core/metrics/MetricsExporter.h
+ *  @brief This class periodically writes content of MetricsRegistry to the file configured in MetricsSettings.
+ *  @details File is replaced atomically, so it can be read by node_exporter textfile collector or by any other
+ *           tool at any moment.
+ */
+
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsExporter(QObject* parent = nullptr);
+    ~MetricsExporter();
+
+    /*! @brief Starts periodic export. Does nothing if metrics file is not configured */
+    void start();
+
+public slots:
+    /*! @brief Writes current values of metrics to the metrics file */
+    void exportMetrics();
+
+signals:
+    /*! @brief This signal is emitted when metrics file can not be written */
+    void errorMessage(const QString& errorMessage);
+
+private:
+    QTimer      m_exportTimer;
+    QString     m_fileName;
+};
+
+#endif // METRICSEXPORTER_H
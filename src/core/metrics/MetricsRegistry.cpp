@@ -0,0 +1,177 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MetricsRegistry.h"
+
+#include <QMutexLocker>
+
+MetricsRegistry::~MetricsRegistry()
+{
+    for (Family* family : qAsConst(m_families)) {
+        for (const Entry& entry : qAsConst(family->entries)) {
+            switch (family->type) {
+            case CounterMetric:
+                delete static_cast<Counter*>(entry.metric);
+                break;
+            case GaugeMetric:
+                delete static_cast<Gauge*>(entry.metric);
+                break;
+            case HistogramMetric:
+                delete static_cast<Histogram*>(entry.metric);
+                break;
+            }
+        }
+        delete family;
+    }
+}
+
+Counter* MetricsRegistry::counter(const QString& name, const QString& help, const QString& labels)
+{
+    return static_cast<Counter*>(_metric(CounterMetric,name,help,labels));
+}
+
+Gauge* MetricsRegistry::gauge(const QString& name, const QString& help, const QString& labels)
+{
+    return static_cast<Gauge*>(_metric(GaugeMetric,name,help,labels));
+}
+
+Histogram* MetricsRegistry::histogram(const QString& name, const QString& help, const QString& labels)
+{
+    return static_cast<Histogram*>(_metric(HistogramMetric,name,help,labels));
+}
+
+QString MetricsRegistry::label(const QString& name, const QString& value)
+{
+    QString escaped = value;
+    escaped.replace('\\',QLatin1String("\\\\"));
+    escaped.replace('"',QLatin1String("\\\""));
+    escaped.replace('\n',QLatin1String("\\n"));
+
+    return QString("%1=\"%2\"").arg(name,escaped);
+}
+
+QByteArray MetricsRegistry::toPrometheusText() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray output;
+    for (const Family* family : m_families) {
+        output.append("# HELP ").append(family->name.toUtf8()).append(' ').append(family->help.toUtf8()).append('\n');
+        output.append("# TYPE ").append(family->name.toUtf8()).append(' ');
+        switch (family->type) {
+        case CounterMetric:   output.append("counter\n");   break;
+        case GaugeMetric:     output.append("gauge\n");     break;
+        case HistogramMetric: output.append("histogram\n"); break;
+        }
+
+        for (const Entry& entry : family->entries) {
+            if (family->type == HistogramMetric) {
+                _writeHistogram(output,family,entry);
+                continue;
+            }
+
+            output.append(family->name.toUtf8());
+            if (!entry.labels.isEmpty())
+                output.append('{').append(entry.labels.toUtf8()).append('}');
+            output.append(' ');
+
+            if (family->type == CounterMetric)
+                output.append(QByteArray::number(static_cast<Counter*>(entry.metric)->value()));
+            else
+                output.append(QByteArray::number(static_cast<Gauge*>(entry.metric)->value()));
+            output.append('\n');
+        }
+    }
+
+    return output;
+}
+
+void* MetricsRegistry::_metric(MetricType type, const QString& name, const QString& help, const QString& labels)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Family* family = m_familiesByName.value(name,nullptr);
+    if (family == nullptr) {
+        family = new Family{name,help,type,{}};
+        m_families.append(family);
+        m_familiesByName.insert(name,family);
+    }
+    Q_ASSERT(family->type == type);
+
+    for (const Entry& entry : qAsConst(family->entries)) {
+        if (entry.labels == labels)
+            return entry.metric;
+    }
+
+    void* metric = nullptr;
+    switch (type) {
+    case CounterMetric:
+        metric = new Counter;
+        break;
+    case GaugeMetric:
+        metric = new Gauge;
+        break;
+    case HistogramMetric:
+        metric = new Histogram;
+        break;
+    }
+
+    family->entries.append({labels,metric});
+    return metric;
+}
+
+void MetricsRegistry::_writeHistogram(QByteArray& output, const Family* family, const Entry& entry)
+{
+    const Histogram* histogram = static_cast<Histogram*>(entry.metric);
+    const QByteArray name = family->name.toUtf8();
+    const QByteArray labels = entry.labels.isEmpty() ? QByteArray() : entry.labels.toUtf8().append(',');
+
+    //Fine-grained buckets are merged by powers of two and every histogram exports the same bounds (from ~1 us
+    //to ~137 s), so the set of series never changes between scrapes, as histogram_quantile() and rate() expect
+    static const int FIRST_EXPORTED_BIT = 10;
+    static const int LAST_EXPORTED_BIT = 37;
+
+    quint64 cumulativeCount = 0;
+    int bucket = 0;
+    for (int bit = FIRST_EXPORTED_BIT; bit <= LAST_EXPORTED_BIT; bit++) {
+        //Recorded values are integer nanoseconds, so the largest value of the bucket is inclusive "le" bound
+        const quint64 upperBound = (Q_UINT64_C(1) << bit) - 1;
+        const int lastBucket = Histogram::bucketIndex(upperBound);
+        for (; bucket <= lastBucket; bucket++)
+            cumulativeCount += histogram->bucketCount(bucket);
+
+        output.append(name).append("_bucket{").append(labels).append("le=\"")
+              .append(QByteArray::number(double(upperBound) / 1e9,'g',9)).append("\"} ")
+              .append(QByteArray::number(cumulativeCount)).append('\n');
+    }
+    for (; bucket < Histogram::BUCKET_COUNT; bucket++)
+        cumulativeCount += histogram->bucketCount(bucket);
+
+    output.append(name).append("_bucket{").append(labels).append("le=\"+Inf\"} ")
+          .append(QByteArray::number(cumulativeCount)).append('\n');
+
+    const QByteArray plainLabels = entry.labels.isEmpty() ? QByteArray() : '{' + entry.labels.toUtf8() + '}';
+    output.append(name).append("_sum").append(plainLabels).append(' ')
+          .append(QByteArray::number(double(histogram->sum()) / 1e9,'g',12)).append('\n');
+    output.append(name).append("_count").append(plainLabels).append(' ')
+          .append(QByteArray::number(cumulativeCount)).append('\n');
+}
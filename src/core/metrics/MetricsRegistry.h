@@ -0,0 +1,94 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include "Metrics.h"
+
+/*!
+ *  @class MetricsRegistry core/metrics/MetricsRegistry.h
+ *  @brief This class owns all metrics of the application and serializes them to Prometheus text format.
+ *  @details Metrics are registered once (e.g. in constructors or when device is opened) and are never deleted
+ *           before application exits, so code parts can keep pointers to them and update them without any lookups.
+ *           Registering metric with the same name and labels returns already existing object.
+ */
+
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry* get() {
+        static MetricsRegistry theOne;
+        return &theOne;
+    }
+    ~MetricsRegistry();
+
+    Counter*     counter(const QString& name, const QString& help, const QString& labels = QString());
+    Gauge*       gauge(const QString& name, const QString& help, const QString& labels = QString());
+
+    /*! @brief Histograms are recording nanoseconds, but are exported in seconds (as Prometheus recommends) */
+    Histogram*   histogram(const QString& name, const QString& help, const QString& labels = QString());
+
+    /*! @brief Returns labels string in form of name="value" with escaped value. Several labels can be joined
+     *         by comma. */
+    static QString label(const QString& name, const QString& value);
+
+    /*! @brief Returns current values of all metrics in Prometheus text exposition format */
+    QByteArray   toPrometheusText() const;
+
+private:
+    MetricsRegistry() {}
+    Q_DISABLE_COPY(MetricsRegistry)
+
+    enum MetricType {
+        CounterMetric,
+        GaugeMetric,
+        HistogramMetric
+    };
+
+    struct Entry {
+        QString      labels;
+        void*        metric;
+    };
+
+    struct Family {
+        QString      name;
+        QString      help;
+        MetricType   type;
+        QList<Entry> entries;
+    };
+
+    void*        _metric(MetricType type, const QString& name, const QString& help, const QString& labels);
+    static void  _writeHistogram(QByteArray& output, const Family* family, const Entry& entry);
+
+    mutable QMutex           m_mutex;
+    QList<Family*>           m_families;
+    QHash<QString,Family*>   m_familiesByName;
+};
+#define metricsRegistry MetricsRegistry::get()
+
+#endif // METRICSREGISTRY_H
@@ -38,7 +38,7 @@ void NfcManager::stop()
 
 void NfcManager::_nfcTargetDetected(QNearFieldTarget* target)
 {
-    emit keyFound(target->uid());
+    emit keyFound(KeyEvent(target->uid(),KeyEvent::now()));
 
     target->deleteLater();
 }
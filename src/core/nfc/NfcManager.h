@@ -28,6 +28,8 @@
 #include <QNearFieldManager>
 #include <QNearFieldTarget>
 
+#include "core/KeyEvent.h"
+
 class NfcManager : public QObject
 {
     Q_OBJECT
@@ -41,7 +43,7 @@ public:
     void stop();
 
 signals:
-    void keyFound(const QString& key);
+    void keyFound(const KeyEvent& keyEvent);
     void errorMessage(const QString& errorMessage);
 
 private slots:
@@ -0,0 +1,238 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SerialBaudDetector.h"
+
+//Frame can not reach VALID_PERCENT anymore, if it has more invalid bytes than this
+static const int MAX_INVALID_BYTES =
+        (SerialBaudDetector::MAX_FRAME_LENGTH * (100 - SerialBaudDetector::VALID_PERCENT)) / 100;
+
+SerialBaudDetector::SerialBaudDetector(const QList<QSerialPort::BaudRate>& candidates, QObject* parent)
+    : QObject(parent),
+    m_candidates(candidates),
+    m_current(0),
+    m_attempt(0),
+    m_length(0),
+    m_invalidCount(0),
+    m_synchronized(false),
+    m_firstByteTime(0),
+    m_lastByteTime(0),
+    m_candidateStartTime(0),
+    m_finished(true)
+{
+    Q_ASSERT(!m_candidates.isEmpty());
+}
+
+QSerialPort::BaudRate SerialBaudDetector::currentCandidate() const
+{
+    return m_candidates.isEmpty() ? QSerialPort::UnknownBaud : m_candidates.at(m_current);
+}
+
+void SerialBaudDetector::start(quint64 now)
+{
+    m_current = 0;
+    m_finished = false;
+    _resetCandidate(now);
+}
+
+void SerialBaudDetector::feed(const char* data, int size, quint64 time)
+{
+    if (m_finished)
+        return;
+
+    //Bytes following the switch of the candidate were received at the previous baud rate, so they are dropped
+    const quint32 attempt = m_attempt;
+    for (int i = 0; i < size; i++) {
+        _processByte(data[i],time);
+        if (m_finished || m_attempt != attempt)
+            return;
+    }
+
+    _schedule();
+}
+
+bool SerialBaudDetector::rejectCandidate(quint64 now)
+{
+    Q_ASSERT(!m_finished);
+
+    m_candidates.removeAt(m_current);
+    if (m_candidates.isEmpty()) {
+        m_finished = true;
+        timerWheel->cancel(this);
+        return false;
+    }
+
+    //The next candidate took place of the removed one
+    if (m_current == m_candidates.count())
+        m_current = 0;
+    m_attempt++;
+    _resetCandidate(now);
+
+    emit candidateChanged(currentCandidate());
+    return true;
+}
+
+int SerialBaudDetector::frameScore(const char* data, int size)
+{
+    if (size <= 0)
+        return 0;
+
+    int valid = 0;
+    for (int i = 0; i < size; i++) {
+        if (_isValidByte(data[i]))
+            valid++;
+    }
+
+    return (valid * 100) / size;
+}
+
+void SerialBaudDetector::_timerWheelExpired(quint64 now)
+{
+    if (m_finished)
+        return;
+
+    if (now > m_lastByteTime + FRAME_GAP_NS) {
+        //Line is idle - collected frame is complete and the next byte will start a new frame
+        if (m_length > 0) {
+            const quint32 attempt = m_attempt;
+            if (_evaluateFrame() || m_attempt != attempt)
+                return;
+        }
+        m_synchronized = true;
+    }
+
+    if (m_length == 0 && now >= m_candidateStartTime + DWELL_NS) {
+        _nextCandidate(now);
+        return;
+    }
+
+    _schedule();
+}
+
+bool SerialBaudDetector::_isValidByte(char byte)
+{
+    const uchar value = static_cast<uchar>(byte);
+    return (value >= 0x20 && value < 0x7F)
+            || value == 0x02        //STX
+            || value == 0x03        //ETX
+            || value == '\t';
+}
+
+void SerialBaudDetector::_processByte(char byte, quint64 time)
+{
+    if (time > m_lastByteTime + FRAME_GAP_NS) {
+        if (m_length > 0) {
+            const quint32 attempt = m_attempt;
+            if (_evaluateFrame() || m_attempt != attempt)
+                return;
+        }
+        m_synchronized = true;
+    }
+    m_lastByteTime = time;
+
+    const bool terminator = _isTerminator(byte);
+    if (!terminator && !_isValidByte(byte) && ++m_invalidCount > MAX_INVALID_BYTES) {
+        _nextCandidate(time);
+        return;
+    }
+
+    //After switching the candidate port can be in the middle of the frame. Such tail can look valid, but it is not
+    //the whole key - so everything till the first terminator or pause is skipped
+    if (!m_synchronized) {
+        if (terminator) {
+            m_synchronized = true;
+            m_invalidCount = 0;
+        }
+        return;
+    }
+
+    if (terminator) {
+        if (m_length > 0)
+            _evaluateFrame();
+        return;
+    }
+
+    if (m_length == MAX_FRAME_LENGTH) {
+        _nextCandidate(time);
+        return;
+    }
+
+    if (m_length == 0)
+        m_firstByteTime = time;
+    m_frame[m_length++] = byte;
+}
+
+bool SerialBaudDetector::_evaluateFrame()
+{
+    if (frameScore(m_frame,m_length) < VALID_PERCENT) {
+        _nextCandidate(m_lastByteTime);
+        return false;
+    }
+
+    //Too short frames are ignored, as few bytes of noise can look valid at any baud rate
+    if (m_length < MIN_FRAME_LENGTH) {
+        m_length = 0;
+        m_invalidCount = 0;
+        return false;
+    }
+
+    m_finished = true;
+    timerWheel->cancel(this);
+
+    QByteArray frame(m_frame,m_length);
+    frame.append('\r');
+    m_length = 0;
+
+    emit baudRateDetected(currentCandidate(),frame,m_firstByteTime);
+    return true;
+}
+
+void SerialBaudDetector::_nextCandidate(quint64 now)
+{
+    m_current = (m_current + 1) % m_candidates.count();
+    m_attempt++;
+    _resetCandidate(now);
+
+    emit candidateChanged(currentCandidate());
+}
+
+void SerialBaudDetector::_resetCandidate(quint64 now)
+{
+    m_length = 0;
+    m_invalidCount = 0;
+    m_synchronized = false;
+    m_candidateStartTime = now;
+    m_lastByteTime = now;
+
+    _schedule();
+}
+
+void SerialBaudDetector::_schedule()
+{
+    if (m_length > 0) {
+        timerWheel->schedule(this,m_lastByteTime + FRAME_GAP_NS + 1);
+    } else if (!m_synchronized) {
+        timerWheel->schedule(this,qMin(m_lastByteTime + FRAME_GAP_NS + 1,m_candidateStartTime + DWELL_NS));
+    } else {
+        timerWheel->schedule(this,m_candidateStartTime + DWELL_NS);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SERIALBAUDDETECTOR_H
+#define SERIALBAUDDETECTOR_H
+
+#include <QObject>
+#include <QList>
+#include <QSerialPort>
+
+#include "./core/TimerWheel.h"
+
+/*!
+ *  @class SerialBaudDetector core/serial/SerialBaudDetector.h
+ *  @brief This class finds baud rate of the serial reader by checking, whether received frames look valid.
+ *  @details Port is switched between candidate baud rates. Bytes received at the current candidate are collected into
+ *           a frame, which ends at CR/LF or at the pause of FRAME_GAP_NS. Frame is accepted if it is long enough and
+ *           almost all of its bytes are printable ASCII or usual framing characters (STX, ETX, TAB). At the wrong baud
+ *           rate UART produces mostly NUL, 0x80...0xFF and other control characters, so such frame is rejected as soon
+ *           as it can not reach the threshold anymore and the next candidate is tried at once. Without any input
+ *           candidate is changed after DWELL_NS, so reader, which repeats the frame while card is held near it, is
+ *           detected during one read.
+ *
+ *           Each opened port has its own detector driven by the TimerWheel, so ports with unknown settings are probed
+ *           simultaneously and do not wait for each other.
+ */
+
+class SerialBaudDetector : public QObject, private TimerWheel::Client
+{
+    Q_OBJECT
+public:
+    static const int      MAX_FRAME_LENGTH = 64;
+    static const int      MIN_FRAME_LENGTH = 4;
+    static const int      VALID_PERCENT    = 90;
+    static const quint64  FRAME_GAP_NS     = 50 * 1000 * 1000;
+    static const quint64  DWELL_NS         = 400 * 1000 * 1000;
+
+    explicit SerialBaudDetector(const QList<QSerialPort::BaudRate>& candidates, QObject* parent = nullptr);
+    ~SerialBaudDetector() {}
+
+    /*! @brief Returns baud rate, which is currently probed */
+    QSerialPort::BaudRate   currentCandidate() const;
+
+    /*! @brief Starts probing from the first candidate. Port is expected to be configured to currentCandidate */
+    void                    start(quint64 now);
+
+    /*! @brief Processes bytes received at time with currentCandidate baud rate */
+    void                    feed(const char* data, int size, quint64 time);
+
+    /*! @brief Removes currentCandidate (e.g. port did not accept it) and switches to the next candidate. Returns false
+     *         and stops detection if no candidates are left */
+    bool                    rejectCandidate(quint64 now);
+
+    /*! @brief Returns percentage of valid bytes in data (0...100) */
+    static int              frameScore(const char* data, int size);
+
+signals:
+    /*! @brief Emitted when port should be switched to rate. Input received before switching should be flushed */
+    void                    candidateChanged(QSerialPort::BaudRate rate);
+
+    /*! @brief Emitted when frame received at rate was accepted. frame contains the frame with its terminator, so it can
+     *         be passed to the KeyDecoder. firstByteTime - time, when first byte of the frame was received */
+    void                    baudRateDetected(QSerialPort::BaudRate rate, const QByteArray& frame, quint64 firstByteTime);
+
+protected:
+    void                    _timerWheelExpired(quint64 now) override;
+
+private:
+    static inline bool      _isValidByte(char byte);
+    static inline bool      _isTerminator(char byte)   { return byte == '\r' || byte == '\n'; }
+
+    void                    _processByte(char byte, quint64 time);
+
+    /*! @brief Checks collected frame, returns true if detection is finished */
+    bool                    _evaluateFrame();
+    void                    _nextCandidate(quint64 now);
+    void                    _resetCandidate(quint64 now);
+    void                    _schedule();
+
+    QList<QSerialPort::BaudRate>  m_candidates;
+    int                           m_current;
+    quint32                       m_attempt;        //!< @brief Incremented on each switch of the candidate
+
+    char                          m_frame[MAX_FRAME_LENGTH];
+    int                           m_length;
+    int                           m_invalidCount;
+    bool                          m_synchronized;   //!< @brief Start of the frame was seen at current candidate
+    quint64                       m_firstByteTime;
+    quint64                       m_lastByteTime;
+    quint64                       m_candidateStartTime;
+    bool                          m_finished;
+};
+
+#endif // SERIALBAUDDETECTOR_H
@@ -23,32 +23,61 @@
 #include "SerialDeviceManager.h"
 
 #include <QDebug>
+#include <QtConcurrent>
+
+#include "core/StartupProfiler.h"
 
 SerialDeviceManager::SerialDeviceManager(QObject *parent)
-    : QObject{parent}
+    : QObject{parent},
+    m_reconnectSupervisor("serial")
 {
+    connect(&m_reconnectSupervisor,&ReconnectSupervisor::reconnectRequested,this,&SerialDeviceManager::_reconnectSerialDevice);
+
     connect(&m_serialDeviceWatcher,&SerialDeviceWatcher::deviceWasAttached,this,&SerialDeviceManager::_handleAttachedSerialDevice);
     connect(&m_serialDeviceWatcher,&SerialDeviceWatcher::deviceWasDetached,this,&SerialDeviceManager::_handleDetachedSerialDevice);
+
+    connect(&m_portListWatcher,&QFutureWatcher<QList<QSerialPortInfo>>::finished,this,&SerialDeviceManager::_initialPortListReady);
+}
+
+SerialDeviceManager::~SerialDeviceManager()
+{
+    m_portListWatcher.waitForFinished();
 }
 
 void SerialDeviceManager::start()
 {
+    reconnectSettings->configureReconnectSupervisor(&m_reconnectSupervisor);
+
+    //Enumerating serial ports (udev/sysfs) is the slow part, so it is done on a worker thread. QSerialPort objects
+    //must live in the thread, where they are used, so ports are opened in _initialPortListReady.
+    startupProfiler->mark("Serial port enumeration started");
+    m_portListWatcher.setFuture(QtConcurrent::run(&QSerialPortInfo::availablePorts));
+}
+
+void SerialDeviceManager::_initialPortListReady()
+{
+    const QList<QSerialPortInfo> ports = m_portListWatcher.result();
+
     //Automatically connect all devices, which are matching autoconnect criteria
     if (serialDeviceManagerSettings->serialDeviceAutoconnection()) {   //If autoconnect enabled
 
         //Go through attached device list and connect enything which is fitting autoconnect rules
-        for (const QSerialPortInfo& portInfo : m_serialDeviceWatcher.availableDevices()) {
+        for (const QSerialPortInfo& portInfo : ports) {
             if (!serialDeviceManagerSettings->serialDeviceFilter().isMatching(portInfo)) {
                 continue;
             }
 
             if (_tryOpeningSerialDevice(portInfo)) {
+                startupProfiler->mark(QString("Serial device %1 opened").arg(portInfo.portName()));
                 emit serialDeviceWasOpened(portInfo);
             }
         }
     }
 
-    m_serialDeviceWatcher.start();
+    m_serialDeviceWatcher.start(ports);
+
+    startupProfiler->mark("Serial devices ready");
+    emit started();
 }
 
 QList<QSerialPortInfo> SerialDeviceManager::openedSerialDevices() const
@@ -92,7 +121,10 @@ void SerialDeviceManager::serialDeviceOpeningRequested(const QSerialPortInfo& po
 
 void SerialDeviceManager::serialDeviceClosureRequested(const QSerialPortInfo& deviceDetails)
 {
-    //This method should be invoked only by interactions with the user
+    //This method should be invoked only by interactions with the user. Port closed by the user should stay closed
+    m_reconnectSupervisor.forgetDevice(deviceDetails.portName());
+    m_supervisedDevices.remove(deviceDetails.portName());
+
     for (int i = 0; i < m_openedSerialDevices.count(); i++) {
         SerialDevice* serialDevice = m_openedSerialDevices.at(i);
         if (serialDevice->portInfo().portName() == deviceDetails.portName()) {
@@ -107,6 +139,11 @@ void SerialDeviceManager::serialDeviceClosureRequested(const QSerialPortInfo& de
 void SerialDeviceManager::_handleAttachedSerialDevice(const QSerialPortInfo& port)
 {
     //This method is invoked when new device is connected to the computer
+    if (_isSupervised(port)) {                                  //If port has failed or was detached
+        m_reconnectSupervisor.deviceAttached(port.portName()); //Reopen it (and inform user there)
+        return;
+    }
+
     if (!serialDeviceManagerSettings->serialDeviceAutoconnection()) {  //If autoconnect disabled
         emit serialDeviceWasAttached(port);           //Just inform user about new device
         return;
@@ -127,6 +164,7 @@ void SerialDeviceManager::_handleAttachedSerialDevice(const QSerialPortInfo& por
 
 void SerialDeviceManager::_handleDetachedSerialDevice(const QSerialPortInfo& port)
 {
+    m_reconnectSupervisor.deviceDetached(port.portName());
     emit serialDeviceWasDetached(port);      //Inform anybody interested that device was disconnected
 }
 
@@ -149,18 +187,88 @@ void SerialDeviceManager::_serialDeviceErrorOccured(QSerialPort::SerialPortError
     if (error == QSerialPort::NoError)
         return;
 
+    m_reconnectSupervisor.deviceFailed(device->portInfo().portName());
+
     emit errorMessage(_getSerialErrorMessage(error,device->portInfo()));
     device->close();
 }
 
-bool SerialDeviceManager::_tryOpeningSerialDevice(const QSerialPortInfo& portInfo)
+void SerialDeviceManager::_reconnectSerialDevice(const QString& portName)
+{
+    //Port could be opened by the user meanwhile
+    for (SerialDevice* device : qAsConst(m_openedSerialDevices)) {
+        if (device->portInfo().portName() == portName) {
+            m_reconnectSupervisor.deviceConnected(portName);
+            return;
+        }
+    }
+
+    //Port name could be taken by another device meanwhile. Missing port is not checked - opening it fails
+    const QSerialPortInfo portInfo = m_supervisedDevices.value(portName);
+    const QSerialPortInfo currentInfo(portName);
+    if (!currentInfo.isNull() && !_isSupervised(currentInfo))
+        return;
+
+    if (!_tryOpeningSerialDevice(portInfo,false)) {
+        m_reconnectSupervisor.deviceFailed(portName);
+        return;
+    }
+
+    emit serialDeviceWasOpened(portInfo);
+}
+
+bool SerialDeviceManager::_isSupervised(const QSerialPortInfo& portInfo)
+{
+    const QString portName = portInfo.portName();
+    if (!m_reconnectSupervisor.isSupervised(portName))
+        return false;
+
+    if (_isSameDevice(m_supervisedDevices.value(portName),portInfo))
+        return true;
+
+    qDebug() << "Device "<<portInfo.description()<<" has taken port of supervised device"<<portName
+             <<", which is not reconnected anymore";
+    m_reconnectSupervisor.forgetDevice(portName);
+    m_supervisedDevices.remove(portName);
+    return false;
+}
+
+bool SerialDeviceManager::_isSameDevice(const QSerialPortInfo& lhs, const QSerialPortInfo& rhs)
+{
+    return  (lhs.vendorIdentifier()     == rhs.vendorIdentifier())    &&
+            (lhs.productIdentifier()    == rhs.productIdentifier())   &&
+            (lhs.serialNumber()         == rhs.serialNumber())        &&
+            (lhs.manufacturer()         == rhs.manufacturer())        &&
+            (lhs.description()          == rhs.description());
+}
+
+void SerialDeviceManager::_serialDeviceBaudRateDetected(QSerialPort::BaudRate rate)
 {
+    SerialDevice* device = qobject_cast<SerialDevice*>(sender());
+    Q_ASSERT(device != nullptr);
+
+    qDebug() << "Port "<<device->portInfo().portName()<<" uses baud rate "<<rate;
+
+    //Candidates are validated by settings, so the saved profile can be applied next time
+    Q_ASSERT(SerialPortConfig::isSupportedBaudRate(rate));
+
+    //Detected settings are remembered, so port is opened with them next time. Explicit "auto" profile is kept as is
+    if (!serialDeviceManagerSettings->hasSerialPortProfile(device->portInfo()))
+        serialDeviceManagerSettings->setPortNameProfile(device->portInfo().portName(),device->configuration());
+}
+
+bool SerialDeviceManager::_tryOpeningSerialDevice(const QSerialPortInfo& portInfo, bool reportErrors)
+{
+    const SerialPortConfig config = serialDeviceManagerSettings->serialPortConfiguration(portInfo);
+
     SerialDevice* device = new SerialDevice(portInfo);
-    device->configureSerialPort(serialDeviceManagerSettings->defaultSerialPortConfiguration());
+    device->configureSerialPort(config);
+    decoderSettings->configureKeyDecoder(device->keyDecoder());
 
     if (!device->open(QIODevice::ReadOnly)) {
         qDebug() << "Port "<<portInfo.portName()<< " opening failed. Reason: "<<device->errorString();
-        emit errorMessage(_getSerialErrorMessage(device->error(),device->portInfo()));
+        if (reportErrors)
+            emit errorMessage(_getSerialErrorMessage(device->error(),device->portInfo()));
         device->deleteLater();
         return false;
     }
@@ -169,6 +277,16 @@ bool SerialDeviceManager::_tryOpeningSerialDevice(const QSerialPortInfo& portInf
     connect(device,&SerialDevice::errorOccured,this,&SerialDeviceManager::_serialDeviceErrorOccured);
     connect(device,&SerialDevice::keyFound,this,&SerialDeviceManager::keyFound);
     m_openedSerialDevices.append(device);
+
+    m_supervisedDevices.insert(portInfo.portName(),portInfo);
+    m_reconnectSupervisor.deviceConnected(portInfo.portName());
+
+    //Each port is probed by its own detector, so several new readers are detected at the same time
+    if (config.autodetectBaudRate()) {
+        connect(device,&SerialDevice::baudRateDetected,this,&SerialDeviceManager::_serialDeviceBaudRateDetected);
+        device->startBaudRateDetection(serialDeviceManagerSettings->baudRateCandidates());
+    }
+
     return true;
 }
 
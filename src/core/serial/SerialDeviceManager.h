@@ -24,16 +24,22 @@
 #define SERIALDEVICEMANAGER_H
 
 #include <QObject>
+#include <QFutureWatcher>
 
 #include "./SerialPortFilter.h"
 #include "./SerialDeviceWatcher.h"
 #include "./core/devices/SerialDevice.h"
 
+#include "./core/devices/ReconnectSupervisor.h"
+
+#include "./appconfig/DecoderSettings.h"
+#include "./appconfig/ReconnectSettings.h"
 #include "./appconfig/SerialDeviceManagerSettings.h"
 
 /*!
  *  @class SerialDeviceManager core/serial/SerialDeviceManager.h
  *  @brief This class is responsible for handling Serial devices (manual opening, closure, autoconnection, etc.
+ *  @details Ports closed because of errors are reopened by ReconnectSupervisor, ports closed by the user are not.
  */
 
 class SerialDeviceManager : public QObject
@@ -41,7 +47,10 @@ class SerialDeviceManager : public QObject
     Q_OBJECT
 public:
     explicit SerialDeviceManager(QObject *parent = nullptr);
+    ~SerialDeviceManager();
 
+    /*! @brief Starts monitoring of serial devices. Ports are enumerated on a worker thread, after that ports
+     *         matching autoconnect criteria are opened and SerialDeviceManager::started is emitted. */
     void                     start();
     void                     stop()                             { m_serialDeviceWatcher.stop(); }
     void                     updateSerialDeviceList()           { m_serialDeviceWatcher.updateDeviceList(); }
@@ -60,8 +69,11 @@ public:
     void                     appendSerialDeviceFilter(const SerialPortFilter& filter);
 
 signals:
+    /*! @brief This signal is emitted when devices matching autoconnect criteria were opened after start() */
+    void started();
+
     /*! @brief This signal is emitted when any of the connected devices has read any key/tag/etc. */
-    void keyFound(const QString& key);
+    void keyFound(const KeyEvent& keyEvent);
 
     /*! @brief This signal is emitted when any error has happeded. Contains description of the error in human-readable
      *         form. */
@@ -84,11 +96,26 @@ private slots:
     void _handleDetachedSerialDevice(const QSerialPortInfo& portInfo);
     void _handleClosedSerialDevice();
     void _serialDeviceErrorOccured(QSerialPort::SerialPortError error);
+    void _serialDeviceBaudRateDetected(QSerialPort::BaudRate rate);
+    void _reconnectSerialDevice(const QString& portName);
+    void _initialPortListReady();
 
 private:
     SerialDeviceWatcher           m_serialDeviceWatcher;
     QList<SerialDevice*>          m_openedSerialDevices;
-    bool _tryOpeningSerialDevice(const QSerialPortInfo& portInfo);
+    QFutureWatcher<QList<QSerialPortInfo>> m_portListWatcher;
+    ReconnectSupervisor           m_reconnectSupervisor;
+    QHash<QString,QSerialPortInfo> m_supervisedDevices;     //!< @brief Ports, which were opened, by port name
+
+    /*! @brief If reportErrors is false - failure is not reported with errorMessage (e.g. for reconnection attempts) */
+    bool _tryOpeningSerialDevice(const QSerialPortInfo& portInfo, bool reportErrors = true);
+
+    /*! @brief Returns true if portInfo is supervised port. If port name is supervised, but belongs to another device
+     *         now - supervised port is forgotten, so the other device is not opened by reconnection */
+    bool _isSupervised(const QSerialPortInfo& portInfo);
+
+    /*! @brief Returns true if both describe the same device. Port names are not compared - they are reused */
+    static bool _isSameDevice(const QSerialPortInfo& lhs, const QSerialPortInfo& rhs);
 
     static QString _getSerialErrorMessage(QSerialPort::SerialPortError error,const QSerialPortInfo& portInfo);
 };
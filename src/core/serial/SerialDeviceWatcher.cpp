@@ -25,7 +25,8 @@
 SerialDeviceWatcher::SerialDeviceWatcher(QObject *parent)
     : QObject{parent},m_autoupdateInterval(500)
 {
-    m_lastScanResults = QSerialPortInfo::availablePorts();
+    //Scanning is postponed till start(), enumerating ports may be slow and we do not want to block construction
+    connect(&m_autoupdateTimer,&QTimer::timeout,this,&SerialDeviceWatcher::updateDeviceList);
 }
 
 SerialDeviceWatcher::~SerialDeviceWatcher()
@@ -38,7 +39,13 @@ void SerialDeviceWatcher::start()
     updateDeviceList();
     m_autoupdateTimer.setInterval(m_autoupdateInterval);
     m_autoupdateTimer.start();
-    connect(&m_autoupdateTimer,&QTimer::timeout,this,&SerialDeviceWatcher::updateDeviceList);
+}
+
+void SerialDeviceWatcher::start(const QList<QSerialPortInfo>& currentDevices)
+{
+    m_lastScanResults = currentDevices;
+    m_autoupdateTimer.setInterval(m_autoupdateInterval);
+    m_autoupdateTimer.start();
 }
 
 void SerialDeviceWatcher::stop()
@@ -46,6 +46,10 @@ public:
     /*! @brief Use this method to start automated updating of serial device list. */
     void start();
 
+    /*! @brief Same as SerialDeviceWatcher::start, but currentDevices (e.g. list retrieved on a worker thread) is
+     *         used as a current device list instead of scanning system once again. */
+    void start(const QList<QSerialPortInfo>& currentDevices);
+
     /*! @brief Use this method to stop automated updating of serial device list. */
     void stop();
 
@@ -58,7 +62,8 @@ public:
     /*! @brief Use this method to get current autoupdate interval. */
     uint autoupdateInterval() const                        { return m_autoupdateInterval; }
 
-    /*! @brief This method returns list of serial devices, which are currently attached to the system. */
+    /*! @brief This method returns list of serial devices, which are currently attached to the system. List is
+     *         empty until SerialDeviceWatcher::start is called. */
     QList<QSerialPortInfo> availableDevices() const        { return m_lastScanResults; }
 
 signals:
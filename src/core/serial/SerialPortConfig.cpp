@@ -22,6 +22,21 @@
 
 #include "SerialPortConfig.h"
 
+#include <QDebug>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <linux/serial.h>
+    #include <string.h>
+    #include <sys/ioctl.h>
+    #include <termios.h>
+#elif defined(Q_OS_WINDOWS)
+    #error("Windows builds currently not supported")
+#else
+    #error("Builds for other platforms are not supported")
+#endif
+
 void SerialPortConfig::configureSerialPort(QSerialPort* port) const
 {
     port->setBaudRate(baudRate());
@@ -31,6 +46,178 @@ void SerialPortConfig::configureSerialPort(QSerialPort* port) const
     port->setFlowControl(flowControl());
 }
 
+bool SerialPortConfig::configureTermios(int fd) const
+{
+    struct termios options;
+    if (tcgetattr(fd, &options) < 0)
+        return false;
+
+    //No echo, no line editing, no translation of CR/LF - bytes are passed as they are
+    cfmakeraw(&options);
+    options.c_cflag |= CLOCAL | CREAD;
+
+    speed_t speed;
+    switch (baudRate()) {
+    case QSerialPort::Baud1200:    speed = B1200;   break;
+    case QSerialPort::Baud2400:    speed = B2400;   break;
+    case QSerialPort::Baud4800:    speed = B4800;   break;
+    case QSerialPort::Baud9600:    speed = B9600;   break;
+    case QSerialPort::Baud19200:   speed = B19200;  break;
+    case QSerialPort::Baud38400:   speed = B38400;  break;
+    case QSerialPort::Baud57600:   speed = B57600;  break;
+    case QSerialPort::Baud115200:  speed = B115200; break;
+    default:
+        errno = EINVAL;
+        return false;
+    }
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+
+    options.c_cflag &= ~CSIZE;
+    switch (dataBits()) {
+    case QSerialPort::Data5:  options.c_cflag |= CS5; break;
+    case QSerialPort::Data6:  options.c_cflag |= CS6; break;
+    case QSerialPort::Data7:  options.c_cflag |= CS7; break;
+    default:                  options.c_cflag |= CS8; break;
+    }
+
+    options.c_cflag &= ~(PARENB | PARODD | CMSPAR);
+    switch (parity()) {
+    case QSerialPort::EvenParity:   options.c_cflag |= PARENB;                   break;
+    case QSerialPort::OddParity:    options.c_cflag |= PARENB | PARODD;          break;
+    case QSerialPort::SpaceParity:  options.c_cflag |= PARENB | CMSPAR;          break;
+    case QSerialPort::MarkParity:   options.c_cflag |= PARENB | CMSPAR | PARODD; break;
+    default:                                                                     break;
+    }
+
+    if (stopBits() == QSerialPort::TwoStop) {
+        options.c_cflag |= CSTOPB;
+    } else {
+        options.c_cflag &= ~CSTOPB;
+    }
+
+    options.c_cflag &= ~CRTSCTS;
+    options.c_iflag &= ~(IXON | IXOFF | IXANY);
+    if (flowControl() == QSerialPort::HardwareControl) {
+        options.c_cflag |= CRTSCTS;
+    } else if (flowControl() == QSerialPort::SoftwareControl) {
+        options.c_iflag |= IXON | IXOFF;
+    }
+
+    //VMIN/VTIME only control how long blocking read() waits. Descriptor read by DeviceMultiplexer is non-blocking,
+    //there epoll/io_uring report it readable as soon as any byte is buffered, so other values would only be misleading
+    const int flags = fcntl(fd, F_GETFL);
+    const bool nonBlocking = (flags >= 0) && (flags & O_NONBLOCK);
+    if (nonBlocking && (readMinimum() != 1 || readTimeout() != 0))
+        qDebug() << "VMIN="<<readMinimum()<<"and VTIME="<<readTimeout()<<"are ignored for non-blocking fd="<<fd;
+
+    options.c_cc[VMIN] = nonBlocking ? 1 : readMinimum();
+    options.c_cc[VTIME] = nonBlocking ? 0 : readTimeout();
+
+    if (tcsetattr(fd, TCSANOW, &options) < 0)
+        return false;
+
+    if (lowLatency()) {
+        struct serial_struct serial;
+        if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags |= ASYNC_LOW_LATENCY;
+            if (ioctl(fd, TIOCSSERIAL, &serial) < 0)
+                qDebug() << "TIOCSSERIAL call failed for fd="<<fd<<"; strerror(errno)="<<strerror(errno);
+        } else {
+            qDebug() << "TIOCGSERIAL call failed for fd="<<fd<<"; strerror(errno)="<<strerror(errno);
+        }
+    }
+
+    return true;
+}
+
+QString SerialPortConfig::toProfileString() const
+{
+    QString result = autodetectBaudRate() ? QStringLiteral("auto") : QString::number(baudRate());
+    result.append(',');
+
+    result.append(QString::number(dataBits()));
+    switch (parity()) {
+    case QSerialPort::EvenParity:   result.append('E'); break;
+    case QSerialPort::OddParity:    result.append('O'); break;
+    case QSerialPort::SpaceParity:  result.append('S'); break;
+    case QSerialPort::MarkParity:   result.append('M'); break;
+    default:                        result.append('N'); break;
+    }
+    result.append((stopBits() == QSerialPort::TwoStop) ? '2' : '1');
+    result.append(',');
+
+    switch (flowControl()) {
+    case QSerialPort::HardwareControl:  result.append("hardware"); break;
+    case QSerialPort::SoftwareControl:  result.append("software"); break;
+    default:                            result.append("none");     break;
+    }
+
+    return result;
+}
+
+bool SerialPortConfig::applyProfileString(const QString& profile)
+{
+    const QStringList parts = profile.trimmed().split(',');
+    if (parts.isEmpty() || parts.size() > 3)
+        return false;
+
+    SerialPortConfig result(*this);
+
+    const QString baud = parts.at(0).trimmed();
+    if (baud.compare("auto",Qt::CaseInsensitive) == 0) {
+        result.setAutodetectBaudRate(true);
+    } else {
+        bool ok = false;
+        const int rate = baud.toInt(&ok);
+        if (!ok || !isSupportedBaudRate(rate))
+            return false;
+        result.setBaudRate(static_cast<QSerialPort::BaudRate>(rate));
+        result.setAutodetectBaudRate(false);
+    }
+
+    if (parts.size() > 1) {
+        const QString frame = parts.at(1).trimmed().toUpper();
+        if (frame.size() != 3 || frame.at(0) < '5' || frame.at(0) > '8')
+            return false;
+
+        result.setDataBits(static_cast<QSerialPort::DataBits>(frame.at(0).digitValue()));
+
+        switch (frame.at(1).toLatin1()) {
+        case 'N': result.setParity(QSerialPort::NoParity);    break;
+        case 'E': result.setParity(QSerialPort::EvenParity);  break;
+        case 'O': result.setParity(QSerialPort::OddParity);   break;
+        case 'S': result.setParity(QSerialPort::SpaceParity); break;
+        case 'M': result.setParity(QSerialPort::MarkParity);  break;
+        default:
+            return false;
+        }
+
+        switch (frame.at(2).toLatin1()) {
+        case '1': result.setStopBits(QSerialPort::OneStop); break;
+        case '2': result.setStopBits(QSerialPort::TwoStop); break;
+        default:
+            return false;
+        }
+    }
+
+    if (parts.size() > 2) {
+        const QString flow = parts.at(2).trimmed().toLower();
+        if (flow == "none") {
+            result.setFlowControl(QSerialPort::NoFlowControl);
+        } else if (flow == "hardware") {
+            result.setFlowControl(QSerialPort::HardwareControl);
+        } else if (flow == "software") {
+            result.setFlowControl(QSerialPort::SoftwareControl);
+        } else {
+            return false;
+        }
+    }
+
+    *this = result;
+    return true;
+}
+
 SerialPortConfig SerialPortConfig::readFromPort(const QSerialPort& port)
 {
     SerialPortConfig result;
@@ -44,6 +231,23 @@ SerialPortConfig SerialPortConfig::readFromPort(const QSerialPort& port)
     return result;
 }
 
+bool SerialPortConfig::isSupportedBaudRate(qint32 rate)
+{
+    switch (rate) {
+    case QSerialPort::Baud1200:
+    case QSerialPort::Baud2400:
+    case QSerialPort::Baud4800:
+    case QSerialPort::Baud9600:
+    case QSerialPort::Baud19200:
+    case QSerialPort::Baud38400:
+    case QSerialPort::Baud57600:
+    case QSerialPort::Baud115200:
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool operator==(const QSerialPortInfo& lhs, const QSerialPortInfo& rhs)
 {
     return (lhs.portName() == rhs.portName());
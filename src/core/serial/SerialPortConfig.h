@@ -29,11 +29,19 @@
 /*!
  *  @class SerialPortConfig core/serial/SerialPortConfig.h
  *  @brief This class holds information about QSerialPort configuration ooptions. Like baud rate, data bits etc.
+ *  @details Options readMinimum, readTimeout, lowLatency and readBufferSize are used only by Termios backend, which
+ *           reads port descriptor directly through DeviceMultiplexer.
  */
 
 class SerialPortConfig
 {
 public:
+    /*! @brief This enum holds information about ways port can be read */
+    enum Backend {
+        QtSerialPortBackend,     /*!< @brief Port is read by QSerialPort */
+        TermiosBackend           /*!< @brief Port descriptor is configured with termios and read by DeviceMultiplexer */
+    };
+
     QSerialPort::BaudRate         baudRate() const                   { return m_baudRate; }
     QSerialPort::StopBits         stopBits() const                   { return m_stopBits; }
     QSerialPort::DataBits         dataBits() const                   { return m_dataBits; }
@@ -46,18 +54,65 @@ public:
     void setParity(QSerialPort::Parity parity)                       { m_parity = parity; };
     void setFlowControl(QSerialPort::FlowControl flowControl)        { m_flowControl = flowControl; }
 
+    Backend                       backend() const                    { return m_backend; }
+    void setBackend(Backend backend)                                 { m_backend = backend; }
+
+    /*! @brief VMIN - blocking read waits till at least this number of bytes was received (0...255). Termios backend
+     *         reads non-blocking descriptor, where VMIN/VTIME have no effect, so 1 and 0 are always applied there */
+    int                           readMinimum() const                { return m_readMinimum; }
+    void setReadMinimum(int bytes)                                   { m_readMinimum = qBound(0,bytes,255); }
+
+    /*! @brief VTIME - inter-byte timeout of blocking read in tenths of a second, 0 - no timeout (0...255) */
+    int                           readTimeout() const                { return m_readTimeout; }
+    void setReadTimeout(int deciseconds)                             { m_readTimeout = qBound(0,deciseconds,255); }
+
+    /*! @brief ASYNC_LOW_LATENCY - driver passes received bytes to tty layer immediately, without buffering */
+    bool                          lowLatency() const                 { return m_lowLatency; }
+    void setLowLatency(bool state)                                   { m_lowLatency = state; }
+
+    /*! @brief Maximal number of bytes requested by one read */
+    int                           readBufferSize() const             { return m_readBufferSize; }
+    void setReadBufferSize(int bytes)                                { m_readBufferSize = qBound(1,bytes,4096); }
+
+    /*! @brief If true - baud rate is unknown and should be detected from received frames (see SerialBaudDetector) */
+    bool                          autodetectBaudRate() const         { return m_autodetectBaudRate; }
+    void setAutodetectBaudRate(bool state)                           { m_autodetectBaudRate = state; }
+
+    /*! @brief Returns line settings in profile form: "<baud rate|auto>,<data bits><parity><stop bits>,<flow control>",
+     *         e.g. "9600,8N1,none" or "auto,7E1,hardware" */
+    QString                       toProfileString() const;
+
+    /*! @brief Applies profile string (see SerialPortConfig::toProfileString) to this config. Trailing parts can be
+     *         omitted (e.g. "115200" or "auto"), then current values stay. Returns false if string is malformed */
+    bool                          applyProfileString(const QString& profile);
+
     /*! @brief This method is used to apply configuration stored in this object to QSerialPort passed as a pointer */
     void                          configureSerialPort(QSerialPort* port) const;
 
+    /*! @brief This method is used to apply configuration stored in this object to termios of opened port descriptor.
+     *         Returns false (and leaves errno set) if configuration was not accepted. Failure to set lowLatency is
+     *         ignored, as not all drivers support it */
+    bool                          configureTermios(int fd) const;
+
     /*! @brief This method is used to read configuration from QSerialPort and construct new SerialPortConfig object */
     static SerialPortConfig       readFromPort(const QSerialPort& port);
 
+    /*! @brief Returns true if rate is one of the standard baud rates (1200...115200), which both backends can apply */
+    static bool                   isSupportedBaudRate(qint32 rate);
+
 private:
     QSerialPort::BaudRate    m_baudRate;
     QSerialPort::StopBits    m_stopBits;
     QSerialPort::DataBits    m_dataBits;
     QSerialPort::Parity      m_parity;
     QSerialPort::FlowControl m_flowControl;
+
+    Backend                  m_backend = QtSerialPortBackend;
+    int                      m_readMinimum = 1;
+    int                      m_readTimeout = 0;
+    bool                     m_lowLatency = true;
+    int                      m_readBufferSize = 256;
+    bool                     m_autodetectBaudRate = false;
 };
 
 bool          operator==(const QSerialPortInfo& lhs, const QSerialPortInfo& rhs);
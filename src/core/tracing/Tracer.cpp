@@ -0,0 +1,109 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+static const int DEFAULT_CAPACITY = 4096;
+
+Tracer::Tracer()
+    : m_spans(DEFAULT_CAPACITY)
+{}
+
+void Tracer::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spans.setCapacity(qMax(1,capacity));
+}
+
+int Tracer::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spans.capacity();
+}
+
+void Tracer::addSpan(quint64 traceId, const char* stage, quint64 start, quint64 end)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spans.append({traceId,stage,start,(end < start) ? start : end});
+}
+
+QByteArray Tracer::toChromeTraceJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    //Complete events ("ph":"X"), times are in microseconds. Every tap is placed on its own track.
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray output("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (int i = 0; i < m_spans.count(); i++) {
+        const TraceSpan& span = m_spans.at(i);
+        if (i > 0)
+            output.append(",\n");
+
+        output.append("{\"name\":\"").append(span.stage)
+              .append("\",\"cat\":\"rfid\",\"ph\":\"X\",\"pid\":").append(pid)
+              .append(",\"tid\":").append(QByteArray::number(span.traceId))
+              .append(",\"ts\":").append(QByteArray::number(double(span.start) / 1000.0,'f',3))
+              .append(",\"dur\":").append(QByteArray::number(double(span.end - span.start) / 1000.0,'f',3))
+              .append('}');
+    }
+    output.append("\n]}\n");
+
+    return output;
+}
+
+QByteArray Tracer::toText() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray output;
+    for (int i = 0; i < m_spans.count(); i++) {
+        const TraceSpan& span = m_spans.at(i);
+        output.append(QByteArray::number(span.traceId)).append('\t')
+              .append(span.stage).append('\t')
+              .append(QByteArray::number(span.start)).append('\t')
+              .append(QByteArray::number(span.end - span.start)).append(" ns\n");
+    }
+
+    return output;
+}
+
+bool Tracer::writeToFile(const QString& fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Can not open trace file "<<fileName<<": "<<file.errorString();
+        return false;
+    }
+
+    file.write(fileName.endsWith(QLatin1String(".json"),Qt::CaseInsensitive) ? toChromeTraceJson() : toText());
+    if (!file.commit()) {
+        qDebug() << "Can not write trace file "<<fileName<<": "<<file.errorString();
+        return false;
+    }
+
+    return true;
+}
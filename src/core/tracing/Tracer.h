@@ -0,0 +1,87 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QMutex>
+#include <QString>
+
+#include "core/KeyEvent.h"
+#include "core/RingBuffer.h"
+
+/*!
+ *  @struct TraceSpan core/tracing/Tracer.h
+ *  @brief One stage of processing a tap. Times are monotonic nanoseconds (see KeyEvent::now).
+ */
+
+struct TraceSpan {
+    quint64       traceId;
+    const char*   stage;       //!< @brief Stage name. Must be a string literal, it is not copied
+    quint64       start;
+    quint64       end;
+};
+
+/*!
+ *  @class Tracer core/tracing/Tracer.h
+ *  @brief This class keeps the last recorded TraceSpan objects in a ring buffer, so the latency of every tap can be
+ *         split between stages (device input, delivery, dispatch, command execution).
+ *  @details Recording span does not allocate memory. Recorded spans can be exported as Chrome trace JSON (can be
+ *           opened by chrome://tracing or ui.perfetto.dev) or as plain text dump.
+ */
+
+class Tracer
+{
+public:
+    static Tracer* get() {
+        static Tracer theOne;
+        return &theOne;
+    }
+
+    /*! @brief Sets number of spans to keep. Older spans are dropped */
+    void         setCapacity(int capacity);
+    int          capacity() const;
+
+    void         addSpan(quint64 traceId, const char* stage, quint64 start, quint64 end);
+    void         addSpan(const KeyEvent& event, const char* stage, quint64 start, quint64 end)
+                                                           { addSpan(event.traceId(),stage,start,end); }
+
+    /*! @brief Returns recorded spans in Chrome trace event format */
+    QByteArray   toChromeTraceJson() const;
+
+    /*! @brief Returns recorded spans as text, one span per line */
+    QByteArray   toText() const;
+
+    /*! @brief Writes recorded spans to fileName. Files ending with .json are written in Chrome trace format,
+     *         other files - as plain text. Returns false on error. */
+    bool         writeToFile(const QString& fileName) const;
+
+private:
+    Tracer();
+    Q_DISABLE_COPY(Tracer)
+
+    mutable QMutex         m_mutex;
+    RingBuffer<TraceSpan>  m_spans;
+};
+#define tracer Tracer::get()
+
+#endif // TRACER_H
@@ -32,6 +32,9 @@
 #include "./appconfig/CommandLineParser.h"
 #include "./appconfig/Settings.h"
 #include "./core/RfidController.h"
+#include "./core/StartupProfiler.h"
+#include "./core/cards/CardNormalizer.h"
+#include "./core/commands/KeySet.h"
 
 #ifdef GUI
     #include <QApplication>
@@ -43,9 +46,13 @@
 #endif //GUI
 
 void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+int  buildKeySetImage(const QString& fileName);
 
 int main(int argc, char *argv[])
 {
+    //Starts measuring startup time
+    startupProfiler;
+
     qInstallMessageHandler(myMessageOutput);
 
 #ifdef GUI
@@ -60,6 +67,9 @@ int main(int argc, char *argv[])
     CommandLineParser parser;
     parser.process(app);
 
+    startupProfiler->setEnabled(parser.startupProfile());
+    startupProfiler->mark("Application object created");
+
     Settings* appSettings = Settings::getSettings();
     if (!parser.configFile().isEmpty())
         appSettings->setConfigFileName(parser.configFile());
@@ -67,30 +77,74 @@ int main(int argc, char *argv[])
     if (!appSettings->configParsed())
         qWarning() << QCoreApplication::translate("main","Error parsing config file %1. Using default parameters.").arg(appSettings->confiFileName());
 
+    startupProfiler->mark("Settings loaded");
+
+    if (!parser.buildKeySet().isEmpty())
+        return buildKeySetImage(parser.buildKeySet());
+
     RfidController* controller = RfidController::get();
+    startupProfiler->mark("Controller created");
 
 #ifdef GUI
     if (parser.startHidden())
         appSettings->setStartHidden(true);
 
     QScopedPointer<MainWindow> mainWindow;
-    if (!parser.noGui()) {
+    auto createMainWindow = [&mainWindow,appSettings]() {
         mainWindow.reset(new MainWindow);
 
         if (!appSettings->startHidden())
             mainWindow->show();
-    }
+
+        startupProfiler->mark("Main window created");
+    };
+
+    //Hidden main window is not needed right now, so it is created only when all devices are ready
+    const bool createMainWindowLater = !parser.noGui() && appSettings->startHidden();
+    if (createMainWindowLater)
+        QObject::connect(controller,&RfidController::started,&app,createMainWindow);
+#endif //GUI
+
+    //Devices are opened on worker threads and attached from the event loop, so they are being opened while GUI is
+    //created. Keys can be delivered only from the event loop, so command list will be loaded before any key.
+    QObject::connect(controller,&RfidController::started,&app,[](){
+        startupProfiler->mark("All devices ready");
+        startupProfiler->print();
+    });
+    controller->start();
+    startupProfiler->mark("Device opening started");
+
+#ifdef GUI
+    if (!parser.noGui() && !createMainWindowLater)
+        createMainWindow();
 #endif //GUI
 
     if (appSettings->openedCommandsFileName().isEmpty())
         controller->newCommandList();
     else
         controller->openCommandListFile(appSettings->openedCommandsFileName());
-    controller->start();
+    startupProfiler->mark("Commands loaded");
 
     return app.exec();
 }
 
+int buildKeySetImage(const QString& fileName)
+{
+    //Keys of image are normalized with card format settings of this config
+    Settings::getSettings()->configureCardNormalizer(cardNormalizer);
+
+    KeySet keySet;
+    QString errorString;
+    if (!keySet.load(fileName,&errorString) || !keySet.save(fileName + ".kset",&errorString)) {
+        qCritical() << errorString;
+        return 1;
+    }
+
+    qInfo("%lld keys (%lld invalid lines skipped), %lld bytes written to %s.kset",keySet.count(),keySet.invalidCount(),
+          keySet.size(),qUtf8Printable(fileName));
+    return 0;
+}
+
 void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
     QByteArray localMsg = msg.toLocal8Bit();
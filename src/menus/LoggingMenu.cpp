@@ -60,6 +60,10 @@ void LoggingMenu::_setupUi()
     w_logClosedDevicesAction->setCheckable(true);
     connect(w_logClosedDevicesAction,&QAction::triggered,this,&LoggingMenu::logClosedDevicesTriggered);
 
+    w_logCommandsAction = this->addAction(tr("Finished commands"));
+    w_logCommandsAction->setCheckable(true);
+    connect(w_logCommandsAction,&QAction::triggered,this,&LoggingMenu::logCommandsTriggered);
+
     w_logErrorsAction = this->addAction(tr("Errors logging"));
     w_logErrorsAction->setCheckable(true);
     connect(w_logErrorsAction,&QAction::triggered,this,&LoggingMenu::logErrorsTriggered);
@@ -51,6 +51,8 @@ signals:
     void logOpenedDevicesTriggered(bool state);
     void logClosedDevicesTriggered(bool state);
 
+    void logCommandsTriggered(bool state);
+
     void logErrorsTriggered(bool state);
 
 public slots:
@@ -63,6 +65,8 @@ public slots:
     void setLogOpenedDevicesChecked(bool state)       { w_logOpenedDevicesAction->setChecked(state); }
     void setLogClosedDevicesChecked(bool state)       { w_logClosedDevicesAction->setChecked(state); }
 
+    void setLogCommandsChecked(bool state)            { w_logCommandsAction->setChecked(state); }
+
     void setLogErrorsChecked(bool state)              { w_logErrorsAction->setChecked(state); }
 
 private:
@@ -77,6 +81,8 @@ private:
     QAction* w_logOpenedDevicesAction;
     QAction* w_logClosedDevicesAction;
 
+    QAction* w_logCommandsAction;
+
     QAction* w_logErrorsAction;
 };
 
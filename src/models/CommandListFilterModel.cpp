@@ -0,0 +1,54 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandListFilterModel.h"
+
+#include "CommandListModel.h"
+
+CommandListFilterModel::CommandListFilterModel(QObject* parent)
+    : QSortFilterProxyModel(parent)
+{
+    //Rows are changed by editing, but we do not want them to disappear from the view while user is editing them
+    setDynamicSortFilter(false);
+}
+
+void CommandListFilterModel::setSearchString(const QString& searchString)
+{
+    if (m_searchString == searchString)
+        return;
+
+    m_searchString = searchString;
+    invalidateFilter();
+}
+
+bool CommandListFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+    if (m_searchString.isEmpty())
+        return true;
+
+    const QModelIndex keyIndex = sourceModel()->index(sourceRow,CommandListModel::KeyColumn,sourceParent);
+    if (keyIndex.data().toString().contains(m_searchString,Qt::CaseInsensitive))
+        return true;
+
+    const QModelIndex programIndex = sourceModel()->index(sourceRow,CommandListModel::ProgramColumn,sourceParent);
+    return programIndex.data().toString().contains(m_searchString,Qt::CaseInsensitive);
+}
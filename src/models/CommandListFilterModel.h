@@ -20,44 +20,34 @@
  *
  */
 
-#ifndef SHELLCOMMANDEDITWIDGET_H
-#define SHELLCOMMANDEDITWIDGET_H
+#ifndef COMMANDLISTFILTERMODEL_H
+#define COMMANDLISTFILTERMODEL_H
 
-#include "CommandEditWidget.h"
-
-class QCheckBox;
-class QLineEdit;
-
-class ShellCommand;
+#include <QSortFilterProxyModel>
 
 /*!
- *  @class ShellCommandEditWidget widgets/ShellCommandEditWidget.h
- *  @brief This class represents widget to display and edit ShellCommand objects
+ *  @class CommandListFilterModel models/CommandListFilterModel.h
+ *  @brief This proxy model is used to search within CommandListModel by key or program while user is typing.
  */
 
-class ShellCommandEditWidget : public CommandEditWidget
+class CommandListFilterModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 public:
-    explicit ShellCommandEditWidget(QWidget *parent = nullptr);
-    ~ShellCommandEditWidget() {}
+    explicit CommandListFilterModel(QObject* parent = nullptr);
+    ~CommandListFilterModel() {}
 
-protected:
-    /*! @brief Implementing pure virtual method to display command. Required by CommandEditWidget */
-    void _displayCommand(Command* command);
+    QString    searchString() const                             { return m_searchString; }
 
-private slots:
-    void _commandEnabledChecked(bool state);
-    void _keyEditingFinished();
-    void _programEditingFinished();
-    void _argumentsEditingFinished();
+public slots:
+    /*! @brief This slot is used to set string, which should be present in key or program of displayed commands */
+    void       setSearchString(const QString& searchString);
+
+protected:
+    bool       filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
 private:
-    inline void _setupUi();
-    QCheckBox*     w_enabledCheckBox;
-    QLineEdit*     w_keyEdit;
-    QLineEdit*     w_programEdit;
-    QLineEdit*     w_argumentListEdit;
+    QString    m_searchString;
 };
 
-#endif // SHELLCOMMANDEDITWIDGET_H
+#endif // COMMANDLISTFILTERMODEL_H
@@ -0,0 +1,277 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandListModel.h"
+
+#include "core/commands/Command.h"
+#include "core/commands/CommandList.h"
+#include "core/commands/MembershipCommand.h"
+#include "core/commands/ShellCommand.h"
+
+CommandListModel::CommandListModel(QObject* parent)
+    : QAbstractTableModel(parent),p_commandList(nullptr),m_removingRow(false)
+{}
+
+void CommandListModel::setCommandList(CommandList* commandList)
+{
+    beginResetModel();
+
+    if (p_commandList != nullptr)
+        _disconnectCommandList();
+
+    p_commandList = commandList;
+
+    if (p_commandList != nullptr)
+        _connectCommandList();
+
+    endResetModel();
+}
+
+Command* CommandListModel::commandAt(const QModelIndex& index) const
+{
+    if (p_commandList == nullptr || !index.isValid())
+        return nullptr;
+
+    if (index.row() >= p_commandList->count())
+        return nullptr;
+
+    return p_commandList->at(index.row());
+}
+
+int CommandListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid() || p_commandList == nullptr)
+        return 0;
+
+    return p_commandList->count();
+}
+
+int CommandListModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return ColumnCount;
+}
+
+QVariant CommandListModel::data(const QModelIndex& index, int role) const
+{
+    Command* cmd = commandAt(index);
+    if (cmd == nullptr)
+        return QVariant();
+
+    if (index.column() == EnabledColumn) {
+        if (role == Qt::CheckStateRole)
+            return cmd->isEnabled() ? Qt::Checked : Qt::Unchecked;
+        if (role == Qt::ToolTipRole)
+            return tr("Is command enabled?");
+        return QVariant();
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::EditRole && role != Qt::ToolTipRole)
+        return QVariant();
+
+    ShellCommand* shellCommand = cmd->to<ShellCommand>();
+
+    switch (index.column()) {
+    case KeyColumn:
+        if (cmd->type() == Command::Membership) {
+            MembershipCommand* membershipCommand = cmd->to<MembershipCommand>();
+            return membershipCommand->isInverted() ? tr("not in %1").arg(membershipCommand->keySetFile())
+                                                   : tr("in %1").arg(membershipCommand->keySetFile());
+        }
+        //Raw key of hashed command is not known
+        if (cmd->hasKeyDigest() && role != Qt::EditRole)
+            return tr("(hashed)");
+        return cmd->key();
+    case ProgramColumn:
+        return (shellCommand != nullptr) ? shellCommand->program() : QVariant();
+    case ArgumentsColumn:
+        return (shellCommand != nullptr) ? shellCommand->argumentsString() : QVariant();
+    }
+
+    return QVariant();
+}
+
+bool CommandListModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+    Command* cmd = commandAt(index);
+    if (cmd == nullptr)
+        return false;
+
+    if (index.column() == EnabledColumn) {
+        if (role != Qt::CheckStateRole)
+            return false;
+
+        bool state = (value.toInt() == Qt::Checked);
+        if (cmd->isEnabled() != state)
+            cmd->setEnabled(state);
+        return true;
+    }
+
+    if (role != Qt::EditRole)
+        return false;
+
+    ShellCommand* shellCommand = cmd->to<ShellCommand>();
+    const QString text = value.toString();
+
+    switch (index.column()) {
+    case KeyColumn:
+        if (cmd->type() == Command::Membership)
+            return false;
+        if (cmd->key() != text)
+            cmd->setKey(text);
+        return true;
+    case ProgramColumn:
+        if (shellCommand == nullptr)
+            return false;
+        if (shellCommand->program() != text)
+            shellCommand->setProgram(text);
+        return true;
+    case ArgumentsColumn:
+        if (shellCommand == nullptr)
+            return false;
+        if (shellCommand->argumentsString() != text)
+            shellCommand->setArgumentsString(text);
+        return true;
+    }
+
+    return false;
+}
+
+QVariant CommandListModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    if (orientation == Qt::Vertical)
+        return section + 1;
+
+    switch (section) {
+    case EnabledColumn:
+        return tr("Enabled");
+    case KeyColumn:
+        return tr("Key");
+    case ProgramColumn:
+        return tr("Program");
+    case ArgumentsColumn:
+        return tr("Arguments");
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags CommandListModel::flags(const QModelIndex& index) const
+{
+    Command* cmd = commandAt(index);
+    if (cmd == nullptr)
+        return Qt::NoItemFlags;
+
+    Qt::ItemFlags result = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+
+    switch (index.column()) {
+    case EnabledColumn:
+        return result | Qt::ItemIsUserCheckable;
+    case KeyColumn:
+        return (cmd->type() != Command::Membership) ? (result | Qt::ItemIsEditable) : result;
+    case ProgramColumn:
+    case ArgumentsColumn:
+        return (cmd->to<ShellCommand>() != nullptr) ? (result | Qt::ItemIsEditable) : result;
+    }
+
+    return result;
+}
+
+/*
+ **********************************************************************************************************************
+ * Tracking changes in CommandList
+ */
+
+void CommandListModel::_commandAboutToBeAdded(int index)
+{
+    beginInsertRows(QModelIndex(),index,index);
+}
+
+void CommandListModel::_commandAdded()
+{
+    endInsertRows();
+}
+
+void CommandListModel::_commandAboutToBeRemoved(int index)
+{
+    beginRemoveRows(QModelIndex(),index,index);
+    m_removingRow = true;
+}
+
+void CommandListModel::_commandRemoved()
+{
+    //CommandList::clear() also emits commandRemoved for every Command, this is handled by model reset
+    if (!m_removingRow)
+        return;
+
+    m_removingRow = false;
+    endRemoveRows();
+}
+
+void CommandListModel::_commandListAboutToBeCleared()
+{
+    beginResetModel();
+}
+
+void CommandListModel::_commandListCleared()
+{
+    endResetModel();
+}
+
+void CommandListModel::_commandChanged(Command* command)
+{
+    int row = p_commandList->indexOf(command);
+    if (row < 0)
+        return;
+
+    emit dataChanged(index(row,0),index(row,ColumnCount-1));
+}
+
+void CommandListModel::_commandListDestroyed()
+{
+    //CommandList was deleted by its owner, so there is nothing to disconnect from
+    beginResetModel();
+    p_commandList = nullptr;
+    endResetModel();
+}
+
+void CommandListModel::_connectCommandList()
+{
+    connect(p_commandList,&CommandList::commandAboutToBeAdded,this,&CommandListModel::_commandAboutToBeAdded);
+    connect(p_commandList,&CommandList::commandAdded,this,&CommandListModel::_commandAdded);
+    connect(p_commandList,&CommandList::commandAboutToBeRemoved,this,&CommandListModel::_commandAboutToBeRemoved);
+    connect(p_commandList,&CommandList::commandRemoved,this,&CommandListModel::_commandRemoved);
+    connect(p_commandList,&CommandList::commandListAboutToBeCleared,this,&CommandListModel::_commandListAboutToBeCleared);
+    connect(p_commandList,&CommandList::commandListCleared,this,&CommandListModel::_commandListCleared);
+    connect(p_commandList,&CommandList::commandChanged,this,&CommandListModel::_commandChanged);
+    connect(p_commandList,&QObject::destroyed,this,&CommandListModel::_commandListDestroyed);
+}
+
+void CommandListModel::_disconnectCommandList()
+{
+    disconnect(p_commandList,nullptr,this,nullptr);
+}
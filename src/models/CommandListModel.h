@@ -0,0 +1,86 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDLISTMODEL_H
+#define COMMANDLISTMODEL_H
+
+#include <QAbstractTableModel>
+
+class Command;
+class CommandList;
+
+/*!
+ *  @class CommandListModel models/CommandListModel.h
+ *  @brief This class provides table model over CommandList object. Each row represents one Command object, so views
+ *         are creating editors only for the rows which are currently visible.
+ */
+
+class CommandListModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    /*! @brief This enum holds information about columns provided by this model */
+    enum Column {
+        EnabledColumn,     /*!< @brief Is command enabled. Represented by Qt::CheckStateRole */
+        KeyColumn,         /*!< @brief Key, activating command */
+        ProgramColumn,     /*!< @brief Program to start. Only for ShellCommand objects */
+        ArgumentsColumn,   /*!< @brief Command line arguments. Only for ShellCommand objects */
+        ColumnCount
+    };
+
+    explicit CommandListModel(QObject* parent = nullptr);
+    ~CommandListModel() {}
+
+    /*! @brief This method is used to set CommandList which will be represented by this model. Can be nullptr */
+    void            setCommandList(CommandList* commandList);
+    CommandList*    commandList() const                             { return p_commandList; }
+
+    /*! @brief Returns Command object displayed in the specified row, or nullptr if index is invalid */
+    Command*        commandAt(const QModelIndex& index) const;
+
+    int             rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int             columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    QVariant        data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool            setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    QVariant        headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags   flags(const QModelIndex& index) const override;
+
+private slots:
+    void _commandAboutToBeAdded(int index);
+    void _commandAdded();
+    void _commandAboutToBeRemoved(int index);
+    void _commandRemoved();
+    void _commandListAboutToBeCleared();
+    void _commandListCleared();
+    void _commandChanged(Command* command);
+    void _commandListDestroyed();
+
+private:
+    void            _connectCommandList();
+    void            _disconnectCommandList();
+
+    CommandList*    p_commandList;
+    bool            m_removingRow;
+};
+
+#endif // COMMANDLISTMODEL_H
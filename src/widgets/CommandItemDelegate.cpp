@@ -0,0 +1,78 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CommandItemDelegate.h"
+
+#include <QLineEdit>
+
+#include "models/CommandListModel.h"
+
+CommandItemDelegate::CommandItemDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{}
+
+QWidget* CommandItemDelegate::createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    QLineEdit* editor = nullptr;
+
+    switch (index.column()) {
+    case CommandListModel::KeyColumn:
+        editor = new QLineEdit(parent);
+        editor->setPlaceholderText(tr("Key, activating command"));
+        break;
+    case CommandListModel::ProgramColumn:
+        editor = new QLineEdit(parent);
+        editor->setPlaceholderText(tr("Program to start"));
+        break;
+    case CommandListModel::ArgumentsColumn:
+        editor = new QLineEdit(parent);
+        editor->setPlaceholderText(tr("Command line arguments"));
+        break;
+    default:
+        return QStyledItemDelegate::createEditor(parent,option,index);
+    }
+
+    editor->setFrame(false);
+    return editor;
+}
+
+void CommandItemDelegate::setEditorData(QWidget* editor, const QModelIndex& index) const
+{
+    QLineEdit* lineEdit = qobject_cast<QLineEdit*>(editor);
+    if (lineEdit == nullptr) {
+        QStyledItemDelegate::setEditorData(editor,index);
+        return;
+    }
+
+    lineEdit->setText(index.data(Qt::EditRole).toString());
+}
+
+void CommandItemDelegate::setModelData(QWidget* editor, QAbstractItemModel* model, const QModelIndex& index) const
+{
+    QLineEdit* lineEdit = qobject_cast<QLineEdit*>(editor);
+    if (lineEdit == nullptr) {
+        QStyledItemDelegate::setModelData(editor,model,index);
+        return;
+    }
+
+    model->setData(index,lineEdit->text(),Qt::EditRole);
+}
@@ -0,0 +1,46 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMANDITEMDELEGATE_H
+#define COMMANDITEMDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+/*!
+ *  @class CommandItemDelegate widgets/CommandItemDelegate.h
+ *  @brief This delegate is used to edit Command objects displayed by CommandListModel. Editor widget exists only
+ *         while user is editing specific cell.
+ */
+
+class CommandItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit CommandItemDelegate(QObject* parent = nullptr);
+    ~CommandItemDelegate() {}
+
+    QWidget*  createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    void      setEditorData(QWidget* editor, const QModelIndex& index) const override;
+    void      setModelData(QWidget* editor, QAbstractItemModel* model, const QModelIndex& index) const override;
+};
+
+#endif // COMMANDITEMDELEGATE_H
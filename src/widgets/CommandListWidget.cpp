@@ -22,44 +22,45 @@
 
 #include "CommandListWidget.h"
 
+#include <QAction>
+#include <QEvent>
+#include <QHeaderView>
+#include <QLineEdit>
 #include <QMenu>
+#include <QMouseEvent>
+#include <QTableView>
 #include <QVBoxLayout>
-#include <QScrollArea>
 
-#include "CommandEditWidget.h"
+#include "CommandItemDelegate.h"
+#include "core/commands/Command.h"
 #include "core/commands/CommandList.h"
+#include "models/CommandListFilterModel.h"
+#include "models/CommandListModel.h"
 
 CommandListWidget::CommandListWidget(QWidget* parent)
     : QWidget(parent),p_currentCommandList(nullptr)
 {
     _setupUi();
 
-    setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(this,&CommandListWidget::customContextMenuRequested,this,&CommandListWidget::_contextMenuRequested);
+    w_commandsView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(w_commandsView,&QTableView::customContextMenuRequested,this,&CommandListWidget::_contextMenuRequested);
 
-    setToolTip(tr("Double click to add new empty command"));
+    w_commandsView->viewport()->installEventFilter(this);
+    w_commandsView->setToolTip(tr("Double click on empty space to add new empty command"));
 }
 
 void CommandListWidget::setModel(CommandList* model)
 {
-    if (p_currentCommandList != nullptr) {
-        disconnect(p_currentCommandList,&CommandList::commandRemoved,this,&CommandListWidget::_commandRemoved);
-        disconnect(p_currentCommandList,&CommandList::commandAdded,this,&CommandListWidget::_commandAdded);
+    if (p_currentCommandList != nullptr)
         disconnect(p_currentCommandList,&CommandList::commandListChanged,this,&CommandListWidget::_commandListChanged);
-        _clearView();
-    }
 
     p_currentCommandList = model;
+    p_commandListModel->setCommandList(model);
+
     if (p_currentCommandList == nullptr)
         return;
 
-    connect(p_currentCommandList,&CommandList::commandRemoved,this,&CommandListWidget::_commandRemoved);
-    connect(p_currentCommandList,&CommandList::commandAdded,this,&CommandListWidget::_commandAdded);
     connect(p_currentCommandList,&CommandList::commandListChanged,this,&CommandListWidget::_commandListChanged);
-
-    for (int i = 0; i < p_currentCommandList->count(); i++) {
-        _commandAdded(p_currentCommandList->at(i));
-    }
 }
 
 void CommandListWidget::clear()
@@ -68,50 +69,49 @@ void CommandListWidget::clear()
         p_currentCommandList->clear();
 }
 
-void CommandListWidget::mouseDoubleClickEvent(QMouseEvent *event)
+bool CommandListWidget::eventFilter(QObject* watched, QEvent* event)
 {
-    _commandAdditionRequested();
+    if (watched == w_commandsView->viewport() && event->type() == QEvent::MouseButtonDblClick) {
+        QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+        if (!w_commandsView->indexAt(mouseEvent->pos()).isValid()) {
+            _commandAdditionRequested();
+            return true;
+        }
+    }
 
-    QWidget::mouseDoubleClickEvent(event);
+    return QWidget::eventFilter(watched,event);
 }
 
 void CommandListWidget::_commandAdditionRequested()
 {
-    if (p_currentCommandList != nullptr)
-        p_currentCommandList->append(Command::create(Command::Shell));
-
-}
+    if (p_currentCommandList == nullptr)
+        return;
 
-void CommandListWidget::_commandAdded(Command* command)
-{
-    CommandEditWidget* cmdWidget = CommandEditWidget::create(command->type());
+    //Otherwise new empty command may be hidden by the current search string
+    w_searchEdit->clear();
 
-    connect(cmdWidget,&CommandEditWidget::removeCurrentCommand,this,&CommandListWidget::_commandRemovalRequested);
+    p_currentCommandList->append(Command::create(Command::Shell));
 
-    cmdWidget->setCurrentCommand(command);
-    m_widgetList.append(cmdWidget);
-    w_scrollableLayout->insertWidget(w_scrollableLayout->count()-1,cmdWidget); //w_scrollableLayout has stretch in the end.
-                                                                               //So we need insert widget at one before last position
+    QModelIndex newIndex = p_filterModel->mapFromSource(
+        p_commandListModel->index(p_currentCommandList->count()-1,CommandListModel::KeyColumn));
+    w_commandsView->scrollTo(newIndex);
+    w_commandsView->setCurrentIndex(newIndex);
+    w_commandsView->edit(newIndex);
 }
 
 void CommandListWidget::_commandRemovalRequested()
 {
-    CommandEditWidget* senderWidget = qobject_cast<CommandEditWidget*>(sender());
-    Q_ASSERT(senderWidget != nullptr);
-    p_currentCommandList->removeCommand(senderWidget->currentCommand());
-}
+    if (p_currentCommandList == nullptr)
+        return;
 
-void CommandListWidget::_commandRemoved(Command* command)
-{
-    for (int i = 0; i < m_widgetList.count(); i++) {
-        CommandEditWidget* current = m_widgetList.at(i);
-
-        if (current->currentCommand() == command) {
-            w_scrollableLayout->removeWidget(current);
-            m_widgetList.removeAll(current);
-            current->deleteLater();
-            return;
-        }
+    //Collect commands first, as removing rows is changing indexes of the other rows
+    QList<Command*> selectedCommands;
+    for (const QModelIndex& index : w_commandsView->selectionModel()->selectedRows())
+        selectedCommands.append(p_commandListModel->commandAt(p_filterModel->mapToSource(index)));
+
+    for (Command* command : selectedCommands) {
+        if (command != nullptr)
+            p_currentCommandList->removeCommand(command);
     }
 }
 
@@ -124,19 +124,11 @@ void CommandListWidget::_contextMenuRequested(const QPoint& point)
 {
     QMenu contextMenu;
     contextMenu.addAction(tr("Add command"),this,&CommandListWidget::_commandAdditionRequested);
+    QAction* removeAction = contextMenu.addAction(tr("Remove selected"),this,&CommandListWidget::_commandRemovalRequested);
+    removeAction->setEnabled(w_commandsView->selectionModel()->hasSelection());
     contextMenu.addAction(tr("Clear"),this,&CommandListWidget::clear);
 
-    contextMenu.exec(mapToGlobal(point));
-}
-
-void CommandListWidget::_clearView()
-{
-    for (CommandEditWidget* widget : m_widgetList) {
-        w_scrollableLayout->removeWidget(widget);
-        widget->deleteLater();
-    }
-
-    m_widgetList.clear();
+    contextMenu.exec(w_commandsView->viewport()->mapToGlobal(point));
 }
 
 /*
@@ -148,17 +140,39 @@ void CommandListWidget::_setupUi()
 {
     QVBoxLayout* mainLayout = new QVBoxLayout;
 
-    w_commandsScrollArea = new QScrollArea;
-    w_commandsScrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    w_commandsScrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    w_commandsScrollArea->setWidgetResizable(true);
-
-    w_scrollableLayout = new QVBoxLayout;
-    w_scrollableLayout->addStretch();
-    w_commandsContainerWidget = new QWidget;
-    w_commandsContainerWidget->setLayout(w_scrollableLayout);
-    w_commandsScrollArea->setWidget(w_commandsContainerWidget);
-
-    mainLayout->addWidget(w_commandsScrollArea);
+    p_commandListModel = new CommandListModel(this);
+    p_filterModel = new CommandListFilterModel(this);
+    p_filterModel->setSourceModel(p_commandListModel);
+
+    w_searchEdit = new QLineEdit;
+    w_searchEdit->setPlaceholderText(tr("Search by key or program"));
+    w_searchEdit->setClearButtonEnabled(true);
+    connect(w_searchEdit,&QLineEdit::textChanged,p_filterModel,&CommandListFilterModel::setSearchString);
+    mainLayout->addWidget(w_searchEdit);
+
+    w_commandsView = new QTableView;
+    w_commandsView->setModel(p_filterModel);
+    w_commandsView->setItemDelegate(new CommandItemDelegate(w_commandsView));
+    w_commandsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    w_commandsView->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed
+                                    | QAbstractItemView::AnyKeyPressed);
+    w_commandsView->setWordWrap(false);
+    w_commandsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    w_commandsView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    //Fixed row height - so the view does not need to measure every row of large CommandList
+    w_commandsView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    w_commandsView->horizontalHeader()->setSectionResizeMode(CommandListModel::EnabledColumn,QHeaderView::ResizeToContents);
+    w_commandsView->horizontalHeader()->setSectionResizeMode(CommandListModel::KeyColumn,QHeaderView::Stretch);
+    w_commandsView->horizontalHeader()->setSectionResizeMode(CommandListModel::ProgramColumn,QHeaderView::Stretch);
+    w_commandsView->horizontalHeader()->setSectionResizeMode(CommandListModel::ArgumentsColumn,QHeaderView::Stretch);
+
+    QAction* removeAction = new QAction(tr("Remove selected"),w_commandsView);
+    removeAction->setShortcut(QKeySequence::Delete);
+    removeAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(removeAction,&QAction::triggered,this,&CommandListWidget::_commandRemovalRequested);
+    w_commandsView->addAction(removeAction);
+
+    mainLayout->addWidget(w_commandsView);
     setLayout(mainLayout);
 }
@@ -25,18 +25,19 @@
 
 #include <QWidget>
 
-#include <QList>
-
-class QScrollArea;
-class QVBoxLayout;
+class QLineEdit;
+class QTableView;
 
 class Command;
 class CommandList;
-class CommandEditWidget;
+class CommandListFilterModel;
+class CommandListModel;
 
 /*!
  *  @class CommandListWidget widgets/CommandListWidget.h
  *  @brief This widget is used to display CommandList object as well as allow user to edit and interact with its data
+ *  @details Commands are displayed by QTableView over CommandListModel, so only visible rows are painted and editors
+ *           are created only for the cell which is being edited.
  */
 
 class CommandListWidget : public QWidget
@@ -54,37 +55,28 @@ public slots:
     void clear();
 
 protected:
-    /*! @brief Reimplementing this method to allow user create new commands by double-click */
-    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    /*! @brief Reimplementing this method to allow user create new commands by double-click on empty space */
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
 private slots:
     void _commandAdditionRequested();
 
-    /*! @brief This slot is invoked when Command was added to the currently displayed CommandList */
-    void _commandAdded(Command* comm1and);
-
-    /*! @brief This slot is invoked when user requests to remove one of the active commands */
+    /*! @brief This slot is invoked when user requests to remove selected commands */
     void _commandRemovalRequested();
 
-    /*! @brief This slot should be invoked when Command was removed from the currently displayed CommandList */
-    void _commandRemoved(Command* command);
-
     /*! @brief This slot should be invoked when the currently displayed CommandList was changed */
     void _commandListChanged();
 
     void _contextMenuRequested(const QPoint& point);
 
 private:
-    /*! @brief This method just removes all displayed widgets */
-    void _clearView();
-
     inline void _setupUi();
     CommandList*                  p_currentCommandList;
-    QWidget*                      w_commandsContainerWidget;
-    QVBoxLayout*                  w_scrollableLayout;
-    QList<CommandEditWidget*>     m_widgetList;
-    QScrollArea*                  w_commandsScrollArea;
+    CommandListModel*             p_commandListModel;
+    CommandListFilterModel*       p_filterModel;
 
+    QLineEdit*                    w_searchEdit;
+    QTableView*                   w_commandsView;
 };
 
 #endif // COMMANDLISTWIDGET_H
@@ -25,6 +25,7 @@
 #include <QApplication>
 #include <QButtonGroup>
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDebug>
 #include <QFileDialog>
 #include <QHBoxLayout>
@@ -34,25 +35,41 @@
 #include <QPlainTextEdit>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QScrollBar>
+#include <QSpinBox>
 #include <QVBoxLayout>
 
 #include "appconfig/LoggerWidgetSettings.h"
 
+//Lines are rendered not more often than once per frame
+static const int FLUSH_INTERVAL_MS = 16;
+
 LogWidget::LogWidget(QWidget *parent)
-    : QWidget{parent}
+    : QWidget{parent},
+      m_lines(loggerWidgetSettings->maxLineCount()),
+      m_pendingLineCount(0)
 {
     _setupUi();
 
     w_logToWidgetCheckBox->setChecked(loggerWidgetSettings->logToWidget());
     w_textEdit->setEnabled(loggerWidgetSettings->logToWidget());
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer,&QTimer::timeout,this,&LogWidget::_flushPendingLines);
 }
 
-void LogWidget::appendLine(const QString logLine)
+void LogWidget::appendLine(Logger::EventType type, const QString& logLine)
 {
     if (!w_logToWidgetCheckBox->isChecked())
         return;
 
-    w_textEdit->appendPlainText(logLine);
+    m_lines.append({type,logLine});
+    m_pendingLineCount = qMin(m_pendingLineCount + 1,m_lines.count());
+
+    //While widget is hidden - lines are only buffered. They will be rendered in showEvent
+    if (isVisible() && !m_flushTimer.isActive())
+        m_flushTimer.start();
 }
 
 void LogWidget::logFileNameChaged(const QFileInfo& newLogFileInfo)
@@ -63,9 +80,81 @@ void LogWidget::logFileNameChaged(const QFileInfo& newLogFileInfo)
 
 void LogWidget::clearLogWidget()
 {
+    m_flushTimer.stop();
+    m_lines.clear();
+    m_pendingLineCount = 0;
     w_textEdit->clear();
 }
 
+void LogWidget::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+
+    if (m_pendingLineCount > 0)
+        _flushPendingLines();
+}
+
+void LogWidget::hideEvent(QHideEvent* event)
+{
+    m_flushTimer.stop();
+
+    QWidget::hideEvent(event);
+}
+
+void LogWidget::_flushPendingLines()
+{
+    if (m_pendingLineCount == 0)
+        return;
+
+    //Collect all pending lines, so that document is changed (and relayouted) only once
+    QStringList newLines;
+    for (int i = m_lines.count() - m_pendingLineCount; i < m_lines.count(); i++) {
+        if (_isDisplayed(m_lines.at(i).type))
+            newLines.append(m_lines.at(i).text);
+    }
+    m_pendingLineCount = 0;
+
+    if (newLines.isEmpty())
+        return;
+
+    //QPlainTextEdit::maximumBlockCount is equal to the m_lines capacity, so document is trimmed automatically
+    w_textEdit->appendPlainText(newLines.join('\n'));
+}
+
+void LogWidget::_maxLineCountChanged(int count)
+{
+    loggerWidgetSettings->setMaxLineCount(count);
+
+    m_lines.setCapacity(count);
+    m_pendingLineCount = qMin(m_pendingLineCount,m_lines.count());
+    w_textEdit->setMaximumBlockCount(count);
+}
+
+void LogWidget::_renderAllLines()
+{
+    m_flushTimer.stop();
+
+    //Only event types of the buffered lines are checked here, text is not scanned
+    QStringList lines;
+    for (int i = 0; i < m_lines.count(); i++) {
+        if (_isDisplayed(m_lines.at(i).type))
+            lines.append(m_lines.at(i).text);
+    }
+    m_pendingLineCount = 0;
+
+    w_textEdit->setPlainText(lines.join('\n'));
+    w_textEdit->verticalScrollBar()->setValue(w_textEdit->verticalScrollBar()->maximum());
+}
+
+bool LogWidget::_isDisplayed(Logger::EventType type) const
+{
+    QVariant selectedType = w_eventTypeFilter->currentData();
+    if (!selectedType.isValid())
+        return true;
+
+    return (selectedType.toInt() == type);
+}
+
 void LogWidget::_newLogFileButtonPressed()
 {
     QString oldLogDirectory = (w_logFilePath->text().isEmpty()) ? QDir::homePath() : w_logFilePath->text();
@@ -105,8 +194,32 @@ void LogWidget::_setupUi()
 
     w_textEdit = new QPlainTextEdit;
     w_textEdit->setReadOnly(true);
+    w_textEdit->setUndoRedoEnabled(false);
+    w_textEdit->setMaximumBlockCount(m_lines.capacity());
     mainLayout->addWidget(w_textEdit);
 
+    QHBoxLayout* displayOptionsLayout = new QHBoxLayout;
+    displayOptionsLayout->addWidget(new QLabel(tr("Show:")));
+    w_eventTypeFilter = new QComboBox;
+    w_eventTypeFilter->addItem(tr("All events"));
+    w_eventTypeFilter->addItem(tr("Keys"),Logger::KeyLogEvent);
+    w_eventTypeFilter->addItem(tr("Errors"),Logger::ErrorEvent);
+    w_eventTypeFilter->addItem(tr("Devices"),Logger::DeviceEvent);
+    w_eventTypeFilter->addItem(tr("Commands"),Logger::CommandEvent);
+    w_eventTypeFilter->addItem(tr("Application"),Logger::ApplicationEvent);
+    connect(w_eventTypeFilter,QOverload<int>::of(&QComboBox::currentIndexChanged),this,&LogWidget::_renderAllLines);
+    displayOptionsLayout->addWidget(w_eventTypeFilter);
+    displayOptionsLayout->addStretch();
+    displayOptionsLayout->addWidget(new QLabel(tr("Lines to keep:")));
+    w_maxLineCount = new QSpinBox;
+    w_maxLineCount->setRange(LoggerWidgetSettings::MINIMAL_LINE_COUNT,LoggerWidgetSettings::MAXIMAL_LINE_COUNT);
+    w_maxLineCount->setSingleStep(1000);
+    w_maxLineCount->setValue(m_lines.capacity());
+    w_maxLineCount->setKeyboardTracking(false);
+    connect(w_maxLineCount,QOverload<int>::of(&QSpinBox::valueChanged),this,&LogWidget::_maxLineCountChanged);
+    displayOptionsLayout->addWidget(w_maxLineCount);
+    mainLayout->addLayout(displayOptionsLayout);
+
     QHBoxLayout* controlButtonsLayout = new QHBoxLayout;
     QPushButton* newLogFileButton = new QPushButton(tr("New log file"));
     connect(newLogFileButton,&QPushButton::clicked,this,&LogWidget::_newLogFileButtonPressed);
@@ -26,14 +26,22 @@
 #include <QWidget>
 
 class QCheckBox;
+class QComboBox;
 class QLineEdit;
 class QPlainTextEdit;
+class QSpinBox;
 
 #include <QFileInfo>
+#include <QTimer>
+
+#include "core/Logger.h"
+#include "core/RingBuffer.h"
 
 /*!
  *  @class LogWidget widgets/LogWidget.h
  *  @brief This widget is used to display logged events as well as control some functions of Logger objects.
+ *  @details Only the last LoggerWidgetSettings::maxLineCount lines are kept. New lines are rendered at most once per
+ *           frame and are not rendered at all while widget is hidden.
  */
 
 class LogWidget : public QWidget
@@ -54,8 +62,9 @@ signals:
     void logFileClosureRequested();
 
 public slots:
-    /*! @brief This slot should be invoked when some new line was attached to log. Just displaying it. */
-    void appendLine(const QString logLine);
+    /*! @brief This slot should be invoked when some new line was attached to log. Line is displayed with next
+     *         rendered frame. */
+    void appendLine(Logger::EventType type, const QString& logLine);
 
     /*! @brief This slot should be invoked when log file has changed (e.g. name was changed). */
     void logFileNameChaged(const QFileInfo& newLogFileInfo);
@@ -63,15 +72,37 @@ public slots:
     /*! @brief This slot is used to clear log display widget from old events. New events will be appended to empty widget. */
     void clearLogWidget();
 
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private slots:
+    void _flushPendingLines();
+    void _maxLineCountChanged(int count);
+
 private:
     void _newLogFileButtonPressed();
     void _appendlogFileButtonPressed();
 
+    /*! @brief Re-renders all buffered lines, which are matching currently selected event type */
+    void _renderAllLines();
+    bool _isDisplayed(Logger::EventType type) const;
+
+    struct LogLine {
+        Logger::EventType  type;
+        QString            text;
+    };
+    RingBuffer<LogLine>  m_lines;
+    int                  m_pendingLineCount;
+    QTimer               m_flushTimer;
+
 private:
     inline void     _setupUi();
     QPlainTextEdit* w_textEdit;
     QLineEdit*      w_logFilePath;
     QCheckBox*      w_logToWidgetCheckBox;
+    QComboBox*      w_eventTypeFilter;
+    QSpinBox*       w_maxLineCount;
 
     QFileInfo       m_logFileInfo;
 };
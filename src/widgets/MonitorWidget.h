@@ -32,8 +32,6 @@ class QEvent;
 class QLabel;
 class QLineEdit;
 
-class ShellCommandEditWidget;
-
 /*!
  *  @class MonitorWidget widgets/MonitorWidget.h
  *  @brief This is the class for central widget. Can display last readed key and contains CommandListWidget object
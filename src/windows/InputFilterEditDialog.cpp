@@ -115,7 +115,7 @@ void InputFilterEditDialog::_setupUi()
     w_vendorIdSelector = new QComboBox;
     w_vendorIdSelector->addItem(tr("<Add new vendor_id>"));
     connect(w_vendorIdSelector,qOverload<int>(&QComboBox::currentIndexChanged),
-            [=](int index){ w_vendorIdSpinBox->setValue(w_vendorIdSelector->itemData(index).toUInt()); }
+            [this](int index){ w_vendorIdSpinBox->setValue(w_vendorIdSelector->itemData(index).toUInt()); }
     );
     paramsLayout->addWidget(w_vendorIdSelector,0,2);
 
@@ -153,7 +153,7 @@ void InputFilterEditDialog::_setupUi()
     w_productIdSelector = new QComboBox;
     w_productIdSelector->addItem(tr("<Add new product_id>"));
     connect(w_productIdSelector,qOverload<int>(&QComboBox::currentIndexChanged),
-            [=](int index){ w_productIdSpinBox->setValue(w_productIdSelector->itemData(index).toUInt()); }
+            [this](int index){ w_productIdSpinBox->setValue(w_productIdSelector->itemData(index).toUInt()); }
     );
     paramsLayout->addWidget(w_productIdSelector,1,2);
 
@@ -194,7 +194,7 @@ void InputFilterEditDialog::_setupUi()
     w_deviceNameSelector = new QComboBox;
     w_deviceNameSelector->addItem(tr("<Add new device name>"));
     connect(w_deviceNameSelector,qOverload<int>(&QComboBox::currentIndexChanged),
-            [=](int index){ w_deviceNameEdit->setText(w_deviceNameSelector->itemData(index).toString()); }
+            [this](int index){ w_deviceNameEdit->setText(w_deviceNameSelector->itemData(index).toString()); }
     );
     paramsLayout->addWidget(w_deviceNameSelector,2,2);
 
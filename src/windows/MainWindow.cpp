@@ -231,15 +231,35 @@ void MainWindow::_saveCommandsFile()
 }
 
 void MainWindow::_saveCommandsFileAs()
+{
+    QString fileName = _selectSaveFileName();
+
+    if (!fileName.isEmpty())
+        p_controller->saveCurrentCommandsListAs(fileName);
+}
+
+void MainWindow::_saveCommandsFileWithHashedKeys()
+{
+    QString fileName = _selectSaveFileName();
+    if (fileName.isEmpty())
+        return;
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this,qApp->applicationName(),
+                tr("Keys of commands will be replaced with their digests and can not be shown or restored later. "
+                   "File can be opened only with the digest secret from settings of this application. Continue?"));
+    if (answer != QMessageBox::Yes)
+        return;
+
+    p_controller->saveCurrentCommandsListAs(fileName,true);
+}
+
+QString MainWindow::_selectSaveFileName()
 {
     QFileInfo currentFileInfo = p_controller->currentFileInfo();
     QDir searchDir = (currentFileInfo.exists()) ? currentFileInfo.dir() : QDir::home();
 
-    QString fileName = QFileDialog::getSaveFileName(this,tr("Save commands file - %1").arg(qApp->applicationName()),
+    return QFileDialog::getSaveFileName(this,tr("Save commands file - %1").arg(qApp->applicationName()),
                 searchDir.path(),tr("cmds (*.cmds);; All files (*.*)"));
-
-    if (!fileName.isEmpty())
-        p_controller->saveCurrentCommandsListAs(fileName);
 }
 
 void MainWindow::_closeCommandsFile()
@@ -747,6 +767,8 @@ void MainWindow::_setupMenus()
     connect(saveCommandsFileAction,&QAction::triggered,this,&MainWindow::_saveCommandsFile);
     QAction* saveCommandsFileAsAction = fileMenu->addAction(tr("Save As"));
     connect(saveCommandsFileAsAction,&QAction::triggered,this,&MainWindow::_saveCommandsFileAs);
+    QAction* saveWithHashedKeysAction = fileMenu->addAction(tr("Save As with Hashed Keys"));
+    connect(saveWithHashedKeysAction,&QAction::triggered,this,&MainWindow::_saveCommandsFileWithHashedKeys);
 
     w_recentFilesMenu = fileMenu->addMenu(tr("Recent"));
     w_recentFilesActions = new QActionGroup(w_recentFilesMenu);
@@ -879,6 +901,12 @@ void MainWindow::_connectController()
     connect(p_controller,&RfidController::commandFileNameChanged,this,&MainWindow::commandsFileInfoChanged);
     connect(p_controller,&RfidController::commandsFileModified,this,&MainWindow::commandsFileModified);
 
+    //Command list can be loaded before this window is created (e.g. when window is created lazily)
+    if (p_controller->currentCommandsList() != nullptr) {
+        setCommandList(p_controller->currentCommandsList());
+        commandsFileInfoChanged(p_controller->currentFileInfo());
+    }
+
 #ifdef HID
     //
     //Input devices
@@ -887,6 +915,10 @@ void MainWindow::_connectController()
     //Add devices, which are already attached to the system
     w_inputDeviceSelectorMenu->setCurrentInputDeviceList(p_controller->inputDeviceManager()->availableInputDevices());
 
+    //Devices can be opened before this window is created
+    for (const InputDeviceInfo& deviceInfo : p_controller->inputDeviceManager()->openedInputDevices())
+        w_inputDeviceSelectorMenu->deviceWasOpened(deviceInfo);
+
     //Refreshing
     connect(w_inputDeviceSelectorMenu,&InputDeviceSelectorMenu::updateRequested,p_controller->inputDeviceManager(),&InputDeviceManager::updateInputDeviceList);
 
@@ -920,6 +952,10 @@ void MainWindow::_connectController()
     //
     w_serialDeviceSelectorMenu->setCurrentSerialDeviceList(p_controller->serialDeviceManager()->availableDevices());
 
+    //Devices can be opened before this window is created
+    for (const QSerialPortInfo& portInfo : p_controller->serialDeviceManager()->openedSerialDevices())
+        w_serialDeviceSelectorMenu->deviceWasOpened(portInfo);
+
     //Refreshing
     connect(w_serialDeviceSelectorMenu,&SerialDeviceSelectorMenu::updateRequested,p_controller->serialDeviceManager(),&SerialDeviceManager::updateSerialDeviceList);
 
@@ -964,6 +1000,9 @@ void MainWindow::_connectController()
     w_loggingMenu->setLogClosedDevicesChecked(p_controller->logger()->logClosedDevices());
     connect(w_loggingMenu,&LoggingMenu::logClosedDevicesTriggered,p_controller->logger(),&Logger::setClosedDeviceLogging);
 
+    w_loggingMenu->setLogCommandsChecked(p_controller->logger()->logCommands());
+    connect(w_loggingMenu,&LoggingMenu::logCommandsTriggered,p_controller->logger(),&Logger::setCommandsLogging);
+
     w_loggingMenu->setLogErrorsChecked(p_controller->logger()->logErrors());
     connect(w_loggingMenu,&LoggingMenu::logErrorsTriggered,p_controller->logger(),&Logger::setLoggingErrors);
 
@@ -89,6 +89,7 @@ private slots:
     void _openCommandsFile();
     void _saveCommandsFile();
     void _saveCommandsFileAs();
+    void _saveCommandsFileWithHashedKeys();
     void _closeCommandsFile();
 
     //Recent files
@@ -119,6 +120,7 @@ private:
     void _showError(const QString& messageText,Notification::Type type);
 
     bool _maybeSave();
+    QString _selectSaveFileName();
 
     //UI-Related
     inline void _setupUi();
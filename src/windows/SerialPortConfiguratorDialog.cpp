@@ -35,6 +35,9 @@ SerialPortConfiguratorDialog::SerialPortConfiguratorDialog(QWidget* parent)
 
 void SerialPortConfiguratorDialog::displaySerialPortConfig(const SerialPortConfig& config)
 {
+    //Options, which are not displayed, are returned by serialPortConfig() unchanged
+    m_config = config;
+
     setBaudRate(config.baudRate());
     setStopBits(config.stopBits());
     setDataBits(config.dataBits());
@@ -44,7 +47,7 @@ void SerialPortConfiguratorDialog::displaySerialPortConfig(const SerialPortConfi
 
 SerialPortConfig SerialPortConfiguratorDialog::serialPortConfig() const
 {
-    SerialPortConfig result;
+    SerialPortConfig result(m_config);
 
     result.setBaudRate(baudRate());
     result.setStopBits(stopBits());
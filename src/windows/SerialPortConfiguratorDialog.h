@@ -58,6 +58,8 @@ public:
     void setFlowControl(QSerialPort::FlowControl flowControl);
 
 private:
+    SerialPortConfig    m_config;
+
     inline void         _setupUi();
     inline QComboBox*   _createBaudSelector();
     QComboBox*          w_baudSelector;
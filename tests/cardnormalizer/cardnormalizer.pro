@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = tst_cardnormalizer
+
+SOURCES += \
+    tst_cardnormalizer.cpp \
+    ../../src/core/cards/CardNormalizer.cpp
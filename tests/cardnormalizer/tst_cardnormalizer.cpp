@@ -0,0 +1,193 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/cards/CardNormalizer.h"
+
+Q_DECLARE_METATYPE(CardNormalizer::Format)
+
+class CardNormalizerTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+
+    void normalize_data();
+    void normalize();
+    void kindsDoNotCollide();
+    void proxBits();
+    void reverseUid();
+    void disabled();
+    void parseHex();
+    void parseDecimal();
+
+private:
+    /*! @brief Returns canonical form of key, or "INVALID" if key is invalid */
+    static QByteArray _normalize(const QByteArray& key, CardNormalizer::Format* format = nullptr);
+};
+
+QByteArray CardNormalizerTest::_normalize(const QByteArray& key, CardNormalizer::Format* format)
+{
+    char output[128];
+    const int length = cardNormalizer->normalize(key.constData(),key.size(),output,format);
+    return (length < 0) ? QByteArray("INVALID") : QByteArray(output,length);
+}
+
+void CardNormalizerTest::init()
+{
+    //Normalizer is a singleton, so settings changed by previous test are restored
+    cardNormalizer->setEnabled(true);
+    cardNormalizer->setProxBits(32);
+    cardNormalizer->setReverseUid(false);
+}
+
+void CardNormalizerTest::normalize_data()
+{
+    QTest::addColumn<QByteArray>("key");
+    QTest::addColumn<QByteArray>("expected");
+    QTest::addColumn<CardNormalizer::Format>("format");
+
+    QTest::newRow("decimal")            << QByteArray("0012345678")   << QByteArray("0012345678") << CardNormalizer::Decimal;
+    QTest::newRow("stx/etx")            << QByteArray("\x02""0012345678\x03") << QByteArray("0012345678") << CardNormalizer::Decimal;
+    QTest::newRow("spaces")             << QByteArray(" 0012345678 ") << QByteArray("0012345678") << CardNormalizer::Decimal;
+
+    QTest::newRow("em4100")             << QByteArray("0000BC614E")   << QByteArray("0000012345678") << CardNormalizer::Em4100;
+    QTest::newRow("em4100, lowercase")  << QByteArray("0000bc614e")   << QByteArray("0000012345678") << CardNormalizer::Em4100;
+    QTest::newRow("em4100, version")    << QByteArray("1A00BC614E")   << QByteArray("0111681495374") << CardNormalizer::Em4100;
+    QTest::newRow("em4100, other version") << QByteArray("2B00BC614E") << QByteArray("0184695939406") << CardNormalizer::Em4100;
+    QTest::newRow("em4100, checksum")   << QByteArray("1A00BC614E89") << QByteArray("0111681495374") << CardNormalizer::Em4100Checksum;
+    QTest::newRow("em4100, largest")    << QByteArray("FFFFFFFFFF")   << QByteArray("1099511627775") << CardNormalizer::Em4100;
+    QTest::newRow("em4100, digits")     << QByteArray("9999999999")   << QByteArray("0659706976665") << CardNormalizer::Em4100;
+
+    //12 digits with wrong checksum are most likely UPC-A barcode or 6-byte UID
+    QTest::newRow("checksum mismatch")  << QByteArray("036000291452") << QByteArray("036000291452") << CardNormalizer::Unknown;
+
+    QTest::newRow("facility,card")      << QByteArray("188,24910")    << QByteArray("0012345678") << CardNormalizer::FacilityCard;
+    QTest::newRow("facility too large") << QByteArray("70000,1")      << QByteArray("70000,1")    << CardNormalizer::Unknown;
+
+    QTest::newRow("wiegand26")          << QByteArray("11011110001100001010011100") << QByteArray("0012345678") << CardNormalizer::Wiegand26;
+    QTest::newRow("wiegand26, parity")  << QByteArray("11011110001100001010011101") << QByteArray("INVALID")    << CardNormalizer::Wiegand26;
+    QTest::newRow("wiegand34")          << QByteArray("1000000001011110001100001010011100") << QByteArray("0012345678") << CardNormalizer::Wiegand34;
+    QTest::newRow("h10304")             << QByteArray("0101010111100110100100100011010001010") << QByteArray("23058785093") << CardNormalizer::HidProx37;
+
+    QTest::newRow("uid, separators")    << QByteArray("04:a1:b2:c3")  << QByteArray("04A1B2C3")   << CardNormalizer::MifareUid;
+    QTest::newRow("uid")                << QByteArray("04A1B2C3")     << QByteArray("04A1B2C3")   << CardNormalizer::MifareUid;
+    QTest::newRow("uid, digits")        << QByteArray("12345678")     << QByteArray("12345678")   << CardNormalizer::MifareUid;
+    QTest::newRow("uid, 7 bytes")       << QByteArray("04-A1-B2-C3-D4-E5-F6") << QByteArray("04A1B2C3D4E5F6") << CardNormalizer::MifareUid;
+
+    QTest::newRow("text")               << QByteArray("hello")        << QByteArray("hello")      << CardNormalizer::Unknown;
+    QTest::newRow("short number")       << QByteArray("1234")         << QByteArray("1234")       << CardNormalizer::Unknown;
+    QTest::newRow("9 digits")           << QByteArray("012345678")    << QByteArray("012345678")  << CardNormalizer::Unknown;
+}
+
+void CardNormalizerTest::normalize()
+{
+    QFETCH(QByteArray,key);
+    QFETCH(QByteArray,expected);
+    QFETCH(CardNormalizer::Format,format);
+
+    CardNormalizer::Format detected = CardNormalizer::FormatCount;
+    QCOMPARE(_normalize(key,&detected),expected);
+    QCOMPARE(detected,format);
+}
+
+void CardNormalizerTest::kindsDoNotCollide()
+{
+    //Decimal card number, EM4100 card with the same number and UID with the same digits are different cards
+    QCOMPARE(_normalize("0012345678"),QByteArray("0012345678"));
+    QCOMPARE(_normalize("0000BC614E"),QByteArray("0000012345678"));
+    QCOMPARE(_normalize("12345678"),QByteArray("12345678"));
+
+    //Digits-only EM4100 key can not be told apart from decimal, so it must not match EM4100 with checksum either
+    QCOMPARE(_normalize("001234567808"),QByteArray("0000305419896"));
+    QVERIFY(_normalize("0012345678") != _normalize("001234567808"));
+
+    //Different encodings of the same card of one kind still match
+    QCOMPARE(_normalize("0000BC614E93"),_normalize("0000BC614E"));
+    QCOMPARE(_normalize("12:34:56:78"),_normalize("12345678"));
+    QCOMPARE(_normalize("188,24910"),_normalize("0012345678"));
+}
+
+void CardNormalizerTest::proxBits()
+{
+    cardNormalizer->setProxBits(24);
+    QCOMPARE(_normalize("0305419896"),QByteArray("0003430008"));
+    QCOMPARE(_normalize("188,24910"),QByteArray("0012345678"));
+
+    //EM4100 numbers are 40 bits wide, so they are never reduced
+    QCOMPARE(_normalize("1A00BC614E"),QByteArray("0111681495374"));
+
+    cardNormalizer->setProxBits(8);
+    QCOMPARE(cardNormalizer->proxBits(),24);
+    cardNormalizer->setProxBits(64);
+    QCOMPARE(cardNormalizer->proxBits(),32);
+}
+
+void CardNormalizerTest::reverseUid()
+{
+    cardNormalizer->setReverseUid(true);
+    QCOMPARE(_normalize("04A1B2C3"),QByteArray("C3B2A104"));
+    QCOMPARE(_normalize("04:A1:B2:C3"),QByteArray("C3B2A104"));
+
+    //Proximity cards are not affected
+    QCOMPARE(_normalize("0012345678"),QByteArray("0012345678"));
+}
+
+void CardNormalizerTest::disabled()
+{
+    cardNormalizer->setEnabled(false);
+
+    CardNormalizer::Format format = CardNormalizer::FormatCount;
+    QCOMPARE(_normalize("0000BC614E",&format),QByteArray("0000BC614E"));
+    QCOMPARE(format,CardNormalizer::Unknown);
+}
+
+void CardNormalizerTest::parseHex()
+{
+    quint64 value = 0;
+    QVERIFY(CardNormalizer::parseHex("FFFFFFFFFFFFFFFF",16,&value));
+    QCOMPARE(value,Q_UINT64_C(0xFFFFFFFFFFFFFFFF));
+
+    QVERIFY(CardNormalizer::parseHex("00bc614E",8,&value));
+    QCOMPARE(value,Q_UINT64_C(0xBC614E));
+
+    QVERIFY(!CardNormalizer::parseHex("0123456g",8,&value));
+    QVERIFY(!CardNormalizer::parseHex("01:3",4,&value));
+}
+
+void CardNormalizerTest::parseDecimal()
+{
+    quint64 value = 0;
+    QVERIFY(CardNormalizer::parseDecimal("1234567890123456789",19,&value));
+    QCOMPARE(value,Q_UINT64_C(1234567890123456789));
+
+    QVERIFY(CardNormalizer::parseDecimal("0012345678",10,&value));
+    QCOMPARE(value,Q_UINT64_C(12345678));
+
+    QVERIFY(!CardNormalizer::parseDecimal("12345:78",8,&value));
+    QVERIFY(!CardNormalizer::parseDecimal("12a",3,&value));
+}
+
+QTEST_APPLESS_MAIN(CardNormalizerTest)
+
+#include "tst_cardnormalizer.moc"
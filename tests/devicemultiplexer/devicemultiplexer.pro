@@ -0,0 +1,19 @@
+include(../tests.pri)
+
+DEFINES += METRICS
+
+TARGET = tst_devicemultiplexer
+
+HEADERS += \
+    ../../src/core/devices/DeviceMultiplexer.h \
+    ../../src/core/devices/EpollBackend.h \
+    ../../src/core/devices/IoUringBackend.h \
+    ../../src/core/devices/MultiplexerBackend.h
+
+SOURCES += \
+    tst_devicemultiplexer.cpp \
+    ../../src/core/devices/DeviceMultiplexer.cpp \
+    ../../src/core/devices/EpollBackend.cpp \
+    ../../src/core/devices/IoUringBackend.cpp \
+    ../../src/core/metrics/Metrics.cpp \
+    ../../src/core/metrics/MetricsRegistry.cpp
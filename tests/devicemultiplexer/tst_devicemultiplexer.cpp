@@ -0,0 +1,291 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "core/devices/DeviceMultiplexer.h"
+#include "core/metrics/MetricsRegistry.h"
+
+/*! @brief Collects data read by DeviceMultiplexer. If removeOnData is set - device is removed from within the call */
+class TestHandler : public DeviceMultiplexer::Handler
+{
+public:
+    QByteArray  data;
+    qint64      received = 0;
+    int         error = 0;
+    bool        removeOnData = false;
+
+    void _deviceDataRead(int fd, const char* buffer, int size) override {
+        data.append(buffer,size);
+        received += size;
+        if (removeOnData)
+            deviceMultiplexer->removeDevice(fd);
+    }
+
+    void _deviceReadFailed(int fd, int readError) override {
+        Q_UNUSED(fd);
+        error = readError;
+    }
+};
+
+/*! @brief Pipe standing in for device file. Read end is registered within DeviceMultiplexer */
+struct TestPipe
+{
+    int   readEnd = -1;
+    int   writeEnd = -1;
+
+    bool  open() {
+        int handles[2];
+        if (pipe2(handles, O_CLOEXEC) != 0)
+            return false;
+        readEnd = handles[0];
+        writeEnd = handles[1];
+        return true;
+    }
+
+    bool  write(const QByteArray& data) {
+        return ::write(writeEnd, data.constData(), data.size()) == data.size();
+    }
+
+    void  closeWriteEnd() {
+        ::close(writeEnd);
+        writeEnd = -1;
+    }
+
+    void  close() {
+        deviceMultiplexer->removeDevice(readEnd);
+        ::close(readEnd);
+        if (writeEnd >= 0)
+            ::close(writeEnd);
+        readEnd = writeEnd = -1;
+    }
+};
+
+/*! @brief Value of "backend" column of benchmark, which reads each pipe with its own QSocketNotifier and one read()
+ *         per notification, as InputDevice did before DeviceMultiplexer was introduced */
+static const int NOTIFIER_PER_DEVICE = -1;
+
+class DeviceMultiplexerTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+
+    void backendNames();
+
+    void dataIsRead_data()                      { _backends(); }
+    void dataIsRead();
+    void manyDevices_data()                     { _backends(); }
+    void manyDevices();
+    void endOfFileIsReported_data()             { _backends(); }
+    void endOfFileIsReported();
+    void deviceRemovedByHandler_data()          { _backends(); }
+    void deviceRemovedByHandler();
+
+    void benchmarkReading_data();
+    void benchmarkReading();
+
+private:
+    void      _backends();
+};
+
+void DeviceMultiplexerTest::_backends()
+{
+    QTest::addColumn<int>("backend");
+
+    QTest::newRow("epoll") << int(DeviceMultiplexer::Epoll);
+    QTest::newRow("io_uring") << int(DeviceMultiplexer::IoUring);
+}
+
+/*! @brief Switches DeviceMultiplexer to the backend of the current row, skips the row if it is not available */
+#define SELECT_BACKEND() \
+    QFETCH(int,backend); \
+    if ((backend != NOTIFIER_PER_DEVICE) && !deviceMultiplexer->setBackend(DeviceMultiplexer::Backend(backend))) \
+        QSKIP("Backend is not available");
+
+void DeviceMultiplexerTest::cleanup()
+{
+    QCOMPARE(deviceMultiplexer->deviceCount(),0);
+}
+
+void DeviceMultiplexerTest::backendNames()
+{
+    DeviceMultiplexer::Backend backend = DeviceMultiplexer::Epoll;
+    QVERIFY(DeviceMultiplexer::backendFromName("IO_URING",&backend));
+    QCOMPARE(backend,DeviceMultiplexer::IoUring);
+    QVERIFY(DeviceMultiplexer::backendFromName("epoll",&backend));
+    QCOMPARE(backend,DeviceMultiplexer::Epoll);
+    QVERIFY(!DeviceMultiplexer::backendFromName("select",&backend));
+}
+
+void DeviceMultiplexerTest::dataIsRead()
+{
+    SELECT_BACKEND();
+
+    TestPipe pipe;
+    QVERIFY(pipe.open());
+    TestHandler handler;
+    QVERIFY(deviceMultiplexer->addDevice(pipe.readEnd,&handler,64));
+
+    QVERIFY(pipe.write("0004567890\r\n"));
+    QTRY_COMPARE(handler.data,QByteArray("0004567890\r\n"));
+
+    //Data longer than the buffer is read in parts
+    const QByteArray longData(1000,'x');
+    QVERIFY(pipe.write(longData));
+    QTRY_COMPARE(handler.received,qint64(12 + longData.size()));
+    QCOMPARE(handler.error,0);
+
+    pipe.close();
+}
+
+void DeviceMultiplexerTest::manyDevices()
+{
+    SELECT_BACKEND();
+
+    static const int DEVICES = 32;
+    TestPipe pipes[DEVICES];
+    TestHandler handlers[DEVICES];
+    for (int i = 0; i < DEVICES; i++) {
+        QVERIFY(pipes[i].open());
+        QVERIFY(deviceMultiplexer->addDevice(pipes[i].readEnd,&handlers[i],64));
+    }
+    QCOMPARE(deviceMultiplexer->deviceCount(),DEVICES);
+
+    for (int i = 0; i < DEVICES; i++)
+        QVERIFY(pipes[i].write(QByteArray::number(i)));
+
+    for (int i = 0; i < DEVICES; i++)
+        QTRY_COMPARE(handlers[i].data,QByteArray::number(i));
+
+    for (int i = 0; i < DEVICES; i++)
+        pipes[i].close();
+}
+
+void DeviceMultiplexerTest::endOfFileIsReported()
+{
+    SELECT_BACKEND();
+
+    TestPipe pipe;
+    QVERIFY(pipe.open());
+    TestHandler handler;
+    QVERIFY(deviceMultiplexer->addDevice(pipe.readEnd,&handler,64));
+
+    QVERIFY(pipe.write("0004567890"));
+    pipe.closeWriteEnd();
+    QTRY_COMPARE(handler.error,EIO);
+    QCOMPARE(handler.data,QByteArray("0004567890"));
+
+    pipe.close();
+}
+
+void DeviceMultiplexerTest::deviceRemovedByHandler()
+{
+    SELECT_BACKEND();
+
+    TestPipe pipe;
+    QVERIFY(pipe.open());
+    TestHandler handler;
+    handler.removeOnData = true;
+    QVERIFY(deviceMultiplexer->addDevice(pipe.readEnd,&handler,4));
+
+    //Rest of the data is not passed to the handler, which has removed its device
+    QVERIFY(pipe.write("0004567890"));
+    QTRY_COMPARE(deviceMultiplexer->deviceCount(),0);
+    QTest::qWait(50);
+    QCOMPARE(handler.data,QByteArray("0004"));
+
+    ::close(pipe.readEnd);
+    ::close(pipe.writeEnd);
+}
+
+void DeviceMultiplexerTest::benchmarkReading_data()
+{
+    _backends();
+    QTest::newRow("notifier per device") << NOTIFIER_PER_DEVICE;
+}
+
+void DeviceMultiplexerTest::benchmarkReading()
+{
+    SELECT_BACKEND();
+
+    //Each of the readers sends key press of HID reader (EV_KEY and SYN_REPORT, 24 bytes each) at once
+    static const int DEVICES = 16;
+    static const int BUFFER_SIZE = 64 * 24;
+    const QByteArray record(2 * 24,'\x01');
+
+    TestPipe pipes[DEVICES];
+    TestHandler handler;
+    QList<QSocketNotifier*> notifiers;
+    quint64 notifierReads = 0;
+    for (int i = 0; i < DEVICES; i++) {
+        QVERIFY(pipes[i].open());
+        if (backend != NOTIFIER_PER_DEVICE) {
+            QVERIFY(deviceMultiplexer->addDevice(pipes[i].readEnd,&handler,BUFFER_SIZE));
+            continue;
+        }
+
+        const int fd = pipes[i].readEnd;
+        QSocketNotifier* notifier = new QSocketNotifier(fd,QSocketNotifier::Read,this);
+        connect(notifier,&QSocketNotifier::activated,this,[fd,&handler,&notifierReads]() {
+            char buffer[BUFFER_SIZE];
+            const ssize_t size = ::read(fd, buffer, sizeof(buffer));
+            notifierReads++;
+            if (size > 0)
+                handler._deviceDataRead(fd,buffer,int(size));
+        });
+        notifiers.append(notifier);
+    }
+
+    Counter* syscallsCounter = nullptr;
+    if (backend != NOTIFIER_PER_DEVICE) {
+        syscallsCounter = metricsRegistry->counter("rfid_multiplexer_syscalls_total",QString(),
+                                                   MetricsRegistry::label("backend",DeviceMultiplexer::backendName(DeviceMultiplexer::Backend(backend))));
+    }
+    const quint64 syscalls = (syscallsCounter != nullptr) ? syscallsCounter->value() : 0;
+
+    qint64 sent = 0;
+    QBENCHMARK {
+        for (int i = 0; i < DEVICES; i++)
+            pipes[i].write(record);
+        sent += DEVICES * record.size();
+
+        while (handler.received < sent)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    const quint64 records = sent / record.size();
+    const quint64 readSyscalls = (syscallsCounter != nullptr) ? syscallsCounter->value() - syscalls : notifierReads;
+    qInfo() << "Read system calls per record:"<<double(readSyscalls) / records;
+
+    qDeleteAll(notifiers);
+    for (int i = 0; i < DEVICES; i++)
+        pipes[i].close();
+}
+
+QTEST_GUILESS_MAIN(DeviceMultiplexerTest)
+
+#include "tst_devicemultiplexer.moc"
@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_fuzzykeyindex
+
+SOURCES += \
+    tst_fuzzykeyindex.cpp \
+    ../../src/core/cards/CardNormalizer.cpp \
+    ../../src/core/commands/FuzzyKeyIndex.cpp
@@ -0,0 +1,154 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <algorithm>
+
+#include "core/commands/FuzzyKeyIndex.h"
+
+class FuzzyKeyIndexTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void find_data();
+    void find();
+    void onlyNumbersAreIndexed();
+    void groups();
+    void maxDistanceIsBounded();
+    void clear();
+
+private:
+    FuzzyKeyIndex   m_index;
+};
+
+void FuzzyKeyIndexTest::initTestCase()
+{
+    QVERIFY(m_index.add("0012345678",10,1));
+    QVERIFY(m_index.add("0012345677",10,2));
+    QVERIFY(m_index.add("04A1B2C3",8,3));
+    QVERIFY(m_index.add("0087654321",10,4));
+    QVERIFY(m_index.add("0087654321",10,5));
+    QVERIFY(m_index.add("12345678",8,7));
+
+    m_index.build(2);
+    QCOMPARE(m_index.maxDistance(),2);
+}
+
+void FuzzyKeyIndexTest::find_data()
+{
+    QTest::addColumn<QByteArray>("key");
+    QTest::addColumn<int>("distance");
+    QTest::addColumn<bool>("ambiguous");
+    QTest::addColumn<QVector<int>>("entries");
+
+    QTest::newRow("exact")              << QByteArray("0012345678") << 0  << false << QVector<int>({1});
+    QTest::newRow("one bit")            << QByteArray("0011297102") << 1  << false << QVector<int>({1});
+    QTest::newRow("hex uid")            << QByteArray("04A1B2C2")   << 1  << false << QVector<int>({3});
+    QTest::newRow("hex uid, lowercase") << QByteArray("04a1b2c2")   << 1  << false << QVector<int>({3});
+    QTest::newRow("same key twice")     << QByteArray("0087654320") << 1  << false << QVector<int>({4, 5});
+    QTest::newRow("other length")       << QByteArray("12345679")   << 1  << false << QVector<int>({7});
+
+    //0012345679 is one bit away from both 0012345678 and 0012345677
+    QTest::newRow("ambiguous")          << QByteArray("0012345679") << -1 << true  << QVector<int>();
+    QTest::newRow("ambiguous, 2 bits")  << QByteArray("0012345423") << -1 << true  << QVector<int>();
+
+    QTest::newRow("too far")            << QByteArray("9999999999") << -1 << false << QVector<int>();
+    QTest::newRow("not a number")       << QByteArray("hello")      << -1 << false << QVector<int>();
+    QTest::newRow("no such group")      << QByteArray("04A1B2C3D4") << -1 << false << QVector<int>();
+    QTest::newRow("empty")              << QByteArray()             << -1 << false << QVector<int>();
+}
+
+void FuzzyKeyIndexTest::find()
+{
+    QFETCH(QByteArray,key);
+    QFETCH(int,distance);
+    QFETCH(bool,ambiguous);
+    QFETCH(QVector<int>,entries);
+
+    QVector<int> found({42});
+    bool foundAmbiguous = !ambiguous;
+    QCOMPARE(m_index.find(key.constData(),key.size(),&found,&foundAmbiguous),distance);
+    QCOMPARE(foundAmbiguous,ambiguous);
+
+    std::sort(found.begin(),found.end());
+    QCOMPARE(found,entries);
+}
+
+void FuzzyKeyIndexTest::onlyNumbersAreIndexed()
+{
+    FuzzyKeyIndex index;
+    QVERIFY(!index.add("hello",5,0));
+    QVERIFY(!index.add("12345678901234567890",20,0));
+    QVERIFY(index.isEmpty());
+}
+
+void FuzzyKeyIndexTest::groups()
+{
+    quint32 decimal10 = 0;
+    quint32 decimal8 = 0;
+    quint32 hex8 = 0;
+    quint64 value = 0;
+
+    QVERIFY(FuzzyKeyIndex::encode("0012345678",10,&decimal10,&value));
+    QCOMPARE(value,Q_UINT64_C(12345678));
+    QVERIFY(FuzzyKeyIndex::encode("12345678",8,&decimal8,&value));
+    QCOMPARE(value,Q_UINT64_C(12345678));
+    QVERIFY(FuzzyKeyIndex::encode("04A1B2C3",8,&hex8,&value));
+    QCOMPARE(value,Q_UINT64_C(0x04A1B2C3));
+
+    //Same value of another length or kind is another key
+    QVERIFY(decimal10 != decimal8);
+    QVERIFY(decimal8 != hex8);
+}
+
+void FuzzyKeyIndexTest::maxDistanceIsBounded()
+{
+    FuzzyKeyIndex index;
+    index.add("0012345678",10,0);
+
+    index.build(FuzzyKeyIndex::MAX_DISTANCE + 5);
+    QCOMPARE(index.maxDistance(),int(FuzzyKeyIndex::MAX_DISTANCE));
+
+    index.build(0);
+    QCOMPARE(index.maxDistance(),1);
+}
+
+void FuzzyKeyIndexTest::clear()
+{
+    FuzzyKeyIndex index;
+    index.add("0012345678",10,0);
+    index.build(1);
+
+    index.clear();
+    QVERIFY(index.isEmpty());
+
+    QVector<int> entries;
+    QCOMPARE(index.find("0012345678",10,&entries),-1);
+    QVERIFY(entries.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(FuzzyKeyIndexTest)
+
+#include "tst_fuzzykeyindex.moc"
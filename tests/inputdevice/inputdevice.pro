@@ -0,0 +1,32 @@
+include(../tests.pri)
+
+DEFINES += METRICS
+
+TARGET = tst_inputdevice
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/devices/DeviceMultiplexer.h \
+    ../../src/core/devices/EpollBackend.h \
+    ../../src/core/devices/InputDevice.h \
+    ../../src/core/devices/IoUringBackend.h \
+    ../../src/core/devices/KeyDecoder.h \
+    ../../src/core/devices/MultiplexerBackend.h \
+    ../../src/core/devices/ReconnectSupervisor.h
+
+SOURCES += \
+    tst_inputdevice.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/cards/CardNormalizer.cpp \
+    ../../src/core/devices/DeviceMultiplexer.cpp \
+    ../../src/core/devices/EpollBackend.cpp \
+    ../../src/core/devices/InputDevice.cpp \
+    ../../src/core/devices/IoUringBackend.cpp \
+    ../../src/core/devices/KeyDecoder.cpp \
+    ../../src/core/devices/ReconnectSupervisor.cpp \
+    ../../src/core/input/InputDeviceInfo.cpp \
+    ../../src/core/input/InputEvent.cpp \
+    ../../src/core/metrics/Metrics.cpp \
+    ../../src/core/metrics/MetricsRegistry.cpp
@@ -0,0 +1,378 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "core/cards/CardNormalizer.h"
+#include "core/devices/InputDevice.h"
+#include "core/devices/ReconnectSupervisor.h"
+#include "core/metrics/MetricsRegistry.h"
+
+static const quint64 MS = 1000 * 1000;
+
+/*! @brief Keyboard-like reader created with /dev/uinput. As real HID readers do, it reports scan code (EV_MSC)
+ *         before each key press and release */
+class UinputReader
+{
+public:
+    ~UinputReader()                                     { destroy(); }
+
+    /*! @brief Creates the device and waits for its file in /dev/input. Returns false, if /dev/uinput is not
+     *         available (e.g. module is not loaded or tests are not run as root) */
+    bool      create();
+    void      destroy();
+    bool      isCreated() const                         { return m_handle >= 0; }
+
+    /*! @brief Name of the device file within /dev/input, e.g. "event5" */
+    QString   deviceFileName() const                    { return m_deviceFileName; }
+
+    /*! @brief Types digits of key followed by ENTER */
+    void      type(const QByteArray& key);
+
+private:
+    void      _press(int code);
+    void      _write(int type, int code, int value);
+
+    int       m_handle = -1;
+    QString   m_deviceFileName;
+};
+
+bool UinputReader::create()
+{
+    m_handle = ::open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_handle < 0)
+        return false;
+
+    ioctl(m_handle, UI_SET_EVBIT, EV_KEY);
+    ioctl(m_handle, UI_SET_EVBIT, EV_MSC);
+    ioctl(m_handle, UI_SET_MSCBIT, MSC_SCAN);
+    for (int code = KEY_1; code <= KEY_0; code++)
+        ioctl(m_handle, UI_SET_KEYBIT, code);
+    ioctl(m_handle, UI_SET_KEYBIT, KEY_ENTER);
+
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_USB;
+    setup.id.vendor = 0x1209;
+    setup.id.product = 0x0001;
+    strncpy(setup.name, "rfid-controller test reader", UINPUT_MAX_NAME_SIZE - 1);
+
+    char sysName[64] = {};
+    if ((ioctl(m_handle, UI_DEV_SETUP, &setup) != 0) || (ioctl(m_handle, UI_DEV_CREATE) != 0)
+            || (ioctl(m_handle, UI_GET_SYSNAME(sizeof(sysName)), sysName) < 0)) {
+        destroy();
+        return false;
+    }
+
+    const QDir sysDir(QString("/sys/devices/virtual/input/%1").arg(sysName));
+    const QStringList eventDirs = sysDir.entryList({ "event*" },QDir::Dirs);
+    if (eventDirs.isEmpty()) {
+        destroy();
+        return false;
+    }
+    m_deviceFileName = eventDirs.first();
+
+    //Device file is created by devtmpfs (and its permissions are set by udev) a bit later
+    const QByteArray path = QString("/dev/input/%1").arg(m_deviceFileName).toLocal8Bit();
+    for (int i = 0; (i < 100) && (::access(path.constData(), R_OK) != 0); i++)
+        QTest::qWait(20);
+
+    if (::access(path.constData(), R_OK) != 0) {
+        destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void UinputReader::destroy()
+{
+    if (m_handle < 0)
+        return;
+
+    ioctl(m_handle, UI_DEV_DESTROY);
+    ::close(m_handle);
+    m_handle = -1;
+}
+
+void UinputReader::type(const QByteArray& key)
+{
+    for (char c : key)
+        _press((c == '0') ? KEY_0 : KEY_1 + (c - '1'));
+    _press(KEY_ENTER);
+}
+
+void UinputReader::_press(int code)
+{
+    for (int value : { 1, 0 }) {
+        _write(EV_MSC, MSC_SCAN, 0x70000 + code);
+        _write(EV_KEY, code, value);
+        _write(EV_SYN, SYN_REPORT, 0);
+    }
+}
+
+void UinputReader::_write(int type, int code, int value)
+{
+    struct input_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.code = code;
+    event.value = value;
+
+    const ssize_t written = ::write(m_handle, &event, sizeof(event));
+    Q_ASSERT(written == ssize_t(sizeof(event)));
+    Q_UNUSED(written);
+}
+
+class InputDeviceTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void keysAreRead();
+    void timestampsAreMonotonic();
+    void unusedEventsAreMasked();
+    void overflowDiscardsPartialKeys();
+    void reconnectAfterFault();
+
+private:
+    UinputReader  m_reader;
+    InputDevice*  p_device = nullptr;
+    QStringList   m_keys;           //!< @brief Keys emitted with InputDevice::keyFound
+    QList<quint64> m_keyTimes;      //!< @brief Timestamps of emitted keys
+    int           m_overflows = 0;  //!< @brief BufferOverflowError errors of the device
+
+    /*! @brief Opens InputDevice for the uinput reader */
+    bool _open(bool exclusiveAccess = true);
+
+    /*! @brief Returns value of counter of the opened device */
+    quint64 _deviceCounter(const char* name) const {
+        return metricsRegistry->counter(name,QString(),MetricsRegistry::label("bus","hid") + ','
+                                        + MetricsRegistry::label("device",m_reader.deviceFileName()))->value();
+    }
+};
+
+void InputDeviceTest::initTestCase()
+{
+    if (!m_reader.create())
+        QSKIP("/dev/uinput is not available");
+
+    //Keys are compared as they were typed
+    cardNormalizer->setEnabled(false);
+}
+
+void InputDeviceTest::init()
+{
+    m_keys.clear();
+    m_keyTimes.clear();
+    m_overflows = 0;
+}
+
+void InputDeviceTest::cleanup()
+{
+    delete p_device;
+    p_device = nullptr;
+}
+
+bool InputDeviceTest::_open(bool exclusiveAccess)
+{
+    p_device = new InputDevice(InputDeviceInfo::fromDeviceFileName(m_reader.deviceFileName()));
+    p_device->setExclusiveAccess(exclusiveAccess);
+    connect(p_device,&InputDevice::keyFound,this,[this](const KeyEvent& keyEvent) {
+        m_keys.append(keyEvent.key());
+        m_keyTimes.append(keyEvent.timestamp());
+    });
+    connect(p_device,&InputDevice::errorOccured,this,[this](InputDevice::InputDeviceError error) {
+        if (error == InputDevice::BufferOverflowError)
+            m_overflows++;
+    });
+
+    return p_device->open(InputDevice::ReadOnly);
+}
+
+void InputDeviceTest::keysAreRead()
+{
+    QVERIFY(_open());
+
+    //Kernel buffers only 64 events per descriptor, so each badge is read before the next one is typed
+    m_reader.type("0004567890");
+    QTRY_COMPARE(m_keys.size(),1);
+    m_reader.type("0001234567");
+    QTRY_COMPARE(m_keys.size(),2);
+    QCOMPARE(m_keys,QStringList({ "0004567890", "0001234567" }));
+}
+
+void InputDeviceTest::timestampsAreMonotonic()
+{
+    QVERIFY(_open());
+
+    //Kernel timestamps are either taken by CLOCK_MONOTONIC (EVIOCSCLOCKID) or converted to it
+    const quint64 before = KeyEvent::now();
+    m_reader.type("0004567890");
+    QTRY_COMPARE(m_keys.size(),1);
+
+    QVERIFY(m_keyTimes.first() >= before);
+    QVERIFY(m_keyTimes.first() <= KeyEvent::now());
+    QVERIFY(m_keyTimes.first() - before < 1000 * MS);
+}
+
+void InputDeviceTest::unusedEventsAreMasked()
+{
+    //Kernel delivers all events to the descriptor of the test, so they can be compared with events of the device
+    const QByteArray path = QString("/dev/input/%1").arg(m_reader.deviceFileName()).toLocal8Bit();
+    const int rawHandle = ::open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    QVERIFY(rawHandle >= 0);
+
+    struct input_mask mask;
+    mask.type = EV_MSC;
+    mask.codes_size = 0;
+    mask.codes_ptr = 0;
+    const int probeHandle = ::open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    const bool maskSupported = (ioctl(probeHandle, EVIOCSMASK, &mask) == 0);
+    ::close(probeHandle);
+    if (!maskSupported) {
+        ::close(rawHandle);
+        QSKIP("EVIOCSMASK is not supported by the kernel");
+    }
+
+    QVERIFY(_open(false));
+    Counter* wakeupsCounter = metricsRegistry->counter("rfid_multiplexer_wakeups_total",QString(),
+                                                       MetricsRegistry::label("backend","epoll"));
+    const quint64 events = _deviceCounter("rfid_device_events_total");
+    const quint64 reads = _deviceCounter("rfid_device_reads_total");
+    const quint64 wakeups = wakeupsCounter->value();
+
+    //Badge of 8 digits is 54 events, both descriptors are read before their 64 events buffers overflow
+    static const int BADGES = 20;
+    quint64 rawEvents = 0;
+    for (int i = 0; i < BADGES; i++) {
+        m_reader.type("45678901");
+        QTRY_COMPARE(m_keys.size(),i + 1);
+
+        struct input_event buffer[64];
+        ssize_t size = 0;
+        while ((size = ::read(rawHandle, buffer, sizeof(buffer))) > 0)
+            rawEvents += size / sizeof(struct input_event);
+    }
+    ::close(rawHandle);
+
+    //Each of 9 keys (8 digits and ENTER) is MSC+KEY+SYN on press and release, scan codes are not delivered
+    const quint64 deviceEvents = _deviceCounter("rfid_device_events_total") - events;
+    QCOMPARE(rawEvents,quint64(BADGES * 9 * 6));
+    QCOMPARE(deviceEvents,quint64(BADGES * 9 * 4));
+
+    qInfo() << "Per badge: events"<<double(rawEvents) / BADGES<<"->"<<double(deviceEvents) / BADGES
+            <<"reads"<<double(_deviceCounter("rfid_device_reads_total") - reads) / BADGES
+            <<"wakeups"<<double(wakeupsCounter->value() - wakeups) / BADGES;
+}
+
+void InputDeviceTest::overflowDiscardsPartialKeys()
+{
+    QVERIFY(_open());
+    const quint64 overflows = _deviceCounter("rfid_device_overflows_total");
+
+    //Event loop is stalled while badges are typed, so kernel buffer of 64 events overflows many times
+    static const int BADGES = 50;
+    QStringList typed;
+    for (int i = 0; i < BADGES; i++) {
+        typed.append(QString::number(1000000000 + i));
+        m_reader.type(typed.last().toLatin1());
+    }
+
+    //Badge typed after the flood is read, when everything queued before it was processed
+    QTest::qWait(100);
+    m_reader.type("0009999999");
+    QTRY_VERIFY(!m_keys.isEmpty() && (m_keys.last() == QLatin1String("0009999999")));
+
+    QVERIFY(m_overflows > 0);
+    QVERIFY(_deviceCounter("rfid_device_overflows_total") > overflows);
+    QVERIFY(p_device->isOpened());
+
+    //Only whole badges are emitted, keys assembled from parts of different badges are discarded
+    m_keys.removeLast();
+    QVERIFY(m_keys.size() < BADGES);
+    for (const QString& key : qAsConst(m_keys))
+        QVERIFY2(typed.contains(key),qPrintable(key));
+}
+
+void InputDeviceTest::reconnectAfterFault()
+{
+    QVERIFY(_open());
+    const QString deviceFileName = m_reader.deviceFileName();
+    const QString path = p_device->deviceInfo().deviceFilePath();
+
+    //Device is supervised the same way as within InputDeviceManager
+    ReconnectSupervisor supervisor("hid");
+    supervisor.setInitialDelay(10 * MS);
+    supervisor.setMaximumDelay(40 * MS);
+    supervisor.deviceConnected(path);
+
+    QList<InputDevice::InputDeviceError> errors;
+    connect(p_device,&InputDevice::errorOccured,&supervisor,[&supervisor,&errors,path](InputDevice::InputDeviceError error) {
+        errors.append(error);
+        if (error != InputDevice::BufferOverflowError)
+            supervisor.deviceFailed(path);
+    });
+    connect(&supervisor,&ReconnectSupervisor::reconnectRequested,this,[this,&supervisor](const QString& deviceId) {
+        //Failure is reported by InputDevice::errorOccured
+        if (p_device->open(InputDevice::ReadOnly))
+            supervisor.deviceConnected(deviceId);
+    });
+
+    m_reader.type("0004567890");
+    QTRY_COMPARE(m_keys.size(),1);
+
+    //Removed device fails reading with ENODEV, reopening fails till it appears again
+    m_reader.destroy();
+    QTRY_VERIFY(!errors.isEmpty());
+    QCOMPARE(errors.first(),InputDevice::NoSuchDeviceError);
+    QVERIFY(!p_device->isOpened());
+    QTRY_VERIFY(supervisor.attempt(path) >= 3);
+    QVERIFY(supervisor.state(path) != ReconnectSupervisor::Connected);
+
+    QVERIFY(m_reader.create());
+    if (m_reader.deviceFileName() != deviceFileName)
+        QSKIP("Recreated uinput device got another device file");
+
+    supervisor.deviceAttached(path);
+    QTRY_COMPARE(supervisor.state(path),ReconnectSupervisor::Connected);
+    QVERIFY(p_device->isOpened());
+
+    m_reader.type("0001234567");
+    QTRY_COMPARE(m_keys.size(),2);
+    QCOMPARE(m_keys.last(),QStringLiteral("0001234567"));
+}
+
+QTEST_GUILESS_MAIN(InputDeviceTest)
+
+#include "tst_inputdevice.moc"
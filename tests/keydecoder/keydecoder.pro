@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+TARGET = tst_keydecoder
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/devices/KeyDecoder.h
+
+SOURCES += \
+    tst_keydecoder.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/devices/KeyDecoder.cpp
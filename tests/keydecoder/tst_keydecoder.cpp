@@ -0,0 +1,275 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/devices/KeyDecoder.h"
+
+static const quint64 MS = 1000 * 1000;
+
+/*! @brief Time of the injected clock. Each test starts one minute later, so position of the wheel left by previous
+ *         test does not matter */
+static quint64 s_now = 0;
+static quint64 testClock() { return s_now; }
+
+class KeyDecoderTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void defaults();
+    void terminatedKey();
+    void terminatorsAreNotPartOfKey();
+    void timeoutDiscardsKey();
+    void timeoutEmitsKey();
+    void gapIsDetectedByFeed();
+    void deadlineMovesWithCharacters();
+    void overflow();
+    void reset();
+    void dropTillTerminator();
+    void maximumLengthIsBounded();
+
+private:
+    quint64       m_base = 0;
+    KeyDecoder*   p_decoder = nullptr;
+    QStringList   m_keys;           //!< @brief Keys emitted with KeyDecoder::keyDecoded
+    QList<quint64> m_keyTimes;      //!< @brief Times of first characters of emitted keys
+
+    /*! @brief Feeds text to the decoder at time after start of the test */
+    void _feed(const char* text, quint64 time) {
+        s_now = m_base + time;
+        p_decoder->feed(text,int(qstrlen(text)),s_now);
+    }
+
+    /*! @brief Moves clock to the time after start of the test and advances the wheel, as internal QTimer would */
+    void _advance(quint64 time) {
+        s_now = m_base + time;
+        timerWheel->advance(s_now);
+    }
+};
+
+void KeyDecoderTest::initTestCase()
+{
+    qRegisterMetaType<KeyDecoder::DiscardReason>("KeyDecoder::DiscardReason");
+    timerWheel->setClock(&testClock);
+}
+
+void KeyDecoderTest::init()
+{
+    m_base = s_now = s_now + 60 * 1000 * MS;
+    m_keys.clear();
+    m_keyTimes.clear();
+
+    p_decoder = new KeyDecoder;
+    p_decoder->setTerminators("\r\n");
+    p_decoder->setTimeout(50 * MS);
+
+    //Key points to the buffer of decoder, so it is copied right away
+    connect(p_decoder,&KeyDecoder::keyDecoded,this,[this](const char* key, int length, quint64 firstCharacterTime){
+        m_keys.append(QString::fromLatin1(key,length));
+        m_keyTimes.append(firstCharacterTime - m_base);
+    });
+}
+
+void KeyDecoderTest::cleanup()
+{
+    delete p_decoder;
+    p_decoder = nullptr;
+    QCOMPARE(timerWheel->pendingCount(),0);
+}
+
+void KeyDecoderTest::defaults()
+{
+    KeyDecoder decoder;
+    QCOMPARE(decoder.terminators(),QByteArray(1,'\0'));
+    QCOMPARE(decoder.timeout(),100 * MS);
+    QCOMPARE(decoder.maximumLength(),64);
+    QVERIFY(!decoder.emitOnTimeout());
+    QCOMPARE(decoder.pendingLength(),0);
+}
+
+void KeyDecoderTest::terminatedKey()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    _feed("0012",0);
+    _feed("345678\r",5 * MS);
+    QCOMPARE(m_keys,QStringList({"0012345678"}));
+    QCOMPARE(m_keyTimes.first(),quint64(0));
+    QCOMPARE(p_decoder->pendingLength(),0);
+    QVERIFY(discarded.isEmpty());
+
+    //Timeout is cancelled together with the key
+    QCOMPARE(timerWheel->pendingCount(),0);
+}
+
+void KeyDecoderTest::terminatorsAreNotPartOfKey()
+{
+    _feed("\r\n\r\nA1\r\n\nB2\n",0);
+    QCOMPARE(m_keys,QStringList({"A1","B2"}));
+}
+
+void KeyDecoderTest::timeoutDiscardsKey()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    _feed("00123",0);
+    _advance(40 * MS);
+    QVERIFY(discarded.isEmpty());
+
+    _advance(70 * MS);
+    QCOMPARE(discarded.count(),1);
+    QCOMPARE(discarded.first().at(0).value<KeyDecoder::DiscardReason>(),KeyDecoder::TimeoutDiscard);
+    QCOMPARE(discarded.first().at(1).toInt(),5);
+    QVERIFY(m_keys.isEmpty());
+    QCOMPARE(p_decoder->pendingLength(),0);
+
+    //The rest of stalled key is not a key, the next key is decoded normally
+    _feed("45678\r",200 * MS);
+    QVERIFY(m_keys.isEmpty());
+    QCOMPARE(discarded.count(),1);
+
+    _feed("0099\r",210 * MS);
+    QCOMPARE(m_keys,QStringList({"0099"}));
+}
+
+void KeyDecoderTest::timeoutEmitsKey()
+{
+    p_decoder->setEmitOnTimeout(true);
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    _feed("12345678",10 * MS);
+    _advance(70 * MS);
+    QCOMPARE(m_keys,QStringList({"12345678"}));
+    QCOMPARE(m_keyTimes.first(),10 * MS);
+    QVERIFY(discarded.isEmpty());
+}
+
+void KeyDecoderTest::gapIsDetectedByFeed()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    //Wheel is not advanced, so partial key is not expired yet when the rest of it comes
+    _feed("001",0);
+    _feed("2345678\r",200 * MS);
+    QCOMPARE(discarded.count(),1);
+    QCOMPARE(discarded.first().at(1).toInt(),3);
+    QVERIFY(m_keys.isEmpty());
+
+    _feed("0012345678\r",210 * MS);
+    QCOMPARE(m_keys,QStringList({"0012345678"}));
+    QCOMPARE(m_keyTimes.first(),210 * MS);
+}
+
+void KeyDecoderTest::deadlineMovesWithCharacters()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    //Each gap is shorter than timeout, while the whole key is longer
+    for (quint64 time = 0; time <= 120; time += 40) {
+        _feed("1",time * MS);
+        _advance(time * MS + 30 * MS);
+    }
+    QVERIFY(discarded.isEmpty());
+    QCOMPARE(p_decoder->pendingLength(),4);
+
+    _feed("\r",160 * MS);
+    QCOMPARE(m_keys,QStringList({"1111"}));
+}
+
+void KeyDecoderTest::overflow()
+{
+    p_decoder->setMaximumLength(4);
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    //The rest of too long key is dropped too, the next key is decoded normally
+    _feed("123456789\rABC\r",0);
+    QCOMPARE(discarded.count(),1);
+    QCOMPARE(discarded.first().at(0).value<KeyDecoder::DiscardReason>(),KeyDecoder::OverflowDiscard);
+    QCOMPARE(discarded.first().at(1).toInt(),4);
+    QCOMPARE(m_keys,QStringList({"ABC"}));
+
+    //Key of exactly maximal length is fine
+    _feed("WXYZ\r",10 * MS);
+    QCOMPARE(m_keys,QStringList({"ABC","WXYZ"}));
+}
+
+void KeyDecoderTest::reset()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    _feed("123",0);
+    p_decoder->reset();
+    QCOMPARE(discarded.count(),1);
+    QCOMPARE(discarded.first().at(0).value<KeyDecoder::DiscardReason>(),KeyDecoder::ResetDiscard);
+    QCOMPARE(discarded.first().at(1).toInt(),3);
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    //Nothing is pending, so nothing is discarded
+    p_decoder->reset();
+    QCOMPARE(discarded.count(),1);
+
+    _feed("456\r",10 * MS);
+    QCOMPARE(m_keys,QStringList({"456"}));
+}
+
+void KeyDecoderTest::dropTillTerminator()
+{
+    QSignalSpy discarded(p_decoder,&KeyDecoder::keyDiscarded);
+
+    //Input was lost in the middle of the key, its suffix must not be decoded as a key
+    _feed("0012",0);
+    p_decoder->drop();
+    QCOMPARE(discarded.count(),1);
+    QCOMPARE(discarded.first().at(0).value<KeyDecoder::DiscardReason>(),KeyDecoder::InputLostDiscard);
+    QCOMPARE(discarded.first().at(1).toInt(),4);
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    _feed("345678\r",1 * MS);
+    QVERIFY(m_keys.isEmpty());
+    QCOMPARE(discarded.count(),1);
+
+    //Nothing is pending, but the rest of the key is still dropped
+    p_decoder->drop();
+    _feed("5678\r",2 * MS);
+    QCOMPARE(discarded.count(),1);
+    QVERIFY(m_keys.isEmpty());
+
+    _feed("0099\r",10 * MS);
+    QCOMPARE(m_keys,QStringList({"0099"}));
+}
+
+void KeyDecoderTest::maximumLengthIsBounded()
+{
+    p_decoder->setMaximumLength(0);
+    QCOMPARE(p_decoder->maximumLength(),1);
+
+    p_decoder->setMaximumLength(KeyDecoder::CAPACITY + 1);
+    QCOMPARE(p_decoder->maximumLength(),int(KeyDecoder::CAPACITY));
+}
+
+QTEST_GUILESS_MAIN(KeyDecoderTest)
+
+#include "tst_keydecoder.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_keydigest
+
+SOURCES += \
+    tst_keydigest.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/commands/KeyDigest.cpp
@@ -0,0 +1,165 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QMessageAuthenticationCode>
+
+#include "core/commands/KeyDigest.h"
+
+class KeyDigestTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void implementation();
+    void sha256_data();
+    void sha256();
+    void sha256Lengths();
+    void hmac_data();
+    void hmac();
+    void longSecret();
+    void secretId();
+    void generateSecret();
+
+private:
+    static QByteArray _sha256(const QByteArray& data);
+};
+
+QByteArray KeyDigestTest::_sha256(const QByteArray& data)
+{
+    QByteArray result(KeyDigest::SIZE,'\0');
+    KeyDigest::sha256(reinterpret_cast<const quint8*>(data.constData()),data.size(),
+                      reinterpret_cast<quint8*>(result.data()));
+    return result;
+}
+
+void KeyDigestTest::implementation()
+{
+    const QByteArray name(KeyDigest::implementationName());
+    QVERIFY(name == "sha-ni" || name == "generic");
+    qInfo() << "SHA-256 implementation:" << name;
+}
+
+void KeyDigestTest::sha256_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QByteArray>("expected");
+
+    //FIPS 180-2 test vectors
+    QTest::newRow("empty")      << QByteArray()
+                                << QByteArray::fromHex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    QTest::newRow("abc")        << QByteArray("abc")
+                                << QByteArray::fromHex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    QTest::newRow("448 bits")   << QByteArray("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")
+                                << QByteArray::fromHex("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    QTest::newRow("1M of 'a'")  << QByteArray(1000000,'a')
+                                << QByteArray::fromHex("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+void KeyDigestTest::sha256()
+{
+    QFETCH(QByteArray,data);
+    QFETCH(QByteArray,expected);
+
+    QCOMPARE(_sha256(data).toHex(),expected.toHex());
+}
+
+void KeyDigestTest::sha256Lengths()
+{
+    //Padding differs around block boundaries (55, 56, 63, 64 bytes)
+    QByteArray data;
+    for (int length = 0; length <= 200; length++) {
+        const QByteArray expected = QCryptographicHash::hash(data,QCryptographicHash::Sha256);
+        QVERIFY2(_sha256(data) == expected,qPrintable(QString("Length %1").arg(length)));
+        data.append(char(length * 7 + 1));
+    }
+}
+
+void KeyDigestTest::hmac_data()
+{
+    QTest::addColumn<QByteArray>("secret");
+    QTest::addColumn<QByteArray>("key");
+    QTest::addColumn<QByteArray>("expected");
+
+    //RFC 4231 test cases
+    QTest::newRow("case 1")     << QByteArray(20,'\x0b') << QByteArray("Hi There")
+                                << QByteArray::fromHex("b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+    QTest::newRow("case 2")     << QByteArray("Jefe") << QByteArray("what do ya want for nothing?")
+                                << QByteArray::fromHex("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    QTest::newRow("case 6")     << QByteArray(131,'\xaa') << QByteArray("Test Using Larger Than Block-Size Key - Hash Key First")
+                                << QByteArray::fromHex("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
+void KeyDigestTest::hmac()
+{
+    QFETCH(QByteArray,secret);
+    QFETCH(QByteArray,key);
+    QFETCH(QByteArray,expected);
+
+    const KeyDigest keyDigest(secret);
+    QVERIFY(keyDigest.hasSecret());
+    QCOMPARE(keyDigest.digest(key).toHex(),expected.toHex());
+
+    quint8 output[KeyDigest::SIZE];
+    keyDigest.digest(key.constData(),key.size(),output);
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(output),KeyDigest::SIZE).toHex(),expected.toHex());
+
+    QCOMPARE(keyDigest.digest(key),QMessageAuthenticationCode::hash(key,secret,QCryptographicHash::Sha256));
+}
+
+void KeyDigestTest::longSecret()
+{
+    //Secret longer than one block is used as its SHA-256
+    const QByteArray secret(100,'s');
+    const KeyDigest longDigest(secret);
+    const KeyDigest hashedDigest(QCryptographicHash::hash(secret,QCryptographicHash::Sha256));
+    QCOMPARE(longDigest.digest("0012345678"),hashedDigest.digest("0012345678"));
+}
+
+void KeyDigestTest::secretId()
+{
+    KeyDigest keyDigest;
+    QVERIFY(!keyDigest.hasSecret());
+
+    const QByteArray secret("0123456789abcdef0123456789abcdef");
+    keyDigest.setSecret(secret);
+    QVERIFY(keyDigest.hasSecret());
+    QCOMPARE(keyDigest.secretId(),QCryptographicHash::hash(secret,QCryptographicHash::Sha256).left(KeyDigest::SECRET_ID_SIZE));
+
+    //Digests made with other secrets differ
+    const KeyDigest otherDigest("0123456789abcdef0123456789abcdeF");
+    QVERIFY(otherDigest.secretId() != keyDigest.secretId());
+    QVERIFY(otherDigest.digest("0012345678") != keyDigest.digest("0012345678"));
+}
+
+void KeyDigestTest::generateSecret()
+{
+    const QByteArray first = KeyDigest::generateSecret();
+    const QByteArray second = KeyDigest::generateSecret();
+    QCOMPARE(first.size(),int(KeyDigest::SECRET_SIZE));
+    QCOMPARE(second.size(),int(KeyDigest::SECRET_SIZE));
+    QVERIFY(first != second);
+}
+
+QTEST_APPLESS_MAIN(KeyDigestTest)
+
+#include "tst_keydigest.moc"
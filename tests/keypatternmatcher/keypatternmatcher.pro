@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = tst_keypatternmatcher
+
+SOURCES += \
+    tst_keypatternmatcher.cpp \
+    ../../src/core/commands/KeyPatternMatcher.cpp
@@ -0,0 +1,177 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/commands/KeyPatternMatcher.h"
+
+class KeyPatternMatcherTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void match_data();
+    void match();
+    void invalidRegex();
+    void clear();
+    void rangesWithoutDigits();
+    void parseRange_data();
+    void parseRange();
+
+private:
+    KeyPatternMatcher   m_matcher;
+};
+
+void KeyPatternMatcherTest::initTestCase()
+{
+    m_matcher.addPrefix("",0);
+    m_matcher.addPrefix("0012",1);
+    m_matcher.addPrefix("00123",2);
+    m_matcher.addPrefix("0012",3);
+
+    m_matcher.addRange(12345000,12345999,4);
+    m_matcher.addRange(12345678,12345678,5);
+    m_matcher.addRange(0,99,6);
+
+    QVERIFY(m_matcher.addRegex("00\\d{8}",7));
+    QVERIFY(m_matcher.addRegex("[0-9A-F]{8}",8));
+    QVERIFY(m_matcher.addRegex("04(A1|B2)+C3",9));
+
+    //Backreference is not supported by DFA, so it is matched with QRegularExpression
+    QVERIFY(m_matcher.addRegex("(\\d)\\1+",10));
+
+    m_matcher.compile();
+    QVERIFY(!m_matcher.isEmpty());
+}
+
+void KeyPatternMatcherTest::match_data()
+{
+    QTest::addColumn<QByteArray>("key");
+    QTest::addColumn<QVector<int>>("expected");
+
+    QTest::newRow("all kinds")          << QByteArray("0012345678")   << QVector<int>({0, 1, 2, 3, 4, 5, 7});
+    QTest::newRow("ranges and class")   << QByteArray("12345678")     << QVector<int>({0, 4, 5, 8});
+    QTest::newRow("prefix only")        << QByteArray("0012")         << QVector<int>({0, 1, 3, 6});
+    QTest::newRow("shorter than prefix") << QByteArray("001")         << QVector<int>({0, 6});
+    QTest::newRow("alternation")        << QByteArray("04A1B2C3")     << QVector<int>({0, 8, 9});
+    QTest::newRow("repetition")         << QByteArray("04A1A1C3")     << QVector<int>({0, 8, 9});
+    QTest::newRow("backreference")      << QByteArray("7777")         << QVector<int>({0, 10});
+    QTest::newRow("small number")       << QByteArray("42")           << QVector<int>({0, 6});
+    QTest::newRow("whole key")          << QByteArray("00123456789")  << QVector<int>({0, 1, 2, 3});
+    QTest::newRow("not a number")       << QByteArray("0012345A78")   << QVector<int>({0, 1, 2, 3});
+    QTest::newRow("empty key")          << QByteArray()               << QVector<int>({0});
+}
+
+void KeyPatternMatcherTest::match()
+{
+    QFETCH(QByteArray,key);
+    QFETCH(QVector<int>,expected);
+
+    QVector<int> rules;
+    m_matcher.match(key.constData(),key.size(),&rules);
+    QCOMPARE(rules,expected);
+
+    //Second pass uses cached DFA states
+    m_matcher.match(key.constData(),key.size(),&rules);
+    QCOMPARE(rules,expected);
+}
+
+void KeyPatternMatcherTest::invalidRegex()
+{
+    KeyPatternMatcher matcher;
+    QString errorString;
+    QVERIFY(!matcher.addRegex("(",0,&errorString));
+    QVERIFY(!errorString.isEmpty());
+    QVERIFY(matcher.isEmpty());
+}
+
+void KeyPatternMatcherTest::clear()
+{
+    KeyPatternMatcher matcher;
+    matcher.addPrefix("00",0);
+    matcher.addRange(1,2,1);
+    matcher.addRegex("\\d+",2);
+    matcher.compile();
+
+    matcher.clear();
+    QVERIFY(matcher.isEmpty());
+    matcher.compile();
+
+    QVector<int> rules({42});
+    matcher.match("0012",4,&rules);
+    QVERIFY(rules.isEmpty());
+}
+
+void KeyPatternMatcherTest::rangesWithoutDigits()
+{
+    KeyPatternMatcher matcher;
+    matcher.addRange(0,Q_UINT64_C(0xFFFFFFFFFFFFFFFF),0);
+    matcher.compile();
+
+    QVector<int> rules;
+    matcher.match("1234567890123456789",19,&rules);
+    QCOMPARE(rules,QVector<int>({0}));
+
+    //Keys longer than 19 digits do not fit into 64 bits, hex keys are not numbers
+    matcher.match("12345678901234567890",20,&rules);
+    QVERIFY(rules.isEmpty());
+    matcher.match("04A1B2C3",8,&rules);
+    QVERIFY(rules.isEmpty());
+}
+
+void KeyPatternMatcherTest::parseRange_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<quint64>("low");
+    QTest::addColumn<quint64>("high");
+
+    QTest::newRow("range")          << "1000-1999"      << true  << quint64(1000)     << quint64(1999);
+    QTest::newRow("spaces")         << " 1000 - 1999 "  << true  << quint64(1000)     << quint64(1999);
+    QTest::newRow("single")         << "1234"           << true  << quint64(1234)     << quint64(1234);
+    QTest::newRow("facility")       << "facility:188"   << true  << quint64(188 << 16) << quint64((188 << 16) | 0xFFFF);
+    QTest::newRow("facility > 16 bits") << "facility:65536" << false << quint64(0)    << quint64(0);
+    QTest::newRow("reversed")       << "1999-1000"      << false << quint64(0)        << quint64(0);
+    QTest::newRow("text")           << "abc"            << false << quint64(0)        << quint64(0);
+    QTest::newRow("open range")     << "1000-"          << false << quint64(0)        << quint64(0);
+}
+
+void KeyPatternMatcherTest::parseRange()
+{
+    QFETCH(QString,text);
+    QFETCH(bool,valid);
+    QFETCH(quint64,low);
+    QFETCH(quint64,high);
+
+    quint64 parsedLow = 0;
+    quint64 parsedHigh = 0;
+    QCOMPARE(KeyPatternMatcher::parseRange(text,&parsedLow,&parsedHigh),valid);
+    if (valid) {
+        QCOMPARE(parsedLow,low);
+        QCOMPARE(parsedHigh,high);
+    }
+}
+
+QTEST_APPLESS_MAIN(KeyPatternMatcherTest)
+
+#include "tst_keypatternmatcher.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_keyset
+
+SOURCES += \
+    tst_keyset.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/cards/CardNormalizer.cpp \
+    ../../src/core/commands/KeySet.cpp
@@ -0,0 +1,231 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/cards/CardNormalizer.h"
+#include "core/commands/KeySet.h"
+
+static const char PLAIN_LIST[] =
+        "# allowed badges\n"
+        "\n"
+        "188,24910\n"
+        "0012345678\r\n"
+        "  04:a1:b2:c3\n"
+        "hello-world\n"
+        "11011110001100001010011101\n"
+        "0000BC614E\n";
+
+class KeySetTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+
+    void empty();
+    void plainList();
+    void largeSet();
+    void saveAndLoad();
+    void loadPlainList();
+    void truncatedImage();
+    void otherNormalizerSettings();
+    void missingFile();
+
+private:
+    QTemporaryDir   m_dir;
+
+    /*! @brief Returns true if set contains key, which is already in canonical form */
+    static bool _contains(const KeySet& set, const QByteArray& key) {
+        return set.contains(key.constData(),key.size(),KeyId::fromBytes(key.constData(),key.size()));
+    }
+
+    /*! @brief Returns text with 10-digit card numbers 0, 2, 4 ... 2 * (count - 1), one per line */
+    static QByteArray _evenNumbers(int count);
+
+    bool _writeFile(const QString& fileName, const QByteArray& data);
+};
+
+QByteArray KeySetTest::_evenNumbers(int count)
+{
+    QByteArray result;
+    result.reserve(count * 11);
+    for (int i = 0; i < count; i++)
+        result.append(QByteArray::number(i * 2).rightJustified(10,'0')).append('\n');
+    return result;
+}
+
+bool KeySetTest::_writeFile(const QString& fileName, const QByteArray& data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+void KeySetTest::init()
+{
+    QVERIFY(m_dir.isValid());
+
+    //Images depend on settings of CardNormalizer, so each test starts with the defaults
+    cardNormalizer->setEnabled(true);
+    cardNormalizer->setProxBits(32);
+    cardNormalizer->setReverseUid(false);
+}
+
+void KeySetTest::empty()
+{
+    KeySet set;
+    QCOMPARE(set.count(),qint64(0));
+    QVERIFY(!_contains(set,"0012345678"));
+
+    set.build("",0);
+    QCOMPARE(set.count(),qint64(0));
+    QVERIFY(!_contains(set,"0012345678"));
+}
+
+void KeySetTest::plainList()
+{
+    KeySet set;
+    set.build(PLAIN_LIST,qstrlen(PLAIN_LIST));
+
+    //Facility-card pair and decimal encodings of one card are stored once, EM4100 card with the same number is
+    //another card, bad Wiegand frame is skipped
+    QCOMPARE(set.count(),qint64(4));
+    QCOMPARE(set.invalidCount(),qint64(1));
+
+    QVERIFY(_contains(set,"0012345678"));
+    QVERIFY(_contains(set,"0000012345678"));
+    QVERIFY(_contains(set,"04A1B2C3"));
+    QVERIFY(_contains(set,"hello-world"));
+
+    QVERIFY(!_contains(set,"0012345679"));
+    QVERIFY(!_contains(set,"hello"));
+    QVERIFY(!_contains(set,"# allowed badges"));
+    QVERIFY(!_contains(set,""));
+}
+
+void KeySetTest::largeSet()
+{
+    const int count = 100000;
+    const QByteArray list = _evenNumbers(count);
+
+    KeySet set;
+    set.build(list.constData(),list.size());
+    QCOMPARE(set.count(),qint64(count));
+
+    //Bloom filter passes some of the odd numbers, Elias-Fano lookup has to reject them
+    for (int i = 0; i < 2 * count; i++) {
+        const QByteArray key = QByteArray::number(i).rightJustified(10,'0');
+        if (_contains(set,key) != (i % 2 == 0))
+            QFAIL(qPrintable(QString("Wrong result for %1").arg(QString::fromLatin1(key))));
+    }
+}
+
+void KeySetTest::saveAndLoad()
+{
+    const QByteArray list = QByteArray(PLAIN_LIST) + _evenNumbers(1000);
+    KeySet built;
+    built.build(list.constData(),list.size());
+
+    const QString fileName = m_dir.filePath("saved.kset");
+    QString errorString;
+    QVERIFY2(built.save(fileName,&errorString),qPrintable(errorString));
+
+    KeySet loaded;
+    QVERIFY2(loaded.load(fileName,&errorString),qPrintable(errorString));
+    QCOMPARE(loaded.count(),built.count());
+    QCOMPARE(loaded.size(),built.size());
+    QCOMPARE(loaded.size(),QFileInfo(fileName).size());
+
+    QVERIFY(_contains(loaded,"0012345678"));
+    QVERIFY(_contains(loaded,"0000012345678"));
+    QVERIFY(_contains(loaded,"04A1B2C3"));
+    QVERIFY(_contains(loaded,"hello-world"));
+    QVERIFY(_contains(loaded,"0000001998"));
+    QVERIFY(!_contains(loaded,"0000001997"));
+}
+
+void KeySetTest::loadPlainList()
+{
+    const QString fileName = m_dir.filePath("list.txt");
+    QVERIFY(_writeFile(fileName,PLAIN_LIST));
+
+    KeySet set;
+    QVERIFY(set.load(fileName));
+    QCOMPARE(set.count(),qint64(4));
+    QCOMPARE(set.invalidCount(),qint64(1));
+    QVERIFY(_contains(set,"0012345678"));
+}
+
+void KeySetTest::truncatedImage()
+{
+    const QByteArray list = _evenNumbers(1000);
+    KeySet built;
+    built.build(list.constData(),list.size());
+
+    const QString fileName = m_dir.filePath("truncated.kset");
+    QVERIFY(built.save(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray image = file.readAll();
+    file.close();
+    QVERIFY(_writeFile(fileName,image.left(image.size() / 2)));
+
+    KeySet loaded;
+    QString errorString;
+    QVERIFY(!loaded.load(fileName,&errorString));
+    QVERIFY(!errorString.isEmpty());
+    QCOMPARE(loaded.count(),qint64(0));
+    QVERIFY(!_contains(loaded,"0000000000"));
+}
+
+void KeySetTest::otherNormalizerSettings()
+{
+    const QByteArray list = _evenNumbers(1000);
+    KeySet built;
+    built.build(list.constData(),list.size());
+
+    const QString fileName = m_dir.filePath("proxbits.kset");
+    QVERIFY(built.save(fileName));
+
+    //Keys of this image would not match keys normalized with 24 bits
+    cardNormalizer->setProxBits(24);
+    KeySet loaded;
+    QString errorString;
+    QVERIFY(!loaded.load(fileName,&errorString));
+    QVERIFY(!errorString.isEmpty());
+
+    cardNormalizer->setProxBits(32);
+    QVERIFY(loaded.load(fileName));
+    QCOMPARE(loaded.count(),qint64(1000));
+}
+
+void KeySetTest::missingFile()
+{
+    KeySet set;
+    QString errorString;
+    QVERIFY(!set.load(m_dir.filePath("missing.kset"),&errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(KeySetTest)
+
+#include "tst_keyset.moc"
@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_metrics
+
+SOURCES += \
+    tst_metrics.cpp \
+    ../../src/core/metrics/Metrics.cpp \
+    ../../src/core/metrics/MetricsRegistry.cpp
@@ -0,0 +1,223 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "core/metrics/MetricsRegistry.h"
+
+static const quint64 US = 1000;
+static const quint64 MS = 1000 * US;
+
+class MetricsTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void counterSumsShards();
+    void bucketBounds();
+    void quantile();
+    void labelEscaping();
+    void registryReturnsSameMetric();
+    void histogramSeriesAreFixed();
+    void histogramCumulativeCounts();
+
+    void benchmarkCounterIncrement();
+    void benchmarkHistogramRecord();
+    void benchmarkPrometheusText();
+
+private:
+    /*! @brief Returns "le" labels and values of bucket lines of the histogram with specified name */
+    static QList<QPair<QByteArray,quint64>> _buckets(const QByteArray& text, const QByteArray& name);
+};
+
+QList<QPair<QByteArray,quint64>> MetricsTest::_buckets(const QByteArray& text, const QByteArray& name)
+{
+    QList<QPair<QByteArray,quint64>> result;
+    const QByteArray prefix = name + "_bucket{";
+    for (const QByteArray& line : text.split('\n')) {
+        if (!line.startsWith(prefix))
+            continue;
+
+        const int leStart = line.indexOf("le=\"") + 4;
+        const int leEnd = line.indexOf('"',leStart);
+        result.append({line.mid(leStart,leEnd - leStart),line.mid(line.lastIndexOf(' ') + 1).toULongLong()});
+    }
+
+    return result;
+}
+
+void MetricsTest::counterSumsShards()
+{
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Counter::SHARD_COUNT * 2; i++) {
+        threads.emplace_back([&counter]() {
+            for (int j = 0; j < 10000; j++)
+                counter.increment();
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    QCOMPARE(counter.value(),quint64(Counter::SHARD_COUNT * 2 * 10000));
+}
+
+void MetricsTest::bucketBounds()
+{
+    QCOMPARE(Histogram::bucketLowerBound(0),quint64(0));
+    for (int i = 1; i < Histogram::BUCKET_COUNT; i++) {
+        const quint64 lowerBound = Histogram::bucketLowerBound(i);
+        QVERIFY(lowerBound > Histogram::bucketLowerBound(i - 1));
+        QCOMPARE(Histogram::bucketIndex(lowerBound),i);
+        QCOMPARE(Histogram::bucketIndex(lowerBound - 1),i - 1);
+    }
+    QCOMPARE(Histogram::bucketIndex(std::numeric_limits<quint64>::max()),Histogram::BUCKET_COUNT - 1);
+}
+
+void MetricsTest::quantile()
+{
+    Histogram histogram;
+    QCOMPARE(histogram.quantile(0.5),quint64(0));
+
+    for (quint64 i = 1; i <= 100; i++)
+        histogram.record(i * MS);
+    QCOMPARE(histogram.count(),quint64(100));
+    QCOMPARE(histogram.sum(),5050 * MS);
+
+    //Relative error is not larger than one sub-bucket
+    const quint64 median = histogram.quantile(0.5);
+    QVERIFY(median <= 50 * MS);
+    QVERIFY(median > 50 * MS - 50 * MS / Histogram::SUB_BUCKET_COUNT);
+    QVERIFY(histogram.quantile(1.0) <= 100 * MS);
+    QVERIFY(histogram.quantile(0.0) <= 1 * MS);
+}
+
+void MetricsTest::labelEscaping()
+{
+    QCOMPARE(MetricsRegistry::label("device","/dev/ttyUSB0"),QString("device=\"/dev/ttyUSB0\""));
+    QCOMPARE(MetricsRegistry::label("name","a\"b\\c\nd"),QString("name=\"a\\\"b\\\\c\\nd\""));
+}
+
+void MetricsTest::registryReturnsSameMetric()
+{
+    Counter* counter = metricsRegistry->counter("test_same_total","Test");
+    QCOMPARE(metricsRegistry->counter("test_same_total","Test"),counter);
+    QVERIFY(metricsRegistry->counter("test_same_total","Test",MetricsRegistry::label("a","b")) != counter);
+
+    counter->increment(3);
+    QVERIFY(metricsRegistry->toPrometheusText().contains("\ntest_same_total 3\n"));
+}
+
+void MetricsTest::histogramSeriesAreFixed()
+{
+    //Set of "le" series must not change between scrapes, otherwise rate() and histogram_quantile() break
+    Histogram* histogram = metricsRegistry->histogram("test_fixed_seconds","Test");
+    const QList<QPair<QByteArray,quint64>> empty = _buckets(metricsRegistry->toPrometheusText(),"test_fixed_seconds");
+    QVERIFY(empty.size() > 1);
+    QCOMPARE(empty.last().first,QByteArray("+Inf"));
+
+    histogram->record(5 * US);
+    const QList<QPair<QByteArray,quint64>> small = _buckets(metricsRegistry->toPrometheusText(),"test_fixed_seconds");
+    histogram->record(10 * 1000 * MS);
+    histogram->record(std::numeric_limits<quint64>::max() / 2);
+    const QList<QPair<QByteArray,quint64>> large = _buckets(metricsRegistry->toPrometheusText(),"test_fixed_seconds");
+
+    QCOMPARE(small.size(),empty.size());
+    QCOMPARE(large.size(),empty.size());
+    for (int i = 0; i < empty.size(); i++) {
+        QCOMPARE(small.at(i).first,empty.at(i).first);
+        QCOMPARE(large.at(i).first,empty.at(i).first);
+        QCOMPARE(empty.at(i).second,quint64(0));
+    }
+}
+
+void MetricsTest::histogramCumulativeCounts()
+{
+    Histogram* histogram = metricsRegistry->histogram("test_cumulative_seconds","Test");
+    histogram->record(0);
+    histogram->record(100 * US);
+    histogram->record(100 * MS);
+    histogram->record(1000 * 1000 * MS);
+
+    const QByteArray text = metricsRegistry->toPrometheusText();
+    const QList<QPair<QByteArray,quint64>> buckets = _buckets(text,"test_cumulative_seconds");
+
+    quint64 previous = 0;
+    double previousBound = 0;
+    for (const QPair<QByteArray,quint64>& bucket : buckets) {
+        QVERIFY(bucket.second >= previous);
+        previous = bucket.second;
+        if (bucket.first == "+Inf")
+            continue;
+
+        //Every value not larger than the bound is counted
+        const double bound = bucket.first.toDouble();
+        QVERIFY(bound > previousBound);
+        previousBound = bound;
+        const quint64 expected = (bound >= 0.0001 ? 1 : 0) + (bound >= 0.1 ? 1 : 0) + 1;
+        QCOMPARE(bucket.second,expected);
+    }
+    QCOMPARE(buckets.last().second,quint64(4));
+
+    QVERIFY(text.contains("\ntest_cumulative_seconds_count 4\n"));
+    QVERIFY(text.contains("\ntest_cumulative_seconds_sum 1000.1001\n"));
+}
+
+void MetricsTest::benchmarkCounterIncrement()
+{
+    Counter* counter = metricsRegistry->counter("test_benchmark_total","Test");
+    QBENCHMARK {
+        for (int i = 0; i < 1000; i++)
+            counter->increment();
+    }
+}
+
+void MetricsTest::benchmarkHistogramRecord()
+{
+    Histogram* histogram = metricsRegistry->histogram("test_benchmark_seconds","Test");
+    quint64 value = 12345;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; i++) {
+            histogram->record(value);
+            value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+            value >>= 30;
+        }
+    }
+}
+
+void MetricsTest::benchmarkPrometheusText()
+{
+    for (int i = 0; i < 20; i++)
+        metricsRegistry->histogram("test_export_seconds","Test",MetricsRegistry::label("device",QString::number(i)))->record(i * MS);
+
+    QBENCHMARK {
+        const QByteArray text = metricsRegistry->toPrometheusText();
+        Q_UNUSED(text)
+    }
+}
+
+QTEST_APPLESS_MAIN(MetricsTest)
+
+#include "tst_metrics.moc"
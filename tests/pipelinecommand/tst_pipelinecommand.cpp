@@ -0,0 +1,173 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <QJsonArray>
+
+#include "core/TimerWheel.h"
+#include "core/commands/CommandScheduler.h"
+#include "core/commands/PipelineCommand.h"
+
+/*! @brief Command, which is finished by the test. Executions are kept till TestCommand::finish is called */
+class TestCommand : public Command
+{
+public:
+    QList<quint64> executions;
+    int       executedCount = 0;
+
+    Type      type() const override                     { return Unknown; }
+    QJsonObject toJson() const override                 { return QJsonObject({ { "type", "test" } }); }
+
+    void      finish(bool success = true)               { finishExecution(executions.takeFirst(),success); }
+
+protected:
+    bool      execute(const KeyEvent& event, quint64 execution) override {
+        Q_UNUSED(event);
+        executedCount++;
+        executions.append(execution);
+        return false;
+    }
+};
+
+class PipelineCommandTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+
+    void invalidStepsAreSaved();
+    void invalidPipelineIsNotExecuted();
+    void stepsRunWithinGlobalLimit();
+
+private:
+    /*! @brief Submits command to the scheduler, result is stored in m_result when the execution has finished */
+    void _submit(Command* command) {
+        m_finished = false;
+        commandScheduler->submit(command,KeyEvent(QStringLiteral("0001234567"),0),[this](bool success) {
+            m_finished = true;
+            m_result = success;
+        });
+    }
+
+    bool      m_finished = false;
+    bool      m_result = false;
+};
+
+void PipelineCommandTest::cleanup()
+{
+    commandScheduler->setMaxInFlight(0);
+    QCOMPARE(commandScheduler->inFlight(),0);
+    QCOMPARE(commandScheduler->queued(),0);
+}
+
+void PipelineCommandTest::invalidStepsAreSaved()
+{
+    const QJsonArray stepsArray({
+        QJsonObject({ { "command", QJsonObject({ { "type", "shell" }, { "program", "true" } }) } }),
+        QJsonObject({ { "command", QJsonObject({ { "type", "teleport" }, { "target", "door" } }) },
+                      { "when",    "failure" } }),
+        QJsonObject({ { "command", QJsonObject({ { "type", "batch" }, { "program", "cat" } }) },
+                      { "timeout", 100 } }),
+        QJsonObject({ { "command", QJsonObject({ { "type", "shell" }, { "program", "false" } }) },
+                      { "when",    "always" } })
+    });
+    PipelineCommand pipeline(QJsonObject({
+        { "type",    "pipeline" },
+        { "enabled", true },
+        { "key",     "0001234567" },
+        { "steps",   stepsArray }
+    }));
+
+    //Invalid steps keep their places, so conditions still belong to the same steps
+    QVERIFY(!pipeline.isValid());
+    const QVector<PipelineCommand::Step> steps = pipeline.steps();
+    QCOMPARE(steps.size(),4);
+    QVERIFY(steps.at(0).command != nullptr);
+    QVERIFY(steps.at(1).command == nullptr);
+    QCOMPARE(steps.at(1).condition,PipelineCommand::OnFailure);
+    QVERIFY(steps.at(2).command == nullptr);
+    QCOMPARE(steps.at(2).timeout,100);
+    QVERIFY(steps.at(3).command != nullptr);
+    QCOMPARE(steps.at(3).condition,PipelineCommand::Always);
+
+    const QJsonArray savedSteps = pipeline.toJson().value("steps").toArray();
+    QCOMPARE(savedSteps.size(),4);
+    QCOMPARE(savedSteps.at(1).toObject(),stepsArray.at(1).toObject());
+    QCOMPARE(savedSteps.at(2).toObject(),stepsArray.at(2).toObject());
+    QCOMPARE(savedSteps.at(3).toObject().value("when").toString(),QStringLiteral("always"));
+}
+
+void PipelineCommandTest::invalidPipelineIsNotExecuted()
+{
+    PipelineCommand pipeline(QJsonObject({
+        { "type",    "pipeline" },
+        { "enabled", true },
+        { "key",     "0001234567" },
+        { "steps",   QJsonArray({ QJsonObject({ { "command", QJsonObject({ { "type", "teleport" } }) } }) }) }
+    }));
+    TestCommand* command = new TestCommand;
+    pipeline.appendStep(command);
+
+    _submit(&pipeline);
+    QVERIFY(m_finished);
+    QVERIFY(!m_result);
+    QCOMPARE(command->executedCount,0);
+}
+
+void PipelineCommandTest::stepsRunWithinGlobalLimit()
+{
+    //Pipeline does not hold the only slot, otherwise its steps would wait for it forever
+    commandScheduler->setMaxInFlight(1);
+
+    PipelineCommand pipeline;
+    TestCommand* first = new TestCommand;
+    TestCommand* second = new TestCommand;
+    pipeline.appendStep(first);
+    pipeline.appendStep(second);
+    TestCommand other;
+
+    _submit(&pipeline);
+    QCOMPARE(first->executedCount,1);
+    QCOMPARE(commandScheduler->inFlight(),2);
+
+    //Steps still hold slots, so other commands wait for them
+    QCOMPARE(commandScheduler->submit(&other,KeyEvent(QStringLiteral("0007654321"),0)),CommandScheduler::Queued);
+
+    //Freed slot is given to the pending command first, next step waits for it
+    first->finish();
+    QCOMPARE(other.executedCount,1);
+    QCOMPARE(second->executedCount,0);
+    QCOMPARE(commandScheduler->queued(second),1);
+
+    other.finish();
+    QCOMPARE(second->executedCount,1);
+    QVERIFY(!m_finished);
+
+    second->finish();
+    QVERIFY(m_finished);
+    QVERIFY(m_result);
+}
+
+QTEST_GUILESS_MAIN(PipelineCommandTest)
+
+#include "tst_pipelinecommand.moc"
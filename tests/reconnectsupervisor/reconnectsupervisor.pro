@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+TARGET = tst_reconnectsupervisor
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/devices/ReconnectSupervisor.h
+
+SOURCES += \
+    tst_reconnectsupervisor.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/devices/ReconnectSupervisor.cpp
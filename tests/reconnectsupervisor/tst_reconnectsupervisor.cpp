@@ -0,0 +1,220 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/devices/ReconnectSupervisor.h"
+
+static const quint64 MS = 1000 * 1000;
+static const QString DEVICE = QStringLiteral("/dev/input/event7");
+
+/*! @brief Time of the injected clock. Each test starts one minute later, so position of the wheel left by previous
+ *         test does not matter */
+static quint64 s_now = 0;
+static quint64 testClock() { return s_now; }
+
+class ReconnectSupervisorTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void backoffDelay_data();
+    void backoffDelay();
+    void reconnectAfterBackoff();
+    void delayGrowsWithAttempts();
+    void attemptsAreResetWhenStable();
+    void detachedDeviceWaitsForAttach();
+    void forgetDevice();
+    void disabled();
+
+private:
+    quint64                 m_base = 0;
+    ReconnectSupervisor*    p_supervisor = nullptr;
+    QSignalSpy*             p_requested = nullptr;
+
+    /*! @brief Moves clock to the time after start of the test and advances the wheel, as internal QTimer would */
+    void _advance(quint64 time) {
+        s_now = m_base + time;
+        timerWheel->advance(s_now);
+    }
+};
+
+void ReconnectSupervisorTest::initTestCase()
+{
+    timerWheel->setClock(&testClock);
+}
+
+void ReconnectSupervisorTest::init()
+{
+    m_base = s_now = s_now + 60 * 1000 * MS;
+    p_supervisor = new ReconnectSupervisor("test");
+    p_requested = new QSignalSpy(p_supervisor,&ReconnectSupervisor::reconnectRequested);
+}
+
+void ReconnectSupervisorTest::cleanup()
+{
+    delete p_requested;
+    p_requested = nullptr;
+    delete p_supervisor;
+    p_supervisor = nullptr;
+    QCOMPARE(timerWheel->pendingCount(),0);
+}
+
+void ReconnectSupervisorTest::backoffDelay_data()
+{
+    QTest::addColumn<int>("attempt");
+    QTest::addColumn<quint32>("random");
+    QTest::addColumn<quint64>("expected");
+
+    QTest::newRow("first retry")      << 0 << quint32(12345)      << 50 * MS;
+    QTest::newRow("second, min")      << 1 << quint32(0)          << 50 * MS;
+    QTest::newRow("second, max")      << 1 << quint32(50 * MS)    << 100 * MS;
+    QTest::newRow("third, min")       << 2 << quint32(0)          << 100 * MS;
+    QTest::newRow("jitter wraps")     << 2 << quint32(100 * MS + 1) << 100 * MS;
+    QTest::newRow("capped, min")      << 20 << quint32(0)         << 500 * MS;
+    QTest::newRow("capped, max")      << 20 << quint32(500 * MS)  << 1000 * MS;
+    QTest::newRow("huge attempt")     << 1000 << quint32(0)       << 500 * MS;
+}
+
+void ReconnectSupervisorTest::backoffDelay()
+{
+    QFETCH(int,attempt);
+    QFETCH(quint32,random);
+    QFETCH(quint64,expected);
+
+    QCOMPARE(ReconnectSupervisor::backoffDelay(attempt,50 * MS,1000 * MS,random),expected);
+}
+
+void ReconnectSupervisorTest::reconnectAfterBackoff()
+{
+    p_supervisor->deviceConnected(DEVICE);
+    QVERIFY(p_supervisor->isSupervised(DEVICE));
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Connected);
+
+    p_supervisor->deviceFailed(DEVICE);
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Waiting);
+    QCOMPARE(p_supervisor->attempt(DEVICE),1);
+
+    _advance(40 * MS);
+    QVERIFY(p_requested->isEmpty());
+
+    _advance(60 * MS);
+    QCOMPARE(p_requested->count(),1);
+    QCOMPARE(p_requested->first().at(0).toString(),DEVICE);
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Reconnecting);
+
+    p_supervisor->deviceConnected(DEVICE);
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Connected);
+}
+
+void ReconnectSupervisorTest::delayGrowsWithAttempts()
+{
+    p_supervisor->deviceConnected(DEVICE);
+    p_supervisor->deviceFailed(DEVICE);
+    _advance(60 * MS);
+    QCOMPARE(p_requested->count(),1);
+
+    //Second delay is between 50 and 100 ms
+    p_supervisor->deviceFailed(DEVICE);
+    QCOMPARE(p_supervisor->attempt(DEVICE),2);
+    _advance(100 * MS);
+    QCOMPARE(p_requested->count(),1);
+
+    _advance(170 * MS);
+    QCOMPARE(p_requested->count(),2);
+}
+
+void ReconnectSupervisorTest::attemptsAreResetWhenStable()
+{
+    p_supervisor->deviceConnected(DEVICE);
+    p_supervisor->deviceFailed(DEVICE);
+    _advance(60 * MS);
+    p_supervisor->deviceFailed(DEVICE);
+    _advance(200 * MS);
+    QCOMPARE(p_requested->count(),2);
+
+    //Device failing soon after reconnection keeps backing off
+    p_supervisor->deviceConnected(DEVICE);
+    _advance(1200 * MS);
+    p_supervisor->deviceFailed(DEVICE);
+    QCOMPARE(p_supervisor->attempt(DEVICE),3);
+    _advance(2000 * MS);
+    QCOMPARE(p_requested->count(),3);
+
+    //Device, which worked long enough, starts from the first attempt
+    p_supervisor->deviceConnected(DEVICE);
+    _advance(2000 * MS + ReconnectSupervisor::STABLE_NS);
+    p_supervisor->deviceFailed(DEVICE);
+    QCOMPARE(p_supervisor->attempt(DEVICE),1);
+    p_supervisor->forgetDevice(DEVICE);
+}
+
+void ReconnectSupervisorTest::detachedDeviceWaitsForAttach()
+{
+    p_supervisor->deviceConnected(DEVICE);
+    p_supervisor->deviceFailed(DEVICE);
+    p_supervisor->deviceDetached(DEVICE);
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Detached);
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    _advance(5000 * MS);
+    QVERIFY(p_requested->isEmpty());
+
+    //Device is reopened as soon as it appears
+    p_supervisor->deviceAttached(DEVICE);
+    QCOMPARE(p_requested->count(),1);
+    QCOMPARE(p_supervisor->state(DEVICE),ReconnectSupervisor::Reconnecting);
+
+    //Device, which is not supervised, is not reopened
+    p_supervisor->deviceAttached("/dev/input/event8");
+    QCOMPARE(p_requested->count(),1);
+}
+
+void ReconnectSupervisorTest::forgetDevice()
+{
+    p_supervisor->deviceConnected(DEVICE);
+    p_supervisor->deviceFailed(DEVICE);
+    p_supervisor->forgetDevice(DEVICE);
+    QVERIFY(!p_supervisor->isSupervised(DEVICE));
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    _advance(5000 * MS);
+    QVERIFY(p_requested->isEmpty());
+}
+
+void ReconnectSupervisorTest::disabled()
+{
+    p_supervisor->setEnabled(false);
+    p_supervisor->deviceConnected(DEVICE);
+    p_supervisor->deviceFailed(DEVICE);
+    QVERIFY(!p_supervisor->isSupervised(DEVICE));
+
+    _advance(5000 * MS);
+    QVERIFY(p_requested->isEmpty());
+}
+
+QTEST_GUILESS_MAIN(ReconnectSupervisorTest)
+
+#include "tst_reconnectsupervisor.moc"
@@ -0,0 +1,24 @@
+include(../tests.pri)
+
+QT += serialport
+
+TARGET = tst_serialbackend
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/devices/DeviceMultiplexer.h \
+    ../../src/core/devices/EpollBackend.h \
+    ../../src/core/devices/IoUringBackend.h \
+    ../../src/core/devices/MultiplexerBackend.h \
+    ../../src/core/devices/ReconnectSupervisor.h
+
+SOURCES += \
+    tst_serialbackend.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/devices/DeviceMultiplexer.cpp \
+    ../../src/core/devices/EpollBackend.cpp \
+    ../../src/core/devices/IoUringBackend.cpp \
+    ../../src/core/devices/ReconnectSupervisor.cpp \
+    ../../src/core/serial/SerialPortConfig.cpp
@@ -0,0 +1,331 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "core/devices/DeviceMultiplexer.h"
+#include "core/devices/ReconnectSupervisor.h"
+#include "core/serial/SerialPortConfig.h"
+
+static const quint64 MS = 1000 * 1000;
+
+/*! @brief Pseudoterminal pair. Slave stands in for the port of serial reader, test writes frames to the master */
+struct TestPty
+{
+    int       master = -1;
+    QString   slavePath;
+
+    bool      open() {
+        master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if ((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0))
+            return false;
+        slavePath = QString::fromLocal8Bit(ptsname(master));
+        return true;
+    }
+
+    bool      write(const QByteArray& data) {
+        return ::write(master, data.constData(), data.size()) == data.size();
+    }
+
+    void      close() {
+        if (master >= 0)
+            ::close(master);
+        master = -1;
+    }
+};
+
+/*! @brief Reads the port as SerialDevice does it with TermiosBackend */
+class TermiosReader : public DeviceMultiplexer::Handler
+{
+public:
+    QByteArray  data;
+    int         reads = 0;
+    int         error = 0;
+    int         handle = -1;
+
+    bool  open(const QString& path, const SerialPortConfig& config) {
+        handle = ::open(path.toLocal8Bit().constData(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        return (handle >= 0) && config.configureTermios(handle)
+                && deviceMultiplexer->addDevice(handle,this,config.readBufferSize());
+    }
+
+    void  close() {
+        deviceMultiplexer->removeDevice(handle);
+        ::close(handle);
+        handle = -1;
+    }
+
+    void  _deviceDataRead(int fd, const char* buffer, int size) override {
+        Q_UNUSED(fd);
+        data.append(buffer,size);
+        reads++;
+    }
+
+    void  _deviceReadFailed(int fd, int readError) override {
+        Q_UNUSED(fd);
+        error = readError;
+    }
+};
+
+class SerialBackendTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void termiosIsApplied();
+    void blockingReadKeepsReadMinimum();
+    void unsupportedBaudRate();
+
+    void framesAreRead_data()                   { _backends(); }
+    void framesAreRead();
+    void hangupIsReported_data()                { _backends(); }
+    void hangupIsReported();
+    void reconnectBacksOff();
+
+    void benchmarkLatency_data()                { _backends(); }
+    void benchmarkLatency();
+
+private:
+    TestPty           m_pty;
+    SerialPortConfig  m_config;
+    TermiosReader     m_termiosReader;
+    QSerialPort       m_port;
+    QByteArray        m_portData;         //!< @brief Data read by QSerialPort
+    int               m_portReads = 0;    //!< @brief readyRead signals of QSerialPort
+    QSerialPort::SerialPortError m_portError = QSerialPort::NoError;
+
+    void      _backends();
+
+    /*! @brief Opens slave of the pty with the backend of the current row */
+    bool      _open(SerialPortConfig::Backend backend);
+    QByteArray _received(SerialPortConfig::Backend backend) const {
+        return (backend == SerialPortConfig::TermiosBackend) ? m_termiosReader.data : m_portData;
+    }
+};
+
+void SerialBackendTest::initTestCase()
+{
+    connect(&m_port,&QSerialPort::readyRead,this,[this]() {
+        m_portData.append(m_port.readAll());
+        m_portReads++;
+    });
+    connect(&m_port,&QSerialPort::errorOccurred,this,[this](QSerialPort::SerialPortError error) {
+        if (error != QSerialPort::NoError)
+            m_portError = error;
+    });
+}
+
+void SerialBackendTest::init()
+{
+    QVERIFY(m_pty.open());
+
+    m_config = SerialPortConfig();
+    m_config.setBaudRate(QSerialPort::Baud9600);
+    m_config.setDataBits(QSerialPort::Data8);
+    m_config.setParity(QSerialPort::NoParity);
+    m_config.setStopBits(QSerialPort::OneStop);
+    m_config.setFlowControl(QSerialPort::NoFlowControl);
+
+    m_termiosReader.data.clear();
+    m_termiosReader.reads = 0;
+    m_termiosReader.error = 0;
+    m_portData.clear();
+    m_portReads = 0;
+    m_portError = QSerialPort::NoError;
+}
+
+void SerialBackendTest::cleanup()
+{
+    if (m_termiosReader.handle >= 0)
+        m_termiosReader.close();
+    m_port.close();
+    m_pty.close();
+
+    QCOMPARE(deviceMultiplexer->deviceCount(),0);
+}
+
+void SerialBackendTest::_backends()
+{
+    QTest::addColumn<int>("backend");
+
+    QTest::newRow("termios") << int(SerialPortConfig::TermiosBackend);
+    QTest::newRow("QSerialPort") << int(SerialPortConfig::QtSerialPortBackend);
+}
+
+bool SerialBackendTest::_open(SerialPortConfig::Backend backend)
+{
+    if (backend == SerialPortConfig::TermiosBackend)
+        return m_termiosReader.open(m_pty.slavePath,m_config);
+
+    m_port.setPortName(m_pty.slavePath);
+    m_config.configureSerialPort(&m_port);
+    return m_port.open(QIODevice::ReadOnly);
+}
+
+void SerialBackendTest::termiosIsApplied()
+{
+    m_config.setDataBits(QSerialPort::Data7);
+    m_config.setParity(QSerialPort::EvenParity);
+    m_config.setReadMinimum(8);
+    m_config.setReadTimeout(5);
+    QVERIFY(_open(SerialPortConfig::TermiosBackend));
+
+    struct termios options;
+    QCOMPARE(tcgetattr(m_termiosReader.handle, &options),0);
+    QCOMPARE(cfgetispeed(&options),speed_t(B9600));
+    QCOMPARE(options.c_cflag & CSIZE,tcflag_t(CS7));
+    QVERIFY(options.c_cflag & PARENB);
+    QVERIFY(!(options.c_cflag & PARODD));
+    QVERIFY(!(options.c_lflag & ICANON));
+
+    //Non-blocking descriptor is readable as soon as any byte is buffered, whatever VMIN/VTIME are
+    QCOMPARE(int(options.c_cc[VMIN]),1);
+    QCOMPARE(int(options.c_cc[VTIME]),0);
+}
+
+void SerialBackendTest::blockingReadKeepsReadMinimum()
+{
+    m_config.setReadMinimum(8);
+    m_config.setReadTimeout(5);
+
+    const int handle = ::open(m_pty.slavePath.toLocal8Bit().constData(), O_RDONLY | O_NOCTTY | O_CLOEXEC);
+    QVERIFY(handle >= 0);
+    QVERIFY(m_config.configureTermios(handle));
+
+    struct termios options;
+    QCOMPARE(tcgetattr(handle, &options),0);
+    ::close(handle);
+    QCOMPARE(int(options.c_cc[VMIN]),8);
+    QCOMPARE(int(options.c_cc[VTIME]),5);
+}
+
+void SerialBackendTest::unsupportedBaudRate()
+{
+    m_config.setBaudRate(QSerialPort::BaudRate(250000));
+
+    const int handle = ::open(m_pty.slavePath.toLocal8Bit().constData(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    QVERIFY(handle >= 0);
+    const bool configured = m_config.configureTermios(handle);
+    const int error = errno;
+    ::close(handle);
+
+    QVERIFY(!configured);
+    QCOMPARE(error,EINVAL);
+}
+
+void SerialBackendTest::framesAreRead()
+{
+    QFETCH(int,backend);
+
+    //Frames longer than read buffer of termios backend are read in parts
+    m_config.setReadBufferSize(8);
+    QVERIFY(_open(SerialPortConfig::Backend(backend)));
+
+    QVERIFY(m_pty.write("0004567890\r\n"));
+    QTRY_COMPARE(_received(SerialPortConfig::Backend(backend)),QByteArray("0004567890\r\n"));
+
+    const QByteArray longFrame = QByteArray(300,'7') + "\r\n";
+    QVERIFY(m_pty.write(longFrame));
+    QTRY_COMPARE(_received(SerialPortConfig::Backend(backend)).size(),12 + longFrame.size());
+}
+
+void SerialBackendTest::hangupIsReported()
+{
+    QFETCH(int,backend);
+    QVERIFY(_open(SerialPortConfig::Backend(backend)));
+
+    //Closed master hangs up the slave, as unplugged USB adapter does
+    m_pty.close();
+    if (backend == SerialPortConfig::TermiosBackend) {
+        QTRY_COMPARE(m_termiosReader.error,EIO);
+    } else {
+        //QSerialPort reports end of file as ReadError, EIO as ResourceError
+        QTRY_VERIFY((m_portError == QSerialPort::ReadError) || (m_portError == QSerialPort::ResourceError));
+    }
+}
+
+void SerialBackendTest::reconnectBacksOff()
+{
+    QVERIFY(_open(SerialPortConfig::TermiosBackend));
+    const QString path = m_pty.slavePath;
+
+    //Port is supervised the same way as within SerialDeviceManager
+    ReconnectSupervisor supervisor("serial");
+    supervisor.setInitialDelay(10 * MS);
+    supervisor.setMaximumDelay(40 * MS);
+    supervisor.deviceConnected(path);
+
+    int attempts = 0;
+    connect(&supervisor,&ReconnectSupervisor::reconnectRequested,this,[this,&supervisor,&attempts](const QString& deviceId) {
+        attempts++;
+        if (m_termiosReader.open(deviceId,m_config)) {
+            supervisor.deviceConnected(deviceId);
+            return;
+        }
+        if (m_termiosReader.handle >= 0)
+            m_termiosReader.close();
+        supervisor.deviceFailed(deviceId);
+    });
+
+    m_pty.close();
+    QTRY_COMPARE(m_termiosReader.error,EIO);
+    m_termiosReader.close();
+    supervisor.deviceFailed(path);
+
+    //Slave of closed pty can not be opened anymore, so every attempt fails and delays grow
+    QTRY_VERIFY(attempts >= 3);
+    QCOMPARE(supervisor.attempt(path),attempts + 1);
+    QVERIFY(supervisor.state(path) != ReconnectSupervisor::Connected);
+}
+
+void SerialBackendTest::benchmarkLatency()
+{
+    QFETCH(int,backend);
+    QVERIFY(_open(SerialPortConfig::Backend(backend)));
+
+    //Time from writing frame to the master till it is read by the backend from the slave
+    const QByteArray frame("0004567890\r\n");
+    int frames = 0;
+    QBENCHMARK {
+        QVERIFY(m_pty.write(frame));
+        frames++;
+
+        while (_received(SerialPortConfig::Backend(backend)).size() < frames * frame.size())
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    const int reads = (backend == SerialPortConfig::TermiosBackend) ? m_termiosReader.reads : m_portReads;
+    qInfo() << "Reads per frame:"<<double(reads) / frames;
+}
+
+QTEST_GUILESS_MAIN(SerialBackendTest)
+
+#include "tst_serialbackend.moc"
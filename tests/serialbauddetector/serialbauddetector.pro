@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+QT += serialport
+
+TARGET = tst_serialbauddetector
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/serial/SerialBaudDetector.h
+
+SOURCES += \
+    tst_serialbauddetector.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/serial/SerialBaudDetector.cpp
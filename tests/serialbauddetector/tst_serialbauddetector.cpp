@@ -0,0 +1,175 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/serial/SerialBaudDetector.h"
+
+static const quint64 MS = 1000 * 1000;
+
+/*! @brief Time of the injected clock. Each test starts one minute later, so position of the wheel left by previous
+ *         test does not matter */
+static quint64 s_now = 0;
+static quint64 testClock() { return s_now; }
+
+class SerialBaudDetectorTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void frameScore();
+    void validFrameIsDetected();
+    void garbageSwitchesCandidate();
+    void dwellSwitchesCandidate();
+    void rejectCandidate();
+    void rejectLastCandidate();
+
+private:
+    quint64               m_base = 0;
+    SerialBaudDetector*   p_detector = nullptr;
+    QSignalSpy*           p_changed = nullptr;
+    QSignalSpy*           p_detected = nullptr;
+
+    /*! @brief Feeds bytes to the detector at time after start of the test */
+    void _feed(const QByteArray& data, quint64 time) {
+        s_now = m_base + time;
+        p_detector->feed(data.constData(),data.size(),s_now);
+    }
+
+    /*! @brief Moves clock to the time after start of the test and advances the wheel, as internal QTimer would */
+    void _advance(quint64 time) {
+        s_now = m_base + time;
+        timerWheel->advance(s_now);
+    }
+
+    QSerialPort::BaudRate _lastChange() const {
+        return p_changed->last().at(0).value<QSerialPort::BaudRate>();
+    }
+};
+
+void SerialBaudDetectorTest::initTestCase()
+{
+    qRegisterMetaType<QSerialPort::BaudRate>("QSerialPort::BaudRate");
+    timerWheel->setClock(&testClock);
+}
+
+void SerialBaudDetectorTest::init()
+{
+    m_base = s_now = s_now + 60 * 1000 * MS;
+
+    p_detector = new SerialBaudDetector({QSerialPort::Baud9600,QSerialPort::Baud19200,QSerialPort::Baud115200});
+    p_changed = new QSignalSpy(p_detector,&SerialBaudDetector::candidateChanged);
+    p_detected = new QSignalSpy(p_detector,&SerialBaudDetector::baudRateDetected);
+    p_detector->start(s_now);
+}
+
+void SerialBaudDetectorTest::cleanup()
+{
+    delete p_changed;
+    delete p_detected;
+    delete p_detector;
+    p_changed = p_detected = nullptr;
+    p_detector = nullptr;
+    QCOMPARE(timerWheel->pendingCount(),0);
+}
+
+void SerialBaudDetectorTest::frameScore()
+{
+    QCOMPARE(SerialBaudDetector::frameScore("0012345678",10),100);
+    QCOMPARE(SerialBaudDetector::frameScore("\x02" "12AB\x03",6),100);
+    QCOMPARE(SerialBaudDetector::frameScore("\xff\x80\x00\x01",4),0);
+    QCOMPARE(SerialBaudDetector::frameScore("",0),0);
+}
+
+void SerialBaudDetectorTest::validFrameIsDetected()
+{
+    //Pause before the frame means, that it is received from its start
+    _feed("0012345678\r",60 * MS);
+    QCOMPARE(p_detected->count(),1);
+    QCOMPARE(p_detected->first().at(0).value<QSerialPort::BaudRate>(),QSerialPort::Baud9600);
+    QCOMPARE(p_detected->first().at(1).toByteArray(),QByteArray("0012345678\r"));
+    QCOMPARE(p_detected->first().at(2).toULongLong(),s_now);
+    QVERIFY(p_changed->isEmpty());
+}
+
+void SerialBaudDetectorTest::garbageSwitchesCandidate()
+{
+    _feed(QByteArray(16,'\xff'),60 * MS);
+    QCOMPARE(p_changed->count(),1);
+    QCOMPARE(_lastChange(),QSerialPort::Baud19200);
+    QCOMPARE(p_detector->currentCandidate(),QSerialPort::Baud19200);
+
+    _feed("0012345678\r",200 * MS);
+    QCOMPARE(p_detected->count(),1);
+    QCOMPARE(p_detected->first().at(0).value<QSerialPort::BaudRate>(),QSerialPort::Baud19200);
+}
+
+void SerialBaudDetectorTest::dwellSwitchesCandidate()
+{
+    _advance(SerialBaudDetector::DWELL_NS + 10 * MS);
+    QCOMPARE(p_changed->count(),1);
+    QCOMPARE(_lastChange(),QSerialPort::Baud19200);
+
+    _advance(2 * SerialBaudDetector::DWELL_NS + 20 * MS);
+    _advance(3 * SerialBaudDetector::DWELL_NS + 30 * MS);
+    QCOMPARE(p_changed->count(),3);
+    QCOMPARE(_lastChange(),QSerialPort::Baud9600);
+    QVERIFY(p_detected->isEmpty());
+}
+
+void SerialBaudDetectorTest::rejectCandidate()
+{
+    //Port did not accept 19200, so it is not probed anymore
+    _advance(SerialBaudDetector::DWELL_NS + 10 * MS);
+    QCOMPARE(_lastChange(),QSerialPort::Baud19200);
+    QVERIFY(p_detector->rejectCandidate(s_now));
+    QCOMPARE(p_changed->count(),2);
+    QCOMPARE(_lastChange(),QSerialPort::Baud115200);
+
+    const quint64 start = s_now - m_base;
+    _advance(start + SerialBaudDetector::DWELL_NS + 10 * MS);
+    QCOMPARE(_lastChange(),QSerialPort::Baud9600);
+    _advance(start + 2 * SerialBaudDetector::DWELL_NS + 20 * MS);
+    QCOMPARE(_lastChange(),QSerialPort::Baud115200);
+}
+
+void SerialBaudDetectorTest::rejectLastCandidate()
+{
+    QVERIFY(p_detector->rejectCandidate(s_now));
+    QVERIFY(p_detector->rejectCandidate(s_now));
+    QCOMPARE(p_detector->currentCandidate(),QSerialPort::Baud115200);
+
+    QVERIFY(!p_detector->rejectCandidate(s_now));
+    QCOMPARE(p_changed->count(),2);
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    //Detection is stopped
+    _feed("0012345678\r",60 * MS);
+    QVERIFY(p_detected->isEmpty());
+}
+
+QTEST_GUILESS_MAIN(SerialBaudDetectorTest)
+
+#include "tst_serialbauddetector.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+QT += serialport
+
+TARGET = tst_serialportconfig
+
+SOURCES += \
+    tst_serialportconfig.cpp \
+    ../../src/core/serial/SerialPortConfig.cpp
@@ -0,0 +1,123 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/serial/SerialPortConfig.h"
+
+class SerialPortConfigTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void supportedBaudRates();
+    void profileString_data();
+    void profileString();
+    void malformedProfile_data();
+    void malformedProfile();
+    void partialProfile();
+
+private:
+    static SerialPortConfig _defaultConfig();
+};
+
+SerialPortConfig SerialPortConfigTest::_defaultConfig()
+{
+    SerialPortConfig config;
+    config.setBaudRate(QSerialPort::Baud9600);
+    config.setDataBits(QSerialPort::Data8);
+    config.setParity(QSerialPort::NoParity);
+    config.setStopBits(QSerialPort::OneStop);
+    config.setFlowControl(QSerialPort::NoFlowControl);
+    return config;
+}
+
+void SerialPortConfigTest::supportedBaudRates()
+{
+    for (qint32 rate : {1200,2400,4800,9600,19200,38400,57600,115200})
+        QVERIFY(SerialPortConfig::isSupportedBaudRate(rate));
+
+    for (qint32 rate : {-1,0,300,9601,14400,230400})
+        QVERIFY(!SerialPortConfig::isSupportedBaudRate(rate));
+}
+
+void SerialPortConfigTest::profileString_data()
+{
+    QTest::addColumn<QString>("profile");
+
+    QTest::newRow("default")    << "9600,8N1,none";
+    QTest::newRow("even")       << "115200,7E1,hardware";
+    QTest::newRow("two stop")   << "1200,5O2,software";
+    QTest::newRow("auto")       << "auto,8M1,none";
+}
+
+void SerialPortConfigTest::profileString()
+{
+    QFETCH(QString,profile);
+
+    SerialPortConfig config = _defaultConfig();
+    QVERIFY(config.applyProfileString(profile));
+    QCOMPARE(config.toProfileString(),profile);
+}
+
+void SerialPortConfigTest::malformedProfile_data()
+{
+    QTest::addColumn<QString>("profile");
+
+    QTest::newRow("empty")          << "";
+    QTest::newRow("unsupported")    << "14400,8N1,none";
+    QTest::newRow("zero")           << "0";
+    QTest::newRow("not a number")   << "fast";
+    QTest::newRow("data bits")      << "9600,9N1";
+    QTest::newRow("parity")         << "9600,8X1";
+    QTest::newRow("stop bits")      << "9600,8N3";
+    QTest::newRow("flow control")   << "9600,8N1,xon";
+    QTest::newRow("too many parts") << "9600,8N1,none,1";
+}
+
+void SerialPortConfigTest::malformedProfile()
+{
+    QFETCH(QString,profile);
+
+    //Config is not changed by malformed profile
+    SerialPortConfig config = _defaultConfig();
+    config.setBaudRate(QSerialPort::Baud19200);
+    QVERIFY(!config.applyProfileString(profile));
+    QCOMPARE(config.toProfileString(),QString("19200,8N1,none"));
+}
+
+void SerialPortConfigTest::partialProfile()
+{
+    SerialPortConfig config = _defaultConfig();
+    config.setFlowControl(QSerialPort::HardwareControl);
+
+    QVERIFY(config.applyProfileString("57600"));
+    QCOMPARE(config.toProfileString(),QString("57600,8N1,hardware"));
+    QVERIFY(!config.autodetectBaudRate());
+
+    QVERIFY(config.applyProfileString("auto,7E1"));
+    QVERIFY(config.autodetectBaudRate());
+    QCOMPARE(config.toProfileString(),QString("auto,7E1,hardware"));
+}
+
+QTEST_APPLESS_MAIN(SerialPortConfigTest)
+
+#include "tst_serialportconfig.moc"
@@ -0,0 +1,37 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_socketcommand
+
+HEADERS += \
+    ../../src/core/TimerWheel.h \
+    ../../src/core/commands/BatchCommand.h \
+    ../../src/core/commands/ChildSupervisor.h \
+    ../../src/core/commands/Command.h \
+    ../../src/core/commands/CommandScheduler.h \
+    ../../src/core/commands/MembershipCommand.h \
+    ../../src/core/commands/PipelineCommand.h \
+    ../../src/core/commands/ShellCommand.h \
+    ../../src/core/commands/SocketCommand.h \
+    ../../src/core/devices/ReconnectSupervisor.h
+
+SOURCES += \
+    tst_socketcommand.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp \
+    ../../src/core/cards/CardNormalizer.cpp \
+    ../../src/core/commands/BatchCommand.cpp \
+    ../../src/core/commands/ChildSupervisor.cpp \
+    ../../src/core/commands/Command.cpp \
+    ../../src/core/commands/CommandScheduler.cpp \
+    ../../src/core/commands/CommandTask.cpp \
+    ../../src/core/commands/CommandTemplate.cpp \
+    ../../src/core/commands/ExecutionPolicy.cpp \
+    ../../src/core/commands/KeySet.cpp \
+    ../../src/core/commands/MembershipCommand.cpp \
+    ../../src/core/commands/PipelineCommand.cpp \
+    ../../src/core/commands/ShellCommand.cpp \
+    ../../src/core/commands/SocketCommand.cpp \
+    ../../src/core/devices/ReconnectSupervisor.cpp
@@ -0,0 +1,348 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include "core/commands/CommandScheduler.h"
+#include "core/commands/ShellCommand.h"
+#include "core/commands/SocketCommand.h"
+
+static const char KEY[] = "0001234567";
+
+/*! @brief Local stand-in for the listener of records. Accepts connections over TCP or unix socket and collects
+ *         everything received on all of them */
+class TestListener
+{
+public:
+    QByteArray  data;
+    int         connections = 0;
+
+    bool listen(SocketCommand::Transport transport, const QString& socketPath) {
+        m_transport = transport;
+        if (transport == SocketCommand::UnixTransport) {
+            QLocalServer::removeServer(socketPath);
+            QObject::connect(&m_localServer,&QLocalServer::newConnection,&m_localServer,[this]() {
+                while (m_localServer.hasPendingConnections())
+                    _accept(m_localServer.nextPendingConnection());
+            });
+            return m_localServer.listen(socketPath);
+        }
+
+        QObject::connect(&m_tcpServer,&QTcpServer::newConnection,&m_tcpServer,[this]() {
+            while (m_tcpServer.hasPendingConnections())
+                _accept(m_tcpServer.nextPendingConnection());
+        });
+        return m_tcpServer.listen(QHostAddress::LocalHost,0);
+    }
+
+    QString endpoint() const {
+        if (m_transport == SocketCommand::UnixTransport)
+            return QStringLiteral("unix:") + m_localServer.fullServerName();
+
+        return QStringLiteral("tcp://127.0.0.1:%1").arg(m_tcpServer.serverPort());
+    }
+
+    /*! @brief Closes accepted connections, as listener going away would, but keeps listening */
+    void closeConnections() {
+        for (QIODevice* socket : qAsConst(m_sockets)) {
+            socket->close();
+            socket->deleteLater();
+        }
+        m_sockets.clear();
+    }
+
+private:
+    void _accept(QIODevice* socket) {
+        connections++;
+        m_sockets.append(socket);
+        QObject::connect(socket,&QIODevice::readyRead,socket,[this,socket]() {
+            data.append(socket->readAll());
+        });
+    }
+
+    SocketCommand::Transport m_transport = SocketCommand::TcpTransport;
+    QTcpServer   m_tcpServer;
+    QLocalServer m_localServer;
+    QList<QIODevice*> m_sockets;
+};
+
+class SocketCommandTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+
+    void endpointsAreParsed();
+    void recordsAreFramed_data();
+    void recordsAreFramed();
+    void recordsAreQueuedWhileConnecting();
+    void reconnectAfterConnectionLoss_data();
+    void reconnectAfterConnectionLoss();
+    void oldestRecordsAreDropped();
+
+    void benchmarkThroughput_data();
+    void benchmarkThroughput();
+
+private:
+    void _transports();
+    QString _socketPath() const { return m_dir.filePath(QStringLiteral("listener")); }
+
+    /*! @brief Splits data received by the listener into records */
+    static QList<QByteArray> _records(const QByteArray& data, SocketCommand::Framing framing);
+    static QJsonObject _socketCommand(const QString& endpoint) {
+        return QJsonObject({
+            { "type",     "socket" },
+            { "enabled",  true },
+            { "key",      KEY },
+            { "endpoint", endpoint },
+            { "record",   "{key}" }
+        });
+    }
+
+    QTemporaryDir m_dir;
+};
+
+void SocketCommandTest::_transports()
+{
+    QTest::addColumn<int>("transport");
+    QTest::newRow("tcp") << int(SocketCommand::TcpTransport);
+    QTest::newRow("unix") << int(SocketCommand::UnixTransport);
+}
+
+QList<QByteArray> SocketCommandTest::_records(const QByteArray& data, SocketCommand::Framing framing)
+{
+    QList<QByteArray> records;
+    if (framing == SocketCommand::LineFraming) {
+        records = data.split('\n');
+        //Complete records end with newline, so the last part is empty or incomplete
+        records.removeLast();
+        return records;
+    }
+
+    int position = 0;
+    while (position + 4 <= data.size()) {
+        const int length = int(qFromBigEndian<quint32>(data.constData() + position));
+        if (position + 4 + length > data.size())
+            break;
+        records.append(data.mid(position + 4,length));
+        position += 4 + length;
+    }
+    return records;
+}
+
+void SocketCommandTest::cleanup()
+{
+    QCOMPARE(commandScheduler->inFlight(),0);
+    QCOMPARE(commandScheduler->queued(),0);
+}
+
+void SocketCommandTest::endpointsAreParsed()
+{
+    QString host;
+    quint16 port = 0;
+    QCOMPARE(SocketCommand::parseEndpoint("tcp://127.0.0.1:9000",&host,&port),SocketCommand::TcpTransport);
+    QCOMPARE(host,QStringLiteral("127.0.0.1"));
+    QCOMPARE(port,quint16(9000));
+    QCOMPARE(SocketCommand::parseEndpoint("udp://localhost:514",&host,&port),SocketCommand::UdpTransport);
+    QCOMPARE(host,QStringLiteral("localhost"));
+    QCOMPARE(port,quint16(514));
+    QCOMPARE(SocketCommand::parseEndpoint("unix:/run/door.sock",&host,&port),SocketCommand::UnixTransport);
+    QCOMPARE(host,QStringLiteral("/run/door.sock"));
+
+    QCOMPARE(SocketCommand::parseEndpoint("tcp://127.0.0.1",&host,&port),SocketCommand::InvalidTransport);
+    QCOMPARE(SocketCommand::parseEndpoint("http://127.0.0.1:80",&host,&port),SocketCommand::InvalidTransport);
+    QCOMPARE(SocketCommand::parseEndpoint("unix:",&host,&port),SocketCommand::InvalidTransport);
+}
+
+void SocketCommandTest::recordsAreFramed_data()
+{
+    QTest::addColumn<int>("transport");
+    QTest::addColumn<int>("framing");
+    QTest::newRow("tcp line") << int(SocketCommand::TcpTransport) << int(SocketCommand::LineFraming);
+    QTest::newRow("tcp length") << int(SocketCommand::TcpTransport) << int(SocketCommand::LengthFraming);
+    QTest::newRow("unix line") << int(SocketCommand::UnixTransport) << int(SocketCommand::LineFraming);
+    QTest::newRow("unix length") << int(SocketCommand::UnixTransport) << int(SocketCommand::LengthFraming);
+}
+
+void SocketCommandTest::recordsAreFramed()
+{
+    QFETCH(int, transport);
+    QFETCH(int, framing);
+
+    TestListener listener;
+    QVERIFY(listener.listen(SocketCommand::Transport(transport),_socketPath()));
+
+    QJsonObject jsonObject = _socketCommand(listener.endpoint());
+    jsonObject.insert("framing",SocketCommand::framingName(SocketCommand::Framing(framing)));
+    jsonObject.insert("record","{key}\n{device}");
+    SocketCommand command(jsonObject);
+    QCOMPARE(command.transport(),SocketCommand::Transport(transport));
+    QTRY_VERIFY(command.isConnected());
+
+    //Records are pipelined - all of them are written without waiting for the listener
+    const QStringList keys({ "0001234567", "0007654321", "0000000042" });
+    for (const QString& key : keys)
+        QCOMPARE(commandScheduler->submit(&command,KeyEvent(key,0,QStringLiteral("/dev/input/event3"))),
+                 CommandScheduler::Started);
+
+    QTRY_COMPARE(_records(listener.data,SocketCommand::Framing(framing)).size(),keys.size());
+    const QList<QByteArray> records = _records(listener.data,SocketCommand::Framing(framing));
+    //Newline within the record would break line framing, length framing keeps the record as it is
+    const char separator = (framing == SocketCommand::LineFraming) ? ' ' : '\n';
+    for (int i = 0; i < keys.size(); i++)
+        QCOMPARE(records.at(i),keys.at(i).toLatin1() + separator + QByteArray("/dev/input/event3"));
+    QCOMPARE(listener.connections,1);
+}
+
+void SocketCommandTest::recordsAreQueuedWhileConnecting()
+{
+    TestListener listener;
+    QVERIFY(listener.listen(SocketCommand::TcpTransport,_socketPath()));
+
+    //Connection is being established, when the first taps come
+    SocketCommand command(_socketCommand(listener.endpoint()));
+    QVERIFY(!command.isConnected());
+    for (int i = 0; i < 3; i++)
+        commandScheduler->submit(&command,KeyEvent(QString::number(i),0));
+    QCOMPARE(command.queuedCount(),3);
+
+    QTRY_COMPARE(listener.data,QByteArray("0\n1\n2\n"));
+    QCOMPARE(command.queuedCount(),0);
+}
+
+void SocketCommandTest::reconnectAfterConnectionLoss_data()
+{
+    _transports();
+}
+
+void SocketCommandTest::reconnectAfterConnectionLoss()
+{
+    QFETCH(int, transport);
+
+    TestListener listener;
+    QVERIFY(listener.listen(SocketCommand::Transport(transport),_socketPath()));
+    SocketCommand command(_socketCommand(listener.endpoint()));
+    QTRY_VERIFY(command.isConnected());
+
+    commandScheduler->submit(&command,KeyEvent(QStringLiteral("0000000001"),0));
+    QTRY_COMPARE(listener.data,QByteArray("0000000001\n"));
+
+    //Records of taps during reconnection are kept in the queue
+    listener.closeConnections();
+    QTRY_VERIFY(!command.isConnected());
+    commandScheduler->submit(&command,KeyEvent(QStringLiteral("0000000002"),0));
+    QCOMPARE(command.queuedCount(),1);
+
+    QTRY_COMPARE(listener.connections,2);
+    QTRY_COMPARE(listener.data,QByteArray("0000000001\n0000000002\n"));
+    QCOMPARE(command.queuedCount(),0);
+}
+
+void SocketCommandTest::oldestRecordsAreDropped()
+{
+    //Nobody listens on the socket yet, so connection attempts fail and records wait in the queue
+    QJsonObject jsonObject = _socketCommand(QStringLiteral("unix:") + _socketPath());
+    jsonObject.insert("queueLimit",2);
+    QLocalServer::removeServer(_socketPath());
+    SocketCommand command(jsonObject);
+    QCOMPARE(command.queueLimit(),2);
+
+    for (int i = 1; i <= 4; i++)
+        commandScheduler->submit(&command,KeyEvent(QString::number(i),0));
+    QCOMPARE(command.queuedCount(),2);
+
+    TestListener listener;
+    QVERIFY(listener.listen(SocketCommand::UnixTransport,_socketPath()));
+    QTRY_COMPARE(listener.data,QByteArray("3\n4\n"));
+}
+
+void SocketCommandTest::benchmarkThroughput_data()
+{
+    QTest::addColumn<QString>("approach");
+    QTest::newRow("socket") << QStringLiteral("socket");
+    //Process per tap, as with script running curl or nc. Script only appends the record to the file, so it is the
+    //lower bound of the shell approach
+    QTest::newRow("shell") << QStringLiteral("shell");
+}
+
+void SocketCommandTest::benchmarkThroughput()
+{
+    QFETCH(QString, approach);
+
+    static const int TAPS = 64;
+    const KeyEvent event(QString::fromLatin1(KEY),0);
+
+    TestListener listener;
+    QVERIFY(listener.listen(SocketCommand::TcpTransport,_socketPath()));
+    QScopedPointer<Command> command;
+    if (approach == QLatin1String("socket")) {
+        command.reset(new SocketCommand(_socketCommand(listener.endpoint())));
+        QTRY_VERIFY(static_cast<SocketCommand*>(command.data())->isConnected());
+    } else {
+        command.reset(new ShellCommand(QJsonObject({
+            { "type",      "shell" },
+            { "enabled",   true },
+            { "key",       KEY },
+            { "program",   "sh" },
+            { "arguments", QJsonArray({ "-c", "printf '%s\\n' \"$1\" >> \"$2\"", "sh", "{key}",
+                                        m_dir.filePath(QStringLiteral("records")) }) }
+        })));
+    }
+
+    //Record is the key followed by newline
+    const qint64 recordSize = qstrlen(KEY) + 1;
+    qint64 sent = 0;
+    int finished = 0;
+    int failed = 0;
+    QBENCHMARK {
+        for (int i = 0; i < TAPS; i++) {
+            commandScheduler->submit(command.data(),event,[&finished,&failed](bool success) {
+                finished++;
+                if (!success)
+                    failed++;
+            });
+        }
+        sent += TAPS;
+
+        if (approach == QLatin1String("socket")) {
+            while (listener.data.size() < sent * recordSize)
+                QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        } else {
+            while (finished < sent)
+                QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+
+    QCOMPARE(failed,0);
+    qInfo() << "Taps per iteration:"<<TAPS;
+}
+
+QTEST_GUILESS_MAIN(SocketCommandTest)
+
+#include "tst_socketcommand.moc"
@@ -0,0 +1,12 @@
+#
+# Common options of unit tests. Each test links only sources of the classes it covers, so features (HID, SERIAL,
+# METRICS, etc.) are disabled there. Run tests with "make check"
+#
+
+QT       += testlib
+QT       -= gui
+
+CONFIG   += c++20 console testcase no_testcase_installs
+CONFIG   -= app_bundle
+
+INCLUDEPATH += $$PWD/../src
@@ -0,0 +1,19 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    cardnormalizer \
+    devicemultiplexer \
+    fuzzykeyindex \
+    inputdevice \
+    keydecoder \
+    keydigest \
+    keypatternmatcher \
+    keyset \
+    metrics \
+    pipelinecommand \
+    reconnectsupervisor \
+    serialbackend \
+    serialbauddetector \
+    serialportconfig \
+    socketcommand \
+    timerwheel
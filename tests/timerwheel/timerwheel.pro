@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+TARGET = tst_timerwheel
+
+HEADERS += \
+    ../../src/core/TimerWheel.h
+
+SOURCES += \
+    tst_timerwheel.cpp \
+    ../../src/core/KeyEvent.cpp \
+    ../../src/core/KeyId.cpp \
+    ../../src/core/TimerWheel.cpp
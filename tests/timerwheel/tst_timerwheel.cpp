@@ -0,0 +1,182 @@
+/*
+ **********************************************************************************************************************
+ *
+ * This file is part of the rfid-controller project.
+ *
+ * Copyright (c) 2023 Ivan Odinets <i_odinets@protonmail.com>
+ *
+ * rfid-controller is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * rfid-controller is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with rfid-controller. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtTest>
+
+#include "core/TimerWheel.h"
+
+static const quint64 MS = 1000 * 1000;
+
+/*! @brief Time of the injected clock. Each test starts one minute later, so position of the wheel left by previous
+ *         test does not matter */
+static quint64 s_now = 0;
+static quint64 testClock() { return s_now; }
+
+class TestClient : public TimerWheel::Client
+{
+public:
+    int       expiredCount = 0;
+    quint64   expiredAt = 0;
+
+protected:
+    void _timerWheelExpired(quint64 now) override {
+        expiredCount++;
+        expiredAt = now;
+    }
+};
+
+class TimerWheelTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+
+    void expiresAfterDeadline();
+    void rescheduleReplacesDeadline();
+    void cancel();
+    void deadlineAfterFullTurn();
+    void destroyedClientIsForgotten();
+    void clientCanRescheduleItself();
+
+private:
+    quint64   m_base = 0;
+
+    /*! @brief Moves clock to the time after start of the test and advances the wheel, as internal QTimer would */
+    void _advance(quint64 time) {
+        s_now = m_base + time;
+        timerWheel->advance(s_now);
+    }
+};
+
+void TimerWheelTest::initTestCase()
+{
+    timerWheel->setClock(&testClock);
+    QCOMPARE(timerWheel->now(),s_now);
+}
+
+void TimerWheelTest::init()
+{
+    QCOMPARE(timerWheel->pendingCount(),0);
+    m_base = s_now = s_now + 60 * 1000 * MS;
+}
+
+void TimerWheelTest::expiresAfterDeadline()
+{
+    TestClient client;
+    timerWheel->schedule(&client,m_base + 25 * MS);
+    QVERIFY(timerWheel->isScheduled(&client));
+    QCOMPARE(timerWheel->pendingCount(),1);
+
+    _advance(20 * MS);
+    QCOMPARE(client.expiredCount,0);
+
+    _advance(30 * MS);
+    QCOMPARE(client.expiredCount,1);
+    QCOMPARE(client.expiredAt,m_base + 30 * MS);
+    QVERIFY(!timerWheel->isScheduled(&client));
+    QCOMPARE(timerWheel->pendingCount(),0);
+}
+
+void TimerWheelTest::rescheduleReplacesDeadline()
+{
+    TestClient client;
+    timerWheel->schedule(&client,m_base + 15 * MS);
+    timerWheel->schedule(&client,m_base + 45 * MS);
+    QCOMPARE(timerWheel->pendingCount(),1);
+
+    _advance(20 * MS);
+    QCOMPARE(client.expiredCount,0);
+
+    _advance(50 * MS);
+    QCOMPARE(client.expiredCount,1);
+}
+
+void TimerWheelTest::cancel()
+{
+    TestClient client;
+    timerWheel->schedule(&client,m_base + 15 * MS);
+    timerWheel->cancel(&client);
+    QVERIFY(!timerWheel->isScheduled(&client));
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    _advance(100 * MS);
+    QCOMPARE(client.expiredCount,0);
+}
+
+void TimerWheelTest::deadlineAfterFullTurn()
+{
+    //Deadline lands in the slot visited after 360 ms, but belongs to the next turn of the wheel
+    const quint64 turn = TimerWheel::SLOT_COUNT * TimerWheel::TICK_NS;
+    TestClient client;
+    timerWheel->schedule(&client,m_base + turn + 360 * MS);
+
+    _advance(360 * MS);
+    QCOMPARE(client.expiredCount,0);
+    QVERIFY(timerWheel->isScheduled(&client));
+
+    _advance(turn + 350 * MS);
+    QCOMPARE(client.expiredCount,0);
+
+    _advance(turn + 360 * MS);
+    QCOMPARE(client.expiredCount,1);
+}
+
+void TimerWheelTest::destroyedClientIsForgotten()
+{
+    TestClient* client = new TestClient;
+    timerWheel->schedule(client,m_base + 15 * MS);
+    delete client;
+    QCOMPARE(timerWheel->pendingCount(),0);
+
+    //Would crash if entry of the deleted client was still in the slot
+    TestClient other;
+    timerWheel->schedule(&other,m_base + 15 * MS);
+    _advance(20 * MS);
+    QCOMPARE(other.expiredCount,1);
+}
+
+void TimerWheelTest::clientCanRescheduleItself()
+{
+    class RepeatingClient : public TimerWheel::Client
+    {
+    public:
+        int   expiredCount = 0;
+    protected:
+        void _timerWheelExpired(quint64 now) override {
+            if (++expiredCount < 3)
+                timerWheel->schedule(this,now + 10 * MS);
+        }
+    };
+
+    RepeatingClient client;
+    timerWheel->schedule(&client,m_base + 10 * MS);
+    for (quint64 time = 10; time <= 100; time += 10)
+        _advance(time * MS);
+
+    QCOMPARE(client.expiredCount,3);
+    QVERIFY(!timerWheel->isScheduled(&client));
+}
+
+QTEST_GUILESS_MAIN(TimerWheelTest)
+
+#include "tst_timerwheel.moc"